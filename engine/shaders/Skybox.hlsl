@@ -1,7 +1,7 @@
 #include <ShaderVariables.hlsl>
+#include <Common.hlsl>
 
-TextureCube _Tex;
-SamplerState _TexSampler;
+FETextureCube(_Tex)
 float4 _Tex_HDR;
 float4 _Tint;
 float _SkyDistance;
@@ -90,7 +90,7 @@ void frag (v2f i, out float3 color : SV_TARGET0, out float2 mv : SV_TARGET1)
     float4 lastProj = mul(_LastSkyVP, float4(i.worldPos, 1));
     lastProj /= lastProj.w;
     mv = uv - (lastProj.xy * 0.5 + 0.5) + _Jitter;
-    float4 tex = _Tex.SampleLevel(_TexSampler, i.texcoord, 0);
+    float4 tex = FESampleCubeLevel(_Tex, i.texcoord, 0);
     //color = DecodeHDR(tex, _Tex_HDR);
     color = tex.xyz;
     color = color * _Tint.rgb * unity_ColorSpaceDouble.rgb * _Exposure;
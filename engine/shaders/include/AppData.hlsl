@@ -17,6 +17,9 @@ struct AppData
 	float4 Tangent : TANGENT;
 	float2 TexCoord : TEXCOORD0;
 	float2 TexCoord1 : TEXCOORD1;
+#ifdef INSTANCING_ON
+	uint InstanceID : SV_InstanceID;
+#endif
 };
 
 
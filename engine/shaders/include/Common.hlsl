@@ -29,9 +29,21 @@
     #define MaterialFloat4x3 float4x3 
 #endif
 
-#define FETexture2D(name) Texture2D name; SamplerState name##Sampler;
-#define FESample(name, uv) name.Sample(name##Sampler, (uv))
-#define FESampleLevel(name, uv, lod) name.SampleLevel(name##Sampler, (uv), (lod))
+// Bindless textures (fishengine/bindless.h): every texture lives in one
+// table and every sampler state in another, both bound once per pass. A
+// material texture is two uints in $Globals, the texture slot and the sampler
+// slot, written by MaterialBuildConstants. The tables alias the same heap
+// range, each texture is only read through the array of its own dimension.
+Texture2D FETextures2D[] : register(t0, space2);
+TextureCube FETexturesCube[] : register(t0, space3);
+SamplerState FESamplers[] : register(s0, space2);
+
+#define FETexture2D(name) uint name##TextureIndex; uint name##SamplerIndex;
+#define FETextureCube(name) uint name##TextureIndex; uint name##SamplerIndex;
+#define FESample(name, uv) FETextures2D[name##TextureIndex].Sample(FESamplers[name##SamplerIndex], (uv))
+#define FESampleLevel(name, uv, lod) FETextures2D[name##TextureIndex].SampleLevel(FESamplers[name##SamplerIndex], (uv), (lod))
+#define FESampleCube(name, dir) FETexturesCube[name##TextureIndex].Sample(FESamplers[name##SamplerIndex], (dir))
+#define FESampleCubeLevel(name, dir, lod) FETexturesCube[name##TextureIndex].SampleLevel(FESamplers[name##SamplerIndex], (dir), (lod))
 
 MaterialFloat4 Texture2DSampleLevel(Texture2D Tex, SamplerState Sampler, float2 UV, MaterialFloat Mip)
 {
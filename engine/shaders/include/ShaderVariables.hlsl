@@ -27,4 +27,22 @@ cbuffer LightingUniforms : register(b3)
     float4 LightDir;        // w=0 not used
 }
 
+#ifdef INSTANCING_ON
+// one entry per instance of an instanced draw, indexed by SV_InstanceID
+struct InstanceData
+{
+    float4x4 MATRIX_M;
+    float4x4 MATRIX_IT_M;
+};
+StructuredBuffer<InstanceData> Instances : register(t0, space1);
+
+#define OBJECT_TO_WORLD(v) Instances[v.InstanceID].MATRIX_M
+#define OBJECT_TO_WORLD_IT(v) Instances[v.InstanceID].MATRIX_IT_M
+#define OBJECT_TO_CLIP(v) mul(MATRIX_VP, Instances[v.InstanceID].MATRIX_M)
+#else
+#define OBJECT_TO_WORLD(v) MATRIX_M
+#define OBJECT_TO_WORLD_IT(v) MATRIX_IT_M
+#define OBJECT_TO_CLIP(v) MATRIX_MVP
+#endif
+
 #endif // ShaderVariables_hlsl
\ No newline at end of file
@@ -1,11 +1,11 @@
 import glob, os, sys, json
-import tarfile
 from shutil import copyfile, rmtree
 from CompileUnityShader import CompileAllVariants
 
 fxc = r"C:\Program Files (x86)\Windows Kits\10\bin\10.0.18362.0\x64\fxc.exe"
 dxc = r"E:\workspace\cengine\engine\binaries\dxc.exe"
 hlslreflect = r"..\binaries\Release\hlslreflect.exe"
+shaderpack = r"..\binaries\Release\shaderpack.exe"
 
 output_dir = "runtime/d3d"
 if os.path.exists(output_dir):
@@ -59,12 +59,10 @@ if __name__ == "__main__":
 
     files = hlsl_files + comp_files + glob.glob(f"{output_dir}/*")
 
-    tar_path = "./shaders.tar"
-    with tarfile.open(tar_path, "w") as tar:
-        for f in files:
-            #fullpath = os.path.abspath(f)
-            name = os.path.basename(f)
-            tar.add(f, name)
-    
-    copyfile(tar_path, "../binaries/Debug/shaders.tar")
-    copyfile(tar_path, "../binaries/Release/shaders.tar")
\ No newline at end of file
+    pak_path = "./shaders.pak"
+    cmd = f'""{shaderpack}" {pak_path} {" ".join(files)}"'
+    ret = os.system(cmd)
+    assert(ret == 0)
+
+    copyfile(pak_path, "../binaries/Debug/shaders.pak")
+    copyfile(pak_path, "../binaries/Release/shaders.pak")
@@ -29,11 +29,11 @@ VSToPS VS(AppData vin)
 {
 	VSToPS vout;
     float4 posH = float4(vin.Position.xyz, 1.0);
-	vout.Position = mul(MATRIX_MVP, posH);
-	vout.WorldPosition = mul(MATRIX_M, posH).xyz;
+	vout.Position = mul(OBJECT_TO_CLIP(vin), posH);
+	vout.WorldPosition = mul(OBJECT_TO_WORLD(vin), posH).xyz;
 	vout.TexCoord = vin.TexCoord;
-	vout.WorldNormal = normalize(mul(MATRIX_IT_M, float4(vin.Normal.xyz, 0.0)).xyz);
-    vout.WorldTangent.xyz = normalize(mul(MATRIX_M, float4(vin.Tangent.xyz, 0.0)).xyz);
+	vout.WorldNormal = normalize(mul(OBJECT_TO_WORLD_IT(vin), float4(vin.Normal.xyz, 0.0)).xyz);
+    vout.WorldTangent.xyz = normalize(mul(OBJECT_TO_WORLD(vin), float4(vin.Tangent.xyz, 0.0)).xyz);
     vout.WorldTangent.w = vin.Tangent.w;
 	return vout;
 }
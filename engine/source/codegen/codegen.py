@@ -6,7 +6,7 @@ tpl_fields = r'''
 // ${field.type} ${field.name} getter
 static JSValue js_fe_${T}_${field.name}_getter(JSContext *ctx, JSValueConst this_val)
 {
-    JSValue ret;
+    JS_FE_COUNT_CALL(${calls.index(T + '.' + field.name + ' get')});
     ${field.type} value;
     ${T} *self = (${T} *)JS_GetOpaque2(ctx, this_val, js_fe_${T}_class_id);
     if (!self)
@@ -16,14 +16,35 @@ static JSValue js_fe_${T}_${field.name}_getter(JSContext *ctx, JSValueConst this
 %else:
     ${field.getter}
 %endif
-    ret = JSValueFrom<${field.type}>(ctx, value);
-    return ret;
+    return ${js_from(field.type, 'value')};
 }
+%if field.type in store_types:
+// ${field.type} ${field.name} getter into argv[0]
+static JSValue js_fe_${T}_${store_name(field)}(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv)
+{
+    JS_FE_COUNT_CALL(${calls.index(T + '.' + store_name(field))});
+    ${field.type} value;
+    ${T} *self = (${T} *)JS_GetOpaque2(ctx, this_value, js_fe_${T}_class_id);
+    if (!self)
+        return JS_EXCEPTION;
+    if (argc < 1)
+        return JS_ThrowTypeError(ctx, "too few arguments");
+%if field.getter == '':
+    value = self->${field.name};
+%else:
+    ${field.getter}
+%endif
+    if (JSValueStore<${field.type}>(ctx, argv[0], value))
+        return JS_EXCEPTION;
+    return JS_DupValue(ctx, argv[0]);
+}
+%endif
 %endif
 %if field.setter is not None:
 // ${field.type} ${field.name} setter
 static JSValue js_fe_${T}_${field.name}_setter(JSContext *ctx, JSValueConst this_val, JSValue val)
 {
+    JS_FE_COUNT_CALL(${calls.index(T + '.' + field.name + ' set')});
     ${T} *self = (${T} *)JS_GetOpaque2(ctx, this_val, js_fe_${T}_class_id);
     if (!self)
         return JS_EXCEPTION;
@@ -46,20 +67,32 @@ tpl_function = r'''
 % for f in functions:
 static JSValue js_fe_${T}_${f['name']}(JSContext *ctx, JSValueConst this_value, int argc, JSValueConst *argv)
 {
+    JS_FE_COUNT_CALL(${calls.index(T + '.' + f['name'])});
 %if not f['is_static']:
     ${T} *self = (${T} *)JS_GetOpaque2(ctx, this_value, js_fe_${T}_class_id);
     if (!self)
         return JS_EXCEPTION;
 % endif
+% if len(f['params']) > 0:
 
-    if (argc != ${len(f['params'])})
-        return JS_EXCEPTION;
+    if (argc < ${len(f['params'])})
+        return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
+% endif
 % for i, p in enumerate(f['params']):
     ${p['type']} ${p['name']};
+<% owned = [q for q in f['params'][:i] if q['type'] == 'string'] %>\
+% if owned:
+    if (JSValueTo<${p['type']}>(ctx, &${p['name']}, argv[${i}])) {
+% for q in owned:
+        JSValueFree<${q['type']}>(ctx, ${q['name']});
+% endfor
+        return JS_EXCEPTION;
+    }
+% else:
     if (JSValueTo<${p['type']}>(ctx, &${p['name']}, argv[${i}]))
         return JS_EXCEPTION;
+% endif
 % endfor
 %if f['ret'] != 'void':
     ${f['ret']} ret;
@@ -74,7 +107,7 @@ static JSValue js_fe_${T}_${f['name']}(JSContext *ctx, JSValueConst this_value,
 %if f['ret'] == 'void':
     return JS_UNDEFINED;
 %else:
-    return JSValueFrom<${f['ret']}>(ctx, ret);
+    return ${js_from(f['ret'], 'ret')};
 %endif
 }
 % endfor
@@ -113,6 +146,7 @@ static JSValue js_fe_${T}_ctor(JSContext *ctx, JSValueConst new_target, int argc
     ${T} *self = NULL;
     JSValue proto;
     JSValue obj = JS_UNDEFINED;
+    JS_FE_COUNT_CALL(${calls.index(T + '.ctor')});
     
     proto = JS_GetPropertyStr(ctx, new_target, "prototype");
     if (JS_IsException(proto))
@@ -148,6 +182,11 @@ static const JSCFunctionListEntry js_fe_${T}_proto_funcs[] = {
         NULL),
 %endif
 % endfor
+% for f in fields:
+%if f.getter is not None and f.type in store_types:
+    JS_CFUNC_DEF("${store_name(f)}", 1, js_fe_${T}_${store_name(f)}),
+%endif
+% endfor
 % for f in functions:
     JS_CFUNC_DEF("${f['name']}", ${len(f['params'])}, js_fe_${T}_${f['name']}),
 % endfor
@@ -155,16 +194,20 @@ static const JSCFunctionListEntry js_fe_${T}_proto_funcs[] = {
 '''
 tpl = Template(tpl)
 
+# class ids are allocated once and the classes registered once per runtime,
+# so another context or runtime keeps the ids the first one handed out; the
+# prototypes are per context, JS_NewObjectClass takes them from there
 tpl_export = r'''
 int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 %for c in classes:
 
     {
 		JSValue proto;
-		JSClassID class_id = 0;
-		JS_NewClassID(&class_id);
-		js_fe_${c['name']}_class_id = class_id;
-		JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_${c['name']}_class);
+		if (js_fe_${c['name']}_class_id == 0)
+			JS_NewClassID(&js_fe_${c['name']}_class_id);
+		JSClassID class_id = js_fe_${c['name']}_class_id;
+		if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+			JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_${c['name']}_class);
 		proto = JS_NewObject(ctx);
 		JS_SetPropertyFunctionList(ctx, proto, js_fe_${c['name']}_proto_funcs, countof(js_fe_${c['name']}_proto_funcs));
 		JS_SetClassProto(ctx, class_id, proto);
@@ -193,6 +236,30 @@ int js_init_module_fishengine_extra(JSContext *ctx, JSModuleDef *m) {
 %endfor
     return 0;
 }
+
+// the `top` most called bindings so far, debug builds only
+void js_fe_print_binding_calls(uint32_t top) {
+#ifndef NDEBUG
+    const uint32_t *calls = js_fe_binding_calls;
+    uint32_t order[countof(js_fe_binding_names)];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < countof(js_fe_binding_names); ++i) {
+        if (calls[i] == 0)
+            continue;
+        uint32_t j = count++;
+        while (j > 0 && calls[order[j - 1]] < calls[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    if (count == 0)
+        return;
+    printf("binding calls:\n");
+    for (uint32_t i = 0; i < count && i < top; ++i)
+        printf("  %-36s %u\n", js_fe_binding_names[order[i]], calls[order[i]]);
+#endif
+}
 '''
 tpl_export = Template(tpl_export)
 
@@ -223,16 +290,66 @@ class Field:
         self.getter = getter
         self.setter = setter
 
+# scalars are made directly, the rest through JSValueFrom; uint32_t does not
+# fit in an int32
+js_new = {'float': 'JS_NewFloat64', 'int': 'JS_NewInt32',
+          'int32_t': 'JS_NewInt32', 'uint32_t': 'JS_NewInt64',
+          'Entity': 'JS_NewInt64', 'bool': 'JS_NewBool'}
+
+def js_from(type_:str, var:str):
+    if type_ in js_new:
+        return f'{js_new[type_]}(ctx, {var})'
+    return f'JSValueFrom<{type_}>(ctx, {var})'
+
+# argv of a method is padded with undefined up to its length, so only a short
+# call is checked and a longer one is fine like for any JS function.
+# vectors and matrices also get a Get<Name>(target) method that fills an
+# existing array, see JSValueStore
+store_types = ('float3', 'float4', 'quat', 'float4x4')
+
+def store_name(field):
+    return 'Get' + field.name[0].upper() + field.name[1:]
+
 import json
 with open('classes.json') as f:
     classes = json.load(f)
 
+# every binding has a call counter in debug builds, by index in `calls`
+calls = []
+for c in classes:
+    T:str = c['name']
+    if c['ctor']:
+        calls.append(T + '.ctor')
+    for x in c['properties']:
+        if x['getter'] is not None:
+            calls.append(T + '.' + x['name'] + ' get')
+            if x['type'] in store_types:
+                calls.append(T + '.' + store_name(Field(x['name'], x['type'], None, None)))
+        if x['setter'] is not None:
+            calls.append(T + '.' + x['name'] + ' set')
+    for f in c['functions'] + c['static_functions']:
+        calls.append(T + '.' + f['name'])
+
 output = r''' /* auto generated by codegen tools, do NOT modified this file directly. see engine/source/codegen*/
+#include <stdio.h>
+
 #include "jsbinding.hpp"
 extern "C" {
 extern World *defaultWorld;
 }
 
+#ifndef NDEBUG
+static const char *js_fe_binding_names[] = {
+'''
+for name in calls:
+    output += f'    "{name}",\n'
+output += r'''};
+static uint32_t js_fe_binding_calls[countof(js_fe_binding_names)];
+#define JS_FE_COUNT_CALL(i) js_fe_binding_calls[i]++
+#else
+#define JS_FE_COUNT_CALL(i)
+#endif
+
 '''
 for c in classes:
     T:str = c['name']
@@ -241,7 +358,8 @@ for c in classes:
     #     assert(f.type in 'float')
     getter_setter = ''
     if fields.count != 0:
-        getter_setter = tpl_fields.render(T=T, fields=fields)
+        getter_setter = tpl_fields.render(T=T, fields=fields, calls=calls,
+            js_from=js_from, store_types=store_types, store_name=store_name)
     function_defines = ''
     functions = c['functions']
     static_functions = c['static_functions']
@@ -251,14 +369,17 @@ for c in classes:
         for f in static_functions:
             f['is_static'] = True
         # print(functions+static_functions)
-        function_defines = tpl_function.render(T=T, functions=functions+static_functions)
+        function_defines = tpl_function.render(T=T, functions=functions+static_functions,
+            calls=calls, js_from=js_from)
     output += tpl.render(T=T, fields=fields, ctor=c['ctor'], dtor=c['dtor'], functions=functions,
-    getter_setter=getter_setter, function_defines=function_defines)
+    getter_setter=getter_setter, function_defines=function_defines, calls=calls,
+    store_types=store_types, store_name=store_name)
 
 output += r'''
 extern "C" {
 int js_init_module_fishengine_extra(JSContext *ctx, JSModuleDef *m);
 int js_fe_init_extra(JSContext *ctx, JSModuleDef *m);
+void js_fe_print_binding_calls(uint32_t top);
 }
 '''
 
@@ -271,4 +392,185 @@ with open(output_path, 'w') as f:
 print("done. write to", output_path)
 
 # import os
-# os.system('cd .. && clang-format -i jsbinding.gen.inl -style=file')
\ No newline at end of file
+# os.system('cd .. && clang-format -i jsbinding.gen.inl -style=file')
+
+# imgui module, from imgui.json
+# params: type is label (a string that is cached), string, bool, int or float;
+# "default" makes it optional, "inout" passes it by pointer and makes the JS
+# function return its new value. Every function is also an op of the command
+# buffer of imgui.Submit.
+
+imgui_to_js = {
+    'bool': 'JS_NewBool',
+    'int': 'JS_NewInt32',
+    'float': 'JS_NewFloat64',
+}
+
+# clang-format puts the statement of an if that does not fit on its own line
+def imgui_if(cond, then, indent=4):
+    line = f'if ({cond}) {then}'
+    if indent + len(line) <= 80:
+        return line
+    return f'if ({cond})\n{" " * (indent + 4)}{then}'
+
+def imgui_arg(p, i):
+    n, d = p['name'], p.get('default')
+    fail = 'return JS_EXCEPTION;'
+    if p['type'] == 'label':
+        assert d is None
+        return f'''const char *{n} = JSImGuiLabel(ctx, argv[{i}]);
+    {imgui_if(f'!{n}', fail)}'''
+    if p['type'] == 'string':
+        assert d is None
+        return f'''JSImGuiString {n}(ctx, argv[{i}]);
+    {imgui_if(f'!{n}', fail)}'''
+    if p['type'] == 'bool':
+        if d is None:
+            return f'bool {n} = JS_ToBool(ctx, argv[{i}]) > 0;'
+        return f'bool {n} = argc > {i} ? JS_ToBool(ctx, argv[{i}]) > 0 : {d};'
+    to = {'int': 'JS_ToInt32', 'float': 'JSImGuiToFloat'}[p['type']]
+    if d is None:
+        return f'''{p['type']} {n};
+    {imgui_if(f'{to}(ctx, &{n}, argv[{i}])', fail)}'''
+    return f'''{p['type']} {n} = {d};
+    {imgui_if(f'argc > {i} && {to}(ctx, &{n}, argv[{i}])', fail)}'''
+
+# the parameters packed after the parenthesis, the way clang-format does
+def imgui_signature(name):
+    head = f'static JSValue js_imgui_{name}('
+    params = ['JSContext *ctx,', 'JSValueConst this_value,', 'int argc,',
+              'JSValueConst *argv) {']
+    lines = [head + params[0]]
+    for p in params[1:]:
+        if len(lines[-1]) + 1 + len(p) <= 80:
+            lines[-1] += ' ' + p
+        else:
+            lines.append(' ' * len(head) + p)
+    return '\n'.join(lines)
+
+def imgui_word(p, i):
+    n = p['name']
+    if p['type'] in ('label', 'string'):
+        return f'''const char *{n} = JSImGuiCommandLabel(c, w[{i}]);
+            if (!{n}) return false;'''
+    return {
+        'bool': f'bool {n} = w[{i}] != 0;',
+        'int': f'int {n} = (int32_t)w[{i}];',
+        'float': f'float {n} = JSImGuiWordToFloat(w[{i}]);',
+    }[p['type']]
+
+def imgui_write_word(p, i):
+    n = p['name']
+    return {
+        'bool': f'w[{i}] = {n};',
+        'int': f'w[{i}] = (uint32_t){n};',
+        'float': f'w[{i}] = JSImGuiFloatToWord({n});',
+    }[p['type']]
+
+tpl_imgui = r'''/* auto generated by codegen tools, do NOT modified this file directly. see
+ * engine/source/codegen*/
+#include <imgui.h>
+
+#include "jsbinding_imgui.hpp"
+
+static inline int JSImGuiToFloat(JSContext *ctx, float *v, JSValueConst val) {
+    double d;
+    int ret = JS_ToFloat64(ctx, &d, val);
+    *v = (float)d;
+    return ret;
+}
+% for f in functions:
+
+${signature(f['name'])}
+% if f['required'] > 0:
+    if (argc < ${f['required']}) return JS_ThrowTypeError(ctx, "too few arguments");
+% endif
+% for i, p in enumerate(f['params']):
+    ${arg(p, i)}
+% endfor
+% if f['ret'] == 'bool' and f['inout']:
+    [[maybe_unused]] bool ret;
+% elif f['ret'] == 'bool':
+    bool ret;
+% endif
+    ${f['code']}
+% if f['inout']:
+    return ${to_js[f['inout']['type']]}(ctx, ${f['inout']['name']});
+% elif f['ret'] == 'bool':
+    return JS_NewBool(ctx, ret);
+% else:
+    return JS_UNDEFINED;
+% endif
+}
+% endfor
+
+const uint8_t js_imgui_op_words[] = {
+% for f in functions:
+    ${len(f['params']) + (1 if f['ret'] == 'bool' else 0)},  // ${f['name']}
+% endfor
+};
+const uint32_t js_imgui_op_count = ${len(functions)};
+
+bool JSImGuiRunCommand(JSImGuiCommands *c, uint32_t op) {
+    uint32_t *w = c->words + c->pos;
+    switch (op) {
+% for op, f in enumerate(functions):
+        case ${op}: {  // ${f['name']}
+% for i, p in enumerate(f['params']):
+            ${word(p, i)}
+% endfor
+% if f['ret'] == 'bool':
+            bool ret;
+% endif
+            ${f['code']}
+% for i, p in enumerate(f['params']):
+% if p.get('inout'):
+            ${write_word(p, i)}
+% endif
+% endfor
+% if f['ret'] == 'bool':
+            w[${len(f['params'])}] = ret;
+% endif
+            break;
+        }
+% endfor
+    }
+    return true;
+}
+
+static const JSCFunctionListEntry js_imgui_ops[] = {
+% for op, f in enumerate(functions):
+    JS_PROP_INT32_DEF("${f['name']}", ${op}, JS_PROP_CONFIGURABLE),
+% endfor
+};
+
+const JSCFunctionListEntry js_imgui_gen_funcs[] = {
+% for f in functions:
+    JS_CFUNC_DEF("${f['name']}", ${len(f['params'])}, js_imgui_${f['name']}),
+% endfor
+    JS_OBJECT_DEF("Op", js_imgui_ops, countof(js_imgui_ops),
+                  JS_PROP_CONFIGURABLE),
+};
+const size_t js_imgui_gen_func_count = countof(js_imgui_gen_funcs);
+'''
+tpl_imgui = Template(tpl_imgui)
+
+with open('imgui.json') as f:
+    imgui_functions = json.load(f)
+for f in imgui_functions:
+    params = f['params']
+    required = [p for p in params if 'default' not in p]
+    assert params[:len(required)] == required, f['name']
+    f['required'] = len(required)
+    inout = [p for p in params if p.get('inout')]
+    assert len(inout) <= 1, f['name']
+    f['inout'] = inout[0] if inout else None
+
+output_path = 'jsbinding_imgui.gen.cpp'
+with open(output_path, 'w') as f:
+    f.write(tpl_imgui.render(functions=imgui_functions, arg=imgui_arg,
+                             signature=imgui_signature,
+                             word=imgui_word, write_word=imgui_write_word,
+                             to_js=imgui_to_js))
+
+print("done. write to", output_path)
@@ -422,20 +422,43 @@ void StatisticsWindow(World* w, JSRuntime* rt) {
     ImGui::Text("%s", "GPU");
     uint32_t total = 0;
     ImGui::Text("    draw call: %u", g_statistics.gpu.drawCall);
+    ImGui::Text("    instanced draw call: %u",
+                g_statistics.gpu.instancedDrawCall);
+    ImGui::Text("    instances: %u", g_statistics.gpu.instanceCount);
+    ImGui::Text("    pipeline changes: %u", g_statistics.gpu.pipelineChanges);
+    ImGui::Text("    material changes: %u", g_statistics.gpu.materialChanges);
+    ImGui::Text("    mesh changes: %u", g_statistics.gpu.meshChanges);
+    ImGui::Text("    redundant binds skipped: %u",
+                g_statistics.gpu.redundantBindsSkipped);
+    ImGui::Text("    pipelines: %u (cached: %u, pending: %u)",
+                g_statistics.gpu.pipelineCount,
+                g_statistics.gpu.pipelineCacheHits,
+                g_statistics.gpu.pipelinesPending);
+    ImGui::Text("    draws skipped: %u", g_statistics.gpu.drawsSkipped);
     ImGui::Text("    buffer count: %u", g_statistics.gpu.bufferCount);
     ImGui::Text("    buffer size: %.2f MB", MB(g_statistics.gpu.bufferSize));
     total += g_statistics.gpu.bufferSize;
     ImGui::Text("    texture count: %u", g_statistics.gpu.textureCount);
     ImGui::Text("    texture size: %.2f MB", MB(g_statistics.gpu.textureSize));
+    ImGui::Text("    bindless textures: %u",
+                g_statistics.gpu.bindlessTextureCount);
     total += g_statistics.gpu.textureSize;
     ImGui::Text("    rt count: %u", g_statistics.gpu.renderTextureCount);
     ImGui::Text("    rt size: %.2f MB", MB(g_statistics.gpu.renderTextureSize));
     total += g_statistics.gpu.renderTextureSize;
     ImGui::Text("    total: %.2f MB", MB(total));
+    ImGui::Text("    dynamic upload: %.2f KB",
+                g_statistics.gpu.dynamicUploadSize / 1024.0);
+    ImGui::Text("    static upload: %.2f KB",
+                g_statistics.gpu.staticUploadSize / 1024.0);
     ImGui::Separator();
 
     uint32_t total2 = 0;
     ImGui::Text("%s", "CPU");
+    ImGui::Text("    visible renderables: %u",
+                g_statistics.cpu.visibleRenderables);
+    ImGui::Text("    culled renderables: %u",
+                g_statistics.cpu.culledRenderables);
     ImGui::Text("    vb: %.2f MB", MB(g_statistics.cpu.vertexBufferSize));
     total2 += g_statistics.cpu.vertexBufferSize;
     ImGui::Text("    ib: %.2f MB", MB(g_statistics.cpu.indexBufferSize));
@@ -446,6 +469,13 @@ void StatisticsWindow(World* w, JSRuntime* rt) {
     ImGui::Text("    upload heap: %.2f MB",
         MB(g_statistics.cpu.uploadHeapSize));
     total2 += g_statistics.cpu.uploadHeapSize;
+    ImGui::Text("    frame alloc: %.2f MB, peak %.2f MB, %u blocks",
+                MB(g_statistics.cpu.frameAllocSize),
+                MB(g_statistics.cpu.frameAllocPeak),
+                g_statistics.cpu.frameAllocBlockCount);
+#ifndef NDEBUG
+    ImGui::Text("    heap allocations: %u", g_statistics.cpu.heapAllocations);
+#endif
     ImGui::Text("    total: %.2f MB", MB(total2));
     ImGui::Separator();
 
@@ -460,6 +490,16 @@ void StatisticsWindow(World* w, JSRuntime* rt) {
     ImGui::Text("    malloc size: %.2f MB", MB(usage.malloc_size));
     ImGui::Text("    memory used count: %lld", usage.memory_used_count);
     ImGui::Text("    memory used size: %.2f MB", MB(usage.memory_used_size));
+    ImGui::Text("    script time: %.2f ms, gc %.2f ms",
+                g_statistics.cpu.scriptTimeUs / 1000.0,
+                g_statistics.cpu.scriptGCTimeUs / 1000.0);
+    ImGui::Text("    heap: %.2f MB, %u objects",
+                MB(g_statistics.cpu.scriptHeapSize),
+                g_statistics.cpu.scriptObjectCount);
+    ImGui::Text("    allocations: %u, %.2f KB, freed %.2f KB",
+                g_statistics.cpu.scriptAllocations,
+                g_statistics.cpu.scriptAllocatedSize / 1024.0,
+                g_statistics.cpu.scriptFreedSize / 1024.0);
     ImGui::Separator();
 
     ImGui::Text("Total: %.2f MB", MB(total + total2 + usage.malloc_size));
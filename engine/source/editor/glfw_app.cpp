@@ -73,7 +73,10 @@ void glfw_scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     SingletonInputUpdateAxis(si, AxisMouseScrollWheel, yoffset);
 }
 
+static float g_AspectRatio = 1280.f / 800.f;
+
 static void glfw_resize_callback(GLFWwindow* window, int width, int height) {
+    if (width > 0 && height > 0) g_AspectRatio = (float)width / height;
     WaitForLastSubmittedFrame();
     ImGui_ImplDX12_InvalidateDeviceObjects();
     CleanupRenderTarget();
@@ -94,6 +97,13 @@ static void glfw_resize_callback(GLFWwindow* window, int width, int height) {
         .type = T##ID, .name = #T, .size = sizeof(T), .ctor = NULL, \
         .dtor = NULL,                                               \
     }
+// components holding pointers, saved by WorldSerialize through their hooks
+#define COMP3(T, free)                                                 \
+    {                                                                  \
+        .type = T##ID, .name = #T, .size = sizeof(T), .ctor = T##Init, \
+        .dtor = free, .save = T##Save, .load = T##Load,                \
+        .check = T##Check,                                             \
+    }
 
 #include <transform.h>
 #include <renderable.h>
@@ -104,10 +114,17 @@ static void glfw_resize_callback(GLFWwindow* window, int width, int height) {
 #include <input.h>
 #include <singleton_time.h>
 #include <singleton_selection.h>
-
-static ComponentDef g_componentDef[] = { COMP(Transform), COMP(Renderable),
-                                        COMP(Camera),    COMP(Light),
-                                        COMP(Animation), COMP(FreeCamera) };
+#include <render_queue.h>
+#include <jobs.h>
+#include <asset.h>
+#include <frame_alloc.h>
+#include <log.h>
+#include <script_worker.h>
+
+static ComponentDef g_componentDef[] = {
+    COMP(Transform), COMP3(Renderable, NULL),
+    COMP(Camera),    COMP(Light),
+    COMP3(Animation, AnimationFree), COMP(FreeCamera) };
 
 static ComponentDef g_singleComponentDef[] = {
     COMP(SingletonTransformManager), COMP(SingletonInput),
@@ -115,28 +132,9 @@ static ComponentDef g_singleComponentDef[] = {
 
 
 void RenderSystem(World* w) {
-    ComponentArray* a = w->componentArrays + RenderableID;
-    uint32_t size = a->m.size;
-    Renderable* r = (Renderable*)a->m.ptr;
-    for (int i = 0; i < size; ++i, ++r) {
-        if (r->mesh && !MeshIsUploaded(r->mesh)) {
-            MeshUploadMeshData(r->mesh);
-        }
-    }
-    r = (Renderable*)a->m.ptr;
-    for (int i = 0; i < size; ++i, ++r) {
-        if (r->skin) {
-            RenderableUpdateBones(r, w);
-            GPUSkinning(r);
-        }
-    }
-    r = (Renderable*)a->m.ptr;
-    BeginPass();
-    for (int i = 0; i < size; ++i, ++r) {
-        Transform* t =
-            (Transform *)ComponentGetSiblingComponent(w, r, RenderableID, TransformID);
-        SimpleDraw(t, r);
-    }
+    static RenderQueue queue;
+    if (queue.packets.ptr == NULL) RenderQueueInit(&queue);
+    RenderQueueRenderWorld(&queue, w, g_AspectRatio);
 }
 
 
@@ -145,6 +143,7 @@ int GLFWApp::Init()
     // Setup window
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit()) return 1;
+    JobSystemInit(UINT32_MAX);
 
     // Create window with graphics context
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -201,9 +200,19 @@ int GLFWApp::Init()
     def.singletonComponentDefCount = countof(g_singleComponentDef);
 
     m_EditorWorld = WorldCreate(&def);
-    WorldAddSystem(m_EditorWorld, AnimationSystem);
-    WorldAddSystem(m_EditorWorld, FreeCameraSystem);
-    WorldAddSystem(m_EditorWorld, RenderSystem);
+    // what they touch, so that script systems are scheduled between them
+    const uint64_t transform = ComponentBit(TransformID);
+    WorldAddSystemWithAccess(m_EditorWorld, AnimationSystem,
+                             ComponentBit(AnimationID) | transform,
+                             ComponentBit(AnimationID) | transform);
+    WorldAddSystemWithAccess(m_EditorWorld, FreeCameraSystem,
+                             ComponentBit(FreeCameraID) | transform,
+                             ComponentBit(FreeCameraID) | transform);
+    WorldAddSystemWithAccess(
+        m_EditorWorld, RenderSystem,
+        transform | ComponentBit(RenderableID) | ComponentBit(CameraID) |
+            ComponentBit(LightID) | ComponentBit(AnimationID),
+        0);
     WorldPrintStats(m_EditorWorld);
 
     app_init(m_EditorWorld);
@@ -262,7 +271,15 @@ void GLFWApp::Run()
     ImGui_ImplGlfw_NewFrame();
     ImGui::DestroyContext();
 
+    // free the gpu side of all assets while the device is alive, so that
+    // CleanupDeviceD3D only reports real leaks
+    AssetDeleteAll();
     CleanupDeviceD3D();
     glfwDestroyWindow(m_Window);
     glfwTerminate();
+    ScriptWorkersShutdown();
+    // the records still in the ring, the last script errors among them
+    LogShutdown();
+    FrameAllocShutdown();
+    JobSystemShutdown();
 }
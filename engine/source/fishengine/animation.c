@@ -69,7 +69,7 @@ quat AnimationCurveEvaluateQuat(AnimationCurve *curve, float time,
 
 void AnimationPlay(World *w, Animation *a) {
     for (int i = 0; i < a->clips.size; ++i) {
-        AnimationClip *clip = array_at(&a->clips, i);
+        AnimationClip *clip = *(AnimationClip **)array_at(&a->clips, i);
         for (int j = 0; j < clip->curves.size; ++j) {
             AnimationCurve *curve = array_at(&clip->curves, j);
             if (curve->type == AnimationCurveTypeTranslation ||
@@ -109,7 +109,7 @@ AnimationClip *AnimationClipNew() {
     clip->length = 0;
     clip->frameRate = 0;
     array_init(&clip->curves, sizeof(AnimationCurve), 4);
-    AssetAdd(AssetTypeAnimationClip, clip);
+    clip->assetID = AssetAdd(AssetTypeAnimationClip, clip);
     return clip;
 }
 
@@ -140,12 +140,54 @@ void AnimationInit(void *_a) {
     a->playing = false;
 }
 
+void AnimationFree(void *_a) {
+    Animation *a = _a;
+    array_free(&a->clips);
+}
+
+// the clips array is replaced by the offset of their ids in `extra`
+void AnimationSave(void *_a, array *extra) {
+    Animation *a = _a;
+    const uint32_t offset = extra->size;
+    AssetID *ids = WorldSnapshotAppend(extra, a->clips.size * sizeof(AssetID));
+    AnimationClip **clips = a->clips.ptr;
+    for (uint32_t i = 0; i < a->clips.size; ++i) ids[i] = clips[i]->assetID;
+    a->clips.ptr = (void *)(uintptr_t)offset;
+    a->clips.capacity = a->clips.size;
+}
+
+bool AnimationCheck(const void *_a, const uint8_t *extra,
+                    uint32_t extraSize) {
+    const Animation *a = _a;
+    const uintptr_t offset = (uintptr_t)a->clips.ptr;
+    const uint32_t count = a->clips.size;
+    if (offset > extraSize || offset % sizeof(AssetID) != 0 ||
+        count > (extraSize - offset) / sizeof(AssetID))
+        return false;
+    const AssetID *ids = (const AssetID *)(extra + offset);
+    for (uint32_t i = 0; i < count; ++i) {
+        const Asset *asset = AssetGet(ids[i]);
+        if (asset == NULL || asset->type != AssetTypeAnimationClip)
+            return false;
+    }
+    return true;
+}
+
+// after AnimationCheck
+void AnimationLoad(void *_a, const uint8_t *extra) {
+    Animation *a = _a;
+    const uint32_t size = a->clips.size;
+    const AssetID *ids = (const AssetID *)(extra + (uintptr_t)a->clips.ptr);
+    array_init(&a->clips, sizeof(AnimationClip *), size > 4 ? size : 4);
+    for (uint32_t i = 0; i < size; ++i)
+        *(AnimationClip **)array_push(&a->clips) = AssetGet(ids[i])->ptr;
+}
+
 #define _MAX(a, b) (a) > (b) ? (a) : (b)
 
 void AnimationAddClip(Animation *animation, AnimationClip *clip) {
     if (clip == NULL) return;
-    AnimationClip *_clip = array_push(&animation->clips);
-    *_clip = *clip;
+    *(AnimationClip **)array_push(&animation->clips) = clip;
     animation->length = _MAX(animation->length, clip->length);
 }
 
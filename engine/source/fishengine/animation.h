@@ -4,6 +4,7 @@
 #include <stdbool.h>
 
 #include "array.h"
+#include "asset.h"
 #include "ecs.h"
 #include "simd_math.h"
 
@@ -52,6 +53,7 @@ struct AnimationClip {
     float frameRate;
     float length;  // Animation length in seconds.
     array curves;  // std::vector<AnimationCurve>
+    AssetID assetID;
 };
 typedef struct AnimationClip AnimationClip;
 
@@ -62,7 +64,7 @@ AnimationCurve *AnimaitonClipGetCurve(AnimationClip *clip, uint32_t curveIndex);
 struct Animation {
     double localTime;
     float length;
-    array clips;  // std::vector<AnimationClip>
+    array clips;  // AnimationClip*, the assets
     bool playing;
 
     Entity entityOffset;
@@ -71,6 +73,12 @@ struct Animation {
 typedef struct Animation Animation;
 
 void AnimationInit(void *a);
+void AnimationFree(void *a);
+// for WorldSerialize: the clips go in the snapshot as asset ids
+void AnimationSave(void *a, array *extra);
+void AnimationLoad(void *a, const uint8_t *extra);
+// false if the ids are not all in `extra` or not all clips
+bool AnimationCheck(const void *a, const uint8_t *extra, uint32_t extraSize);
 void AnimationAddClip(Animation *animation, AnimationClip *clip);
 void AnimationPlay(World *w, Animation *a);
 
@@ -16,9 +16,15 @@
 #include "input.h"
 #include "jsbinding.h"
 #include "light.h"
+#include "log.h"
 #include "mesh.h"
 #include "renderable.h"
 #include "rhi.h"
+#include "script.h"
+#include "script_gc.h"
+#include "script_profiler.h"
+#include "script_worker.h"
+#include "shader.h"
 #include "singleton_time.h"
 #include "singleton_selection.h"
 #include "statistics.h"
@@ -46,119 +52,44 @@
 
 #include "jsbinding.h"
 
-static char string_buffer[2048];
-static int offset = 0;
-static void safe_puts(const char *s) {
-    char *p = string_buffer + offset;
-    offset += snprintf(p, 2048 - offset, "%s", s);
-}
+// looked up once by app_init, before any script runs
+static uint16_t g_scriptLog, g_worldLog;
 
-static JSValue fe_js_print(JSContext *ctx, JSValueConst this_val, int argc,
-                           JSValueConst *argv) {
-    int i;
-    const char *str;
-
-    for (i = 0; i < argc; i++) {
-        if (i != 0)
-            //            putchar(' ');
-            //			sprintf(string_buffer, " ");
-            safe_puts(" ");
-        str = JS_ToCString(ctx, argv[i]);
-        if (!str) return JS_EXCEPTION;
-        //        fputs(str, stdout);
-        safe_puts(str);
+static void fe_js_append_string(JSContext *ctx, DynBuf *b, JSValueConst v) {
+    const char *str = JS_ToCString(ctx, v);
+    if (str) {
+        dbuf_putstr(b, str);
         JS_FreeCString(ctx, str);
+    } else {
+        // the conversion threw
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        dbuf_putstr(b, "[exception]");
     }
-    //    putchar('\n');
-    safe_puts("\n");
-    return JS_UNDEFINED;
 }
 
-static void fe_js_std_dump_error1(JSContext *ctx, JSValueConst exception_val,
-                                  BOOL is_throw) {
-    JSValue val;
-    const char *stack;
-    BOOL is_error;
-
-    is_error = JS_IsError(ctx, exception_val);
-    if (is_throw && !is_error)
-        //        printf("Throw: ");
-        //		sprintf(string_buffer, "Throw: ");
-        safe_puts("Throw: ");
-    fe_js_print(ctx, JS_NULL, 1, (JSValueConst *)&exception_val);
+// the exception and its stack as one error record, however long the stack;
+// from any thread
+void fe_js_dump_error(JSContext *ctx) {
+    JSValue exception_val = JS_GetException(ctx);
+    const bool is_error = JS_IsError(ctx, exception_val);
+    DynBuf b;
+    dbuf_init(&b);
+    if (!is_error) dbuf_putstr(&b, "Throw: ");
+    fe_js_append_string(ctx, &b, exception_val);
     if (is_error) {
-        val = JS_GetPropertyStr(ctx, exception_val, "stack");
-        if (!JS_IsUndefined(val)) {
-            stack = JS_ToCString(ctx, val);
-            //            printf("%s\n", stack);
-            //			sprintf(string_buffer, "%s\n", stack);
-            safe_puts(stack);
-            safe_puts("\n");
-            JS_FreeCString(ctx, stack);
+        JSValue stack = JS_GetPropertyStr(ctx, exception_val, "stack");
+        if (!JS_IsUndefined(stack)) {
+            dbuf_putc(&b, '\n');
+            fe_js_append_string(ctx, &b, stack);
         }
-        JS_FreeValue(ctx, val);
+        JS_FreeValue(ctx, stack);
     }
-}
-
-void fe_js_dump_error(JSContext *ctx) {
-    JSValue exception_val;
-
-    offset = 0;
-    exception_val = JS_GetException(ctx);
-    fe_js_std_dump_error1(ctx, exception_val, TRUE);
+    // the line ends there
+    while (b.size > 0 && b.buf[b.size - 1] == '\n') b.size--;
+    dbuf_putc(&b, '\0');
+    LogWrite(LogLevelError, g_scriptLog, (const char *)b.buf);
+    dbuf_free(&b);
     JS_FreeValue(ctx, exception_val);
-    log_error(string_buffer);
-}
-
-static int eval_buf(JSContext *ctx, const void *buf, int buf_len,
-                    const char *filename, int eval_flags) {
-    JSValue val;
-    int ret;
-
-    if ((eval_flags & JS_EVAL_TYPE_MASK) == JS_EVAL_TYPE_MODULE) {
-        /* for the modules, we compile then run to be able to set
-           import.meta */
-        val = JS_Eval(ctx, buf, buf_len, filename,
-                      eval_flags | JS_EVAL_FLAG_COMPILE_ONLY);
-        if (!JS_IsException(val)) {
-            js_module_set_import_meta(ctx, val, TRUE, TRUE);
-            val = JS_EvalFunction(ctx, val);
-        }
-    } else {
-        val = JS_Eval(ctx, buf, buf_len, filename, eval_flags);
-    }
-    if (JS_IsException(val)) {
-        fe_js_dump_error(ctx);
-        ret = -1;
-    } else {
-        ret = 0;
-    }
-    JS_FreeValue(ctx, val);
-    return ret;
-}
-
-static int eval_file(JSContext *ctx, const char *filename, int module) {
-    uint8_t *buf;
-    int ret, eval_flags;
-    size_t buf_len;
-
-    buf = js_load_file(ctx, &buf_len, filename);
-    if (!buf) {
-        perror(filename);
-        exit(1);
-    }
-
-    if (module < 0) {
-        module = (has_suffix(filename, ".mjs") ||
-                  JS_DetectModule((const char *)buf, buf_len));
-    }
-    if (module)
-        eval_flags = JS_EVAL_TYPE_MODULE;
-    else
-        eval_flags = JS_EVAL_TYPE_GLOBAL;
-    ret = eval_buf(ctx, buf, buf_len, filename, eval_flags);
-    js_free(ctx, buf);
-    return ret;
 }
 
 static World *w = NULL;
@@ -168,6 +99,8 @@ static JSRuntime *rt = NULL;
 static JSContext *ctx = NULL;
 
 static bool g_reload = false;
+// set by fe.reload(), see app_free_handlers_deferred
+static bool g_freeHandlers = false;
 #ifdef APPLE
 #include <constants.h>
 static fse_watcher_t g_watcher;
@@ -192,99 +125,71 @@ struct Application {
 
 struct Application g_app = {.is_playing = false};
 
-#if WIN32
-#define _SEP '\\'
-static char *js_module_normalize_name(JSContext *ctx, const char *base_name,
-                                      const char *name, void *opaque) {
-    char *filename, *p;
-    const char *r;
-    int len;
-
-    if (name[0] != '.') {
-        /* if no initial dot, the module name is not modified */
-        return js_strdup(ctx, name);
-    }
+const char *ApplicationFilePath();
 
-    p = strrchr(base_name, _SEP);
-    if (p)
-        len = p - base_name;
-    else
-        len = 0;
-
-    filename = js_malloc(ctx, len + strlen(name) + 1 + 1);
-    if (!filename) return NULL;
-    memcpy(filename, base_name, len);
-    filename[len] = '\0';
-
-    /* we only normalize the leading '..' or '.' */
-    r = name;
-    // for (;;) {
-    //    if (r[0] == '.' && (r[1] == _SEP || r[1] == '/')) {
-    //        r += 2;
-    //    } else if (r[0] == '.' && r[1] == '.' &&
-    //               (r[1] == _SEP || r[1] == '/')) {
-    //        /* remove the last path element of filename, except if "."
-    //           or ".." */
-    //        if (filename[0] == '\0') break;
-    //        p = strrchr(filename, _SEP);
-    //        if (!p)
-    //            p = filename;
-    //        else
-    //            p++;
-    //        if (!strcmp(p, ".") || !strcmp(p, "..")) break;
-    //        if (p > filename) p--;
-    //        *p = '\0';
-    //        r += 3;
-    //    } else {
-    //        break;
-    //    }
-    //}
-    if (filename[0] != '\0') strcat(filename, "\\");
-    strcat(filename, r);
-    //    printf("normalize: %s %s -> %s\n", base_name, name, filename);
-    return filename;
+void app_set_script(const char *script) { path = script; }
+
+// wall clock, clock() adds up the time of all threads
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
-#endif
 
-const char *ApplicationFilePath();
+static void eval_script(const char *what, double start, uint32_t renamed) {
+    if (ScriptEvalModule(ctx, path) < 0) fe_js_dump_error(ctx);
+    const ScriptStats stats = ScriptResetStats();
+    char reloaded[32] = "";
+    if (renamed > 0)
+        snprintf(reloaded, sizeof(reloaded), ", %u reloaded", renamed);
+    LogWriteF(LogLevelInfo, g_scriptLog,
+              "%s %.1f ms: %u modules compiled, %u from the cache%s", what,
+              (Now() - start) * 1000, stats.compiled, stats.cached, reloaded);
+}
 
 int app_init(World *initWorld) {
     debug_init();
+    g_scriptLog = LogCategory("script");
+    g_worldLog = LogCategory("world");
+    // pack.py puts it next to the binaries
+    LoadShaderArchive(ApplicationFilePath());
 
-    clock_t start, end;
-    double duration;
-    start = clock();
+    const double start = Now();
 
-    rt = JS_NewRuntime();
+    rt = ScriptProfilerNewRuntime();
+    ScriptGCInit(rt);
     ctx = JS_NewContext(rt);
     js_std_add_helpers(ctx, 0, NULL);
     js_init_module_os(ctx, "os");
     js_init_module_std(ctx, "std");
 
-#if WIN32
-    JS_SetModuleLoaderFunc(rt, js_module_normalize_name, js_module_loader,
+    // compiled modules next to the entry script
+    char cacheDirectory[512];
+    const char *slash = strrchr(path, '/');
+    const char *backslash = strrchr(path, '\\');
+    if (backslash && (!slash || backslash > slash)) slash = backslash;
+    if (slash)
+        snprintf(cacheDirectory, sizeof(cacheDirectory), "%.*s/.jscache",
+                 (int)(slash - path), path);
+    else
+        snprintf(cacheDirectory, sizeof(cacheDirectory), ".jscache");
+    ScriptCacheSetDirectory(cacheDirectory);
+    ScriptReset();
+    JS_SetModuleLoaderFunc(rt, ScriptModuleNormalize, ScriptModuleLoader,
                            NULL);
-#else
-    JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
-#endif
 
     w = initWorld;
     SetDefaultWorld(w);
     js_init_module_fishengine(ctx, "FishEngine");
     js_init_module_imgui(ctx, "imgui");
 
-    int flags = JS_EVAL_TYPE_MODULE;
-    eval_file(ctx, path, flags);
+    eval_script("startup", start, 0);
 
 #ifdef APPLE
     fse_init();
     g_watcher = fse_alloc();
     fse_watch(path, OnFileChanged, NULL, NULL, NULL, g_watcher);
 #endif
-
-    end = clock();
-    duration = (double)(end - start) / CLOCKS_PER_SEC;
-    printf("time: %lfs\n", duration);
     return 0;
 }
 
@@ -301,43 +206,36 @@ int app_reload() {
     return 0;
 }
 
+// the runtime stays, only the modules that changed and the ones importing
+// them are loaded again, then the entry script runs again
 int app_reload2() {
+    const double start = Now();
     debug_clear_all();
     js_fishengine_free_handlers(rt);
-    js_std_free_handlers(rt);
-    JS_FreeContext(ctx);
-    JS_FreeRuntime(rt);
-
-    rt = JS_NewRuntime();
-    ctx = JS_NewContext(rt);
-    js_std_add_helpers(ctx, 0, NULL);
-    js_init_module_os(ctx, "os");
-    js_init_module_std(ctx, "std");
-
-    JSModuleNormalizeFunc *module_normalize = NULL;
-#if WIN32
-    module_normalize = js_module_normalize_name;
-#endif
-    JS_SetModuleLoaderFunc(rt, module_normalize, js_module_loader, NULL);
-
-    js_init_module_fishengine(ctx, "FishEngine");
-    js_init_module_imgui(ctx, "imgui");
-
-    int flags = JS_EVAL_TYPE_MODULE;
-    eval_file(ctx, path, flags);
+    const uint32_t renamed = ScriptInvalidateChanged();
+    eval_script("reload", start, renamed);
     app_reload();
+    // the old scene is garbage now, collected at the end of this frame
+    ScriptGCRequestFull();
     return 0;
 }
 
+// fe.reload() is called from renderUI, while the imgui labels handed out in
+// the frame are still in use; the handlers go at the next app_update
+void app_free_handlers_deferred() { g_freeHandlers = true; }
+
 int app_update() {
     if (g_reload) {
-        debug_clear_all();
-        js_fishengine_free_handlers(rt);
-        int flags = JS_EVAL_TYPE_MODULE;
-        eval_file(ctx, path, flags);
-        app_reload();
+        app_reload2();
         g_reload = false;
+    } else if (g_freeHandlers) {
+        js_fishengine_free_handlers(rt);
     }
+    g_freeHandlers = false;
+    // what the workers posted since the last frame
+    ScriptProfilerBegin(ctx, "onmessage");
+    ScriptWorkersDispatch(ctx);
+    ScriptProfilerEnd();
     WorldTick(w);
     return 0;
 }
@@ -345,6 +243,10 @@ int app_update() {
 int app_frame_end() {
     // SingletonInput *si = WorldGetSingletonComponent(w, SingletonInputID);
     InputSystemPostUpdate(w);
+    // after the frame is submitted, collecting does not stall a script
+    ScriptGCFrameEnd(rt);
+    ScriptProfilerFrameEnd(rt);
+    return 0;
 }
 
 int app_render_ui() {
@@ -353,10 +255,13 @@ int app_render_ui() {
         JSValue global_obj = JS_GetGlobalObject(ctx);
         JSValue renderUI = JS_GetPropertyStr(ctx, global_obj, "renderUI");
         if (JS_IsFunction(ctx, renderUI)) {
+            ScriptProfilerBegin(ctx, "renderUI");
             JSValue ret = JS_Call(ctx, renderUI, JS_UNDEFINED, 0, NULL);
+            ScriptProfilerEnd();
             if (JS_IsException(ret)) {
                 fe_js_dump_error(ctx);
             }
+            JS_FreeValue(ctx, ret);
         }
         JS_FreeValue(ctx, renderUI);
         JS_FreeValue(ctx, global_obj);
@@ -365,11 +270,36 @@ int app_render_ui() {
     return 0;
 }
 
+// the world as it was when play mode was entered, put back when it is left
+static array g_playSnapshot = {.stride = 1};
+
 void app_play() {
+    if (!g_app.is_playing) {
+        const double start = Now();
+        g_playSnapshot.size = 0;
+        WorldSerialize(w, &g_playSnapshot);
+        LogWriteF(LogLevelInfo, g_worldLog,
+                  "snapshot of %u KB in %.2f ms", g_playSnapshot.size >> 10,
+                  (Now() - start) * 1000);
+    }
     g_app.is_playing = true;
     g_app.is_paused = false;
 }
 void app_stop() {
+    if (g_app.is_playing) {
+        const double start = Now();
+        // the devices did not go back in time
+        SingletonInput *si = WorldGetSingletonComponent(w, SingletonInputID);
+        const SingletonInput input = *si;
+        if (WorldDeserialize(w, g_playSnapshot.ptr, g_playSnapshot.size)) {
+            *si = input;
+            LogWriteF(LogLevelInfo, g_worldLog,
+                      "restored in %.2f ms", (Now() - start) * 1000);
+        } else {
+            LogWrite(LogLevelError, g_worldLog,
+                     "the snapshot taken when entering play mode is invalid");
+        }
+    }
     g_app.is_playing = false;
     g_app.is_paused = false;
 }
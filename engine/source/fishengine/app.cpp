@@ -1,7 +1,8 @@
 #include "app.h"
-#include <fmt/format.h>
 #include <assert.h>
-#include "fs.hpp"
+#include <stdio.h>
+#include <filesystem>
+#include "texture_encoder.h"
 
 extern "C" {
 bool ConvertToDDS(const char *path);
@@ -11,15 +12,20 @@ bool ConvertToDDS(const char *path) {
     std::filesystem::path p(path);
     p = p.lexically_normal();
     assert(std::filesystem::exists(p));
-    const auto dir = p.parent_path();
+    auto dds = p;
+    dds.replace_extension(".dds");
 
-    std::filesystem::path texconv = ApplicationFilePath();
-    texconv = texconv / "texconv.exe";
-    texconv = texconv.lexically_normal();
-    assert(std::filesystem::exists(texconv));
-    const auto cmd = fmt::format(R"({} -pow2 -f BC1_UNORM -y -o "{}" "{}")",
-                                 texconv.string(), dir.string(), p.string());
-    puts(cmd.c_str());
-    int ret = system(cmd.c_str());
-    return ret == 0;
-}
\ No newline at end of file
+    // BC7 keeps the alpha channel and has far less block artifacts than BC1
+    TextureEncodeSettings settings;
+    settings.format = TextureFormatBC7;
+    settings.quality = TextureEncodeQualityNormal;
+    settings.mipmaps = true;
+    const char *error = nullptr;
+    const auto result = TextureEncodeFile(
+        p.string().c_str(), dds.string().c_str(), &settings, &error);
+    if (result == TextureEncodeError) {
+        printf("[texture encoder] %s: %s\n", p.string().c_str(), error);
+        return false;
+    }
+    return true;
+}
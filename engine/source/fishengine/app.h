@@ -8,9 +8,12 @@
 extern "C" {
 #endif
 
+// entry module evaluated by app_init and the reloads
+void app_set_script(const char *script);
 int app_init(World *initWorld);
 int app_reload();
 int app_reload2();
+void app_free_handlers_deferred();
 int app_update();
 int app_frame_end();
 int app_render_ui();
@@ -2,6 +2,8 @@
 
 #include <string.h>
 
+#include "statistics.h"
+
 #if WIN32
 #ifndef aligned_alloc
 #define aligned_alloc(alignment, size) _aligned_malloc(size, alignment)
@@ -20,12 +22,14 @@ void array_init(array *a, uint32_t stride, uint32_t capacity) {
     a->size = 0;
     const size_t size = stride * capacity;
     a->ptr = aligned_alloc(16, size);
+    count_heap_allocation();
     memset(a->ptr, 0, size);
 }
 
 void array_reserve(array *a, uint32_t new_capacity) {
     if (new_capacity <= a->capacity) return;
     void *ptr = aligned_alloc(16, a->stride * new_capacity);
+    count_heap_allocation();
     void *old_ptr = a->ptr;
     if (a->ptr) {
         memcpy(ptr, old_ptr, a->size * a->stride);
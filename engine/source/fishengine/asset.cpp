@@ -122,8 +122,6 @@ Asset *AssetGet2(AssetType type, uint32_t idx) { return g.Get2(type, idx); }
 void AssetDelete(AssetID aid) { g.Delete(aid); }
 void AssetDeleteAll() { g.DeleteAll(); }
 
-#include <microtar.h>
-
 bool string_end_with(const char *str, const char *end) {
     if (!str || !end) return false;
     size_t len1 = strlen(str);
@@ -152,76 +150,6 @@ void string_combine1(char *dst, const char *src1, size_t src1_len,
 
 #include "shader.h"
 
-bool ShaderDescFromTAR(const char *name_prefix, mtar_t *tar,
-                       ShaderDesc *out_desc) {
-    char name[512];
-    mtar_header_t h1, h2;
-    void *p1 = NULL;
-    char *p2 = NULL;
-
-    string_combine(name, name_prefix, ".cso");
-    int ret = mtar_find(tar, name, &h1);
-    if (ret) return false;
-    p1 = malloc(h1.size);
-    ret = mtar_read_data(tar, p1, h1.size);
-    if (ret) goto FAIL;
-
-    string_combine(name, name_prefix, ".reflect.json");
-    ret = mtar_find(tar, name, &h2);
-    if (ret) goto FAIL;
-    p2 = (char *)malloc(h2.size + 1);
-    p2[h2.size] = '\0';
-    ret = mtar_read_data(tar, p2, h2.size);
-    if (ret) goto FAIL;
-
-    // puts((char *)p2);
-
-    out_desc->bytes.byteLength = h1.size;
-    out_desc->bytes.buffer = p1;
-    out_desc->reflectJson.byteLength = h2.size;
-    out_desc->reflectJson.buffer = p2;
-    return true;
-FAIL:
-    free(p1);
-    free(p2);
-    return false;
-}
-
-void LoadTAR(const char *path) {
-    char tarPath[512];
-    tarPath[0] = '\0';
-    strcat(tarPath, path);
-    strcat(tarPath, "/shaders.tar");
-
-    std::vector<std::string> hlsls;
-
-    mtar_t tar;
-    mtar_header_t h;
-    mtar_open(&tar, tarPath, "r");
-    while ((mtar_read_header(&tar, &h)) != MTAR_ENULLRECORD) {
-        // printf("%s (%d bytes)\n", h.name, h.size);
-        if (string_end_with(h.name, ".hlsl")) hlsls.push_back(h.name);
-        mtar_next(&tar);
-    }
-
-    char name[512];
-    for (auto &_h_name : hlsls) {
-        const char *h_name = _h_name.c_str();
-        size_t pos = strlen(h_name) - strlen(".hlsl");
-        ShaderDesc vs, ps;
-        string_combine1(name, h_name, pos, "_vs");
-        bool ret = ShaderDescFromTAR(name, &tar, &vs);
-        if (ret) {
-            string_combine1(name, h_name, pos, "_ps");
-            ret = ShaderDescFromTAR(name, &tar, &ps);
-        }
-        if (ret) {
-            // ShaderFromMemory(&vs, &ps);
-        }
-    }
-    mtar_close(&tar);
-}
-
 struct AssetBundleImpl {
     std::map<int, Asset> assets;
 };
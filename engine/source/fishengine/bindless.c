@@ -0,0 +1,57 @@
+#include "bindless.h"
+
+#include <stdio.h>
+
+void BindlessTableInit(BindlessTable *t, uint32_t capacity) {
+    HandlePoolInit(&t->slots, "bindless");
+    t->capacity = capacity;
+    t->peakCount = 0;
+    // handle pools never hand out slot 0, it stays BindlessMissingTexture
+}
+
+void BindlessTableFree(BindlessTable *t) {
+    HandlePoolFree(&t->slots);
+    t->capacity = 0;
+}
+
+uint32_t BindlessTableAlloc(BindlessTable *t) {
+    // recycled slots come first, so the table only grows when all slots
+    // handed out so far are alive or still in flight
+    if (t->slots.freeList.size == 0 &&
+        HandlePoolGetSlotCount(&t->slots) >= t->capacity) {
+        printf("[bindless] texture table is full (%u slots)\n", t->capacity);
+        return 0;
+    }
+    uint32_t handle = HandlePoolAlloc(&t->slots);
+    if (t->slots.liveCount > t->peakCount) t->peakCount = t->slots.liveCount;
+    return handle;
+}
+
+void BindlessTableRelease(BindlessTable *t, uint32_t handle, uint64_t frame) {
+    HandlePoolRelease(&t->slots, handle, frame);
+}
+
+uint32_t BindlessTableCollect(BindlessTable *t, uint64_t completedFrame) {
+    return HandlePoolCollect(&t->slots, completedFrame, NULL, NULL);
+}
+
+void BindlessSamplerKey(uint32_t index, FilterMode *filter,
+                        TextureWrapMode *wrapU, TextureWrapMode *wrapV,
+                        TextureWrapMode *wrapW) {
+    assert(index < BindlessSamplerCount);
+    uint32_t n = _TextureWrapModeCount;
+    *wrapW = (TextureWrapMode)(index % n);
+    index /= n;
+    *wrapV = (TextureWrapMode)(index % n);
+    index /= n;
+    *wrapU = (TextureWrapMode)(index % n);
+    *filter = (FilterMode)(index / n);
+}
+
+uint32_t BindlessSamplerIndexOf(const Texture *texture) {
+    if (texture == NULL)
+        return BindlessSamplerIndex(FilterModeBilinear, TextureWrapModeClamp,
+                                    TextureWrapModeClamp, TextureWrapModeClamp);
+    return BindlessSamplerIndex(texture->filterMode, texture->wrapModeU,
+                                texture->wrapModeV, texture->wrapModeW);
+}
@@ -0,0 +1,78 @@
+#ifndef BINDLESS_H
+#define BINDLESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "handle_pool.h"
+#include "texture.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bindless resource model. Every texture owns a slot in one shader visible
+// texture table for its whole lifetime, and every filter/wrap combination has
+// a fixed slot in a sampler table that is filled once at startup. Materials
+// bind nothing: they write the slots of their textures and samplers into
+// their constant buffer (see FETexture2D in Common.hlsl and
+// MaterialBuildConstants), so a draw needs no descriptor work at all.
+// Buffers that shaders read (GetBufferBindlessIndex) take slots of the
+// texture table too.
+//
+// This file only does the bookkeeping, the backends own the descriptors.
+
+// slot 0 of the texture table holds a "missing texture" descriptor, it is
+// what an unset material texture samples
+#define BindlessMissingTexture 0
+#define BindlessMaxTextures 4096
+
+#define BindlessSamplerCount                                        \
+    (_FilterModeCount * _TextureWrapModeCount * _TextureWrapModeCount * \
+     _TextureWrapModeCount)
+
+// Texture slots are handles of a HandlePool: a slot released in frame N is
+// only handed out again once the gpu has finished frame N, so a descriptor
+// is never overwritten while a draw in flight may still read it.
+struct BindlessTable {
+    HandlePool slots;
+    uint32_t capacity;
+    uint32_t peakCount;
+};
+typedef struct BindlessTable BindlessTable;
+
+void BindlessTableInit(BindlessTable *t, uint32_t capacity);
+void BindlessTableFree(BindlessTable *t);
+
+// returns a handle, HandleIndex() of it is the slot; 0 when the table is full
+uint32_t BindlessTableAlloc(BindlessTable *t);
+void BindlessTableRelease(BindlessTable *t, uint32_t handle, uint64_t frame);
+// recycles the slots released in a frame <= completedFrame
+uint32_t BindlessTableCollect(BindlessTable *t, uint64_t completedFrame);
+
+static inline uint32_t BindlessTableGetCount(const BindlessTable *t) {
+    return t->slots.liveCount;
+}
+
+// the slot of a sampler, same layout as the sampler table of the backends
+static inline uint32_t BindlessSamplerIndex(FilterMode filter,
+                                            TextureWrapMode wrapU,
+                                            TextureWrapMode wrapV,
+                                            TextureWrapMode wrapW) {
+    uint32_t n = _TextureWrapModeCount;
+    return ((filter * n + wrapU) * n + wrapV) * n + wrapW;
+}
+
+// inverse of BindlessSamplerIndex, for filling the sampler table
+void BindlessSamplerKey(uint32_t index, FilterMode *filter,
+                        TextureWrapMode *wrapU, TextureWrapMode *wrapV,
+                        TextureWrapMode *wrapW);
+
+// the sampler of a texture, bilinear clamp if texture is NULL
+uint32_t BindlessSamplerIndexOf(const Texture *texture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BINDLESS_H */
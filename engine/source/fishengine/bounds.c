@@ -0,0 +1,66 @@
+#include "bounds.h"
+
+Bounds BoundsUnion(Bounds a, Bounds b) {
+    float3 amin = BoundsGetMin(a), amax = BoundsGetMax(a);
+    float3 bmin = BoundsGetMin(b), bmax = BoundsGetMax(b);
+    float3 min = {fminf(amin.x, bmin.x), fminf(amin.y, bmin.y),
+                  fminf(amin.z, bmin.z)};
+    float3 max = {fmaxf(amax.x, bmax.x), fmaxf(amax.y, bmax.y),
+                  fmaxf(amax.z, bmax.z)};
+    return BoundsFromMinMax(min, max);
+}
+
+Bounds BoundsTransform(const float4x4 *m, Bounds b) {
+    // Arvo: the new extents are |M| * extents
+    Bounds r;
+    const float3 c = b.center, e = b.extents;
+    r.center.x = m->m00 * c.x + m->m01 * c.y + m->m02 * c.z + m->m03;
+    r.center.y = m->m10 * c.x + m->m11 * c.y + m->m12 * c.z + m->m13;
+    r.center.z = m->m20 * c.x + m->m21 * c.y + m->m22 * c.z + m->m23;
+    r.extents.x =
+        fabsf(m->m00) * e.x + fabsf(m->m01) * e.y + fabsf(m->m02) * e.z;
+    r.extents.y =
+        fabsf(m->m10) * e.x + fabsf(m->m11) * e.y + fabsf(m->m12) * e.z;
+    r.extents.z =
+        fabsf(m->m20) * e.x + fabsf(m->m21) * e.y + fabsf(m->m22) * e.z;
+    return r;
+}
+
+static void SetPlane(float *p, float a, float b, float c, float d) {
+    float invLength = 1.f / sqrtf(a * a + b * b + c * c);
+    p[0] = a * invLength;
+    p[1] = b * invLength;
+    p[2] = c * invLength;
+    p[3] = d * invLength;
+}
+
+void FrustumFromMatrix(Frustum *f, const float4x4 *m) {
+    // Gribb & Hartmann, rows of the matrix
+    const float r0[4] = {m->m00, m->m01, m->m02, m->m03};
+    const float r1[4] = {m->m10, m->m11, m->m12, m->m13};
+    const float r2[4] = {m->m20, m->m21, m->m22, m->m23};
+    const float r3[4] = {m->m30, m->m31, m->m32, m->m33};
+    for (int i = 0; i < 2; ++i) {
+        const float *r = i == 0 ? r0 : r1;
+        SetPlane(f->planes[i * 2], r3[0] + r[0], r3[1] + r[1], r3[2] + r[2],
+                 r3[3] + r[3]);
+        SetPlane(f->planes[i * 2 + 1], r3[0] - r[0], r3[1] - r[1],
+                 r3[2] - r[2], r3[3] - r[3]);
+    }
+    SetPlane(f->planes[4], r2[0], r2[1], r2[2], r2[3]);
+    SetPlane(f->planes[5], r3[0] - r2[0], r3[1] - r2[1], r3[2] - r2[2],
+             r3[3] - r2[3]);
+}
+
+enum FrustumTestResult FrustumTestBounds(const Frustum *f, Bounds b) {
+    enum FrustumTestResult result = FrustumInside;
+    const float3 c = b.center, e = b.extents;
+    for (int i = 0; i < 6; ++i) {
+        const float *p = f->planes[i];
+        float d = p[0] * c.x + p[1] * c.y + p[2] * c.z + p[3];
+        float r = fabsf(p[0]) * e.x + fabsf(p[1]) * e.y + fabsf(p[2]) * e.z;
+        if (d + r < 0) return FrustumOutside;
+        if (d - r < 0) result = FrustumIntersect;
+    }
+    return result;
+}
@@ -0,0 +1,61 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "simd_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// axis aligned bounding box
+struct Bounds {
+    float3 center;
+    float3 extents;  // half size
+};
+typedef struct Bounds Bounds;
+
+static inline Bounds BoundsFromMinMax(float3 min, float3 max) {
+    Bounds b;
+    b.center = float3_mul1(float3_add(min, max), 0.5f);
+    b.extents = float3_mul1(float3_subtract(max, min), 0.5f);
+    return b;
+}
+
+static inline float3 BoundsGetMin(Bounds b) {
+    return float3_subtract(b.center, b.extents);
+}
+
+static inline float3 BoundsGetMax(Bounds b) {
+    return float3_add(b.center, b.extents);
+}
+
+Bounds BoundsUnion(Bounds a, Bounds b);
+// bounds of the transformed box
+Bounds BoundsTransform(const float4x4 *m, Bounds b);
+
+// six planes (a, b, c, d), a point p is inside when dot(abc, p) + d >= 0
+// order: left, right, bottom, top, near, far
+struct Frustum {
+    float planes[6][4];
+};
+typedef struct Frustum Frustum;
+
+// planes of the clip volume -w <= x, y <= w, 0 <= z <= w of viewProj
+void FrustumFromMatrix(Frustum *f, const float4x4 *viewProj);
+
+enum FrustumTestResult {
+    FrustumOutside = 0,
+    FrustumIntersect,
+    FrustumInside,
+};
+
+enum FrustumTestResult FrustumTestBounds(const Frustum *f, Bounds b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOUNDS_H */
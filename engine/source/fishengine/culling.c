@@ -0,0 +1,295 @@
+#include "culling.h"
+
+#include "jobs.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+static uint32_t AlignUp(uint32_t x, uint32_t alignment) {
+    return (x + alignment - 1) / alignment * alignment;
+}
+
+#define FOREACH_SOA(g, x)                                                   \
+    array *x[] = {&(g)->centerX, &(g)->centerY, &(g)->centerZ, &(g)->extentX, \
+                  &(g)->extentY, &(g)->extentZ}
+
+void CullingGroupInit(CullingGroup *g) {
+    FOREACH_SOA(g, soa);
+    for (int i = 0; i < 6; ++i) array_init(soa[i], sizeof(float), 1024);
+    array_init(&g->visible, sizeof(uint32_t), 1024);
+    array_init(&g->chunkVisible, sizeof(uint32_t), 16);
+    g->count = 0;
+}
+
+void CullingGroupFree(CullingGroup *g) {
+    FOREACH_SOA(g, soa);
+    for (int i = 0; i < 6; ++i) array_free(soa[i]);
+    array_free(&g->visible);
+    array_free(&g->chunkVisible);
+    g->count = 0;
+}
+
+void CullingGroupClear(CullingGroup *g) {
+    FOREACH_SOA(g, soa);
+    for (int i = 0; i < 6; ++i) soa[i]->size = 0;
+    g->visible.size = 0;
+    g->count = 0;
+}
+
+uint32_t CullingGroupAdd(CullingGroup *g, Bounds b) {
+    FOREACH_SOA(g, soa);
+    const uint32_t idx = g->count++;
+    // keep the arrays a multiple of CullingBatchSize long, capacities double
+    // from 1024 so they stay multiples of it as well
+    const uint32_t size = AlignUp(g->count, CullingBatchSize);
+    const float values[6] = {b.center.x,  b.center.y,  b.center.z,
+                             b.extents.x, b.extents.y, b.extents.z};
+    for (int i = 0; i < 6; ++i) {
+        if (size > soa[i]->capacity)
+            array_reserve(soa[i], soa[i]->capacity * 2);
+        soa[i]->size = size;
+        ((float *)soa[i]->ptr)[idx] = values[i];
+    }
+    return idx;
+}
+
+struct CullContext {
+    const CullingGroup *g;
+    const Frustum *f;
+    uint32_t *visible;
+    uint32_t *chunkVisible;
+};
+typedef struct CullContext CullContext;
+
+static void CullChunk(void *_ctx, uint32_t beginChunk, uint32_t endChunk,
+                      uint32_t threadIndex) {
+    CullContext *ctx = (CullContext *)_ctx;
+    const CullingGroup *g = ctx->g;
+    const float *cx = (const float *)g->centerX.ptr;
+    const float *cy = (const float *)g->centerY.ptr;
+    const float *cz = (const float *)g->centerZ.ptr;
+    const float *ex = (const float *)g->extentX.ptr;
+    const float *ey = (const float *)g->extentY.ptr;
+    const float *ez = (const float *)g->extentZ.ptr;
+
+    // planes and their absolute normals, one lane per object
+    float plane[6][4], absNormal[6][3];
+    for (int p = 0; p < 6; ++p) {
+        for (int k = 0; k < 4; ++k) plane[p][k] = ctx->f->planes[p][k];
+        for (int k = 0; k < 3; ++k) absNormal[p][k] = fabsf(plane[p][k]);
+    }
+
+    for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk) {
+        const uint32_t begin = chunk * CullingChunkSize;
+        uint32_t end = begin + CullingChunkSize;
+        if (end > g->count) end = g->count;
+        uint32_t *out = ctx->visible + begin;
+        uint32_t visibleCount = 0;
+
+        for (uint32_t i = begin; i < end; i += CullingBatchSize) {
+            uint32_t mask;
+#if defined(__AVX__)
+            __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i),
+                   z = _mm256_loadu_ps(cz + i);
+            __m256 hx = _mm256_loadu_ps(ex + i), hy = _mm256_loadu_ps(ey + i),
+                   hz = _mm256_loadu_ps(ez + i);
+            __m256 outside = _mm256_setzero_ps();
+            for (int p = 0; p < 6; ++p) {
+                __m256 d = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[p][0]), x),
+                                  _mm256_mul_ps(_mm256_set1_ps(plane[p][1]), y)),
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane[p][2]), z),
+                                  _mm256_set1_ps(plane[p][3])));
+                __m256 r = _mm256_add_ps(
+                    _mm256_add_ps(
+                        _mm256_mul_ps(_mm256_set1_ps(absNormal[p][0]), hx),
+                        _mm256_mul_ps(_mm256_set1_ps(absNormal[p][1]), hy)),
+                    _mm256_mul_ps(_mm256_set1_ps(absNormal[p][2]), hz));
+                outside = _mm256_or_ps(
+                    outside, _mm256_cmp_ps(_mm256_add_ps(d, r),
+                                           _mm256_setzero_ps(), _CMP_LT_OQ));
+            }
+            mask = ~(uint32_t)_mm256_movemask_ps(outside) & 0xFF;
+#else
+            // same test lane by lane, written so the compiler can vectorize
+            int outside[CullingBatchSize] = {0};
+            for (int p = 0; p < 6; ++p) {
+                for (int k = 0; k < CullingBatchSize; ++k) {
+                    float d = plane[p][0] * cx[i + k] + plane[p][1] * cy[i + k] +
+                              plane[p][2] * cz[i + k] + plane[p][3];
+                    float r = absNormal[p][0] * ex[i + k] +
+                              absNormal[p][1] * ey[i + k] +
+                              absNormal[p][2] * ez[i + k];
+                    outside[k] |= d + r < 0;
+                }
+            }
+            mask = 0;
+            for (int k = 0; k < CullingBatchSize; ++k)
+                mask |= (uint32_t)!outside[k] << k;
+#endif
+            // the last batch may run into the padding
+            if (end - i < CullingBatchSize) mask &= (1u << (end - i)) - 1;
+            for (uint32_t k = 0; k < CullingBatchSize; ++k) {
+                out[visibleCount] = i + k;
+                visibleCount += (mask >> k) & 1;
+            }
+        }
+        ctx->chunkVisible[chunk] = visibleCount;
+    }
+}
+
+uint32_t CullingGroupCull(CullingGroup *g, const Frustum *f) {
+    const uint32_t chunkCount =
+        (g->count + CullingChunkSize - 1) / CullingChunkSize;
+    // the kernel stores a full batch before checking the mask
+    array_resize(&g->visible, AlignUp(g->count, CullingBatchSize));
+    array_resize(&g->chunkVisible, chunkCount);
+
+    CullContext ctx;
+    ctx.g = g;
+    ctx.f = f;
+    ctx.visible = (uint32_t *)g->visible.ptr;
+    ctx.chunkVisible = (uint32_t *)g->chunkVisible.ptr;
+    JobParallelFor(chunkCount, 1, CullChunk, &ctx);
+
+    // every chunk wrote to its own slice, pack them
+    uint32_t total = 0;
+    for (uint32_t c = 0; c < chunkCount; ++c) {
+        const uint32_t n = ctx.chunkVisible[c];
+        const uint32_t begin = c * CullingChunkSize;
+        if (total != begin)
+            memmove(ctx.visible + total, ctx.visible + begin,
+                    n * sizeof(uint32_t));
+        total += n;
+    }
+    g->visible.size = total;
+    return total;
+}
+
+static float GetCenter(const CullingGroup *g, uint32_t idx, int axis) {
+    const array *a[] = {&g->centerX, &g->centerY, &g->centerZ};
+    return ((const float *)a[axis]->ptr)[idx];
+}
+
+// nth_element: afterwards indices[nth] holds the object whose center would be
+// there if [first, last) were sorted along `axis`, with no greater one before
+// it and no smaller one after it
+static void SelectNth(const CullingGroup *g, uint32_t *indices, int64_t first,
+                      int64_t nth, int64_t last, int axis) {
+    while (last - first > 1) {
+        float pivot = GetCenter(g, indices[(first + last) / 2], axis);
+        int64_t i = first, j = last - 1;
+        while (i <= j) {
+            while (GetCenter(g, indices[i], axis) < pivot) ++i;
+            while (GetCenter(g, indices[j], axis) > pivot) --j;
+            if (i <= j) {
+                uint32_t t = indices[i];
+                indices[i++] = indices[j];
+                indices[j--] = t;
+            }
+        }
+        if (nth <= j)
+            last = j + 1;
+        else if (nth >= i)
+            first = i;
+        else
+            return;
+    }
+}
+
+static uint32_t BuildNode(CullingBVH *bvh, const CullingGroup *g,
+                          uint32_t first, uint32_t count) {
+    uint32_t *indices = (uint32_t *)bvh->indices.ptr;
+    float3 bmin = {INFINITY, INFINITY, INFINITY};
+    float3 bmax = {-INFINITY, -INFINITY, -INFINITY};
+    float3 cmin = bmin, cmax = bmax;
+    for (uint32_t i = first; i < first + count; ++i) {
+        Bounds b = CullingGroupGet(g, indices[i]);
+        float3 lo = BoundsGetMin(b), hi = BoundsGetMax(b);
+        bmin.x = fminf(bmin.x, lo.x), bmax.x = fmaxf(bmax.x, hi.x);
+        bmin.y = fminf(bmin.y, lo.y), bmax.y = fmaxf(bmax.y, hi.y);
+        bmin.z = fminf(bmin.z, lo.z), bmax.z = fmaxf(bmax.z, hi.z);
+        cmin.x = fminf(cmin.x, b.center.x), cmax.x = fmaxf(cmax.x, b.center.x);
+        cmin.y = fminf(cmin.y, b.center.y), cmax.y = fmaxf(cmax.y, b.center.y);
+        cmin.z = fminf(cmin.z, b.center.z), cmax.z = fmaxf(cmax.z, b.center.z);
+    }
+
+    const uint32_t nodeIndex = bvh->nodes.size;
+    CullingBVHNode *node = (CullingBVHNode *)array_push(&bvh->nodes);
+    node->bounds = BoundsFromMinMax(bmin, bmax);
+    node->first = first;
+    node->count = count;
+    node->right = 0;
+    node->unused = 0;
+    if (count <= CullingBVHLeafSize) return nodeIndex;
+
+    // median split along the longest axis of the centers
+    float3 size = float3_subtract(cmax, cmin);
+    int axis = 0;
+    if (size.y > size.x) axis = 1;
+    if (size.z > (axis == 0 ? size.x : size.y)) axis = 2;
+    const uint32_t half = count / 2;
+    SelectNth(g, indices, first, first + half, first + count, axis);
+
+    BuildNode(bvh, g, first, half);
+    const uint32_t right = BuildNode(bvh, g, first + half, count - half);
+    // nodes may have moved while building the children
+    ((CullingBVHNode *)bvh->nodes.ptr)[nodeIndex].right = right;
+    return nodeIndex;
+}
+
+void CullingBVHBuild(CullingBVH *bvh, const CullingGroup *g) {
+    const uint32_t count = g->count;
+    array_init(&bvh->indices, sizeof(uint32_t), count > 0 ? count : 1);
+    array_resize(&bvh->indices, count);
+    for (uint32_t i = 0; i < count; ++i)
+        ((uint32_t *)bvh->indices.ptr)[i] = i;
+    array_init(&bvh->nodes, sizeof(CullingBVHNode),
+               2 * (count / CullingBVHLeafSize) + 1);
+    if (count > 0) BuildNode(bvh, g, 0, count);
+}
+
+void CullingBVHFree(CullingBVH *bvh) {
+    array_free(&bvh->nodes);
+    array_free(&bvh->indices);
+}
+
+uint32_t CullingBVHCull(const CullingBVH *bvh, const CullingGroup *g,
+                        const Frustum *f, array *visible) {
+    if (bvh->nodes.size == 0) return 0;
+    const CullingBVHNode *nodes = (const CullingBVHNode *)bvh->nodes.ptr;
+    const uint32_t *indices = (const uint32_t *)bvh->indices.ptr;
+    const uint32_t start = visible->size;
+    array_reserve(visible, start + bvh->indices.size);
+    uint32_t *out = (uint32_t *)visible->ptr + start;
+    uint32_t n = 0;
+
+    // balanced tree, the depth is log2 of the leaf count
+    uint32_t stack[64];
+    uint32_t top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const uint32_t nodeIndex = stack[--top];
+        const CullingBVHNode *node = nodes + nodeIndex;
+        enum FrustumTestResult r = FrustumTestBounds(f, node->bounds);
+        if (r == FrustumOutside) continue;
+        if (r == FrustumInside) {
+            memcpy(out + n, indices + node->first,
+                   node->count * sizeof(uint32_t));
+            n += node->count;
+        } else if (node->right == 0) {
+            for (uint32_t i = node->first; i < node->first + node->count; ++i) {
+                if (FrustumTestBounds(f, CullingGroupGet(g, indices[i])) !=
+                    FrustumOutside)
+                    out[n++] = indices[i];
+            }
+        } else {
+            assert(top + 2 <= sizeof(stack) / sizeof(stack[0]));
+            stack[top++] = node->right;
+            stack[top++] = nodeIndex + 1;
+        }
+    }
+    visible->size = start + n;
+    return n;
+}
@@ -0,0 +1,77 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <stdint.h>
+
+#include "array.h"
+#include "bounds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// bounds are tested CullingBatchSize at a time, CullingChunkSize per job
+#define CullingBatchSize 8
+#define CullingChunkSize 2048
+
+// world space boxes in structure-of-arrays layout
+struct CullingGroup {
+    array centerX, centerY, centerZ;  // float
+    array extentX, extentY, extentZ;  // float
+    array visible;                    // uint32_t, output of CullingGroupCull
+    array chunkVisible;               // uint32_t, visible count per chunk
+    uint32_t count;
+};
+typedef struct CullingGroup CullingGroup;
+
+void CullingGroupInit(CullingGroup *g);
+void CullingGroupFree(CullingGroup *g);
+void CullingGroupClear(CullingGroup *g);
+// returns the index of the new bounds
+uint32_t CullingGroupAdd(CullingGroup *g, Bounds b);
+static inline Bounds CullingGroupGet(const CullingGroup *g, uint32_t i) {
+    Bounds b;
+    b.center.x = ((const float *)g->centerX.ptr)[i];
+    b.center.y = ((const float *)g->centerY.ptr)[i];
+    b.center.z = ((const float *)g->centerZ.ptr)[i];
+    b.extents.x = ((const float *)g->extentX.ptr)[i];
+    b.extents.y = ((const float *)g->extentY.ptr)[i];
+    b.extents.z = ((const float *)g->extentZ.ptr)[i];
+    return b;
+}
+
+// fills g->visible with the indices of the bounds that intersect the
+// frustum, in increasing order, using the job system; returns the count
+uint32_t CullingGroupCull(CullingGroup *g, const Frustum *f);
+
+// bounding volume hierarchy over a CullingGroup, for large static scenes
+// where whole subtrees can be accepted or rejected at once
+struct CullingBVHNode {
+    Bounds bounds;
+    uint32_t first;   // into CullingBVH.indices
+    uint32_t count;   // objects in this subtree
+    uint32_t right;   // right child, left child is the next node; 0 for leaves
+    uint32_t unused;
+};
+typedef struct CullingBVHNode CullingBVHNode;
+
+struct CullingBVH {
+    array nodes;    // CullingBVHNode, nodes[0] is the root
+    array indices;  // uint32_t, into the CullingGroup
+};
+typedef struct CullingBVH CullingBVH;
+
+#define CullingBVHLeafSize 8
+
+void CullingBVHBuild(CullingBVH *bvh, const CullingGroup *g);
+void CullingBVHFree(CullingBVH *bvh);
+// appends the visible indices to `visible` (uint32_t), unordered; returns the
+// count
+uint32_t CullingBVHCull(const CullingBVH *bvh, const CullingGroup *g,
+                        const Frustum *f, array *visible);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CULLING_H */
@@ -4,6 +4,19 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "statistics.h"
 
 typedef uint32_t DWORD;
 
@@ -37,56 +50,475 @@ typedef struct {
     DWORD dwReserved2;
 } DDS_HEADER;
 
+// https://docs.microsoft.com/en-us/windows/desktop/direct3ddds/dds-header-dxt10
+typedef struct {
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+} DDS_HEADER_DXT10;
+
 // https://docs.microsoft.com/en-us/windows/desktop/direct3ddds/dx-graphics-dds-pguide
 struct FullHeader {
     uint32_t magic;
     DDS_HEADER header;
 };
 
+static_assert(sizeof(struct FullHeader) == 128, "");
+static_assert(sizeof(DDS_HEADER_DXT10) == 20, "");
+
 // static uint32_t MakeFourCC(int a, int b, int c, int d)
 //{
 //	return (((((d << 8) | c) << 8) | b) << 8) | a;
 //}
 #define MakeFourCC(a, b, c, d) (((((((d) << 8) | c) << 8) | b) << 8) | a)
 
-uint8_t *loadDDS(const char *path, TextureDesc *desc, uint32_t *byteLength) {
-    FILE *f = fopen(path, "rb");
-    if (!f) return NULL;
-
-    fseek(f, 0, SEEK_END);
-    size_t file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    struct FullHeader header;
-    fread(&header, sizeof(header), 1, f);
-
-    const uint32_t dds_magic = 0x20534444;  // DDS
-    assert(dds_magic == header.magic);
-    assert(124 == header.header.dwSize);
-
-    switch (header.header.ddspf.dwFourCC) {
-        case MakeFourCC('D', 'X', 'T', '1'):
-            //			puts("DXT1");
-            break;
-        case MakeFourCC('D', 'X', 'T', '2'):
-        case MakeFourCC('D', 'X', 'T', '3'):
-        case MakeFourCC('D', 'X', 'T', '4'):
-        case MakeFourCC('D', 'X', 'T', '5'):
-        case MakeFourCC('D', 'X', '1', '0'):
+#define DDSMagic 0x20534444  // "DDS "
+
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+#define DDSD_DEPTH 0x800000
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_ALPHA 0x2
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDPF_LUMINANCE 0x20000
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0xfc00
+#define DDSCAPS2_VOLUME 0x200000
+#define DDS_DIMENSION_TEXTURE1D 2
+#define DDS_DIMENSION_TEXTURE2D 3
+#define DDS_DIMENSION_TEXTURE3D 4
+#define DDS_MISC_TEXTURECUBE 0x4
+
+// D3D12 limits, they also keep the size arithmetic in 32 bits
+#define DDSMaxSize2D 16384
+#define DDSMaxSize3D 2048
+#define DDSMaxLayers 2048
+
+const char *DDSResultString(DDSResult result) {
+    switch (result) {
+        case DDSOk:
+            return "ok";
+        case DDSErrorOpen:
+            return "can not open the file";
+        case DDSErrorNotDDS:
+            return "not a DDS file";
+        case DDSErrorMalformed:
+            return "malformed header";
+        case DDSErrorTruncated:
+            return "file too short for its data";
+        case DDSErrorUnsupported:
+            return "unsupported format or size";
+        default:
+            return "unknown error";
+    }
+}
+
+// DXGI_FORMAT values of the DX10 header
+static TextureFormat FromDXGIFormat(uint32_t format) {
+    switch (format) {
+        case 2:  // R32G32B32A32_FLOAT
+            return TextureFormatRGBA32Float;
+        case 10:  // R16G16B16A16_FLOAT
+            return TextureFormatRGBA16Float;
+        case 28:  // R8G8B8A8_UNORM
+            return TextureFormatRGBA8Unorm;
+        case 29:  // R8G8B8A8_UNORM_SRGB
+            return TextureFormatRGBA8Unorm_sRGB;
+        case 41:  // R32_FLOAT
+            return TextureFormatR32Float;
+        case 49:  // R8G8_UNORM
+            return TextureFormatRG8Unorm;
+        case 61:  // R8_UNORM
+            return TextureFormatR8Unorm;
+        case 65:  // A8_UNORM
+            return TextureFormatAlpha8;
+        case 71:  // BC1_UNORM
+            return TextureFormatDXT1;
+        case 72:  // BC1_UNORM_SRGB
+            return TextureFormatDXT1_sRGB;
+        case 74:  // BC2_UNORM
+            return TextureFormatDXT3;
+        case 75:  // BC2_UNORM_SRGB
+            return TextureFormatDXT3_sRGB;
+        case 77:  // BC3_UNORM
+            return TextureFormatDXT5;
+        case 78:  // BC3_UNORM_SRGB
+            return TextureFormatDXT5_sRGB;
+        case 80:  // BC4_UNORM
+            return TextureFormatBC4;
+        case 83:  // BC5_UNORM
+            return TextureFormatBC5;
+        case 87:  // B8G8R8A8_UNORM
+            return TextureFormatBGRA8Unorm;
+        case 91:  // B8G8R8A8_UNORM_SRGB
+            return TextureFormatBGRA8Unorm_sRGB;
+        case 95:  // BC6H_UF16
+            return TextureFormatBC6H;
+        case 98:  // BC7_UNORM
+            return TextureFormatBC7;
+        case 99:  // BC7_UNORM_SRGB
+            return TextureFormatBC7_sRGB;
         default:
-            puts("[dds loader] only support DXT1");
-            abort();
+            return TextureFormatInvalid;
+    }
+}
+
+static uint32_t ToDXGIFormat(TextureFormat format) {
+    switch (format) {
+        case TextureFormatRGBA32Float:
+            return 2;
+        case TextureFormatRGBA16Float:
+            return 10;
+        case TextureFormatRGBA8Unorm:
+            return 28;
+        case TextureFormatRGBA8Unorm_sRGB:
+            return 29;
+        case TextureFormatR32Float:
+            return 41;
+        case TextureFormatRG8Unorm:
+            return 49;
+        case TextureFormatR8Unorm:
+            return 61;
+        case TextureFormatAlpha8:
+            return 65;
+        case TextureFormatDXT1:
+            return 71;
+        case TextureFormatDXT1_sRGB:
+            return 72;
+        case TextureFormatDXT3:
+            return 74;
+        case TextureFormatDXT3_sRGB:
+            return 75;
+        case TextureFormatDXT5:
+            return 77;
+        case TextureFormatDXT5_sRGB:
+            return 78;
+        case TextureFormatBC4:
+            return 80;
+        case TextureFormatBC5:
+            return 83;
+        case TextureFormatBGRA8Unorm:
+            return 87;
+        case TextureFormatBGRA8Unorm_sRGB:
+            return 91;
+        case TextureFormatBC6H:
+            return 95;
+        case TextureFormatBC7:
+            return 98;
+        case TextureFormatBC7_sRGB:
+            return 99;
+        default:
+            return 0;
+    }
+}
+
+// formats of files without the DX10 header
+static TextureFormat FromPixelFormat(const DDS_PIXELFORMAT *pf) {
+    if (pf->dwFlags & DDPF_FOURCC) {
+        switch (pf->dwFourCC) {
+            case MakeFourCC('D', 'X', 'T', '1'):
+                return TextureFormatDXT1;
+            // premultiplied alpha is not tracked
+            case MakeFourCC('D', 'X', 'T', '2'):
+            case MakeFourCC('D', 'X', 'T', '3'):
+                return TextureFormatDXT3;
+            case MakeFourCC('D', 'X', 'T', '4'):
+            case MakeFourCC('D', 'X', 'T', '5'):
+                return TextureFormatDXT5;
+            case MakeFourCC('A', 'T', 'I', '1'):
+            case MakeFourCC('B', 'C', '4', 'U'):
+                return TextureFormatBC4;
+            case MakeFourCC('A', 'T', 'I', '2'):
+            case MakeFourCC('B', 'C', '5', 'U'):
+                return TextureFormatBC5;
+            // D3DFORMAT values stored as FourCC
+            case 113:  // D3DFMT_A16B16G16R16F
+                return TextureFormatRGBA16Float;
+            case 114:  // D3DFMT_R32F
+                return TextureFormatR32Float;
+            case 116:  // D3DFMT_A32B32G32R32F
+                return TextureFormatRGBA32Float;
+            default:
+                return TextureFormatInvalid;
+        }
+    }
+    if ((pf->dwFlags & DDPF_RGB) && pf->dwRGBBitCount == 32) {
+        if (pf->dwRBitMask == 0xff && pf->dwGBitMask == 0xff00 &&
+            pf->dwBBitMask == 0xff0000)
+            return TextureFormatRGBA8Unorm;
+        if (pf->dwRBitMask == 0xff0000 && pf->dwGBitMask == 0xff00 &&
+            pf->dwBBitMask == 0xff)
+            return TextureFormatBGRA8Unorm;
+        return TextureFormatInvalid;
+    }
+    if ((pf->dwFlags & DDPF_LUMINANCE) && pf->dwRGBBitCount == 8)
+        return TextureFormatR8Unorm;
+    if ((pf->dwFlags & DDPF_LUMINANCE) && (pf->dwFlags & DDPF_ALPHAPIXELS) &&
+        pf->dwRGBBitCount == 16)
+        return TextureFormatRG8Unorm;
+    if ((pf->dwFlags & DDPF_ALPHA) && pf->dwRGBBitCount == 8)
+        return TextureFormatAlpha8;
+    return TextureFormatInvalid;
+}
+
+static uint64_t SubresourceSize(TextureFormat format, uint32_t width,
+                                uint32_t height, uint32_t depth) {
+    return (uint64_t)TextureFormatRowPitch(format, width) *
+           TextureFormatRowCount(format, height) * depth;
+}
+
+static uint32_t MipSize(uint32_t size, uint32_t mip) {
+    size >>= mip;
+    return size > 0 ? size : 1;
+}
+
+DDSResult DDSParseHeader(const uint8_t *data, size_t size, uint64_t fileSize,
+                         TextureDesc *desc, uint32_t *dataOffset) {
+    struct FullHeader full;
+    if (size < sizeof(full)) return DDSErrorNotDDS;
+    memcpy(&full, data, sizeof(full));
+    const DDS_HEADER *h = &full.header;
+    if (full.magic != DDSMagic || h->dwSize != sizeof(DDS_HEADER) ||
+        h->ddspf.dwSize != sizeof(DDS_PIXELFORMAT))
+        return DDSErrorNotDDS;
+
+    TextureDesc d;
+    d.width = h->dwWidth;
+    d.height = h->dwHeight;
+    d.depth = 1;
+    d.arraySize = 1;
+    d.mipmaps = (h->dwFlags & DDSD_MIPMAPCOUNT) ? h->dwMipMapCount : 1;
+    if (d.mipmaps == 0) d.mipmaps = 1;
+    d.dimension = TextureDimensionTex2D;
+    uint32_t offset = sizeof(full);
+
+    const bool dx10 = (h->ddspf.dwFlags & DDPF_FOURCC) &&
+                      h->ddspf.dwFourCC == MakeFourCC('D', 'X', '1', '0');
+    if (dx10) {
+        DDS_HEADER_DXT10 ext;
+        if (size < offset + sizeof(ext)) return DDSErrorTruncated;
+        memcpy(&ext, data + offset, sizeof(ext));
+        offset += sizeof(ext);
+        d.format = FromDXGIFormat(ext.dxgiFormat);
+        if (ext.arraySize == 0) return DDSErrorMalformed;
+        d.arraySize = ext.arraySize;
+        switch (ext.resourceDimension) {
+            case DDS_DIMENSION_TEXTURE1D:
+                return DDSErrorUnsupported;
+            case DDS_DIMENSION_TEXTURE2D:
+                if (ext.miscFlag & DDS_MISC_TEXTURECUBE)
+                    d.dimension = d.arraySize > 1 ? TextureDimensionCubeArray
+                                                  : TextureDimensionCube;
+                else if (d.arraySize > 1)
+                    d.dimension = TextureDimensionTex2DArray;
+                break;
+            case DDS_DIMENSION_TEXTURE3D:
+                if (d.arraySize != 1) return DDSErrorMalformed;
+                d.dimension = TextureDimensionTex3D;
+                d.depth = h->dwDepth;
+                break;
+            default:
+                return DDSErrorMalformed;
+        }
+    } else {
+        d.format = FromPixelFormat(&h->ddspf);
+        if (h->dwCaps2 & DDSCAPS2_CUBEMAP) {
+            // D3D10 and later have no partial cubemaps
+            if ((h->dwCaps2 & DDSCAPS2_CUBEMAP_ALLFACES) !=
+                DDSCAPS2_CUBEMAP_ALLFACES)
+                return DDSErrorUnsupported;
+            d.dimension = TextureDimensionCube;
+        } else if (h->dwCaps2 & DDSCAPS2_VOLUME) {
+            if (!(h->dwFlags & DDSD_DEPTH)) return DDSErrorMalformed;
+            d.dimension = TextureDimensionTex3D;
+            d.depth = h->dwDepth;
+        }
     }
+    if (d.format == TextureFormatInvalid) return DDSErrorUnsupported;
 
-    size_t size = file_size - sizeof(header);
-    uint8_t *bytes = malloc(size);
-    fread(bytes, size, 1, f);
-    fclose(f);
+    if (d.width == 0 || d.height == 0 || d.depth == 0) return DDSErrorMalformed;
+    // cube faces are square
+    if ((d.dimension == TextureDimensionCube ||
+         d.dimension == TextureDimensionCubeArray) &&
+        d.width != d.height)
+        return DDSErrorMalformed;
+    const uint32_t maxSize =
+        d.dimension == TextureDimensionTex3D ? DDSMaxSize3D : DDSMaxSize2D;
+    if (d.width > maxSize || d.height > maxSize || d.depth > maxSize ||
+        d.arraySize > DDSMaxLayers || TextureDescLayerCount(&d) > DDSMaxLayers)
+        return DDSErrorUnsupported;
+    if (d.mipmaps > TextureMaxMips) return DDSErrorUnsupported;
+    // a chain can not go on past 1x1x1
+    uint32_t longest = d.width > d.height ? d.width : d.height;
+    if (d.depth > longest) longest = d.depth;
+    if ((longest >> (d.mipmaps - 1)) == 0) return DDSErrorMalformed;
+
+    uint64_t layerSize = 0;
+    for (uint32_t i = 0; i < d.mipmaps; ++i)
+        layerSize += SubresourceSize(d.format, MipSize(d.width, i),
+                                     MipSize(d.height, i),
+                                     MipSize(d.depth, i));
+    const uint64_t end = offset + layerSize * TextureDescLayerCount(&d);
+    if (end > fileSize) return DDSErrorTruncated;
+    if (end > UINT32_MAX) return DDSErrorUnsupported;
+
+    *desc = d;
+    *dataOffset = offset;
+    return DDSOk;
+}
 
-    desc->width = header.header.dwWidth;
-    desc->height = header.header.dwHeight;
-    desc->mipmaps = header.header.dwMipMapCount;
+void DDSGetSubresources(const TextureDesc *desc, uint32_t dataOffset,
+                        TextureMip *subresources) {
+    const uint32_t layers = TextureDescLayerCount(desc);
+    uint32_t offset = dataOffset;
+    for (uint32_t layer = 0; layer < layers; ++layer) {
+        for (uint32_t i = 0; i < desc->mipmaps; ++i) {
+            TextureMip *m = subresources + layer * desc->mipmaps + i;
+            m->width = MipSize(desc->width, i);
+            m->height = MipSize(desc->height, i);
+            m->depth = MipSize(desc->depth, i);
+            m->offset = offset;
+            m->byteLength = (uint32_t)SubresourceSize(desc->format, m->width,
+                                                      m->height, m->depth);
+            offset += m->byteLength;
+        }
+    }
+}
+
+// in dwReserved1, before the tag
+#define DDSTagMagic MakeFourCC('F', 'I', 'S', 'H')
+
+static_assert(sizeof(struct FullHeader) + sizeof(DDS_HEADER_DXT10) ==
+                  DDSHeaderSize,
+              "");
+
+bool DDSWriteHeader(const TextureDesc *desc, const uint32_t tag[DDSTagSize],
+                    uint8_t header[DDSHeaderSize]) {
+    const uint32_t dxgiFormat = ToDXGIFormat(desc->format);
+    if (dxgiFormat == 0) return false;
+    struct FullHeader full;
+    memset(&full, 0, sizeof(full));
+    full.magic = DDSMagic;
+    DDS_HEADER *h = &full.header;
+    h->dwSize = sizeof(DDS_HEADER);
+    h->dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT |
+                 DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    h->dwHeight = desc->height;
+    h->dwWidth = desc->width;
+    h->dwPitchOrLinearSize = (uint32_t)SubresourceSize(
+        desc->format, desc->width, desc->height, desc->depth);
+    h->dwDepth = desc->depth;
+    h->dwMipMapCount = desc->mipmaps;
+    if (tag != NULL) {
+        h->dwReserved1[0] = DDSTagMagic;
+        memcpy(h->dwReserved1 + 1, tag, DDSTagSize * sizeof(uint32_t));
+    }
+    h->ddspf.dwSize = sizeof(DDS_PIXELFORMAT);
+    h->ddspf.dwFlags = DDPF_FOURCC;
+    h->ddspf.dwFourCC = MakeFourCC('D', 'X', '1', '0');
+    h->dwCaps = DDSCAPS_TEXTURE;
+    if (desc->mipmaps > 1) h->dwCaps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+    DDS_HEADER_DXT10 ext;
+    memset(&ext, 0, sizeof(ext));
+    ext.dxgiFormat = dxgiFormat;
+    ext.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+    ext.arraySize = desc->arraySize;
+    if (desc->dimension == TextureDimensionTex3D) {
+        h->dwFlags |= DDSD_DEPTH;
+        h->dwCaps |= DDSCAPS_COMPLEX;
+        h->dwCaps2 = DDSCAPS2_VOLUME;
+        ext.resourceDimension = DDS_DIMENSION_TEXTURE3D;
+    } else if (desc->dimension == TextureDimensionCube ||
+               desc->dimension == TextureDimensionCubeArray) {
+        h->dwCaps |= DDSCAPS_COMPLEX;
+        h->dwCaps2 = DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES;
+        ext.miscFlag = DDS_MISC_TEXTURECUBE;
+    }
+    memcpy(header, &full, sizeof(full));
+    memcpy(header + sizeof(full), &ext, sizeof(ext));
+    return true;
+}
+
+bool DDSReadTag(const uint8_t *data, size_t size, uint32_t tag[DDSTagSize]) {
+    struct FullHeader full;
+    if (size < sizeof(full)) return false;
+    memcpy(&full, data, sizeof(full));
+    if (full.magic != DDSMagic || full.header.dwReserved1[0] != DDSTagMagic)
+        return false;
+    memcpy(tag, full.header.dwReserved1 + 1, DDSTagSize * sizeof(uint32_t));
+    return true;
+}
+
+static bool MapFile(const char *path, DDSFile *f) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    f->file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) return false;
+    f->size = (uint64_t)size.QuadPart;
+    f->mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (f->mapping == NULL) return false;
+    f->data =
+        (const uint8_t *)MapViewOfFile(f->mapping, FILE_MAP_READ, 0, 0, 0);
+    return f->data != NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    f->size = (uint64_t)st.st_size;
+    f->data = (const uint8_t *)p;
+    return true;
+#endif
+}
+
+DDSResult DDSOpen(const char *path, DDSFile *f) {
+    memset(f, 0, sizeof(*f));
+    if (!MapFile(path, f)) {
+        DDSClose(f);
+        return DDSErrorOpen;
+    }
+    uint32_t dataOffset;
+    DDSResult result =
+        DDSParseHeader(f->data, f->size, f->size, &f->desc, &dataOffset);
+    if (result != DDSOk) {
+        DDSClose(f);
+        return result;
+    }
+    f->subresourceCount = TextureDescSubresourceCount(&f->desc);
+    f->subresources = malloc(f->subresourceCount * sizeof(TextureMip));
+    count_heap_allocation();
+    DDSGetSubresources(&f->desc, dataOffset, f->subresources);
+    return DDSOk;
+}
 
-    *byteLength = size;
-    return bytes;
+void DDSClose(DDSFile *f) {
+#ifdef _WIN32
+    if (f->data) UnmapViewOfFile(f->data);
+    if (f->mapping) CloseHandle(f->mapping);
+    if (f->file && f->file != INVALID_HANDLE_VALUE) CloseHandle(f->file);
+#else
+    if (f->data) munmap((void *)f->data, f->size);
+#endif
+    free(f->subresources);
+    memset(f, 0, sizeof(*f));
 }
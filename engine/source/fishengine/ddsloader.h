@@ -9,16 +9,92 @@
 typedef struct {
     uint32_t width;
     uint32_t height;
+    uint32_t depth;      // 1 unless dimension is TextureDimensionTex3D
+    uint32_t arraySize;  // cubes for the cube dimensions, 1 for Tex3D
     uint32_t mipmaps;
     TextureFormat format;
+    TextureDimension dimension;  // Tex2D, Tex2DArray, Tex3D, Cube, CubeArray
 } TextureDesc;
 
+#define TextureMaxMips 16
+
+// where a subresource (a mip level of an array slice or a cube face) is in
+// its file, and its size
+typedef struct {
+    uint32_t offset;  // from the start of the file
+    uint32_t byteLength;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;  // slices of a volume mip, 1 otherwise
+} TextureMip;
+
+// 2D slices of a texture, every one has desc->mipmaps subresources
+static inline uint32_t TextureDescLayerCount(const TextureDesc *desc) {
+    if (desc->dimension == TextureDimensionTex3D) return 1;
+    if (desc->dimension == TextureDimensionCube ||
+        desc->dimension == TextureDimensionCubeArray)
+        return desc->arraySize * 6;
+    return desc->arraySize;
+}
+
+static inline uint32_t TextureDescSubresourceCount(const TextureDesc *desc) {
+    return TextureDescLayerCount(desc) * desc->mipmaps;
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+typedef enum {
+    DDSOk = 0,
+    DDSErrorOpen,         // the file can not be opened or mapped
+    DDSErrorNotDDS,       // no DDS magic or header
+    DDSErrorMalformed,    // the header contradicts itself
+    DDSErrorTruncated,    // the file is shorter than its subresources
+    DDSErrorUnsupported,  // valid, but a format or size the engine lacks
+} DDSResult;
+
+const char *DDSResultString(DDSResult result);
+
+// Reads the header of a DDS file of fileSize bytes, of which `size` are at
+// `data` (the whole header, up to 148 bytes, must be there), fills desc and
+// the offset of the first subresource. DDSOk guarantees that all the
+// subresources are inside the file and that their offsets fit in 32 bits.
+DDSResult DDSParseHeader(const uint8_t *data, size_t size, uint64_t fileSize,
+                         TextureDesc *desc, uint32_t *dataOffset);
+// fills subresources[TextureDescSubresourceCount(desc)] in D3D order, the
+// mips of the first layer first
+void DDSGetSubresources(const TextureDesc *desc, uint32_t dataOffset,
+                        TextureMip *subresources);
+
+// a mapped DDS file, the texture data is read in place
+typedef struct {
+    const uint8_t *data;
+    uint64_t size;
+    TextureDesc desc;
+    uint32_t subresourceCount;
+    TextureMip *subresources;
+    void *file;  // platform handles of the mapping
+    void *mapping;
+} DDSFile;
+
+DDSResult DDSOpen(const char *path, DDSFile *file);
+void DDSClose(DDSFile *file);
+
+// headers written by DDSWriteHeader always have the DX10 extension
+#define DDSHeaderSize 148
+// words of the header's reserved area that carry an application tag, tools
+// that rewrite the file drop it
+#define DDSTagSize 4
+
+// the subresources follow the header in DDSGetSubresources order; `tag` may
+// be NULL. False for formats DXGI has no name for.
+bool DDSWriteHeader(const TextureDesc *desc, const uint32_t tag[DDSTagSize],
+                    uint8_t header[DDSHeaderSize]);
+// the tag DDSWriteHeader stored, false if the header has none
+bool DDSReadTag(const uint8_t *data, size_t size, uint32_t tag[DDSTagSize]);
+
 bool ConvertToDDS(const char *path);
-uint8_t *loadDDS(const char *path, TextureDesc *desc, uint32_t *byteLength);
 
 #ifdef __cplusplus
 }
@@ -4,29 +4,55 @@
 #include <string.h>
 
 #include "array.h"
+#include "log.h"
 
-static const size_t string_buffer_size = 1 * 1024 * 1024;  // 1 MB
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK Mutex;
+#define MutexInitializer SRWLOCK_INIT
+#define MutexLock(m) AcquireSRWLockExclusive(m)
+#define MutexUnlock(m) ReleaseSRWLockExclusive(m)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t Mutex;
+#define MutexInitializer PTHREAD_MUTEX_INITIALIZER
+#define MutexLock(m) pthread_mutex_lock(m)
+#define MutexUnlock(m) pthread_mutex_unlock(m)
+#endif
+
+#define string_buffer_size (1 * 1024 * 1024)  // 1 MB
 // static char string_buffer[string_buffer_size];
 static array g_string_buffer;
 
-static const size_t error_message_count = 32;
+#define error_message_count 32
 static const char *error_messages[error_message_count];  // ring buffer
 static int next_error_message_id = 0;
 
+// the log thread adds, the editor reads
+static Mutex g_lock = MutexInitializer;
+
+// 128 KB of records
+#define log_capacity 2048
+
 void debug_init() {
     array_init(&g_string_buffer, 1, string_buffer_size);
     char *p = g_string_buffer.ptr;
     p[0] = '\0';
+    LogInit(log_capacity);
 }
 
 void debug_clear_all() {
+    MutexLock(&g_lock);
     next_error_message_id = 0;
     g_string_buffer.size = 0;
+    MutexUnlock(&g_lock);
 }
 
-void log_error(const char *msg) {
+void debug_add_error(const char *msg) {
     size_t len = strlen(msg);
+    MutexLock(&g_lock);
     if (g_string_buffer.size + len + 1 >= g_string_buffer.capacity) {
+        MutexUnlock(&g_lock);
         puts("[DEBUG] string buffer is full\n");
         return;
     }
@@ -37,13 +63,26 @@ void log_error(const char *msg) {
     error_messages[next_error_message_id] = p;
     next_error_message_id++;
     next_error_message_id %= error_message_count;
-    assert(strcmp(p, msg) == 0);
-
-    puts(msg);
+    MutexUnlock(&g_lock);
 }
 
-bool debug_has_error() { return next_error_message_id != 0; }
+bool debug_has_error() {
+    MutexLock(&g_lock);
+    const bool has = next_error_message_id != 0;
+    MutexUnlock(&g_lock);
+    return has;
+}
 
-int debug_get_error_message_count() { return next_error_message_id; }
+int debug_get_error_message_count() {
+    MutexLock(&g_lock);
+    const int count = next_error_message_id;
+    MutexUnlock(&g_lock);
+    return count;
+}
 
-const char *debug_get_error_message_at(int idx) { return error_messages[idx]; }
+const char *debug_get_error_message_at(int idx) {
+    MutexLock(&g_lock);
+    const char *msg = error_messages[idx];
+    MutexUnlock(&g_lock);
+    return msg;
+}
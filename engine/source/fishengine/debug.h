@@ -7,10 +7,16 @@
 extern "C" {
 #endif
 
+// The console of the editor: the text of the error records of log.h, added
+// by the log thread.
+
+// starts the log too
 void debug_init();
 void debug_clear_all();
-void log_error(const char *msg);
+// by the log thread
+void debug_add_error(const char *msg);
 bool debug_has_error();
+// a message stays valid until debug_clear_all, the log thread only appends
 int debug_get_error_message_count();
 const char *debug_get_error_message_at(int idx);
 
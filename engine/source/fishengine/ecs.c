@@ -3,6 +3,12 @@
 #include "statistics.h"
 #include "string.h"
 
+static EntitiesRemoved g_entitiesRemoved = NULL;
+
+void WorldSetEntitiesRemovedCallback(EntitiesRemoved callback) {
+    g_entitiesRemoved = callback;
+}
+
 static void ComponentArrayInit(ComponentArray *array, ComponentType type,
                                int classSize, int capacity) {
     array->type = type;
@@ -94,6 +100,7 @@ void WorldFree(World *w) {
 }
 
 void WorldClear(World *w) {
+    if (g_entitiesRemoved) g_entitiesRemoved(w, 0);
     //	memset(w, 0, sizeof(*w));
     w->entityCount = 0;
     memset(w->entities, 0, sizeof(w->entities));
@@ -107,7 +114,44 @@ void WorldClear(World *w) {
     WorldCreateEntity(w);
 }
 
-void WorldAddSystem(World *w, System f) { w->systems[w->systemCount++] = f; }
+void WorldAddSystem(World *w, System f) {
+    WorldAddSystemWithAccess(w, f, SystemAccessAll, SystemAccessAll);
+}
+
+void WorldAddSystemWithAccess(World *w, System f, uint64_t reads,
+                              uint64_t writes) {
+    assert(w->systemCount < MaxSystem);
+    SystemEntry *s = w->systems + w->systemCount++;
+    memset(s, 0, sizeof(*s));
+    s->func = f;
+    s->reads = reads;
+    s->writes = writes;
+}
+
+void WorldInsertSystem(World *w, const SystemEntry *s) {
+    assert(w->systemCount < MaxSystem);
+    uint32_t after = 0;
+    for (uint32_t i = 0; i < w->systemCount; ++i) {
+        if (w->systems[i].writes & (s->reads | s->writes)) after = i + 1;
+    }
+    uint32_t at = after;
+    while (at < w->systemCount && !(w->systems[at].reads & s->writes)) ++at;
+    memmove(w->systems + at + 1, w->systems + at,
+            (w->systemCount - at) * sizeof(SystemEntry));
+    w->systems[at] = *s;
+    w->systemCount++;
+}
+
+void WorldRemoveSystem(World *w, SystemWithData f, void *data) {
+    for (uint32_t i = 0; i < w->systemCount; ++i) {
+        if (w->systems[i].funcWithData == f && w->systems[i].data == data) {
+            memmove(w->systems + i, w->systems + i + 1,
+                    (w->systemCount - i - 1) * sizeof(SystemEntry));
+            w->systemCount--;
+            return;
+        }
+    }
+}
 
 void WorldAddSingletonComponent(World *w, void *comp, int ID) {
     assert(w->singletonComponents[ID] == NULL);
@@ -120,9 +164,248 @@ void *WorldGetSingletonComponent(World *w, int ID) {
 
 void WorldTick(World *w) {
     for (int i = 0; i < w->systemCount; ++i) {
-        System s = w->systems[i];
-        s(w);
+        const SystemEntry *s = w->systems + i;
+        if (s->func)
+            s->func(w);
+        else
+            s->funcWithData(w, s->data);
+    }
+}
+
+// see WorldSerialize; a header, the entities, each component array as its
+// size, its count, its components and its row of componentEntityMap, each
+// singleton component the same way, then what ComponentDef.save appended.
+// Every section starts at a multiple of 16, the components can be used where
+// they are.
+#define SnapshotMagic 0x53574546u  // "FEWS"
+#define SnapshotVersion 1u
+#define SnapshotAlign(n) (((n) + 15u) & ~15u)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entityCount;
+    uint32_t componentDefCount;
+    uint32_t singletonDefCount;
+    uint32_t extraSize;
+} SnapshotHeader;
+
+typedef struct {
+    uint32_t size;  // ComponentDef.size
+    uint32_t count;
+} SnapshotArray;
+
+void *WorldSnapshotAppend(array *bytes, uint32_t size) {
+    assert(bytes->stride == 1);
+    const uint32_t at = bytes->size;
+    const uint32_t aligned = SnapshotAlign(size);
+    if (at + aligned > bytes->capacity) {
+        uint32_t capacity = bytes->capacity > 0 ? bytes->capacity : 1024;
+        while (capacity < at + aligned) capacity *= 2;
+        array_reserve(bytes, capacity);
+    }
+    bytes->size += aligned;
+    char *p = (char *)bytes->ptr + at;
+    memset(p + size, 0, aligned - size);
+    return p;
+}
+
+static void SnapshotWrite(array *out, const void *data, uint32_t size) {
+    if (size > 0) memcpy(WorldSnapshotAppend(out, size), data, size);
+}
+
+static void SnapshotWriteComponents(array *out, array *extra,
+                                    const ComponentDef *d, const void *comps,
+                                    uint32_t count) {
+    const SnapshotArray a = {d->size, count};
+    SnapshotWrite(out, &a, sizeof(a));
+    if (count == 0) return;
+    // the hooks append to `extra`, the copy stays where it is
+    char *copy = WorldSnapshotAppend(out, d->size * count);
+    memcpy(copy, comps, d->size * count);
+    if (d->save) {
+        for (uint32_t i = 0; i < count; ++i) d->save(copy + i * d->size, extra);
+    }
+}
+
+void WorldSerialize(World *w, array *out) {
+    assert(out->stride == 1 && out->size % 16 == 0);
+    const uint32_t start = out->size;
+    array extra;
+    array_init(&extra, 1, 1024);
+    SnapshotHeader h = {SnapshotMagic,
+                        SnapshotVersion,
+                        w->entityCount,
+                        w->def.componentDefCount,
+                        w->def.singletonComponentDefCount,
+                        0};
+    SnapshotWrite(out, &h, sizeof(h));
+    SnapshotWrite(out, w->entities, w->entityCount * sizeof(_Entity));
+    for (uint32_t i = 0; i < w->def.componentDefCount; ++i) {
+        const ComponentDef *d = w->def.componentDefs + i;
+        array *m = &w->componentArrays[d->type].m;
+        assert(m->stride == d->size);
+        SnapshotWriteComponents(out, &extra, d, m->ptr, m->size);
+        SnapshotWrite(out, w->componentEntityMap[d->type],
+                      m->size * sizeof(Entity));
+    }
+    for (uint32_t i = 0; i < w->def.singletonComponentDefCount; ++i) {
+        const ComponentDef *d = w->def.singletonComponentDefs + i;
+        SnapshotWriteComponents(out, &extra, d,
+                                w->singletonComponents[d->type], 1);
     }
+    SnapshotWrite(out, extra.ptr, extra.size);
+    h.extraSize = extra.size;
+    memcpy((char *)out->ptr + start, &h, sizeof(h));
+    array_free(&extra);
+}
+
+typedef struct {
+    const char *p;
+    uint32_t left;
+} SnapshotReader;
+
+// the next section of `size` bytes, NULL past the end
+static const void *SnapshotRead(SnapshotReader *r, uint32_t size) {
+    size = SnapshotAlign(size);
+    if (size > r->left) return NULL;
+    const void *p = r->p;
+    r->p += size;
+    r->left -= size;
+    return p;
+}
+
+static const void *SnapshotReadComponents(SnapshotReader *r,
+                                          const ComponentDef *d,
+                                          uint32_t maxCount, uint32_t *count) {
+    SnapshotArray a;
+    const void *p = SnapshotRead(r, sizeof(a));
+    if (!p) return NULL;
+    memcpy(&a, p, sizeof(a));
+    if (a.size != d->size || a.count > maxCount) return NULL;
+    *count = a.count;
+    if (a.count == 0) return r->p;
+    return SnapshotRead(r, a.size * a.count);
+}
+
+// every component of the entities is in its array and every row of the
+// entity maps names an entity; counts[type] is the size of the array
+static bool SnapshotCheckEntities(const _Entity *entities, uint32_t count,
+                                  const uint32_t *counts) {
+    // EntityGetComponent finds the transform of e at e
+    if (counts[TransformID] < count) return false;
+    for (uint32_t e = 0; e < count; ++e) {
+        const _Entity *_e = entities + e;
+        if (_e->componentCount > MaxComponentCountPerEntity) return false;
+        for (uint32_t i = 0; i < _e->componentCount; ++i) {
+            const _Component *c = _e->components + i;
+            if (c->type >= MaxComponentType || c->index >= counts[c->type] ||
+                (_e->componentBits & ComponentBit(c->type)) == 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+// ComponentDef.check of the `count` components at `comps`
+static bool SnapshotCheckComponents(const ComponentDef *d, const char *comps,
+                                    uint32_t count, const uint8_t *extra,
+                                    uint32_t extraSize) {
+    if (d->check == NULL) return d->load == NULL;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!d->check(comps + i * d->size, extra, extraSize)) return false;
+    }
+    return true;
+}
+
+// checks the whole snapshot first, the hooks included, then copies it with
+// `apply`
+static bool WorldReadSnapshot(World *w, const void *data, uint32_t size,
+                              bool apply) {
+    // the sections, the extra one included, are aligned like when written
+    if (size % 16 != 0) return false;
+    SnapshotReader r = {(const char *)data, size};
+    SnapshotHeader h;
+    const void *p = SnapshotRead(&r, sizeof(h));
+    if (!p) return false;
+    memcpy(&h, p, sizeof(h));
+    if (h.magic != SnapshotMagic || h.version != SnapshotVersion ||
+        h.entityCount == 0 || h.entityCount > MaxEntity ||
+        h.componentDefCount != w->def.componentDefCount ||
+        h.singletonDefCount != w->def.singletonComponentDefCount ||
+        h.extraSize > size || SnapshotAlign(h.extraSize) > size)
+        return false;
+    const uint8_t *extra =
+        (const uint8_t *)data + size - SnapshotAlign(h.extraSize);
+
+    const _Entity *entities =
+        SnapshotRead(&r, h.entityCount * sizeof(_Entity));
+    if (!entities) return false;
+    if (apply) {
+        if (g_entitiesRemoved && h.entityCount < w->entityCount)
+            g_entitiesRemoved(w, h.entityCount);
+        w->entityCount = h.entityCount;
+        memcpy(w->entities, entities, h.entityCount * sizeof(_Entity));
+        memset(w->entities + h.entityCount, 0,
+               (MaxEntity - h.entityCount) * sizeof(_Entity));
+    }
+
+    uint32_t counts[MaxComponentType] = {0};
+    for (uint32_t i = 0; i < w->def.componentDefCount; ++i) {
+        const ComponentDef *d = w->def.componentDefs + i;
+        uint32_t count;
+        const void *comps = SnapshotReadComponents(&r, d, MaxComponent, &count);
+        if (!comps) return false;
+        const Entity *entityMap = SnapshotRead(&r, count * sizeof(Entity));
+        if (!entityMap) return false;
+        if (!apply) {
+            if (!SnapshotCheckComponents(d, comps, count, extra, h.extraSize))
+                return false;
+            for (uint32_t j = 0; j < count; ++j) {
+                if (entityMap[j] >= h.entityCount) return false;
+            }
+            counts[d->type] = count;
+            continue;
+        }
+        array *m = &w->componentArrays[d->type].m;
+        if (d->dtor) {
+            for (uint32_t j = 0; j < m->size; ++j) d->dtor(array_at(m, j));
+        }
+        array_reserve(m, count);
+        m->size = count;
+        memcpy(m->ptr, comps, d->size * count);
+        memcpy(w->componentEntityMap[d->type], entityMap,
+               count * sizeof(Entity));
+        if (d->load) {
+            for (uint32_t j = 0; j < count; ++j) d->load(array_at(m, j), extra);
+        }
+    }
+
+    for (uint32_t i = 0; i < w->def.singletonComponentDefCount; ++i) {
+        const ComponentDef *d = w->def.singletonComponentDefs + i;
+        uint32_t count;
+        const void *comp = SnapshotReadComponents(&r, d, 1, &count);
+        if (!comp || count != 1) return false;
+        if (!apply) {
+            if (!SnapshotCheckComponents(d, comp, 1, extra, h.extraSize))
+                return false;
+            continue;
+        }
+        void *s = w->singletonComponents[d->type];
+        memcpy(s, comp, d->size);
+        if (d->load) d->load(s, extra);
+    }
+
+    if (!apply && !SnapshotCheckEntities(entities, h.entityCount, counts))
+        return false;
+    // what is left is the extra section
+    return r.left == SnapshotAlign(h.extraSize);
+}
+
+bool WorldDeserialize(World *w, const void *data, uint32_t size) {
+    if (!WorldReadSnapshot(w, data, size, false)) return false;
+    WorldReadSnapshot(w, data, size, true);
+    return true;
 }
 
 void WorldPrintStats(World *w) {
@@ -18,6 +18,7 @@ extern "C" {
 typedef uint32_t Entity;
 typedef struct World World;
 typedef void (*System)(World *);
+typedef void (*SystemWithData)(World *, void *);
 typedef struct ComponentArray ComponentArray;
 typedef uint16_t ComponentType;
 typedef struct WorldDef WorldDef;
@@ -26,6 +27,7 @@ typedef struct WorldDef WorldDef;
 #define MaxComponent 1024
 #define MaxComponentType 64
 #define MaxComponentCountPerEntity 8
+#define MaxSystem 32
 
 typedef struct {
     ComponentType type;
@@ -56,6 +58,16 @@ struct ComponentDef {
     uint32_t size;
     void (*ctor)(void *);
     void (*dtor)(void *);
+    // for the components holding pointers, see WorldSerialize; NULL for
+    // plain data. `save` turns the copy in a snapshot into data, e.g. an
+    // asset pointer into its id, and may append what it points to to
+    // `extra`, an array of bytes; `load` turns it back, in the world.
+    // `check` runs on the copy in the snapshot before anything is restored
+    // and returns false when `load` would read past the `extraSize` bytes of
+    // `extra` or find an asset missing or of another type.
+    void (*save)(void *comp, array *extra);
+    void (*load)(void *comp, const uint8_t *extra);
+    bool (*check)(const void *comp, const uint8_t *extra, uint32_t extraSize);
 };
 typedef struct ComponentDef ComponentDef;
 
@@ -66,6 +78,19 @@ struct WorldDef {
     uint32_t singletonComponentDefCount;
 };
 
+// bits of the component types a system reads and writes, systems added
+// without them are assumed to touch everything
+#define ComponentBit(type) (1ull << (type))
+#define SystemAccessAll UINT64_MAX
+
+typedef struct {
+    System func;
+    SystemWithData funcWithData;  // called with `data` when func is NULL
+    void *data;
+    uint64_t reads;
+    uint64_t writes;
+} SystemEntry;
+
 struct World {
     WorldDef def;
     uint32_t entityCount;
@@ -73,7 +98,7 @@ struct World {
     uint32_t componentArrayCount;
     ComponentArray componentArrays[MaxComponentType];
     uint32_t systemCount;
-    System systems[32];
+    SystemEntry systems[MaxSystem];
 
     //uint32_t singletonComponentCount;
     void* singletonComponents[32];
@@ -108,7 +133,14 @@ World *WorldCreate(WorldDef *def);
 void WorldFree(World *w);
 void WorldClear(World *w);
 Entity WorldCreateEntity(World *w);
+// systems run in the order they are added
 void WorldAddSystem(World *w, System f);
+void WorldAddSystemWithAccess(World *w, System f, uint64_t reads,
+                              uint64_t writes);
+// for systems added at run time: placed after the systems that write what it
+// touches and before the first one after those that reads what it writes
+void WorldInsertSystem(World *w, const SystemEntry *s);
+void WorldRemoveSystem(World *w, SystemWithData f, void *data);
 void WorldAddSingletonComponent(World *w, void *comp, int ID);
 void *WorldGetSingletonComponent(World *w, int ID);
 static inline void *WorldGetComponentAt(World *w, ComponentType type,
@@ -117,6 +149,28 @@ static inline void *WorldGetComponentAt(World *w, ComponentType type,
     return array_at(&w->componentArrays[type].m, idx);
 }
 void WorldTick(World *w);
+
+// A snapshot of the entities, the component arrays (the transform hierarchy
+// is in the Transform components) and the singleton components, as a blob
+// appended to `out`, an array of bytes. The systems are not in it. The
+// components are copied as ComponentDef.size bytes and go through
+// ComponentDef.save; the assets they refer to are saved as their ids and
+// must still be there when the snapshot is restored.
+void WorldSerialize(World *w, array *out);
+// replaces the entities and the components of `w` with a snapshot of a world
+// made with the same component defs, in a memcpy per array; false, and `w`
+// unchanged, when `data` is not such a snapshot
+bool WorldDeserialize(World *w, const void *data, uint32_t size);
+// room for `size` bytes at the end of `bytes`, an array of bytes, zeroed up to
+// a multiple of 16; for ComponentDef.save, valid until the next call
+void *WorldSnapshotAppend(array *bytes, uint32_t size);
+
+// called when WorldClear and WorldDeserialize remove the entities from
+// `first` on, before their ids are handed out again; for whatever is kept
+// per entity outside of the world
+typedef void (*EntitiesRemoved)(World *w, Entity first);
+void WorldSetEntitiesRemovedCallback(EntitiesRemoved callback);
+
 void WorldPrintStats(World *w);
 uint32_t WorldGetMemoryUsage(World *w);
 static inline uint32_t WorldGetComponentIndex(World *w, void *comp,
@@ -0,0 +1,104 @@
+#include "frame_alloc.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "jobs.h"
+#include "statistics.h"
+
+struct FrameBlock {
+    struct FrameBlock *next;
+    size_t size;  // of the data that follows the header
+};
+typedef struct FrameBlock FrameBlock;
+
+// header size, keeps the data 16 byte aligned
+#define FrameBlockHeaderSize ((sizeof(FrameBlock) + 15) & ~(size_t)15)
+
+struct FrameArena {
+    FrameBlock *first;
+    FrameBlock *current;
+    size_t offset;  // in current
+    size_t used;    // this frame, alignment padding included
+    uint32_t blockCount;
+};
+typedef struct FrameArena FrameArena;
+
+static FrameArena g_Arenas[JobMaxWorkerCount + 1];
+static size_t g_Peak;
+
+static uint8_t *BlockData(FrameBlock *b) {
+    return (uint8_t *)b + FrameBlockHeaderSize;
+}
+
+static FrameBlock *NewBlock(FrameArena *arena, size_t size) {
+    if (size < FrameAllocBlockSize) size = FrameAllocBlockSize;
+    FrameBlock *b = (FrameBlock *)malloc(FrameBlockHeaderSize + size);
+    count_heap_allocation();
+    b->next = NULL;
+    b->size = size;
+    arena->blockCount++;
+    return b;
+}
+
+void *FrameAlloc(uint32_t threadIndex, size_t size, size_t alignment) {
+    assert(threadIndex <= JobMaxWorkerCount);
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    FrameArena *arena = &g_Arenas[threadIndex];
+    if (arena->current == NULL) {
+        if (arena->first == NULL) arena->first = NewBlock(arena, size);
+        arena->current = arena->first;
+        arena->offset = 0;
+    }
+    for (;;) {
+        FrameBlock *b = arena->current;
+        uintptr_t base = (uintptr_t)BlockData(b);
+        uintptr_t p = (base + arena->offset + alignment - 1) & ~(alignment - 1);
+        if (p + size <= base + b->size) {
+            arena->used += p + size - (base + arena->offset);
+            arena->offset = p + size - base;
+            return (void *)p;
+        }
+        // a new block goes in front of the rest of the chain, it is
+        // reused in the next frames like all others
+        if (b->next == NULL || b->next->size < size + alignment) {
+            FrameBlock *n = NewBlock(arena, size + alignment);
+            n->next = b->next;
+            b->next = n;
+        }
+        arena->current = b->next;
+        arena->offset = 0;
+    }
+}
+
+void FrameAllocReset() {
+    size_t used = 0;
+    uint32_t blockCount = 0;
+    for (uint32_t i = 0; i <= JobMaxWorkerCount; ++i) {
+        FrameArena *arena = &g_Arenas[i];
+        used += arena->used;
+        blockCount += arena->blockCount;
+        arena->current = arena->first;
+        arena->offset = 0;
+        arena->used = 0;
+    }
+    if (used > g_Peak) g_Peak = used;
+    g_statistics.cpu.frameAllocSize = (uint32_t)used;
+    g_statistics.cpu.frameAllocPeak = (uint32_t)g_Peak;
+    g_statistics.cpu.frameAllocBlockCount = blockCount;
+    g_statistics.cpu.heapAllocations = reset_heap_allocation_count();
+}
+
+void FrameAllocShutdown() {
+    for (uint32_t i = 0; i <= JobMaxWorkerCount; ++i) {
+        FrameBlock *b = g_Arenas[i].first;
+        while (b != NULL) {
+            FrameBlock *next = b->next;
+            free(b);
+            b = next;
+        }
+        g_Arenas[i].first = g_Arenas[i].current = NULL;
+        g_Arenas[i].offset = g_Arenas[i].used = 0;
+        g_Arenas[i].blockCount = 0;
+    }
+}
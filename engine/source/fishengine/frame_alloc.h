@@ -0,0 +1,34 @@
+#ifndef FRAME_ALLOC_H
+#define FRAME_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-thread bump allocator for scratch memory that lives until the next
+// FrameBegin. Every job thread (the threadIndex of jobs.h, 0 is the main
+// thread) owns an arena, so allocating takes no lock. A full block moves on
+// to the next block of the arena's chain and only mallocs when the chain
+// ends; blocks are kept across frames, so once the frames reach their
+// high-water mark nothing goes to the heap any more.
+
+#define FrameAllocBlockSize (256 * 1024)
+
+// alignment must be a power of two. Never returns NULL.
+void *FrameAlloc(uint32_t threadIndex, size_t size, size_t alignment);
+
+// drops the allocations of every thread and publishes the statistics of the
+// finished frame (cpu.frameAlloc*, cpu.heapAllocations). Called by the
+// backends' FrameBegin; must not overlap a JobParallelFor.
+void FrameAllocReset();
+// frees all blocks
+void FrameAllocShutdown();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAME_ALLOC_H */
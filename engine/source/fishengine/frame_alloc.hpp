@@ -0,0 +1,45 @@
+#ifndef FRAME_ALLOC_HPP
+#define FRAME_ALLOC_HPP
+
+#include <memory_resource>
+#include <new>
+
+#include "frame_alloc.h"
+
+// C++ front end of frame_alloc.h. Nothing here runs destructors: only put
+// trivially destructible data in frame memory, or containers whose storage
+// is dropped with the frame.
+
+// count default constructed Ts, valid until the next FrameBegin
+template <class T>
+inline T* FrameAllocArray(size_t count, uint32_t threadIndex = 0) {
+    T* p = (T*)FrameAlloc(threadIndex, sizeof(T) * count, alignof(T));
+    for (size_t i = 0; i < count; ++i) new (p + i) T();
+    return p;
+}
+
+// for std::pmr containers, e.g.
+//     FrameMemoryResource frame(threadIndex);
+//     std::pmr::vector<uint32_t> v(&frame);
+// the resource itself is only a thread index and can live on the stack
+class FrameMemoryResource : public std::pmr::memory_resource {
+   public:
+    explicit FrameMemoryResource(uint32_t threadIndex = 0)
+        : m_ThreadIndex(threadIndex) {}
+
+   private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        return FrameAlloc(m_ThreadIndex, bytes, alignment);
+    }
+    // freed all at once by FrameAllocReset
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override {
+        auto* frame = dynamic_cast<const FrameMemoryResource*>(&other);
+        return frame != nullptr && frame->m_ThreadIndex == m_ThreadIndex;
+    }
+
+    uint32_t m_ThreadIndex;
+};
+
+#endif /* FRAME_ALLOC_HPP */
@@ -83,7 +83,9 @@ const char* ApplicationFilePath() {
 #include <filesystem>
 
 // https://stackoverflow.com/questions/4025370/can-an-executable-discover-its-own-path-linux
-std::string ApplicationFilePath() {
+static char g_exe_path[PATH_MAX];
+
+const char* ApplicationFilePath() {
     char dest[PATH_MAX];
     memset(dest, 0, sizeof(dest));
     if (readlink("/proc/self/exe", dest, PATH_MAX) == -1) {
@@ -91,6 +93,8 @@ std::string ApplicationFilePath() {
         abort();
     }
     std::filesystem::path p(dest);
-    return p.parent_path().string();
+    std::string p2 = p.parent_path().string();
+    snprintf(g_exe_path, sizeof(g_exe_path), "%s", p2.c_str());
+    return g_exe_path;
 }
 #endif
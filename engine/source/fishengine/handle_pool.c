@@ -0,0 +1,116 @@
+#include "handle_pool.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+struct HandleSlot {
+    uint32_t generation;
+    bool alive;
+};
+typedef struct HandleSlot HandleSlot;
+
+struct HandlePending {
+    uint32_t handle;
+    uint64_t frame;
+};
+typedef struct HandlePending HandlePending;
+
+static HandleSlot *GetSlot(const HandlePool *p, uint32_t index) {
+    assert(index < p->slots.size);
+    return (HandleSlot *)p->slots.ptr + index;
+}
+
+void HandlePoolInit(HandlePool *p, const char *name) {
+    array_init(&p->slots, sizeof(HandleSlot), 256);
+    array_init(&p->freeList, sizeof(uint32_t), 64);
+    array_init(&p->pending, sizeof(HandlePending), 64);
+    array_push(&p->slots);  // slot 0, zeroed by array_init
+    p->liveCount = 0;
+    p->name = name;
+}
+
+void HandlePoolFree(HandlePool *p) {
+    array_free(&p->slots);
+    array_free(&p->freeList);
+    array_free(&p->pending);
+    p->liveCount = 0;
+}
+
+uint32_t HandlePoolAlloc(HandlePool *p) {
+    uint32_t index;
+    if (p->freeList.size > 0) {
+        index = ((uint32_t *)p->freeList.ptr)[--p->freeList.size];
+    } else {
+        index = p->slots.size;
+        if (index > HandleIndexMask) {
+            printf("[%s] out of handles (%u slots)\n", p->name, index);
+            return 0;
+        }
+        HandleSlot *s = (HandleSlot *)array_push(&p->slots);
+        s->generation = 0;
+        s->alive = false;
+    }
+    HandleSlot *s = GetSlot(p, index);
+    assert(!s->alive);
+    s->alive = true;
+    p->liveCount++;
+    return (s->generation << HandleIndexBits) | index;
+}
+
+bool HandlePoolIsAlive(const HandlePool *p, uint32_t handle) {
+    uint32_t index = HandleIndex(handle);
+    if (index == 0 || index >= p->slots.size) return false;
+    const HandleSlot *s = GetSlot(p, index);
+    return s->alive && s->generation == HandleGeneration(handle);
+}
+
+uint32_t HandlePoolGetSlotCount(const HandlePool *p) { return p->slots.size; }
+
+void HandlePoolRelease(HandlePool *p, uint32_t handle, uint64_t frame) {
+    if (handle == 0) return;
+    if (!HandlePoolIsAlive(p, handle)) {
+        printf("[%s] released a dead handle: %u (slot %u)\n", p->name, handle,
+               HandleIndex(handle));
+        assert(false);
+        return;
+    }
+    GetSlot(p, HandleIndex(handle))->alive = false;
+    p->liveCount--;
+    HandlePending *e = (HandlePending *)array_push(&p->pending);
+    e->handle = handle;
+    e->frame = frame;
+}
+
+uint32_t HandlePoolCollect(HandlePool *p, uint64_t completedFrame,
+                           HandleDestroyFunc destroy, void *ctx) {
+    // released in frame order, so the completed ones are a prefix
+    HandlePending *pending = (HandlePending *)p->pending.ptr;
+    uint32_t n = 0;
+    while (n < p->pending.size && pending[n].frame <= completedFrame) {
+        uint32_t handle = pending[n].handle;
+        if (destroy) destroy(ctx, handle);
+        HandleSlot *s = GetSlot(p, HandleIndex(handle));
+        s->generation = (s->generation + 1) & HandleGenerationMask;
+        *(uint32_t *)array_push(&p->freeList) = HandleIndex(handle);
+        n++;
+    }
+    if (n > 0) {
+        memmove(pending, pending + n,
+                (p->pending.size - n) * sizeof(HandlePending));
+        p->pending.size -= n;
+    }
+    return n;
+}
+
+uint32_t HandlePoolReportLeaks(const HandlePool *p) {
+    for (uint32_t i = 1; i < p->slots.size; ++i) {
+        const HandleSlot *s = GetSlot(p, i);
+        if (s->alive)
+            printf("[%s] leaked handle %u (slot %u)\n", p->name,
+                   (s->generation << HandleIndexBits) | i, i);
+    }
+    if (p->liveCount > 0)
+        printf("[%s] %u handles leaked\n", p->name, p->liveCount);
+    return p->liveCount;
+}
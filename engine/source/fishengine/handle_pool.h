@@ -0,0 +1,68 @@
+#ifndef HANDLE_POOL_H
+#define HANDLE_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Handles for backend objects (buffers, textures, shaders, pipelines). The
+// low HandleIndexBits are a slot in the backend's table, the high bits count
+// how often that slot was reused, so a handle that outlived its object is
+// caught instead of silently aliasing the next one. Slot 0 is never used and
+// 0 stays the "no object" handle.
+#define HandleIndexBits 20
+#define HandleIndexMask ((1u << HandleIndexBits) - 1)
+#define HandleGenerationMask ((1u << (32 - HandleIndexBits)) - 1)
+
+static inline uint32_t HandleIndex(uint32_t handle) {
+    return handle & HandleIndexMask;
+}
+
+static inline uint32_t HandleGeneration(uint32_t handle) {
+    return handle >> HandleIndexBits;
+}
+
+struct HandlePool {
+    array slots;     // HandleSlot, slot 0 is reserved
+    array freeList;  // uint32_t, slots ready to be reused
+    array pending;   // HandlePending, released but maybe still used by the gpu
+    uint32_t liveCount;
+    const char *name;  // for the leak report
+};
+typedef struct HandlePool HandlePool;
+
+void HandlePoolInit(HandlePool *p, const char *name);
+void HandlePoolFree(HandlePool *p);
+
+// reuses a recycled slot if there is one; the backend grows its table to
+// HandlePoolGetSlotCount(). 0 once all HandleIndexMask slots are alive or
+// still pending
+uint32_t HandlePoolAlloc(HandlePool *p);
+bool HandlePoolIsAlive(const HandlePool *p, uint32_t handle);
+// upper bound of HandleIndex() over all handles handed out so far
+uint32_t HandlePoolGetSlotCount(const HandlePool *p);
+
+// the handle is dead right away, but its slot is only destroyed and recycled
+// by the first HandlePoolCollect whose completedFrame reaches `frame`, i.e.
+// once the gpu is done with every frame that could still reference it
+void HandlePoolRelease(HandlePool *p, uint32_t handle, uint64_t frame);
+
+typedef void (*HandleDestroyFunc)(void *ctx, uint32_t handle);
+// calls destroy for every handle released in a frame <= completedFrame,
+// returns how many were destroyed
+uint32_t HandlePoolCollect(HandlePool *p, uint64_t completedFrame,
+                           HandleDestroyFunc destroy, void *ctx);
+
+// prints every handle that is still alive, returns the count
+uint32_t HandlePoolReportLeaks(const HandlePool *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HANDLE_POOL_H */
@@ -0,0 +1,387 @@
+// Runs a project script on the null backend without a window and ticks the
+// world for a fixed number of frames; for profiling the CPU side of the
+// renderer and for catching regressions in the command stream.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "animation.h"
+#include "app.h"
+#include "asset.h"
+#include "camera.h"
+#include "ecs.h"
+#include "frame_alloc.h"
+#include "free_camera.h"
+#include "input.h"
+#include "jobs.h"
+#include "jsbinding.h"
+#include "light.h"
+#include "log.h"
+#include "render_null.h"
+#include "render_queue.h"
+#include "renderable.h"
+#include "script_profiler.h"
+#include "script_worker.h"
+#include "singleton_selection.h"
+#include "singleton_time.h"
+#include "statistics.h"
+#include "texture.h"
+#include "transform.h"
+
+#ifndef countof
+#define countof(x) (sizeof(x) / sizeof((x)[0]))
+#endif
+
+#define COMP(T)                                                        \
+    {                                                                  \
+        .type = T##ID, .name = #T, .size = sizeof(T), .ctor = T##Init, \
+        .dtor = NULL,                                                  \
+    }
+#define COMP2(T)                                                    \
+    {                                                               \
+        .type = T##ID, .name = #T, .size = sizeof(T), .ctor = NULL, \
+        .dtor = NULL,                                               \
+    }
+// components holding pointers, saved by WorldSerialize through their hooks
+#define COMP3(T, free)                                                 \
+    {                                                                  \
+        .type = T##ID, .name = #T, .size = sizeof(T), .ctor = T##Init, \
+        .dtor = free, .save = T##Save, .load = T##Load,                \
+        .check = T##Check,                                             \
+    }
+
+static ComponentDef g_componentDef[] = {
+    COMP(Transform), COMP3(Renderable, NULL),
+    COMP(Camera),    COMP(Light),
+    COMP3(Animation, AnimationFree), COMP(FreeCamera)};
+
+static ComponentDef g_singleComponentDef[] = {
+    COMP(SingletonTransformManager), COMP(SingletonInput),
+    COMP2(SingletonTime), COMP(SingletonSelection)};
+
+static const uint32_t g_Width = 1280, g_Height = 800;
+
+static void RenderSystem(World *w) {
+    static RenderQueue queue;
+    if (queue.packets.ptr == NULL) RenderQueueInit(&queue);
+    RenderQueueRenderWorld(&queue, w, (float)g_Width / g_Height);
+}
+
+// wall clock, clock() adds up the time of all threads
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *g_CommandNames[] = {
+    "bind pipeline",  "bind material",  "bind mesh",     "draw",
+    "bind view",      "draw instanced", "create buffer", "delete buffer",
+    "upload",         "create texture", "delete texture", "dispatch",
+};
+
+static void PrintCommands() {
+    uint32_t count;
+    const NullCommand *commands = NullGetCommands(&count);
+    uint32_t perType[countof(g_CommandNames)] = {0};
+    uint32_t uploadSize = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (commands[i].type < countof(g_CommandNames))
+            perType[commands[i].type]++;
+        if (commands[i].type == NullCommandUpload)
+            uploadSize += commands[i].args[1];
+    }
+    printf("last frame: %u commands\n", count);
+    for (uint32_t i = 0; i < countof(g_CommandNames); ++i) {
+        if (perType[i] != 0)
+            printf("  %-16s %u\n", g_CommandNames[i], perType[i]);
+    }
+    printf("  uploaded: %u bytes\n", uploadSize);
+}
+
+static void PrintStatistics() {
+    printf("draw call: %u (instanced: %u, instances: %u)\n",
+           g_statistics.gpu.drawCall, g_statistics.gpu.instancedDrawCall,
+           g_statistics.gpu.instanceCount);
+    printf("pipeline/material/mesh changes: %u/%u/%u, skipped: %u\n",
+           g_statistics.gpu.pipelineChanges, g_statistics.gpu.materialChanges,
+           g_statistics.gpu.meshChanges,
+           g_statistics.gpu.redundantBindsSkipped);
+    printf("renderables visible: %u, culled: %u\n",
+           g_statistics.cpu.visibleRenderables,
+           g_statistics.cpu.culledRenderables);
+    printf("buffers: %u, %u bytes\n", g_statistics.gpu.bufferCount,
+           g_statistics.gpu.bufferSize);
+    printf("textures: %u, %u bytes, %u bindless slots\n",
+           g_statistics.gpu.textureCount, g_statistics.gpu.textureSize,
+           g_statistics.gpu.bindlessTextureCount);
+    printf("pipelines: %u (%u from the cache, %u pending), draws skipped: %u\n",
+           g_statistics.gpu.pipelineCount, g_statistics.gpu.pipelineCacheHits,
+           g_statistics.gpu.pipelinesPending, g_statistics.gpu.drawsSkipped);
+    printf("skinning: %u dispatches, %u vertices\n",
+           g_statistics.gpu.skinningDispatches,
+           g_statistics.gpu.skinnedVertices);
+    printf("texture streaming: %u textures, %u/%u bytes resident/budget, "
+           "%u wanted, %u mips in, %u evicted\n",
+           g_statistics.gpu.streamedTextureCount,
+           g_statistics.gpu.streamingResidentSize,
+           g_statistics.gpu.streamingBudget,
+           g_statistics.gpu.streamingWantedSize,
+           g_statistics.gpu.mipsStreamedIn, g_statistics.gpu.mipsEvicted);
+    printf("upload: %u bytes dynamic, %u bytes static\n",
+           g_statistics.gpu.dynamicUploadSize,
+           g_statistics.gpu.staticUploadSize);
+    printf("frame alloc: %u bytes, peak %u, %u blocks\n",
+           g_statistics.cpu.frameAllocSize, g_statistics.cpu.frameAllocPeak,
+           g_statistics.cpu.frameAllocBlockCount);
+#ifndef NDEBUG
+    printf("heap allocations in the last frame: %u\n",
+           g_statistics.cpu.heapAllocations);
+#endif
+    printf("script: %.3fms, gc %.3fms, heap %u bytes, %u objects, "
+           "%u allocations, %u bytes freed\n",
+           g_statistics.cpu.scriptTimeUs / 1000.0,
+           g_statistics.cpu.scriptGCTimeUs / 1000.0,
+           g_statistics.cpu.scriptHeapSize, g_statistics.cpu.scriptObjectCount,
+           g_statistics.cpu.scriptAllocations,
+           g_statistics.cpu.scriptFreedSize);
+    const UploadRing *ring = NullGetUploadRing();
+    printf("upload ring: %llu bytes allocated, %llu padding, %llu peak, "
+           "%u failed\n",
+           (unsigned long long)ring->allocatedBytes,
+           (unsigned long long)ring->paddingBytes,
+           (unsigned long long)ring->peakUsedBytes, ring->failedCount);
+}
+
+static uint32_t g_LogBenchmarkRecords = 0;
+
+static void *LogBenchmarkThread(void *arg) {
+    const uint16_t category = LogCategory("benchmark");
+    const uint32_t thread = (uint32_t)(uintptr_t)arg;
+    for (uint32_t i = 0; i < g_LogBenchmarkRecords; ++i)
+        LogWriteF(LogLevelInfo, category, "record %u of thread %u", i, thread);
+    return NULL;
+}
+
+// records written and dropped by 1 to 8 threads logging at once, the lines
+// going nowhere so that the log thread formats as fast as it can
+static void RunLogBenchmark(uint32_t records) {
+    LogInit(1 << 14);
+    LogSetOutput(NULL);
+    g_LogBenchmarkRecords = records;
+    for (uint32_t threadCount = 1; threadCount <= 8; threadCount *= 2) {
+        pthread_t threads[8];
+        const LogStats before = LogGetStats();
+        const double start = Now();
+        for (uint32_t i = 0; i < threadCount; ++i)
+            pthread_create(&threads[i], NULL, LogBenchmarkThread,
+                           (void *)(uintptr_t)i);
+        for (uint32_t i = 0; i < threadCount; ++i)
+            pthread_join(threads[i], NULL);
+        const double logged = Now() - start;
+        LogFlush();
+        const double t = Now() - start;
+        const LogStats after = LogGetStats();
+        const uint64_t written = after.written - before.written;
+        const uint64_t dropped = after.dropped - before.dropped;
+        printf("log: %u threads, %.1f M records/s logged, %.1f M/s written, "
+               "%.1f%% dropped\n",
+               threadCount, (written + dropped) / logged * 1e-6,
+               written / t * 1e-6, 100.0 * dropped / (written + dropped));
+    }
+    LogSetOutput(stdout);
+    LogShutdown();
+}
+
+static void RunFrame(SingletonTime *st) {
+    st->deltaTime = 1.f / 60.f;
+    FrameBegin();
+    app_update();
+    FrameEnd();
+    app_frame_end();
+}
+
+// takes a snapshot of the world, runs more frames, restores the snapshot and
+// takes another one, which must be the same; a cut snapshot must be refused
+static bool CheckSnapshot(World *w, SingletonTime *st) {
+    array saved = {.stride = 1}, restored = {.stride = 1};
+    double start = Now();
+    WorldSerialize(w, &saved);
+    const double saveTime = Now() - start;
+    for (uint32_t i = 0; i < 10; ++i) RunFrame(st);
+    start = Now();
+    bool ok = WorldDeserialize(w, saved.ptr, saved.size);
+    const double restoreTime = Now() - start;
+    WorldSerialize(w, &restored);
+    ok = ok && restored.size == saved.size &&
+         memcmp(restored.ptr, saved.ptr, saved.size) == 0 &&
+         !WorldDeserialize(w, saved.ptr, saved.size - 16);
+    printf("snapshot: %u entities, %u bytes, saved in %.3fms, restored in "
+           "%.3fms, round trip %s\n",
+           w->entityCount, saved.size, saveTime * 1000, restoreTime * 1000,
+           ok ? "ok" : "FAILED");
+    array_free(&saved);
+    array_free(&restored);
+    return ok;
+}
+
+static void PrintHelp() {
+    puts(
+        "usage:\n"
+        "FishHeadless index.js [frames] [--record] [--live] [--reload n]\n"
+        "             [--pipeline-cache file] [--texture-budget mb]\n"
+        "             [--script-budget ms] [--script-trace file]\n"
+        "             [--snapshot]\n"
+        "FishHeadless --log-benchmark [records]\n"
+        "  --record    record the command stream and summarize the last frame\n"
+        "  --live      free all assets at exit and list the gpu resources\n"
+        "              that are still alive\n"
+        "  --reload n  unload all assets and reload the script every n frames\n"
+        "  --pipeline-cache file\n"
+        "              load the pipeline keys of an earlier run from file and\n"
+        "              write the ones of this run back to it\n"
+        "  --texture-budget mb\n"
+        "              bytes of streamed texture mips that may be resident\n"
+        "  --script-budget ms\n"
+        "              log the frames that spend more than ms in scripts and\n"
+        "              the systems that took the most\n"
+        "  --script-trace file\n"
+        "              sample the JS stacks and write them with the script\n"
+        "              scopes of the last frames to file, in the Chrome trace\n"
+        "              format\n"
+        "  --snapshot  after the frames, restore a snapshot of the world\n"
+        "              taken 10 frames earlier and check that nothing was\n"
+        "              lost, exit with 1 if something was\n"
+        "  --log-benchmark [records]\n"
+        "              log records, 1000000 by default, from 1 to 8 threads\n"
+        "              at once and print how many were written and dropped");
+}
+
+int main(int argc, char *argv[]) {
+    const char *script = NULL;
+    uint32_t frames = 100;
+    uint32_t reloadInterval = 0;
+    bool record = false, live = false, snapshot = false;
+    const char *pipelineCachePath = NULL;
+    uint32_t textureBudget = 0;
+    double scriptBudget = 0;
+    const char *scriptTracePath = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--help") == 0) {
+            PrintHelp();
+            return 0;
+        } else if (strcmp(argv[i], "--log-benchmark") == 0) {
+            RunLogBenchmark(i + 1 < argc ? (uint32_t)atoi(argv[i + 1])
+                                         : 1000000);
+            return 0;
+        } else if (strcmp(argv[i], "--record") == 0) {
+            record = true;
+        } else if (strcmp(argv[i], "--live") == 0) {
+            live = true;
+        } else if (strcmp(argv[i], "--snapshot") == 0) {
+            snapshot = true;
+        } else if (strcmp(argv[i], "--reload") == 0 && i + 1 < argc) {
+            reloadInterval = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pipeline-cache") == 0 && i + 1 < argc) {
+            pipelineCachePath = argv[++i];
+        } else if (strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+            textureBudget = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--script-budget") == 0 && i + 1 < argc) {
+            scriptBudget = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--script-trace") == 0 && i + 1 < argc) {
+            scriptTracePath = argv[++i];
+        } else if (script == NULL) {
+            script = argv[i];
+        } else {
+            frames = (uint32_t)atoi(argv[i]);
+        }
+    }
+    if (script == NULL || frames == 0) {
+        PrintHelp();
+        return 1;
+    }
+
+    init_global_statistics();
+    JobSystemInit(UINT32_MAX);
+    NullSetViewport(g_Width, g_Height);
+    NullSetRecording(record);
+    if (textureBudget > 0)
+        TextureStreamingSetBudget((uint64_t)textureBudget << 20);
+    ScriptProfilerSetBudget(scriptBudget);
+    if (scriptTracePath != NULL) ScriptProfilerSetSampling(1);
+    if (pipelineCachePath != NULL) {
+        PipelineCache *cache = NullGetPipelineCache();
+        if (PipelineCacheLoad(cache, pipelineCachePath))
+            printf("pipeline cache: %u pipelines\n", cache->entries.size);
+    }
+
+    WorldDef def;
+    def.componentDefs = g_componentDef;
+    def.componentDefCount = countof(g_componentDef);
+    def.singletonComponentDefs = g_singleComponentDef;
+    def.singletonComponentDefCount = countof(g_singleComponentDef);
+    World *world = WorldCreate(&def);
+    // what they touch, so that script systems are scheduled between them
+    const uint64_t transform = ComponentBit(TransformID);
+    WorldAddSystemWithAccess(world, AnimationSystem,
+                             ComponentBit(AnimationID) | transform,
+                             ComponentBit(AnimationID) | transform);
+    WorldAddSystemWithAccess(world, FreeCameraSystem,
+                             ComponentBit(FreeCameraID) | transform,
+                             ComponentBit(FreeCameraID) | transform);
+    WorldAddSystemWithAccess(
+        world, RenderSystem,
+        transform | ComponentBit(RenderableID) | ComponentBit(CameraID) |
+            ComponentBit(LightID) | ComponentBit(AnimationID),
+        0);
+
+    app_set_script(script);
+    app_init(world);
+
+    // fixed time step so that runs are reproducible
+    SingletonTime *st =
+        (SingletonTime *)WorldGetSingletonComponent(world, SingletonTimeID);
+    double minTime = 1e9, maxTime = 0;
+    double start = Now();
+    for (uint32_t i = 0; i < frames; ++i) {
+        if (reloadInterval > 0 && i > 0 && i % reloadInterval == 0) {
+            app_reload();
+            AssetDeleteAll();
+            app_reload2();
+            st = (SingletonTime *)WorldGetSingletonComponent(world,
+                                                             SingletonTimeID);
+        }
+        double frameStart = Now();
+        RunFrame(st);
+        double t = Now() - frameStart;
+        if (t < minTime) minTime = t;
+        if (t > maxTime) maxTime = t;
+    }
+    double total = Now() - start;
+
+    printf("%u frames, time: %lfs\n", frames, total);
+    printf("frame: %.3fms avg, %.3fms min, %.3fms max\n",
+           total * 1000 / frames, minTime * 1000, maxTime * 1000);
+    PrintStatistics();
+    js_fe_print_binding_calls(10);
+    const bool snapshotOk = !snapshot || CheckSnapshot(world, st);
+    if (record) PrintCommands();
+    if (scriptTracePath != NULL && !ScriptProfilerDumpTrace(scriptTracePath))
+        printf("failed to write %s\n", scriptTracePath);
+    if (pipelineCachePath != NULL)
+        PipelineCacheSave(NullGetPipelineCache(), pipelineCachePath);
+    if (live) {
+        app_reload();
+        AssetDeleteAll();
+        printf("%u live resources\n", NullReportLiveResources());
+    }
+
+    ScriptWorkersShutdown();
+    LogShutdown();
+    FrameAllocShutdown();
+    JobSystemShutdown();
+    return snapshotOk ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#include <cstdlib>
+#include <new>
+
+#include "statistics.h"
+
+// Debug builds replace the global operator new so that the std::vectors,
+// strings and other containers of the C++ code show up in
+// cpu_statistics.heapAllocations. new[] and the nothrow forms go through
+// this one; the over-aligned forms are not counted.
+
+#ifndef NDEBUG
+void* operator new(std::size_t size) {
+    count_heap_allocation();
+    if (void* p = std::malloc(size > 0 ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
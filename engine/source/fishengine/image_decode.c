@@ -0,0 +1,1057 @@
+#include "image_decode.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "statistics.h"
+
+// zlib (RFC 1950, 1951), for PNG
+
+// codes up to this length are decoded with one table lookup
+#define InflateFastBits 10
+
+typedef struct {
+    uint16_t fast[1 << InflateFastBits];  // symbol << 4 | length, 0: longer
+    uint16_t count[16];                   // codes of each length
+    uint16_t symbol[288];                 // ordered by code
+} Huffman;
+
+typedef struct {
+    const uint8_t *in;
+    const uint8_t *end;
+    uint64_t bits;  // least significant bit first
+    uint32_t bitCount;
+    uint32_t overrun;  // zero bytes read past the end
+    uint8_t *out;
+    size_t outSize;
+    size_t outCapacity;
+    bool error;
+} Inflate;
+
+static void InflateRefill(Inflate *z) {
+    while (z->bitCount <= 56) {
+        uint64_t b = 0;
+        if (z->in < z->end)
+            b = *z->in++;
+        else
+            z->overrun++;
+        z->bits |= b << z->bitCount;
+        z->bitCount += 8;
+    }
+}
+
+static void InflateConsume(Inflate *z, uint32_t n) {
+    z->bits >>= n;
+    z->bitCount -= n;
+    // the bits past the end are zeros made up by InflateRefill
+    if (z->overrun * 8 > z->bitCount) z->error = true;
+}
+
+// n <= 16
+static uint32_t InflateBits(Inflate *z, uint32_t n) {
+    InflateRefill(z);
+    uint32_t v = (uint32_t)(z->bits & ((1ull << n) - 1));
+    InflateConsume(z, n);
+    return v;
+}
+
+static uint32_t ReverseBits(uint32_t code, uint32_t length) {
+    uint32_t r = 0;
+    for (uint32_t i = 0; i < length; ++i) {
+        r = r << 1 | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+// canonical code of the lengths, incomplete codes are allowed (a distance
+// code with a single symbol), oversubscribed ones are not
+static bool HuffmanBuild(Huffman *h, const uint8_t *lengths, uint32_t n) {
+    memset(h->count, 0, sizeof(h->count));
+    memset(h->fast, 0, sizeof(h->fast));
+    for (uint32_t i = 0; i < n; ++i) h->count[lengths[i]]++;
+    h->count[0] = 0;
+    int left = 1;
+    for (uint32_t len = 1; len < 16; ++len) {
+        left = (left << 1) - h->count[len];
+        if (left < 0) return false;
+    }
+    uint16_t offset[16];
+    offset[1] = 0;
+    for (uint32_t len = 1; len < 15; ++len)
+        offset[len + 1] = offset[len] + h->count[len];
+    for (uint32_t i = 0; i < n; ++i)
+        if (lengths[i] != 0) h->symbol[offset[lengths[i]]++] = (uint16_t)i;
+
+    uint32_t code = 0, index = 0;
+    for (uint32_t len = 1; len <= InflateFastBits; ++len) {
+        for (uint32_t k = 0; k < h->count[len]; ++k, ++code, ++index) {
+            // codes are sent most significant bit first
+            const uint32_t reversed = ReverseBits(code, len);
+            const uint16_t e = (uint16_t)(h->symbol[index] << 4 | len);
+            for (uint32_t i = reversed; i < (1u << InflateFastBits);
+                 i += 1u << len)
+                h->fast[i] = e;
+        }
+        code <<= 1;
+    }
+    return true;
+}
+
+static int HuffmanDecode(Inflate *z, const Huffman *h) {
+    InflateRefill(z);
+    const uint32_t e = h->fast[z->bits & ((1u << InflateFastBits) - 1)];
+    if (e != 0) {
+        InflateConsume(z, e & 15);
+        return e >> 4;
+    }
+    // longer codes, or none
+    int code = 0, first = 0, index = 0;
+    for (uint32_t len = 1; len < 16; ++len) {
+        code |= (int)InflateBits(z, 1);
+        const int count = h->count[len];
+        if (code - count < first) return h->symbol[index + (code - first)];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+static const uint16_t LengthBase[29] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                        1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                        4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DistanceBase[30] = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,
+    97,  129, 193, 257, 385, 513,  769,  1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577};
+static const uint8_t DistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                          4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                          9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static bool InflateCodes(Inflate *z, const Huffman *literal,
+                         const Huffman *distance) {
+    for (;;) {
+        int symbol = HuffmanDecode(z, literal);
+        if (symbol < 0 || z->error) return false;
+        if (symbol < 256) {
+            if (z->outSize == z->outCapacity) return false;
+            z->out[z->outSize++] = (uint8_t)symbol;
+        } else if (symbol == 256) {
+            return true;
+        } else {
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            const size_t length =
+                LengthBase[symbol] + InflateBits(z, LengthExtra[symbol]);
+            const int d = HuffmanDecode(z, distance);
+            if (d < 0 || d >= 30) return false;
+            const size_t back =
+                DistanceBase[d] + InflateBits(z, DistanceExtra[d]);
+            if (z->error || back > z->outSize ||
+                length > z->outCapacity - z->outSize)
+                return false;
+            uint8_t *p = z->out + z->outSize;
+            const uint8_t *q = p - back;
+            // byte by byte, overlapping copies repeat the pattern
+            for (size_t i = 0; i < length; ++i) p[i] = q[i];
+            z->outSize += length;
+        }
+    }
+}
+
+static bool InflateStored(Inflate *z) {
+    InflateBits(z, z->bitCount & 7);  // to the next byte
+    const uint32_t length = InflateBits(z, 16);
+    const uint32_t check = InflateBits(z, 16);
+    if (z->error || (length ^ 0xffff) != check ||
+        length > z->outCapacity - z->outSize)
+        return false;
+    for (uint32_t i = 0; i < length; ++i)
+        z->out[z->outSize++] = (uint8_t)InflateBits(z, 8);
+    return !z->error;
+}
+
+static bool InflateFixed(Inflate *z) {
+    uint8_t lengths[288 + 30];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    memset(lengths + 288, 5, 30);
+    Huffman literal, distance;
+    HuffmanBuild(&literal, lengths, 288);
+    HuffmanBuild(&distance, lengths + 288, 30);
+    return InflateCodes(z, &literal, &distance);
+}
+
+static bool InflateDynamic(Inflate *z) {
+    static const uint8_t order[19] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                      11, 4,  12, 3, 13, 2, 14, 1, 15};
+    const uint32_t literalCount = InflateBits(z, 5) + 257;
+    const uint32_t distanceCount = InflateBits(z, 5) + 1;
+    const uint32_t codeCount = InflateBits(z, 4) + 4;
+    if (literalCount > 286 || distanceCount > 30) return false;
+    uint8_t lengths[286 + 30] = {0};
+    for (uint32_t i = 0; i < codeCount; ++i)
+        lengths[order[i]] = (uint8_t)InflateBits(z, 3);
+    Huffman code;
+    if (!HuffmanBuild(&code, lengths, 19)) return false;
+
+    const uint32_t n = literalCount + distanceCount;
+    uint32_t index = 0;
+    while (index < n) {
+        const int symbol = HuffmanDecode(z, &code);
+        if (symbol < 0 || z->error) return false;
+        if (symbol < 16) {
+            lengths[index++] = (uint8_t)symbol;
+            continue;
+        }
+        uint8_t length = 0;
+        uint32_t repeat;
+        if (symbol == 16) {
+            if (index == 0) return false;
+            length = lengths[index - 1];
+            repeat = 3 + InflateBits(z, 2);
+        } else if (symbol == 17) {
+            repeat = 3 + InflateBits(z, 3);
+        } else {
+            repeat = 11 + InflateBits(z, 7);
+        }
+        if (index + repeat > n) return false;
+        while (repeat--) lengths[index++] = length;
+    }
+    if (lengths[256] == 0) return false;  // no end of block
+    Huffman literal, distance;
+    if (!HuffmanBuild(&literal, lengths, literalCount) ||
+        !HuffmanBuild(&distance, lengths + literalCount, distanceCount))
+        return false;
+    return InflateCodes(z, &literal, &distance);
+}
+
+// the adler32 checksum is not verified, PNG has its own CRCs
+static bool ZlibInflate(const uint8_t *in, size_t size, uint8_t *out,
+                        size_t capacity, size_t *outSize) {
+    if (size < 2) return false;
+    if ((in[0] & 15) != 8 || (in[0] >> 4) > 7 || (in[0] << 8 | in[1]) % 31 ||
+        (in[1] & 0x20))
+        return false;
+    Inflate z;
+    memset(&z, 0, sizeof(z));
+    z.in = in + 2;
+    z.end = in + size;
+    z.out = out;
+    z.outCapacity = capacity;
+    uint32_t last;
+    do {
+        last = InflateBits(&z, 1);
+        bool ok;
+        switch (InflateBits(&z, 2)) {
+            case 0:
+                ok = InflateStored(&z);
+                break;
+            case 1:
+                ok = InflateFixed(&z);
+                break;
+            case 2:
+                ok = InflateDynamic(&z);
+                break;
+            default:
+                ok = false;
+        }
+        if (!ok || z.error) return false;
+    } while (!last);
+    *outSize = z.outSize;
+    return true;
+}
+
+// PNG
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t colorType;
+    uint32_t channels;
+    uint8_t palette[256][4];
+    uint32_t paletteSize;
+    bool transparency;  // of gray and RGB images, tRNS
+    uint16_t transparent[3];
+} Png;
+
+static uint32_t ReadBE32(const uint8_t *p) {
+    return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+static uint32_t PngSample(const uint8_t *row, uint32_t depth, uint32_t i) {
+    switch (depth) {
+        case 16:
+            return row[i * 2] << 8 | row[i * 2 + 1];
+        case 8:
+            return row[i];
+        default: {
+            const uint32_t bit = i * depth;
+            return (row[bit >> 3] >> (8 - depth - (bit & 7))) &
+                   ((1u << depth) - 1);
+        }
+    }
+}
+
+static uint8_t PngTo8(uint32_t v, uint32_t depth) {
+    if (depth == 16) return (uint8_t)((v * 255 + 32767) / 65535);
+    return (uint8_t)(v * 255 / ((1u << depth) - 1));
+}
+
+static uint8_t Paeth(int a, int b, int c) {
+    const int p = a + b - c;
+    const int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return (uint8_t)a;
+    return (uint8_t)(pb <= pc ? b : c);
+}
+
+// undoes the filters of the rows of a pass in place, each row is a filter
+// byte and rowBytes of data; bpp is bytes per complete pixel, at least 1
+static bool PngUnfilter(uint8_t *data, uint32_t rowBytes, uint32_t rows,
+                        uint32_t bpp) {
+    const uint8_t *prev = NULL;
+    for (uint32_t y = 0; y < rows; ++y) {
+        uint8_t *row = data + (size_t)y * (rowBytes + 1);
+        uint8_t *cur = row + 1;
+        switch (row[0]) {
+            case 0:
+                break;
+            case 1:
+                for (uint32_t x = bpp; x < rowBytes; ++x)
+                    cur[x] += cur[x - bpp];
+                break;
+            case 2:
+                if (prev)
+                    for (uint32_t x = 0; x < rowBytes; ++x) cur[x] += prev[x];
+                break;
+            case 3:
+                for (uint32_t x = 0; x < rowBytes; ++x) {
+                    const uint32_t a = x >= bpp ? cur[x - bpp] : 0;
+                    const uint32_t b = prev ? prev[x] : 0;
+                    cur[x] += (uint8_t)((a + b) / 2);
+                }
+                break;
+            case 4:
+                for (uint32_t x = 0; x < rowBytes; ++x) {
+                    const int a = x >= bpp ? cur[x - bpp] : 0;
+                    const int b = prev ? prev[x] : 0;
+                    const int c = prev && x >= bpp ? prev[x - bpp] : 0;
+                    cur[x] += Paeth(a, b, c);
+                }
+                break;
+            default:
+                return false;
+        }
+        prev = cur;
+    }
+    return true;
+}
+
+// converts `count` pixels of an unfiltered row to RGBA8, `step` pixels apart
+static bool PngExpandRow(const Png *png, const uint8_t *row, uint32_t count,
+                         uint8_t *out, uint32_t step) {
+    const uint32_t d = png->depth;
+    for (uint32_t i = 0; i < count; ++i, out += step * 4) {
+        uint32_t s[4];
+        switch (png->colorType) {
+            case 0:  // gray
+                s[0] = PngSample(row, d, i);
+                out[0] = out[1] = out[2] = PngTo8(s[0], d);
+                out[3] = png->transparency && s[0] == png->transparent[0]
+                             ? 0
+                             : 255;
+                break;
+            case 2:  // RGB
+                for (uint32_t c = 0; c < 3; ++c) {
+                    s[c] = PngSample(row, d, i * 3 + c);
+                    out[c] = PngTo8(s[c], d);
+                }
+                out[3] = png->transparency && s[0] == png->transparent[0] &&
+                                 s[1] == png->transparent[1] &&
+                                 s[2] == png->transparent[2]
+                             ? 0
+                             : 255;
+                break;
+            case 3:  // palette
+                s[0] = PngSample(row, d, i);
+                if (s[0] >= png->paletteSize) return false;
+                memcpy(out, png->palette[s[0]], 4);
+                break;
+            case 4:  // gray, alpha
+                out[0] = out[1] = out[2] = PngTo8(PngSample(row, d, i * 2), d);
+                out[3] = PngTo8(PngSample(row, d, i * 2 + 1), d);
+                break;
+            default:  // RGBA
+                for (uint32_t c = 0; c < 4; ++c)
+                    out[c] = PngTo8(PngSample(row, d, i * 4 + c), d);
+                break;
+        }
+    }
+    return true;
+}
+
+// the seven passes of Adam7, an image that is not interlaced has one
+static const uint8_t Adam7[7][4] = {
+    // x0, y0, dx, dy
+    {0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4},
+    {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2},
+};
+static const uint8_t NoInterlace[1][4] = {{0, 0, 1, 1}};
+
+static uint32_t PassSize(uint32_t size, uint32_t start, uint32_t step) {
+    return size > start ? (size - start + step - 1) / step : 0;
+}
+
+static bool DecodePng(const uint8_t *data, size_t size, Image *image,
+                      const char **error) {
+    Png png;
+    memset(&png, 0, sizeof(png));
+    uint32_t interlace = 0;
+    uint8_t *idat = NULL;
+    size_t idatSize = 0, idatCapacity = 0;
+    uint8_t *raw = NULL;
+    bool header = false;
+
+    *error = "truncated PNG";
+    size_t pos = 8;
+    for (;;) {
+        if (size - pos < 12) goto FAIL;
+        const uint32_t length = ReadBE32(data + pos);
+        const uint8_t *type = data + pos + 4;
+        const uint8_t *chunk = data + pos + 8;
+        if (length > size - pos - 12) goto FAIL;
+        pos += 12 + (size_t)length;
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            *error = "bad PNG header";
+            if (length != 13 || header) goto FAIL;
+            header = true;
+            png.width = ReadBE32(chunk);
+            png.height = ReadBE32(chunk + 4);
+            png.depth = chunk[8];
+            png.colorType = chunk[9];
+            interlace = chunk[12];
+            if (chunk[10] != 0 || chunk[11] != 0 || interlace > 1) goto FAIL;
+            const uint32_t d = png.depth;
+            switch (png.colorType) {
+                case 0:
+                    png.channels = 1;
+                    if (d != 1 && d != 2 && d != 4 && d != 8 && d != 16)
+                        goto FAIL;
+                    break;
+                case 3:
+                    png.channels = 1;
+                    if (d != 1 && d != 2 && d != 4 && d != 8) goto FAIL;
+                    break;
+                case 2:
+                case 4:
+                case 6:
+                    png.channels = png.colorType == 2 ? 3
+                                   : png.colorType == 4 ? 2
+                                                        : 4;
+                    if (d != 8 && d != 16) goto FAIL;
+                    break;
+                default:
+                    goto FAIL;
+            }
+            *error = "PNG too large";
+            if (png.width == 0 || png.height == 0 ||
+                png.width > ImageMaxSize || png.height > ImageMaxSize)
+                goto FAIL;
+        } else if (!header) {
+            *error = "bad PNG header";
+            goto FAIL;
+        } else if (memcmp(type, "PLTE", 4) == 0) {
+            *error = "bad PNG palette";
+            if (length % 3 != 0 || length > 256 * 3) goto FAIL;
+            png.paletteSize = length / 3;
+            for (uint32_t i = 0; i < png.paletteSize; ++i) {
+                memcpy(png.palette[i], chunk + i * 3, 3);
+                png.palette[i][3] = 255;
+            }
+        } else if (memcmp(type, "tRNS", 4) == 0) {
+            *error = "bad PNG transparency";
+            if (png.colorType == 3) {
+                if (length > png.paletteSize) goto FAIL;
+                for (uint32_t i = 0; i < length; ++i)
+                    png.palette[i][3] = chunk[i];
+            } else if (png.colorType == 0 || png.colorType == 2) {
+                const uint32_t n = png.colorType == 0 ? 1 : 3;
+                if (length != n * 2) goto FAIL;
+                png.transparency = true;
+                for (uint32_t c = 0; c < n; ++c)
+                    png.transparent[c] = chunk[c * 2] << 8 | chunk[c * 2 + 1];
+            }
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            // an empty one grows nothing, idat may still be NULL
+            if (length == 0) continue;
+            if (idatSize + length > idatCapacity) {
+                idatCapacity = (idatSize + length) * 2;
+                uint8_t *p = realloc(idat, idatCapacity);
+                count_heap_allocation();
+                *error = "out of memory";
+                if (p == NULL) goto FAIL;
+                idat = p;
+            }
+            memcpy(idat + idatSize, chunk, length);
+            idatSize += length;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            break;
+        }
+        // ancillary chunks (gamma, text, ...) are skipped
+    }
+    *error = "PNG without palette";
+    if (png.colorType == 3 && png.paletteSize == 0) goto FAIL;
+
+    const uint8_t(*passes)[4] = interlace ? Adam7 : NoInterlace;
+    const uint32_t passCount = interlace ? 7 : 1;
+    const uint32_t bitsPerPixel = png.channels * png.depth;
+    const uint32_t bpp = bitsPerPixel < 8 ? 1 : bitsPerPixel / 8;
+    size_t rawSize = 0;
+    for (uint32_t p = 0; p < passCount; ++p) {
+        const uint32_t w = PassSize(png.width, passes[p][0], passes[p][2]);
+        const uint32_t h = PassSize(png.height, passes[p][1], passes[p][3]);
+        if (w == 0 || h == 0) continue;
+        rawSize += ((size_t)(w * bitsPerPixel + 7) / 8 + 1) * h;
+    }
+    raw = malloc(rawSize);
+    count_heap_allocation();
+    image->pixels = malloc((size_t)png.width * png.height * 4);
+    count_heap_allocation();
+    *error = "out of memory";
+    if (raw == NULL || image->pixels == NULL) goto FAIL;
+    size_t inflated;
+    *error = "bad PNG data";
+    if (idat == NULL ||
+        !ZlibInflate(idat, idatSize, raw, rawSize, &inflated) ||
+        inflated != rawSize)
+        goto FAIL;
+
+    uint8_t *pass = raw;
+    for (uint32_t p = 0; p < passCount; ++p) {
+        const uint32_t x0 = passes[p][0], y0 = passes[p][1];
+        const uint32_t dx = passes[p][2], dy = passes[p][3];
+        const uint32_t w = PassSize(png.width, x0, dx);
+        const uint32_t h = PassSize(png.height, y0, dy);
+        if (w == 0 || h == 0) continue;
+        const uint32_t rowBytes = (w * bitsPerPixel + 7) / 8;
+        if (!PngUnfilter(pass, rowBytes, h, bpp)) goto FAIL;
+        for (uint32_t y = 0; y < h; ++y) {
+            uint8_t *out = image->pixels +
+                           ((size_t)(y0 + y * dy) * png.width + x0) * 4;
+            const uint8_t *row = pass + (size_t)y * (rowBytes + 1) + 1;
+            if (!PngExpandRow(&png, row, w, out, dx)) goto FAIL;
+        }
+        pass += (size_t)(rowBytes + 1) * h;
+    }
+    free(idat);
+    free(raw);
+    image->width = png.width;
+    image->height = png.height;
+    *error = NULL;
+    return true;
+
+FAIL:
+    free(idat);
+    free(raw);
+    ImageFree(image);
+    return false;
+}
+
+// baseline JPEG (ITU T.81), sequential Huffman coding only
+
+#define JpegFastBits 9
+
+typedef struct {
+    uint16_t fast[1 << JpegFastBits];  // value | length << 8, 0: longer
+    uint8_t values[256];
+    uint32_t maxCode[18];  // first code past each length, << (16 - length)
+    int delta[17];         // value index - code, of each length
+    uint32_t count;
+    bool defined;
+} JpegHuffman;
+
+typedef struct {
+    uint32_t id;
+    uint32_t h, v;  // sampling factors
+    uint32_t tq, td, ta;
+    int dcPrediction;
+    uint32_t blocksW, blocksH;  // of the plane, whole MCUs
+    uint8_t *plane;
+} JpegComponent;
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t bits;  // most significant bit first
+    int count;
+    int marker;  // the marker that ended the entropy coded data, or 0
+
+    uint16_t quant[4][64];  // natural order
+    bool quantDefined[4];
+    JpegHuffman dc[4];
+    JpegHuffman ac[4];
+    JpegComponent components[3];
+    uint32_t componentCount;
+    uint32_t width, height;
+    uint32_t hmax, vmax;
+    uint32_t mcusX, mcusY;
+    uint32_t restartInterval;
+    bool frame;
+    bool rgb;       // Adobe APP14 says the components are not YCbCr
+    float idct[8][8];  // [x][u]
+} Jpeg;
+
+static const uint8_t ZigZag[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+static uint32_t ReadBE16(const uint8_t *p) { return p[0] << 8 | p[1]; }
+
+static bool JpegBuildHuffman(JpegHuffman *h, const uint8_t *counts,
+                             const uint8_t *values) {
+    uint8_t sizes[257];
+    uint16_t codes[256];
+    uint32_t k = 0;
+    for (uint32_t len = 1; len <= 16; ++len)
+        for (uint32_t i = 0; i < counts[len - 1]; ++i) sizes[k++] = len;
+    sizes[k] = 0;
+    h->count = k;
+    memcpy(h->values, values, k);
+
+    uint32_t code = 0;
+    k = 0;
+    for (uint32_t len = 1; len <= 16; ++len) {
+        h->delta[len] = (int)k - (int)code;
+        while (sizes[k] == len) codes[k++] = (uint16_t)code++;
+        if (code > (1u << len)) return false;
+        h->maxCode[len] = code << (16 - len);
+        code <<= 1;
+    }
+    h->maxCode[17] = UINT32_MAX;
+
+    memset(h->fast, 0, sizeof(h->fast));
+    for (uint32_t i = 0; i < h->count; ++i) {
+        const uint32_t len = sizes[i];
+        if (len > JpegFastBits) break;
+        const uint32_t first = codes[i] << (JpegFastBits - len);
+        for (uint32_t j = 0; j < (1u << (JpegFastBits - len)); ++j)
+            h->fast[first + j] = (uint16_t)(h->values[i] | len << 8);
+    }
+    h->defined = true;
+    return true;
+}
+
+static void JpegFill(Jpeg *j) {
+    while (j->count <= 24) {
+        uint32_t b = 0;
+        if (j->marker == 0 && j->p < j->end) {
+            b = *j->p++;
+            if (b == 0xff) {
+                while (j->p < j->end && *j->p == 0xff) j->p++;  // fill bytes
+                const uint32_t next = j->p < j->end ? *j->p++ : 0xd9;
+                if (next != 0) {
+                    j->marker = (int)next;
+                    b = 0;
+                }
+            }
+        }
+        j->bits |= b << (24 - j->count);
+        j->count += 8;
+    }
+}
+
+static int JpegDecode(Jpeg *j, const JpegHuffman *h) {
+    JpegFill(j);
+    const uint32_t e = h->fast[j->bits >> (32 - JpegFastBits)];
+    if (e != 0) {
+        const uint32_t len = e >> 8;
+        j->bits <<= len;
+        j->count -= (int)len;
+        return (int)(e & 255);
+    }
+    const uint32_t top = j->bits >> 16;
+    uint32_t len = JpegFastBits + 1;
+    while (top >= h->maxCode[len]) len++;
+    if (len > 16) return -1;
+    const int index = (int)(j->bits >> (32 - len)) + h->delta[len];
+    if (index < 0 || index >= (int)h->count) return -1;
+    j->bits <<= len;
+    j->count -= (int)len;
+    return h->values[index];
+}
+
+// the next n bits as a signed coefficient, n <= 15
+static int JpegReceive(Jpeg *j, uint32_t n) {
+    if (n == 0) return 0;
+    JpegFill(j);
+    const int v = (int)(j->bits >> (32 - n));
+    j->bits <<= n;
+    j->count -= (int)n;
+    return v < (1 << (n - 1)) ? v - (1 << n) + 1 : v;
+}
+
+static void JpegIdct(const Jpeg *j, const float *in, uint8_t *out,
+                     uint32_t stride) {
+    float rows[64];
+    for (uint32_t y = 0; y < 8; ++y) {
+        for (uint32_t x = 0; x < 8; ++x) {
+            float s = 0;
+            for (uint32_t u = 0; u < 8; ++u) s += j->idct[x][u] * in[y * 8 + u];
+            rows[y * 8 + x] = s;
+        }
+    }
+    for (uint32_t x = 0; x < 8; ++x) {
+        for (uint32_t y = 0; y < 8; ++y) {
+            float s = 128.5f;
+            for (uint32_t v = 0; v < 8; ++v)
+                s += j->idct[y][v] * rows[v * 8 + x];
+            out[y * stride + x] = s <= 0 ? 0 : s >= 255 ? 255 : (uint8_t)s;
+        }
+    }
+}
+
+static bool JpegDecodeBlock(Jpeg *j, JpegComponent *c, uint32_t bx,
+                            uint32_t by) {
+    const uint16_t *q = j->quant[c->tq];
+    float coefficients[64] = {0};
+    const int t = JpegDecode(j, &j->dc[c->td]);
+    if (t < 0 || t > 11) return false;
+    c->dcPrediction += JpegReceive(j, (uint32_t)t);
+    coefficients[0] = (float)(c->dcPrediction * q[0]);
+    for (uint32_t k = 1; k < 64;) {
+        const int rs = JpegDecode(j, &j->ac[c->ta]);
+        if (rs < 0) return false;
+        const uint32_t run = (uint32_t)rs >> 4, s = (uint32_t)rs & 15;
+        if (s == 0) {
+            if (run != 15) break;  // end of block
+            k += 16;
+            continue;
+        }
+        k += run;
+        if (k > 63) return false;
+        const uint32_t z = ZigZag[k++];
+        coefficients[z] = (float)(JpegReceive(j, s) * q[z]);
+    }
+    const uint32_t stride = c->blocksW * 8;
+    JpegIdct(j, coefficients, c->plane + (size_t)by * 8 * stride + bx * 8,
+             stride);
+    return true;
+}
+
+// after every restartInterval MCUs: the bits left are padding, then RSTn
+static bool JpegRestart(Jpeg *j) {
+    if (j->marker == 0) {
+        while (j->p + 1 < j->end &&
+               !(j->p[0] == 0xff && j->p[1] >= 0xd0 && j->p[1] <= 0xd7))
+            j->p++;
+        if (j->p + 1 >= j->end) return false;
+        j->marker = j->p[1];
+        j->p += 2;
+    }
+    if (j->marker < 0xd0 || j->marker > 0xd7) return false;
+    j->marker = 0;
+    j->bits = 0;
+    j->count = 0;
+    for (uint32_t i = 0; i < j->componentCount; ++i)
+        j->components[i].dcPrediction = 0;
+    return true;
+}
+
+static bool JpegDecodeScan(Jpeg *j, JpegComponent **scan, uint32_t n) {
+    j->bits = 0;
+    j->count = 0;
+    j->marker = 0;
+    for (uint32_t i = 0; i < n; ++i) scan[i]->dcPrediction = 0;
+    // a single component is not interleaved, its MCU is one block
+    uint32_t mcusX = j->mcusX, mcusY = j->mcusY;
+    if (n == 1) {
+        const JpegComponent *c = scan[0];
+        const uint32_t w = (j->width * c->h + j->hmax - 1) / j->hmax;
+        const uint32_t h = (j->height * c->v + j->vmax - 1) / j->vmax;
+        mcusX = (w + 7) / 8;
+        mcusY = (h + 7) / 8;
+    }
+    uint32_t mcu = 0;
+    for (uint32_t my = 0; my < mcusY; ++my) {
+        for (uint32_t mx = 0; mx < mcusX; ++mx, ++mcu) {
+            if (j->restartInterval && mcu > 0 &&
+                mcu % j->restartInterval == 0 && !JpegRestart(j))
+                return false;
+            if (n == 1) {
+                if (!JpegDecodeBlock(j, scan[0], mx, my)) return false;
+                continue;
+            }
+            for (uint32_t i = 0; i < n; ++i) {
+                JpegComponent *c = scan[i];
+                for (uint32_t v = 0; v < c->v; ++v)
+                    for (uint32_t h = 0; h < c->h; ++h)
+                        if (!JpegDecodeBlock(j, c, mx * c->h + h,
+                                             my * c->v + v))
+                            return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool JpegReadFrame(Jpeg *j, const uint8_t *s, uint32_t length,
+                          const char **error) {
+    *error = "bad JPEG frame";
+    if (j->frame || length < 6) return false;
+    if (s[0] != 8) {
+        *error = "JPEG with more than 8 bits per sample";
+        return false;
+    }
+    j->height = ReadBE16(s + 1);
+    j->width = ReadBE16(s + 3);
+    if (s[5] != 1 && s[5] != 3) {
+        *error = "JPEG that is not grayscale or YCbCr";
+        return false;
+    }
+    j->componentCount = s[5];
+    if (length != 6 + j->componentCount * 3) return false;
+    if (j->width == 0 || j->height == 0) return false;
+    j->hmax = j->vmax = 1;
+    for (uint32_t i = 0; i < j->componentCount; ++i) {
+        JpegComponent *c = j->components + i;
+        const uint8_t *p = s + 6 + i * 3;
+        c->id = p[0];
+        c->h = p[1] >> 4;
+        c->v = p[1] & 15;
+        c->tq = p[2];
+        if (c->h < 1 || c->h > 4 || c->v < 1 || c->v > 4 || c->tq > 3)
+            return false;
+        if (c->h > j->hmax) j->hmax = c->h;
+        if (c->v > j->vmax) j->vmax = c->v;
+    }
+    j->mcusX = (j->width + j->hmax * 8 - 1) / (j->hmax * 8);
+    j->mcusY = (j->height + j->vmax * 8 - 1) / (j->vmax * 8);
+    for (uint32_t i = 0; i < j->componentCount; ++i) {
+        JpegComponent *c = j->components + i;
+        c->blocksW = j->mcusX * c->h;
+        c->blocksH = j->mcusY * c->v;
+        c->plane = malloc((size_t)c->blocksW * c->blocksH * 64);
+        count_heap_allocation();
+        *error = "out of memory";
+        if (c->plane == NULL) return false;
+        memset(c->plane, 128, (size_t)c->blocksW * c->blocksH * 64);
+    }
+    j->frame = true;
+    return true;
+}
+
+static bool JpegReadTables(Jpeg *j, uint32_t marker, const uint8_t *s,
+                           uint32_t length) {
+    if (marker == 0xdb) {  // DQT
+        while (length > 0) {
+            const uint32_t precision = s[0] >> 4, t = s[0] & 15;
+            const uint32_t n = precision ? 129 : 65;
+            if (t > 3 || precision > 1 || length < n) return false;
+            for (uint32_t k = 0; k < 64; ++k)
+                j->quant[t][ZigZag[k]] = (uint16_t)(
+                    precision ? ReadBE16(s + 1 + k * 2) : s[1 + k]);
+            j->quantDefined[t] = true;
+            s += n;
+            length -= n;
+        }
+        return true;
+    }
+    while (length > 0) {  // DHT
+        if (length < 17) return false;
+        const uint32_t tc = s[0] >> 4, th = s[0] & 15;
+        if (tc > 1 || th > 3) return false;
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < 16; ++i) n += s[1 + i];
+        if (n > 256 || length < 17 + n) return false;
+        if (!JpegBuildHuffman(tc ? j->ac + th : j->dc + th, s + 1, s + 17))
+            return false;
+        s += 17 + n;
+        length -= 17 + n;
+    }
+    return true;
+}
+
+static bool JpegReadScan(Jpeg *j, const uint8_t *s, uint32_t length,
+                         const char **error) {
+    *error = "bad JPEG scan";
+    if (!j->frame || length < 1) return false;
+    const uint32_t n = s[0];
+    if (n < 1 || n > j->componentCount || length != 4 + n * 2) return false;
+    JpegComponent *scan[3];
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint8_t *p = s + 1 + i * 2;
+        scan[i] = NULL;
+        for (uint32_t k = 0; k < j->componentCount; ++k)
+            if (j->components[k].id == p[0]) scan[i] = j->components + k;
+        if (scan[i] == NULL) return false;
+        scan[i]->td = p[1] >> 4;
+        scan[i]->ta = p[1] & 15;
+        if (scan[i]->td > 3 || scan[i]->ta > 3 ||
+            !j->dc[scan[i]->td].defined || !j->ac[scan[i]->ta].defined ||
+            !j->quantDefined[scan[i]->tq])
+            return false;
+    }
+    const uint8_t *p = s + 1 + n * 2;
+    if (p[0] != 0 || p[1] != 63 || p[2] != 0) return false;
+    *error = "bad JPEG data";
+    return JpegDecodeScan(j, scan, n);
+}
+
+static void JpegToRGBA(const Jpeg *j, uint8_t *pixels) {
+    for (uint32_t y = 0; y < j->height; ++y) {
+        const uint8_t *rows[3];
+        for (uint32_t i = 0; i < j->componentCount; ++i) {
+            const JpegComponent *c = j->components + i;
+            rows[i] = c->plane + (size_t)(y * c->v / j->vmax) * c->blocksW * 8;
+        }
+        uint8_t *out = pixels + (size_t)y * j->width * 4;
+        for (uint32_t x = 0; x < j->width; ++x, out += 4) {
+            int s[3];
+            for (uint32_t i = 0; i < j->componentCount; ++i)
+                s[i] = rows[i][x * j->components[i].h / j->hmax];
+            if (j->componentCount == 1) {
+                out[0] = out[1] = out[2] = (uint8_t)s[0];
+            } else if (j->rgb) {
+                out[0] = (uint8_t)s[0];
+                out[1] = (uint8_t)s[1];
+                out[2] = (uint8_t)s[2];
+            } else {
+                // JFIF YCbCr, 16.16 fixed point
+                const int y16 = (s[0] << 16) + 32768;
+                const int cb = s[1] - 128, cr = s[2] - 128;
+                const int r = (y16 + 91881 * cr) >> 16;
+                const int g = (y16 - 22554 * cb - 46802 * cr) >> 16;
+                const int b = (y16 + 116130 * cb) >> 16;
+                out[0] = (uint8_t)(r < 0 ? 0 : r > 255 ? 255 : r);
+                out[1] = (uint8_t)(g < 0 ? 0 : g > 255 ? 255 : g);
+                out[2] = (uint8_t)(b < 0 ? 0 : b > 255 ? 255 : b);
+            }
+            out[3] = 255;
+        }
+    }
+}
+
+static bool DecodeJpeg(const uint8_t *data, size_t size, Image *image,
+                       const char **error) {
+    Jpeg *j = malloc(sizeof(Jpeg));
+    count_heap_allocation();
+    memset(j, 0, sizeof(*j));
+    for (uint32_t x = 0; x < 8; ++x)
+        for (uint32_t u = 0; u < 8; ++u)
+            j->idct[x][u] = (u == 0 ? sqrtf(0.125f) : 0.5f) *
+                            cosf((2 * x + 1) * u * 3.14159265f / 16);
+
+    bool ok = false;
+    size_t pos = 2;
+    for (;;) {
+        *error = "truncated JPEG";
+        while (pos < size && data[pos] != 0xff) pos++;  // garbage
+        while (pos < size && data[pos] == 0xff) pos++;  // fill bytes
+        if (pos >= size) break;
+        const uint32_t marker = data[pos++];
+        if (marker == 0xd9) {  // EOI
+            ok = j->frame;
+            break;
+        }
+        if (marker == 0xd8 || (marker >= 0xd0 && marker <= 0xd7)) continue;
+        if (size - pos < 2) break;
+        const uint32_t length = ReadBE16(data + pos);
+        if (length < 2 || length > size - pos) break;
+        const uint8_t *s = data + pos + 2;
+        pos += length;
+
+        if (marker == 0xc0 || marker == 0xc1) {
+            if (!JpegReadFrame(j, s, length - 2, error)) break;
+        } else if (marker == 0xc2 || marker == 0xc6 || marker == 0xca ||
+                   marker == 0xce) {
+            *error = "progressive JPEG";
+            break;
+        } else if (marker >= 0xc3 && marker <= 0xcf && marker != 0xc4 &&
+                   marker != 0xc8 && marker != 0xcc) {
+            *error = "lossless or arithmetic coded JPEG";
+            break;
+        } else if (marker == 0xc4 || marker == 0xdb) {
+            *error = "bad JPEG tables";
+            if (!JpegReadTables(j, marker, s, length - 2)) break;
+        } else if (marker == 0xdd) {  // DRI
+            if (length != 4) break;
+            j->restartInterval = ReadBE16(s);
+        } else if (marker == 0xee) {  // APP14
+            if (length >= 14 && memcmp(s, "Adobe", 5) == 0)
+                j->rgb = s[11] == 0;
+        } else if (marker == 0xda) {  // SOS
+            j->p = data + pos;
+            j->end = data + size;
+            if (!JpegReadScan(j, s, length - 2, error)) break;
+            // the entropy coded data ends at the next marker
+            pos = j->p - data;
+            if (j->marker != 0) pos -= 2;
+        }
+        // APPn, COM and the rest are skipped
+    }
+    if (ok) {
+        image->width = j->width;
+        image->height = j->height;
+        image->pixels = malloc((size_t)j->width * j->height * 4);
+        count_heap_allocation();
+        *error = "out of memory";
+        ok = image->pixels != NULL;
+        if (ok) JpegToRGBA(j, image->pixels);
+    }
+    for (uint32_t i = 0; i < j->componentCount; ++i)
+        free(j->components[i].plane);
+    free(j);
+    if (ok) *error = NULL;
+    return ok;
+}
+
+bool ImageDecode(const uint8_t *data, size_t size, Image *image,
+                 const char **error) {
+    static const uint8_t pngSignature[8] = {0x89, 'P',  'N',  'G',
+                                            '\r', '\n', 0x1a, '\n'};
+    memset(image, 0, sizeof(*image));
+    if (size >= 8 && memcmp(data, pngSignature, 8) == 0)
+        return DecodePng(data, size, image, error);
+    if (size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff)
+        return DecodeJpeg(data, size, image, error);
+    *error = "not a PNG or JPEG file";
+    return false;
+}
+
+bool ImageDecodeFile(const char *path, Image *image, const char **error) {
+    memset(image, 0, sizeof(*image));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        *error = "can not open the file";
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = size > 0 ? malloc((size_t)size) : NULL;
+    count_heap_allocation();
+    bool ok = false;
+    *error = "can not read the file";
+    if (data != NULL && fread(data, (size_t)size, 1, f) == 1)
+        ok = ImageDecode(data, (size_t)size, image, error);
+    fclose(f);
+    free(data);
+    return ok;
+}
+
+void ImageFree(Image *image) {
+    free(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
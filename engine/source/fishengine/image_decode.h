@@ -0,0 +1,37 @@
+#ifndef IMAGE_DECODE_H
+#define IMAGE_DECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decoders for the source images of textures, PNG (all color types and bit
+// depths, interlaced or not) and baseline JPEG (grayscale or YCbCr, any
+// chroma subsampling). Everything is converted to 8 bit RGBA; 16 bit
+// samples are rounded to 8. Progressive and arithmetic coded JPEGs, CMYK and
+// images larger than ImageMaxSize are rejected.
+
+#define ImageMaxSize 16384
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint8_t *pixels;  // RGBA8, rows are width * 4 bytes
+} Image;
+
+// false with a message in *error (a static string) for files that are
+// broken or use a feature listed above
+bool ImageDecode(const uint8_t *data, size_t size, Image *image,
+                 const char **error);
+bool ImageDecodeFile(const char *path, Image *image, const char **error);
+void ImageFree(Image *image);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMAGE_DECODE_H */
@@ -0,0 +1,172 @@
+#include "jobs.h"
+
+#include <assert.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE Thread;
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Cond;
+#define MutexInit(m) InitializeSRWLock(m)
+#define MutexLock(m) AcquireSRWLockExclusive(m)
+#define MutexUnlock(m) ReleaseSRWLockExclusive(m)
+#define CondInit(c) InitializeConditionVariable(c)
+#define CondWait(c, m) SleepConditionVariableSRW(c, m, INFINITE, 0)
+#define CondBroadcast(c) WakeAllConditionVariable(c)
+#define CondSignal(c) WakeConditionVariable(c)
+static uint32_t AtomicFetchAdd(volatile uint32_t *p, uint32_t v) {
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG *)p, (LONG)v);
+}
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Cond;
+#define MutexInit(m) pthread_mutex_init(m, NULL)
+#define MutexLock(m) pthread_mutex_lock(m)
+#define MutexUnlock(m) pthread_mutex_unlock(m)
+#define CondInit(c) pthread_cond_init(c, NULL)
+#define CondWait(c, m) pthread_cond_wait(c, m)
+#define CondBroadcast(c) pthread_cond_broadcast(c)
+#define CondSignal(c) pthread_cond_signal(c)
+static uint32_t AtomicFetchAdd(volatile uint32_t *p, uint32_t v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_ACQ_REL);
+}
+#endif
+
+static struct {
+    Thread threads[JobMaxWorkerCount];
+    uint32_t workerCount;
+    Mutex lock;
+    Cond wake;
+    Cond done;
+    uint64_t generation;  // bumped by every dispatch
+    bool quit;
+    bool running;  // a JobParallelFor is in flight
+
+    JobFunc func;
+    void *ctx;
+    uint32_t count;
+    uint32_t grain;
+    volatile uint32_t next;  // start of the next unclaimed chunk
+    uint32_t busy;           // workers still inside the current dispatch
+} g_Jobs;
+
+static void RunChunks(uint32_t threadIndex) {
+    const uint32_t count = g_Jobs.count, grain = g_Jobs.grain;
+    for (;;) {
+        uint32_t begin = AtomicFetchAdd(&g_Jobs.next, grain);
+        if (begin >= count) break;
+        uint32_t end = count - begin < grain ? count : begin + grain;
+        g_Jobs.func(g_Jobs.ctx, begin, end, threadIndex);
+    }
+}
+
+static void WorkerLoop(uint32_t threadIndex) {
+    uint64_t seen = 0;
+    MutexLock(&g_Jobs.lock);
+    for (;;) {
+        while (!g_Jobs.quit && g_Jobs.generation == seen)
+            CondWait(&g_Jobs.wake, &g_Jobs.lock);
+        if (g_Jobs.quit) break;
+        seen = g_Jobs.generation;
+        MutexUnlock(&g_Jobs.lock);
+        RunChunks(threadIndex);
+        MutexLock(&g_Jobs.lock);
+        if (--g_Jobs.busy == 0) CondSignal(&g_Jobs.done);
+    }
+    MutexUnlock(&g_Jobs.lock);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI WorkerMain(LPVOID arg) {
+    WorkerLoop((uint32_t)(uintptr_t)arg);
+    return 0;
+}
+#else
+static void *WorkerMain(void *arg) {
+    WorkerLoop((uint32_t)(uintptr_t)arg);
+    return NULL;
+}
+#endif
+
+uint32_t JobGetHardwareThreadCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (uint32_t)n : 1;
+#endif
+}
+
+void JobSystemInit(uint32_t workerCount) {
+    assert(g_Jobs.workerCount == 0);
+    if (workerCount == UINT32_MAX) workerCount = JobGetHardwareThreadCount() - 1;
+    if (workerCount > JobMaxWorkerCount) workerCount = JobMaxWorkerCount;
+    MutexInit(&g_Jobs.lock);
+    CondInit(&g_Jobs.wake);
+    CondInit(&g_Jobs.done);
+    g_Jobs.quit = false;
+    g_Jobs.generation = 0;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        void *arg = (void *)(uintptr_t)(i + 1);
+#ifdef _WIN32
+        g_Jobs.threads[i] = CreateThread(NULL, 0, WorkerMain, arg, 0, NULL);
+#else
+        pthread_create(&g_Jobs.threads[i], NULL, WorkerMain, arg);
+#endif
+    }
+    g_Jobs.workerCount = workerCount;
+}
+
+void JobSystemShutdown() {
+    if (g_Jobs.workerCount == 0) return;
+    MutexLock(&g_Jobs.lock);
+    g_Jobs.quit = true;
+    CondBroadcast(&g_Jobs.wake);
+    MutexUnlock(&g_Jobs.lock);
+    for (uint32_t i = 0; i < g_Jobs.workerCount; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(g_Jobs.threads[i], INFINITE);
+        CloseHandle(g_Jobs.threads[i]);
+#else
+        pthread_join(g_Jobs.threads[i], NULL);
+#endif
+    }
+    g_Jobs.workerCount = 0;
+}
+
+uint32_t JobSystemGetThreadCount() { return g_Jobs.workerCount + 1; }
+
+void JobParallelFor(uint32_t count, uint32_t grain, JobFunc func, void *ctx) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    if (g_Jobs.workerCount == 0 || count <= grain) {
+        func(ctx, 0, count, 0);
+        return;
+    }
+
+    MutexLock(&g_Jobs.lock);
+    assert(!g_Jobs.running);
+    g_Jobs.running = true;
+    g_Jobs.func = func;
+    g_Jobs.ctx = ctx;
+    g_Jobs.count = count;
+    g_Jobs.grain = grain;
+    g_Jobs.next = 0;
+    g_Jobs.busy = g_Jobs.workerCount;
+    g_Jobs.generation++;
+    CondBroadcast(&g_Jobs.wake);
+    MutexUnlock(&g_Jobs.lock);
+
+    RunChunks(0);
+
+    MutexLock(&g_Jobs.lock);
+    while (g_Jobs.busy != 0) CondWait(&g_Jobs.done, &g_Jobs.lock);
+    g_Jobs.running = false;
+    MutexUnlock(&g_Jobs.lock);
+}
@@ -0,0 +1,37 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A fixed pool of worker threads for data parallel loops. The calling thread
+// takes part in every JobParallelFor, so without workers (or before
+// JobSystemInit) everything simply runs inline.
+
+#define JobMaxWorkerCount 63
+
+// [begin, end) of the range, threadIndex is 0 for the calling thread and
+// 1..JobSystemGetThreadCount()-1 for the workers
+typedef void (*JobFunc)(void *ctx, uint32_t begin, uint32_t end,
+                        uint32_t threadIndex);
+
+uint32_t JobGetHardwareThreadCount();
+// workerCount == UINT32_MAX: one worker per hardware thread but one
+void JobSystemInit(uint32_t workerCount);
+void JobSystemShutdown();
+// workers + the calling thread
+uint32_t JobSystemGetThreadCount();
+
+// calls func on chunks of at most `grain` items until [0, count) is covered
+// and returns when all of them are done. Not reentrant: do not call it from
+// inside a JobFunc.
+void JobParallelFor(uint32_t count, uint32_t grain, JobFunc func, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JOBS_H */
@@ -1,5 +1,7 @@
 #include "jsbinding.h"
 
+#include <stddef.h>
+
 #include <cutils.h>
 #include <list.h>
 #include <quickjs-libc.h>
@@ -12,6 +14,9 @@
 #include "mesh.h"
 #include "renderable.h"
 #include "rhi.h"
+#include "script_gc.h"
+#include "script_profiler.h"
+#include "script_worker.h"
 #include "texture.h"
 #include "transform.h"
 #include "free_camera.h"
@@ -50,6 +55,68 @@ static JSValue js_wrap_class(JSContext *ctx, void *s, JSClassID classID) {
     return obj;
 }
 
+// one wrapper per entity and per transform, kept alive until the handlers
+// are freed, so that `entity.transform` in a loop does not allocate
+static JSContext *js_handle_ctx = NULL;
+static World *js_handle_world = NULL;
+static JSValue js_entity_handles[MaxEntity];
+static JSValue js_transform_handles[MaxComponent];
+
+// the wrappers of the entities from `first` on and of their transforms, the
+// transform of entity e is component e
+static void js_drop_handles(JSRuntime *rt, Entity first) {
+    for (uint32_t i = first; i < MaxEntity; ++i) {
+        if (JS_VALUE_GET_TAG(js_entity_handles[i]) == JS_TAG_OBJECT)
+            JS_FreeValueRT(rt, js_entity_handles[i]);
+        js_entity_handles[i] = JS_UNDEFINED;
+    }
+    for (uint32_t i = first; i < MaxComponent; ++i) {
+        if (JS_VALUE_GET_TAG(js_transform_handles[i]) == JS_TAG_OBJECT)
+            JS_FreeValueRT(rt, js_transform_handles[i]);
+        js_transform_handles[i] = JS_UNDEFINED;
+    }
+}
+
+static void js_free_handles(JSRuntime *rt) {
+    js_drop_handles(rt, 0);
+    js_handle_ctx = NULL;
+    js_handle_world = NULL;
+}
+
+// a recycled id must not hand back the old object with what scripts set on it
+static void js_entities_removed(World *w, Entity first) {
+    if (js_handle_ctx && w == js_handle_world)
+        js_drop_handles(JS_GetRuntime(js_handle_ctx), first);
+}
+
+static JSValue js_wrap_cached(JSContext *ctx, JSValue *handles, uint32_t idx,
+                              void *s, JSClassID classID) {
+    if (ctx != js_handle_ctx || defaultWorld != js_handle_world) {
+        if (js_handle_ctx) js_free_handles(JS_GetRuntime(js_handle_ctx));
+        js_handle_ctx = ctx;
+        js_handle_world = defaultWorld;
+    }
+    if (JS_VALUE_GET_TAG(handles[idx]) != JS_TAG_OBJECT) {
+        JSValue obj = js_wrap_class(ctx, s, classID);
+        if (JS_VALUE_GET_TAG(obj) != JS_TAG_OBJECT) return obj;
+        handles[idx] = obj;
+    }
+    return JS_DupValue(ctx, handles[idx]);
+}
+
+static JSValue js_wrap_entity(JSContext *ctx, Entity e) {
+    assert(e < MaxEntity);
+    return js_wrap_cached(ctx, js_entity_handles, e, (void *)e,
+                          js_fe_entity_class_id);
+}
+
+static JSValue js_wrap_transform(JSContext *ctx, Transform *t) {
+    if (t == NULL) return JS_NULL;
+    const uint32_t idx = WorldGetComponentIndex(defaultWorld, t, TransformID);
+    return js_wrap_cached(ctx, js_transform_handles, idx, t,
+                          js_fe_Transform_class_id);
+}
+
 #define FUNC(fn)                                                       \
     static JSValue js_fe_##fn(JSContext *ctx, JSValueConst this_value, \
                               int argc, JSValueConst *argv)
@@ -67,7 +134,7 @@ PFUNC(World, CreateEntity) {
     if (!w) return JS_EXCEPTION;
     Entity e = WorldCreateEntity(w);
     //	return JS_NewInt32(ctx, e);
-    return js_wrap_class(ctx, (void *)e, js_fe_entity_class_id);
+    return js_wrap_entity(ctx, e);
 }
 
 PFUNC(World, CreateEntities) {
@@ -80,60 +147,328 @@ PFUNC(World, CreateEntities) {
     return JS_UNDEFINED;
 }
 
-// TODO: delete
+// the fields that can be viewed as typed arrays, in 4 byte elements; not
+// Transform.parent, the child lists have to follow it (transform.parent = p)
+typedef struct {
+    ComponentType type;
+    const char *name;
+    uint32_t offset;
+    uint32_t length;
+    bool isUint;
+} ComponentField;
+
+static const ComponentField js_component_fields[] = {
+    {TransformID, "localRotation", offsetof(Transform, localRotation), 4},
+    {TransformID, "localPosition", offsetof(Transform, localPosition), 3},
+    {TransformID, "localScale", offsetof(Transform, localScale), 3},
+};
+
+static const ComponentField *js_get_component_field(JSContext *ctx,
+                                                    uint32_t type,
+                                                    JSValueConst name) {
+    const char *str = JS_ToCString(ctx, name);
+    if (!str) return NULL;
+    const ComponentField *f = NULL;
+    for (int i = 0; i < countof(js_component_fields); ++i) {
+        if (js_component_fields[i].type == type &&
+            strcmp(js_component_fields[i].name, str) == 0)
+            f = js_component_fields + i;
+    }
+    if (f == NULL)
+        JS_ThrowRangeError(ctx, "no field %s in component %u", str, type);
+    JS_FreeCString(ctx, str);
+    return f;
+}
+
+// entities are handed to query systems in chunks of this many, the component
+// fields packed into one typed array column each
+#define JSSystemChunkSize 256
+#define JSSystemMaxColumns 8
+
+typedef struct {
+    const ComponentField *field;
+    bool write;
+    uint32_t *data;  // owned by the array buffer of `array`
+    JSValue array;
+} JSSystemColumn;
+
 typedef struct {
     struct list_head link;
     JSContext *ctx;
+    World *world;
     JSValue js_world;
     JSValue func;
+    uint64_t query;  // 0 for a system that is called once with the world
+    uint32_t columnCount;
+    JSSystemColumn columns[JSSystemMaxColumns];
+    Entity *entities;
+    JSValue chunk;
+    char name[64];  // of the function, for the profiler
 } JSSystemFunction;
 
 struct list_head js_world_systems = LIST_HEAD_INIT(js_world_systems);
 
+static void js_system_wrapper(World *w, void *data);
+
 static void unlink_system(JSRuntime *rt, JSSystemFunction *th) {
     if (th->link.prev) {
         list_del(&th->link);
         th->link.prev = th->link.next = NULL;
+        WorldRemoveSystem(th->world, js_system_wrapper, th);
         JS_FreeValueRT(rt, th->js_world);
     }
 }
 
 static void free_system(JSRuntime *rt, JSSystemFunction *th) {
     JS_FreeValueRT(rt, th->func);
+    JS_FreeValueRT(rt, th->chunk);
+    for (uint32_t i = 0; i < th->columnCount; ++i)
+        JS_FreeValueRT(rt, th->columns[i].array);
     js_free_rt(rt, th);
 }
 
 extern void fe_js_dump_error(JSContext *ctx);
 
-static void js_system_wrapper(World *w) {
-    struct list_head *el;
-    list_for_each(el, &js_world_systems) {
-        JSSystemFunction *f = list_entry(el, JSSystemFunction, link);
-        JSValue ret = JS_Call(f->ctx, f->func, JS_UNDEFINED, 1, &f->js_world);
-        if (JS_IsException(ret)) {
-            fe_js_dump_error(f->ctx);
+static void js_free_array_buffer(JSRuntime *rt, void *opaque, void *ptr) {
+    js_free_rt(rt, ptr);
+}
+
+// a typed array of JSSystemChunkSize * length elements that owns its memory
+static JSValue js_new_column(JSContext *ctx, uint32_t length, bool isUint,
+                             uint32_t **data) {
+    const size_t size = (size_t)JSSystemChunkSize * length * 4;
+    *data = js_mallocz(ctx, size);
+    if (*data == NULL) return JS_EXCEPTION;
+    JSValue args[1];
+    args[0] = JS_NewArrayBuffer(ctx, (uint8_t *)*data, size,
+                                js_free_array_buffer, NULL, false);
+    if (JS_IsException(args[0])) {
+        js_free(ctx, *data);
+        return args[0];
+    }
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue ctor =
+        JS_GetPropertyStr(ctx, global, isUint ? "Uint32Array" : "Float32Array");
+    JSValue array = JS_CallConstructor(ctx, ctor, 1, args);
+    JS_FreeValue(ctx, ctor);
+    JS_FreeValue(ctx, global);
+    JS_FreeValue(ctx, args[0]);
+    return array;
+}
+
+// reads [[ComponentID, field], ...] from desc[prop] into columns
+static int js_system_add_columns(JSContext *ctx, JSSystemFunction *s,
+                                 JSValueConst desc, const char *prop,
+                                 bool write) {
+    JSValue list = JS_GetPropertyStr(ctx, desc, prop);
+    int ret = -1;
+    uint32_t count = 0;
+    if (JS_IsUndefined(list)) return 0;
+    if (!JS_IsArray(ctx, list)) {
+        JS_ThrowTypeError(ctx, "%s must be an array", prop);
+        goto done;
+    }
+    JSValue length = JS_GetPropertyStr(ctx, list, "length");
+    const int err = JS_ToUint32(ctx, &count, length);
+    JS_FreeValue(ctx, length);
+    if (err) goto done;
+    for (uint32_t i = 0; i < count; ++i) {
+        JSValue item = JS_GetPropertyUint32(ctx, list, i);
+        JSValue typeValue = JS_GetPropertyUint32(ctx, item, 0);
+        JSValue name = JS_GetPropertyUint32(ctx, item, 1);
+        uint32_t type = 0;
+        const ComponentField *f = NULL;
+        if (JS_ToUint32(ctx, &type, typeValue) == 0)
+            f = js_get_component_field(ctx, type, name);
+        JS_FreeValue(ctx, name);
+        JS_FreeValue(ctx, typeValue);
+        JS_FreeValue(ctx, item);
+        if (f == NULL) goto done;
+        for (uint32_t k = 0; k < s->columnCount; ++k) {
+            if (strcmp(s->columns[k].field->name, f->name) == 0) {
+                JS_ThrowTypeError(ctx, "column %s is declared twice", f->name);
+                goto done;
+            }
+        }
+        if (s->columnCount == JSSystemMaxColumns) {
+            JS_ThrowRangeError(ctx, "too many columns");
+            goto done;
+        }
+        JSSystemColumn *c = s->columns + s->columnCount;
+        c->array = js_new_column(ctx, f->length, f->isUint, &c->data);
+        if (JS_IsException(c->array)) goto done;
+        c->field = f;
+        c->write = write;
+        s->columnCount++;
+        s->query |= ComponentBit(type);
+        JS_SetPropertyStr(ctx, s->chunk, f->name, JS_DupValue(ctx, c->array));
+    }
+    ret = 0;
+done:
+    JS_FreeValue(ctx, list);
+    return ret;
+}
+
+static void js_system_call(JSSystemFunction *s, JSValue arg) {
+    JSValue args[2] = {arg, s->js_world};
+    JSValue ret = JS_Call(s->ctx, s->func, JS_UNDEFINED, 2, args);
+    if (JS_IsException(ret)) {
+        fe_js_dump_error(s->ctx);
+    }
+    JS_FreeValue(s->ctx, ret);
+}
+
+static void js_system_run_chunk(World *w, JSSystemFunction *s,
+                                uint32_t count) {
+    for (uint32_t i = 0; i < s->columnCount; ++i) {
+        const JSSystemColumn *c = s->columns + i;
+        const ComponentField *f = c->field;
+        for (uint32_t k = 0; k < count; ++k) {
+            const char *comp = EntityGetComponent(s->entities[k], w, f->type);
+            if (comp == NULL) {
+                memset(c->data + k * f->length, 0, f->length * 4);
+                continue;
+            }
+            memcpy(c->data + k * f->length, comp + f->offset, f->length * 4);
+        }
+    }
+    JS_SetPropertyStr(s->ctx, s->chunk, "count", JS_NewInt32(s->ctx, count));
+    js_system_call(s, s->chunk);
+    for (uint32_t i = 0; i < s->columnCount; ++i) {
+        const JSSystemColumn *c = s->columns + i;
+        const ComponentField *f = c->field;
+        if (!c->write) continue;
+        for (uint32_t k = 0; k < count; ++k) {
+            // the system may have removed it or deleted the entity
+            char *comp = EntityGetComponent(s->entities[k], w, f->type);
+            if (comp == NULL) continue;
+            memcpy(comp + f->offset, c->data + k * f->length, f->length * 4);
+            if (f->type == TransformID) TransformSetDirty(w, (Transform *)comp);
+        }
+    }
+}
+
+// one call for every JSSystemChunkSize entities that have all the queried
+// components, instead of one per entity
+static void js_system_wrapper(World *w, void *data) {
+    JSSystemFunction *s = data;
+    ScriptProfilerBegin(s->ctx, s->name);
+    if (s->query == 0) {
+        js_system_call(s, s->js_world);
+        ScriptProfilerEnd();
+        return;
+    }
+    uint32_t count = 0;
+    for (Entity e = 0; e < w->entityCount; ++e) {
+        const _Entity *_e = w->entities + e;
+        if (_e->deleted || (_e->componentBits & s->query) != s->query)
+            continue;
+        s->entities[count++] = e;
+        if (count == JSSystemChunkSize) {
+            js_system_run_chunk(w, s, count);
+            count = 0;
+        }
+    }
+    if (count > 0) js_system_run_chunk(w, s, count);
+    ScriptProfilerEnd();
+}
+
+// f.name, anonymous functions are numbered
+static void js_system_set_name(JSContext *ctx, JSSystemFunction *s) {
+    static uint32_t anonymous = 0;
+    JSValue name = JS_GetPropertyStr(ctx, s->func, "name");
+    const char *str = JS_ToCString(ctx, name);
+    if (str && str[0] != '\0')
+        snprintf(s->name, sizeof(s->name), "%s", str);
+    else
+        snprintf(s->name, sizeof(s->name), "system %u", anonymous++);
+    if (str)
+        JS_FreeCString(ctx, str);
+    else
+        JS_FreeValue(ctx, JS_GetException(ctx));
+    JS_FreeValue(ctx, name);
+}
+
+// reads the ComponentIDs in desc.query
+static int js_system_add_query(JSContext *ctx, JSSystemFunction *s,
+                               JSValueConst desc) {
+    JSValue list = JS_GetPropertyStr(ctx, desc, "query");
+    int ret = 0;
+    uint32_t count = 0;
+    if (JS_IsUndefined(list)) return 0;
+    JSValue length = JS_GetPropertyStr(ctx, list, "length");
+    ret = JS_ToUint32(ctx, &count, length);
+    JS_FreeValue(ctx, length);
+    for (uint32_t i = 0; ret == 0 && i < count; ++i) {
+        uint32_t type;
+        JSValue item = JS_GetPropertyUint32(ctx, list, i);
+        ret = JS_ToUint32(ctx, &type, item);
+        JS_FreeValue(ctx, item);
+        if (ret == 0 && type >= MaxComponentType) {
+            JS_ThrowRangeError(ctx, "no component %u", type);
+            ret = -1;
         }
-        JS_FreeValue(f->ctx, ret);
+        if (ret == 0) s->query |= ComponentBit(type);
     }
+    JS_FreeValue(ctx, list);
+    return ret;
 }
 
+// world.AddSystem(f) calls f(world) once a frame.
+// world.AddSystem({query, read, write}, f) calls f(chunk, world) for chunks of
+// the entities that have all the components in `query` and in the columns.
+// read and write list [ComponentID, field] pairs, chunk.count entities are
+// in chunk.entities and each field is a packed column chunk[field]. Written
+// columns are copied back after the call.
+// Systems are placed between the native ones by what they read and write, a
+// plain function is assumed to touch everything.
 PFUNC(World, AddSystem) {
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_EXCEPTION;
     World *w = JS_GetOpaque2(ctx, this_value, js_fe_world_class_id);
     if (!w) return JS_EXCEPTION;
-    JSValue f = argv[0];
+    const bool query = argc >= 2;
+    JSValueConst f = argv[query ? 1 : 0];
     if (!JS_IsFunction(ctx, f)) {
-        return JS_EXCEPTION;
+        return JS_ThrowTypeError(ctx, "not a function");
     }
-    JS_DupValue(ctx, f);
-    JSSystemFunction *s = js_malloc(ctx, sizeof(JSSystemFunction));
-    list_add_tail(&s->link, &js_world_systems);
+    JSSystemFunction *s = js_mallocz(ctx, sizeof(JSSystemFunction));
+    if (!s) return JS_EXCEPTION;
     s->ctx = ctx;
-    s->func = f;
-    s->js_world = this_value;
-    JS_DupValue(ctx, this_value);
-    WorldAddSystem(w, js_system_wrapper);
+    s->world = w;
+    s->func = JS_DupValue(ctx, f);
+    s->js_world = JS_DupValue(ctx, this_value);
+    s->chunk = JS_UNDEFINED;
+    js_system_set_name(ctx, s);
+
+    SystemEntry entry = {NULL, js_system_wrapper, s, SystemAccessAll,
+                         SystemAccessAll};
+    if (query) {
+        s->chunk = JS_NewObject(ctx);
+        JSValue entities = js_new_column(ctx, 1, true, &s->entities);
+        if (JS_IsException(entities)) goto fail;
+        JS_SetPropertyStr(ctx, s->chunk, "entities", entities);
+        if (js_system_add_query(ctx, s, argv[0]) ||
+            js_system_add_columns(ctx, s, argv[0], "read", false) ||
+            js_system_add_columns(ctx, s, argv[0], "write", true))
+            goto fail;
+        if (s->query == 0) {
+            JS_ThrowTypeError(ctx, "the query is empty");
+            goto fail;
+        }
+        entry.reads = s->query;
+        entry.writes = 0;
+        for (uint32_t i = 0; i < s->columnCount; ++i) {
+            if (s->columns[i].write)
+                entry.writes |= ComponentBit(s->columns[i].field->type);
+        }
+    }
+    list_add_tail(&s->link, &js_world_systems);
+    WorldInsertSystem(w, &entry);
     return JS_UNDEFINED;
+fail:
+    JS_FreeValue(ctx, s->js_world);
+    free_system(JS_GetRuntime(ctx), s);
+    return JS_EXCEPTION;
 }
 
 PFUNC(World, GetSingletonComponent) {
@@ -154,16 +489,71 @@ PFUNC(World, GetSingletonComponent) {
 PFUNC(World, Clear) {
     World *w = JS_GetOpaque2(ctx, this_value, js_fe_world_class_id);
     if (!w) return JS_EXCEPTION;
+    // the wrappers go in js_entities_removed
     WorldClear(w);
     return JS_UNDEFINED;
 }
 
+// world.View(ComponentID, field) returns a Float32Array (Uint32Array for
+// integer fields) aliasing the component storage, which is allocated once
+// for MaxComponent and never moves. Element c of component i is at
+// view[i * view.stride + c]; view.count is the number of components when
+// the view was made. Writes bypass the dirty flags, see world.Commit.
+PFUNC(World, View) {
+    if (argc != 2) return JS_EXCEPTION;
+    World *w = JS_GetOpaque2(ctx, this_value, js_fe_world_class_id);
+    if (!w) return JS_EXCEPTION;
+    uint32_t type;
+    if (JS_ToUint32(ctx, &type, argv[0])) return JS_EXCEPTION;
+    const ComponentField *f = js_get_component_field(ctx, type, argv[1]);
+    if (f == NULL) return JS_EXCEPTION;
+
+    array *m = &w->componentArrays[type].m;
+    const uint32_t stride = m->stride / 4;
+    const uint32_t count = m->size;
+    const uint32_t length = count ? (count - 1) * stride + f->length : 0;
+    JSValue args[3];
+    args[0] = JS_NewArrayBuffer(ctx, m->ptr, (size_t)m->stride * m->capacity,
+                                NULL, NULL, false);
+    if (JS_IsException(args[0])) return args[0];
+    args[1] = JS_NewInt32(ctx, f->offset);
+    args[2] = JS_NewInt32(ctx, length);
+    JSValue global = JS_GetGlobalObject(ctx);
+    JSValue ctor = JS_GetPropertyStr(
+        ctx, global, f->isUint ? "Uint32Array" : "Float32Array");
+    JSValue view = JS_CallConstructor(ctx, ctor, 3, args);
+    JS_FreeValue(ctx, ctor);
+    JS_FreeValue(ctx, global);
+    JS_FreeValue(ctx, args[0]);
+    if (JS_IsException(view)) return view;
+    JS_SetPropertyStr(ctx, view, "stride", JS_NewInt32(ctx, stride));
+    JS_SetPropertyStr(ctx, view, "count", JS_NewInt32(ctx, count));
+    return view;
+}
+
+// world.Commit(ComponentID[, begin, count]) marks components written through
+// a view as modified, all of them by default
+PFUNC(World, Commit) {
+    if (argc < 1) return JS_EXCEPTION;
+    World *w = JS_GetOpaque2(ctx, this_value, js_fe_world_class_id);
+    if (!w) return JS_EXCEPTION;
+    uint32_t type, begin = 0, count = UINT32_MAX;
+    if (JS_ToUint32(ctx, &type, argv[0])) return JS_EXCEPTION;
+    if (argc >= 2 && JS_ToUint32(ctx, &begin, argv[1])) return JS_EXCEPTION;
+    if (argc >= 3 && JS_ToUint32(ctx, &count, argv[2])) return JS_EXCEPTION;
+    // the other components are read every frame and have no dirty flags
+    if (type == TransformID) TransformSetDirtyRange(w, begin, count);
+    return JS_UNDEFINED;
+}
+
 static const JSCFunctionListEntry js_fe_world_proto_funcs[] = {
     JS_CFUNC_DEF("CreateEntity", 0, js_fe_World_CreateEntity),
     JS_CFUNC_DEF("CreateEntities", 1, js_fe_World_CreateEntities),
-    JS_CFUNC_DEF("AddSystem", 1, js_fe_World_AddSystem),
+    JS_CFUNC_DEF("AddSystem", 2, js_fe_World_AddSystem),
     JS_CFUNC_DEF("GetSingletonComponent", 1, js_fe_World_GetSingletonComponent),
     JS_CFUNC_DEF("Clear", 1, js_fe_World_Clear),
+    JS_CFUNC_DEF("View", 2, js_fe_World_View),
+    JS_CFUNC_DEF("Commit", 3, js_fe_World_Commit),
 };
 
 static JSValue js_fe_Entity_tranform_getter(JSContext *ctx,
@@ -172,7 +562,7 @@ static JSValue js_fe_Entity_tranform_getter(JSContext *ctx,
     if (!p) return JS_EXCEPTION;
     Entity e = (Entity)p;
     void *comp = EntityGetComponent(e, defaultWorld, TransformID);
-    return js_wrap_class(ctx, comp, js_fe_Transform_class_id);
+    return js_wrap_transform(ctx, comp);
 }
 
 // string name getter
@@ -216,7 +606,7 @@ PFUNC(Entity, AddComponent) {
     if (JS_ToUint32(ctx, &type, argv[0])) return JS_EXCEPTION;
     void *comp = EntityAddComponent(e, defaultWorld, type);
     if (type == TransformID) {
-        return js_wrap_class(ctx, comp, js_fe_Transform_class_id);
+        return js_wrap_transform(ctx, comp);
     } else if (type == CameraID) {
         return js_wrap_class(ctx, comp, js_fe_Camera_class_id);
     } else if (type == RenderableID) {
@@ -238,7 +628,7 @@ PFUNC(Entity, GetComponent) {
     if (JS_ToUint32(ctx, &type, argv[0])) return JS_EXCEPTION;
     void *comp = EntityGetComponent(e, defaultWorld, type);
     if (type == TransformID)
-        return js_wrap_class(ctx, comp, js_fe_Transform_class_id);
+        return js_wrap_transform(ctx, comp);
     else if (type == CameraID)
         return js_wrap_class(ctx, comp, js_fe_Camera_class_id);
     else if (type == AnimationID)
@@ -268,8 +658,17 @@ static JSValue js_fe_render_ConvertTexture(JSContext *ctx,
 
 static JSValue js_fe_reload(JSContext *ctx, JSValueConst this_value, int argc,
                             JSValueConst *argv) {
-    js_fishengine_free_handlers(JS_GetRuntime(ctx));
+    // the scene the script builds next goes in the cleared world
     app_reload();
+    app_free_handlers_deferred();
+    return JS_UNDEFINED;
+}
+
+// collects the JS heap at the end of this frame, after a scene load for
+// instance; std.gc() would collect in the middle of the script
+static JSValue js_fe_CollectGarbage(JSContext *ctx, JSValueConst this_value,
+                                    int argc, JSValueConst *argv) {
+    ScriptGCRequestFull();
     return JS_UNDEFINED;
 }
 
@@ -283,6 +682,68 @@ static JSValue js_fe_system(JSContext *ctx, JSValueConst this_value, int argc,
     return JS_NewInt32(ctx, ret);
 }
 
+// new Worker(path) evaluates the module at `path` on a thread of its own,
+// see script_worker.h; worker.onmessage(message, buffers) gets what it posts
+// from the next frame on
+static JSClassID js_fe_Worker_class_id = 0;
+
+static void js_fe_Worker_finalizer(JSRuntime *rt, JSValue val) {
+    ScriptWorker *w = JS_GetOpaque(val, js_fe_Worker_class_id);
+    if (w) ScriptWorkerFree(w);
+}
+
+static JSClassDef js_fe_Worker_class = {
+    "Worker",
+    .finalizer = js_fe_Worker_finalizer,
+};
+
+static JSValue js_fe_Worker_ctor(JSContext *ctx, JSValueConst new_target,
+                                 int argc, JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *path = JS_ToCString(ctx, argv[0]);
+    if (!path) return JS_EXCEPTION;
+    JSValue proto = JS_GetPropertyStr(ctx, new_target, "prototype");
+    if (JS_IsException(proto)) {
+        JS_FreeCString(ctx, path);
+        return proto;
+    }
+    JSValue obj = JS_NewObjectProtoClass(ctx, proto, js_fe_Worker_class_id);
+    JS_FreeValue(ctx, proto);
+    if (JS_IsException(obj)) {
+        JS_FreeCString(ctx, path);
+        return obj;
+    }
+    ScriptWorker *w = ScriptWorkerNew(ctx, obj, path);
+    JS_FreeCString(ctx, path);
+    if (!w) {
+        JS_FreeValue(ctx, obj);
+        return JS_ThrowInternalError(ctx, "could not start the worker");
+    }
+    JS_SetOpaque(obj, w);
+    return obj;
+}
+
+static JSValue js_fe_Worker_postMessage(JSContext *ctx, JSValueConst this_val,
+                                        int argc, JSValueConst *argv) {
+    ScriptWorker *w = JS_GetOpaque(this_val, js_fe_Worker_class_id);
+    if (!w) return JS_ThrowTypeError(ctx, "not a running Worker");
+    if (ScriptWorkerPost(w, ctx, argv[0], argv[1]) < 0) return JS_EXCEPTION;
+    return JS_UNDEFINED;
+}
+
+// interrupts the worker and waits for its thread, the messages are dropped
+static JSValue js_fe_Worker_terminate(JSContext *ctx, JSValueConst this_val,
+                                      int argc, JSValueConst *argv) {
+    ScriptWorker *w = JS_GetOpaque(this_val, js_fe_Worker_class_id);
+    if (w) ScriptWorkerTerminate(w);
+    return JS_UNDEFINED;
+}
+
+static const JSCFunctionListEntry js_fe_Worker_proto_funcs[] = {
+    JS_CFUNC_DEF("postMessage", 2, js_fe_Worker_postMessage),
+    JS_CFUNC_DEF("terminate", 0, js_fe_Worker_terminate),
+};
+
 #define FE_COMP(name) \
     JS_PROP_INT32_DEF(#name "ID", name##ID, JS_PROP_CONFIGURABLE)
 #define FE_FLAG(name) JS_PROP_INT32_DEF(#name, name, JS_PROP_CONFIGURABLE)
@@ -292,12 +753,17 @@ static const JSCFunctionListEntry js_fe_funcs[] = {
     JS_CFUNC_DEF("ConvertTexture", 1, js_fe_render_ConvertTexture),
     JS_CFUNC_DEF("reload", 0, js_fe_reload),
     JS_CFUNC_DEF("system", 1, js_fe_system),
+    JS_CFUNC_DEF("CollectGarbage", 0, js_fe_CollectGarbage),
     FE_COMP(Transform),
     FE_COMP(Renderable),
     FE_COMP(Camera),
     FE_COMP(Animation),
     FE_COMP(Light),
     FE_COMP(FreeCamera),
+};
+
+// the constants, which the worker module has too
+static const JSCFunctionListEntry js_fe_constants[] = {
     FE_FLAG(SingletonInputID),
     FE_FLAG(SingletonSelectionID),
     FE_FLAG(VertexAttrPosition),
@@ -332,27 +798,31 @@ static const JSCFunctionListEntry js_fe_funcs[] = {
 int js_init_module_fishengine_extra(JSContext *ctx, JSModuleDef *m);
 int js_fe_init_extra(JSContext *ctx, JSModuleDef *m);
 
-JSClassID js_def_class(JSContext *ctx, JSClassDef *class_def,
+// class_id is 0 the first time; a class is registered once per runtime and
+// keeps its id for every context after the first
+JSClassID js_def_class(JSContext *ctx, JSClassID class_id,
+                       JSClassDef *class_def,
                        const JSCFunctionListEntry proto_funcs[],
                        int proto_func_count) {
     JSValue proto;
-    JSClassID class_id = 0;
-    JS_NewClassID(&class_id);
-    JS_NewClass(JS_GetRuntime(ctx), class_id, class_def);
+    if (class_id == 0) JS_NewClassID(&class_id);
+    if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+        JS_NewClass(JS_GetRuntime(ctx), class_id, class_def);
     proto = JS_NewObject(ctx);
     JS_SetPropertyFunctionList(ctx, proto, proto_funcs, proto_func_count);
     JS_SetClassProto(ctx, class_id, proto);
     return class_id;
 }
 
-JSClassID js_def_class2(JSContext *ctx, JSClassDef *class_def,
+JSClassID js_def_class2(JSContext *ctx, JSClassID class_id,
+                        JSClassDef *class_def,
                         const JSCFunctionListEntry proto_funcs[],
                         int proto_func_count, JSModuleDef *m,
                         const char *class_name, JSCFunction *ctor) {
     JSValue proto, _class;
-    JSClassID class_id = 0;
-    JS_NewClassID(&class_id);
-    JS_NewClass(JS_GetRuntime(ctx), class_id, class_def);
+    if (class_id == 0) JS_NewClassID(&class_id);
+    if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+        JS_NewClass(JS_GetRuntime(ctx), class_id, class_def);
     proto = JS_NewObject(ctx);
     JS_SetPropertyFunctionList(ctx, proto, proto_funcs, proto_func_count);
     JS_SetClassProto(ctx, class_id, proto);
@@ -366,22 +836,25 @@ JSClassID js_def_class2(JSContext *ctx, JSClassDef *class_def,
     return class_id;
 }
 
-#define CreateClass(name)                                                    \
-    js_fe_##name##_class_id =                                                \
-        js_def_class(ctx, &js_fe_##name##_class, js_fe_##name##_proto_funcs, \
-                     countof(js_fe_##name##_proto_funcs))
+#define CreateClass(name)                                                \
+    js_fe_##name##_class_id = js_def_class(                              \
+        ctx, js_fe_##name##_class_id, &js_fe_##name##_class,             \
+        js_fe_##name##_proto_funcs, countof(js_fe_##name##_proto_funcs))
 
-#define CreateClass2(name)                                      \
-    js_fe_##name##_class_id = js_def_class2(                    \
-        ctx, &js_fe_##name##_class, js_fe_##name##_proto_funcs, \
-        countof(js_fe_##name##_proto_funcs), m, #name, js_fe_##name##_ctor)
+#define CreateClass2(name)                                                \
+    js_fe_##name##_class_id = js_def_class2(                              \
+        ctx, js_fe_##name##_class_id, &js_fe_##name##_class,              \
+        js_fe_##name##_proto_funcs, countof(js_fe_##name##_proto_funcs), \
+        m, #name, js_fe_##name##_ctor)
 
 static int js_fe_init(JSContext *ctx, JSModuleDef *m) {
     CreateClass(world);
     CreateClass(entity);
     //CreateClass(transform);
+    CreateClass2(Worker);
     js_fe_init_extra(ctx, m);
     JS_SetModuleExportList(ctx, m, js_fe_funcs, countof(js_fe_funcs));
+    JS_SetModuleExportList(ctx, m, js_fe_constants, countof(js_fe_constants));
     return 0;
 }
 
@@ -390,14 +863,33 @@ JSModuleDef *js_init_module_fishengine(JSContext *ctx,
     JSModuleDef *m;
     m = JS_NewCModule(ctx, module_name, js_fe_init);
     if (!m) return NULL;
+    WorldSetEntitiesRemovedCallback(js_entities_removed);
     JS_AddModuleExport(ctx, m, js_fe_world_class.class_name);
     //JS_AddModuleExport(ctx, m, js_fe_transform_class.class_name);
+    JS_AddModuleExport(ctx, m, js_fe_Worker_class.class_name);
     js_init_module_fishengine_extra(ctx, m);
     JS_AddModuleExportList(ctx, m, js_fe_funcs, countof(js_fe_funcs));
+    JS_AddModuleExportList(ctx, m, js_fe_constants, countof(js_fe_constants));
+    return m;
+}
+
+static int js_fe_worker_init(JSContext *ctx, JSModuleDef *m) {
+    JS_SetModuleExportList(ctx, m, js_fe_constants, countof(js_fe_constants));
+    return 0;
+}
+
+JSModuleDef *js_init_module_fishengine_worker(JSContext *ctx,
+                                              const char *module_name) {
+    JSModuleDef *m;
+    m = JS_NewCModule(ctx, module_name, js_fe_worker_init);
+    if (!m) return NULL;
+    JS_AddModuleExportList(ctx, m, js_fe_constants, countof(js_fe_constants));
     return m;
 }
 
 void js_fishengine_free_handlers(JSRuntime *rt) {
+    js_free_handles(rt);
+    js_imgui_free_labels();
     struct list_head *el, *el1;
     list_for_each_safe(el, el1, &js_world_systems) {
         JSSystemFunction *th = list_entry(el, JSSystemFunction, link);
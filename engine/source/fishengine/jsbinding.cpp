@@ -1,61 +1,230 @@
 #include "jsbinding.h"
 
 #include <imgui.h>
+#include <stdlib.h>
 
 #include "animation.h"
 #include "app.h"
 #include "camera.h"
 #include "ddsloader.h"
+#include "jsbinding_imgui.hpp"
 #include "mesh.h"
 #include "renderable.h"
 #include "rhi.h"
 #include "texture.h"
 #include "transform.h"
 
-static JSValue js_imgui_begin(JSContext *ctx, JSValueConst this_value, int argc,
-                              JSValueConst *argv) {
-    if (argc != 1) return JS_EXCEPTION;
-    const char *name = NULL;
-    name = JS_ToCString(ctx, argv[0]);
-    if (!name) return JS_EXCEPTION;
-    ImGui::Begin(name);
-    JS_FreeCString(ctx, name);
-    return JS_UNDEFINED;
+// labels by the JSString they were converted from, open addressing; an entry
+// holds a reference to the string so that its address is not reused. A label
+// handed out in this frame may still be held by imgui, only the ones last
+// used in an earlier frame are dropped, the table grows when that is not
+// enough
+#define JSImGuiLabelMinCapacity 1024
+
+struct JSImGuiLabelEntry {
+    JSContext *ctx;  // NULL for a free slot
+    JSValue str;
+    const char *cstr;
+    int frame;  // last used in
+};
+
+static JSImGuiLabelEntry *js_imgui_labels = NULL;
+static uint32_t js_imgui_label_capacity = 0;  // a power of two
+static uint32_t js_imgui_label_count = 0;
+
+static int js_imgui_label_frame() {
+    return ImGui::GetCurrentContext() ? ImGui::GetFrameCount() : 0;
+}
+
+static uint32_t js_imgui_label_slot(const void *key) {
+    const uint32_t h = (uint32_t)(((uintptr_t)key >> 4) * 2654435761u);
+    return h & (js_imgui_label_capacity - 1);
+}
+
+static void js_imgui_insert_label(const JSImGuiLabelEntry &e) {
+    uint32_t i = js_imgui_label_slot(JS_VALUE_GET_PTR(e.str));
+    while (js_imgui_labels[i].ctx) i = (i + 1) & (js_imgui_label_capacity - 1);
+    js_imgui_labels[i] = e;
+    js_imgui_label_count++;
+}
+
+static void js_imgui_free_label(const JSImGuiLabelEntry &e) {
+    JS_FreeCString(e.ctx, e.cstr);
+    JS_FreeValue(e.ctx, e.str);
 }
 
-static JSValue js_imgui_end(JSContext *ctx, JSValueConst this_value, int argc,
-                            JSValueConst *argv) {
-    ImGui::End();
+// drops the labels not used in `frame` and moves the others to a table of
+// `capacity` slots
+static void js_imgui_evict_labels(int frame, uint32_t capacity) {
+    JSImGuiLabelEntry *old = js_imgui_labels;
+    const uint32_t oldCapacity = js_imgui_label_capacity;
+    js_imgui_labels =
+        (JSImGuiLabelEntry *)calloc(capacity, sizeof(JSImGuiLabelEntry));
+    js_imgui_label_capacity = capacity;
+    js_imgui_label_count = 0;
+    for (uint32_t i = 0; i < oldCapacity; ++i) {
+        if (!old[i].ctx) continue;
+        if (old[i].frame == frame)
+            js_imgui_insert_label(old[i]);
+        else
+            js_imgui_free_label(old[i]);
+    }
+    free(old);
+}
+
+const char *JSImGuiLabel(JSContext *ctx, JSValueConst v) {
+    if (!JS_IsString(v)) {
+        JS_ThrowTypeError(ctx, "a label is a string");
+        return NULL;
+    }
+    const int frame = js_imgui_label_frame();
+    const void *key = JS_VALUE_GET_PTR(v);
+    if (js_imgui_label_count) {
+        for (uint32_t i = js_imgui_label_slot(key); js_imgui_labels[i].ctx;
+             i = (i + 1) & (js_imgui_label_capacity - 1)) {
+            JSImGuiLabelEntry &e = js_imgui_labels[i];
+            if (JS_VALUE_GET_PTR(e.str) == key) {
+                e.frame = frame;
+                return e.cstr;
+            }
+        }
+    }
+    if (js_imgui_label_count >= js_imgui_label_capacity * 3 / 4) {
+        uint32_t current = 0;
+        for (uint32_t i = 0; i < js_imgui_label_capacity; ++i)
+            if (js_imgui_labels[i].ctx && js_imgui_labels[i].frame == frame)
+                current++;
+        uint32_t capacity = js_imgui_label_capacity;
+        if (capacity < JSImGuiLabelMinCapacity)
+            capacity = JSImGuiLabelMinCapacity;
+        while (current >= capacity / 2) capacity *= 2;
+        js_imgui_evict_labels(frame, capacity);
+    }
+    const char *cstr = JS_ToCString(ctx, v);
+    if (!cstr) return NULL;
+    js_imgui_insert_label({ctx, JS_DupValue(ctx, v), cstr, frame});
+    return cstr;
+}
+
+// out of renderUI only, the labels of this frame go too
+void js_imgui_free_labels() {
+    for (uint32_t i = 0; i < js_imgui_label_capacity; ++i)
+        if (js_imgui_labels[i].ctx) js_imgui_free_label(js_imgui_labels[i]);
+    free(js_imgui_labels);
+    js_imgui_labels = NULL;
+    js_imgui_label_capacity = 0;
+    js_imgui_label_count = 0;
+}
+
+const char *JSImGuiCommandLabel(JSImGuiCommands *c, uint32_t index) {
+    JSValue v = JS_GetPropertyUint32(c->ctx, c->strings, index);
+    const char *label = JSImGuiLabel(c->ctx, v);
+    // the cache has its own reference
+    JS_FreeValue(c->ctx, v);
+    return label;
+}
+
+// imgui.ListClipper(count, f) calls f(i) for the rows in view only, the rows
+// being one line high like Selectable and Text
+static JSValue js_imgui_ListClipper(JSContext *ctx, JSValueConst this_value,
+                                    int argc, JSValueConst *argv) {
+    int32_t count;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
+    if (JS_ToInt32(ctx, &count, argv[0])) return JS_EXCEPTION;
+    if (!JS_IsFunction(ctx, argv[1]))
+        return JS_ThrowTypeError(ctx, "not a function");
+    ImGuiListClipper clipper;
+    clipper.Begin(count);
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            JSValue arg = JS_NewInt32(ctx, i);
+            JSValue ret = JS_Call(ctx, argv[1], JS_UNDEFINED, 1, &arg);
+            if (JS_IsException(ret)) {
+                clipper.End();
+                return ret;
+            }
+            JS_FreeValue(ctx, ret);
+        }
+    }
     return JS_UNDEFINED;
 }
 
-static JSValue js_imgui_IsItemFocused(JSContext *ctx, JSValueConst this_value,
-                                      int argc, JSValueConst *argv) {
-    return JS_NewBool(ctx, ImGui::IsItemFocused());
+// imgui.SelectableList(labels, selected) draws a Selectable for the labels in
+// view and returns the index picked by a click or by keyboard navigation,
+// `selected` when there is none; it does not call back into JS
+static JSValue js_imgui_SelectableList(JSContext *ctx,
+                                       JSValueConst this_value, int argc,
+                                       JSValueConst *argv) {
+    int32_t count, selected;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
+    if (JS_ToInt32(ctx, &count, JS_GetPropertyStr(ctx, argv[0], "length")) ||
+        JS_ToInt32(ctx, &selected, argv[1]))
+        return JS_EXCEPTION;
+    int32_t picked = selected;
+    ImGuiListClipper clipper;
+    clipper.Begin(count);
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            JSValue v = JS_GetPropertyUint32(ctx, argv[0], i);
+            const char *label = JSImGuiLabel(ctx, v);
+            JS_FreeValue(ctx, v);
+            if (!label) {
+                clipper.End();
+                return JS_EXCEPTION;
+            }
+            ImGui::PushID(i);
+            if (ImGui::Selectable(label, i == selected) ||
+                ImGui::IsItemFocused())
+                picked = i;
+            ImGui::PopID();
+        }
+    }
+    return JS_NewInt32(ctx, picked);
 }
 
-static JSValue js_imgui_selectable(JSContext *ctx, JSValueConst this_value,
-                                   int argc, JSValueConst *argv) {
-    const char *label = NULL;
-    bool selected;
-    if (argc != 2) return JS_EXCEPTION;
-    label = JS_ToCString(ctx, argv[0]);
-    if (!label) return JS_EXCEPTION;
-    selected = JS_ToBool(ctx, argv[1]);
-    bool pressed = ImGui::Selectable(label, selected);
-    JS_FreeCString(ctx, label);
-    return JS_NewBool(ctx, pressed);
+// imgui.Submit(words, count, strings), see JSImGuiCommands
+static JSValue js_imgui_Submit(JSContext *ctx, JSValueConst this_value,
+                               int argc, JSValueConst *argv) {
+    size_t offset, length, bytesPerElement, size;
+    uint32_t count;
+    if (argc < 3) return JS_ThrowTypeError(ctx, "too few arguments");
+    JSValue buffer = JS_GetTypedArrayBuffer(ctx, argv[0], &offset, &length,
+                                            &bytesPerElement);
+    if (JS_IsException(buffer)) return buffer;
+    uint8_t *data = JS_GetArrayBuffer(ctx, &size, buffer);
+    JS_FreeValue(ctx, buffer);
+    if (!data || bytesPerElement != 4)
+        return JS_ThrowTypeError(ctx, "words is not a Uint32Array");
+    if (JS_ToUint32(ctx, &count, argv[1])) return JS_EXCEPTION;
+    if (count > length / 4)
+        return JS_ThrowRangeError(ctx, "%u words, the array has %u", count,
+                                  (uint32_t)(length / 4));
+
+    JSImGuiCommands c = {ctx, argv[2], (uint32_t *)(data + offset), count, 0};
+    while (c.pos < c.count) {
+        const uint32_t op = c.words[c.pos];
+        if (op >= js_imgui_op_count)
+            return JS_ThrowRangeError(ctx, "no op %u at %u", op, c.pos);
+        if (c.pos + 1 + js_imgui_op_words[op] > c.count)
+            return JS_ThrowRangeError(ctx, "op %u at %u is cut off", op,
+                                      c.pos);
+        c.pos++;
+        if (!JSImGuiRunCommand(&c, op)) return JS_EXCEPTION;
+        c.pos += js_imgui_op_words[op];
+    }
+    return JS_UNDEFINED;
 }
 
 static const JSCFunctionListEntry js_imgui_funcs[] = {
-    JS_CFUNC_DEF("Begin", 1, js_imgui_begin),
-    JS_CFUNC_DEF("End", 0, js_imgui_end),
-    JS_CFUNC_DEF("Selectable", 2, js_imgui_selectable),
-    JS_CFUNC_DEF("IsItemFocused", 0, js_imgui_IsItemFocused),
+    JS_CFUNC_DEF("ListClipper", 2, js_imgui_ListClipper),
+    JS_CFUNC_DEF("SelectableList", 2, js_imgui_SelectableList),
+    JS_CFUNC_DEF("Submit", 3, js_imgui_Submit),
 };
 
 static int js_imgui_init(JSContext *ctx, JSModuleDef *m) {
     JS_SetModuleExportList(ctx, m, js_imgui_funcs, countof(js_imgui_funcs));
+    JS_SetModuleExportList(ctx, m, js_imgui_gen_funcs,
+                           js_imgui_gen_func_count);
     return 0;
 }
 
@@ -64,5 +233,7 @@ JSModuleDef *js_init_module_imgui(JSContext *ctx, const char *module_name) {
     m = JS_NewCModule(ctx, module_name, js_imgui_init);
     if (!m) return NULL;
     JS_AddModuleExportList(ctx, m, js_imgui_funcs, countof(js_imgui_funcs));
+    JS_AddModuleExportList(ctx, m, js_imgui_gen_funcs,
+                           js_imgui_gen_func_count);
     return m;
 }
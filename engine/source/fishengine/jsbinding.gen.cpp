@@ -1,10 +1,110 @@
 /* auto generated by codegen tools, do NOT modified this file directly. see
  * engine/source/codegen*/
+#include <stdio.h>
+
 #include "jsbinding.hpp"
 extern "C" {
 extern World *defaultWorld;
 }
 
+#ifndef NDEBUG
+static const char *js_fe_binding_names[] = {
+    "Transform.parent get",
+    "Transform.parent set",
+    "Transform.localPosition get",
+    "Transform.GetLocalPosition",
+    "Transform.localPosition set",
+    "Transform.localRotation get",
+    "Transform.GetLocalRotation",
+    "Transform.localRotation set",
+    "Transform.localEulerAngles get",
+    "Transform.GetLocalEulerAngles",
+    "Transform.localEulerAngles set",
+    "Transform.localScale get",
+    "Transform.GetLocalScale",
+    "Transform.localScale set",
+    "Transform.position get",
+    "Transform.GetPosition",
+    "Transform.localMatrix set",
+    "Transform.LookAt",
+    "Transform.Translate",
+    "Camera.fieldOfView get",
+    "Camera.fieldOfView set",
+    "Camera.nearClipPlane get",
+    "Camera.nearClipPlane set",
+    "Camera.farClipPlane get",
+    "Camera.farClipPlane set",
+    "Camera.GetMainCamera",
+    "Texture.ctor",
+    "Texture.width get",
+    "Texture.height get",
+    "Texture.mipmaps get",
+    "Texture.dimension get",
+    "Texture.filterMode get",
+    "Texture.filterMode set",
+    "Texture.wrapModeU get",
+    "Texture.wrapModeU set",
+    "Texture.wrapModeV get",
+    "Texture.wrapModeV set",
+    "Texture.wrapModeW get",
+    "Texture.wrapModeW set",
+    "Texture.FromDDSFile",
+    "Shader.ctor",
+    "Shader.FromFile",
+    "Shader.PropertyToID",
+    "Skin.ctor",
+    "Skin.root get",
+    "Skin.root set",
+    "Skin.minJoint get",
+    "Skin.minJoint set",
+    "Skin.inverseBindMatrices set",
+    "Skin.joints set",
+    "Mesh.ctor",
+    "Mesh.triangles set",
+    "Mesh.Clear",
+    "Mesh.SetVertices",
+    "Mesh.UploadMeshData",
+    "Mesh.CombineMeshes",
+    "Material.ctor",
+    "Material.mainTexture get",
+    "Material.mainTexture set",
+    "Material.color get",
+    "Material.GetColor",
+    "Material.color set",
+    "Material.SetFloat",
+    "Material.SetVector",
+    "Material.SetTexture",
+    "Material.SetShader",
+    "Material.EnableKeyword",
+    "Renderable.mesh get",
+    "Renderable.mesh set",
+    "Renderable.material get",
+    "Renderable.material set",
+    "Renderable.skin get",
+    "Renderable.skin set",
+    "Renderable.MapBoneToEntity",
+    "AnimationClip.ctor",
+    "AnimationClip.frameRate get",
+    "AnimationClip.frameRate set",
+    "AnimationClip.length get",
+    "AnimationClip.SetCurve",
+    "Animation.Play",
+    "Animation.AddClip",
+    "Animation.SetEntityOffset",
+    "Animation.SetEntityRemap",
+    "Light.type get",
+    "Light.type set",
+    "SingletonInput.GetKeyDown",
+    "SingletonInput.GetKeyUp",
+    "SingletonInput.GetKey",
+    "SingletonInput.GetAxis",
+};
+static uint32_t js_fe_binding_calls[countof(js_fe_binding_names)];
+#define JS_FE_COUNT_CALL(i) js_fe_binding_calls[i]++
+#else
+#define JS_FE_COUNT_CALL(i)
+#endif
+
 extern "C" {
 JSClassID js_fe_Transform_class_id = 0;
 }
@@ -22,7 +122,7 @@ static JSClassDef js_fe_Transform_class = {
 // Transform * parent getter
 static JSValue js_fe_Transform_parent_getter(JSContext *ctx,
                                              JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(0);
     Transform *value;
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
@@ -30,13 +130,13 @@ static JSValue js_fe_Transform_parent_getter(JSContext *ctx,
 
     value = TransformGetParent(defaultWorld, self);
 
-    ret = JSValueFrom<Transform *>(ctx, value);
-    return ret;
+    return JSValueFrom<Transform *>(ctx, value);
 }
 // Transform * parent setter
 static JSValue js_fe_Transform_parent_setter(JSContext *ctx,
                                              JSValueConst this_val,
                                              JSValue val) {
+    JS_FE_COUNT_CALL(1);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
@@ -50,19 +150,33 @@ static JSValue js_fe_Transform_parent_setter(JSContext *ctx,
 // float3 localPosition getter
 static JSValue js_fe_Transform_localPosition_getter(JSContext *ctx,
                                                     JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(2);
     float3 value;
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->localPosition;
-    ret = JSValueFrom<float3>(ctx, value);
-    return ret;
+    return JSValueFrom<float3>(ctx, value);
+}
+// float3 localPosition getter into argv[0]
+static JSValue js_fe_Transform_GetLocalPosition(JSContext *ctx,
+                                                JSValueConst this_value,
+                                                int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(3);
+    float3 value;
+    Transform *self =
+        (Transform *)JS_GetOpaque2(ctx, this_value, js_fe_Transform_class_id);
+    if (!self) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    value = self->localPosition;
+    if (JSValueStore<float3>(ctx, argv[0], value)) return JS_EXCEPTION;
+    return JS_DupValue(ctx, argv[0]);
 }
 // float3 localPosition setter
 static JSValue js_fe_Transform_localPosition_setter(JSContext *ctx,
                                                     JSValueConst this_val,
                                                     JSValue val) {
+    JS_FE_COUNT_CALL(4);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
@@ -77,19 +191,33 @@ static JSValue js_fe_Transform_localPosition_setter(JSContext *ctx,
 // quat localRotation getter
 static JSValue js_fe_Transform_localRotation_getter(JSContext *ctx,
                                                     JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(5);
     quat value;
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->localRotation;
-    ret = JSValueFrom<quat>(ctx, value);
-    return ret;
+    return JSValueFrom<quat>(ctx, value);
+}
+// quat localRotation getter into argv[0]
+static JSValue js_fe_Transform_GetLocalRotation(JSContext *ctx,
+                                                JSValueConst this_value,
+                                                int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(6);
+    quat value;
+    Transform *self =
+        (Transform *)JS_GetOpaque2(ctx, this_value, js_fe_Transform_class_id);
+    if (!self) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    value = self->localRotation;
+    if (JSValueStore<quat>(ctx, argv[0], value)) return JS_EXCEPTION;
+    return JS_DupValue(ctx, argv[0]);
 }
 // quat localRotation setter
 static JSValue js_fe_Transform_localRotation_setter(JSContext *ctx,
                                                     JSValueConst this_val,
                                                     JSValue val) {
+    JS_FE_COUNT_CALL(7);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
@@ -104,7 +232,7 @@ static JSValue js_fe_Transform_localRotation_setter(JSContext *ctx,
 // float3 localEulerAngles getter
 static JSValue js_fe_Transform_localEulerAngles_getter(JSContext *ctx,
                                                        JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(8);
     float3 value;
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
@@ -112,13 +240,30 @@ static JSValue js_fe_Transform_localEulerAngles_getter(JSContext *ctx,
 
     value = quat_to_euler(self->localRotation);
 
-    ret = JSValueFrom<float3>(ctx, value);
-    return ret;
+    return JSValueFrom<float3>(ctx, value);
+}
+// float3 localEulerAngles getter into argv[0]
+static JSValue js_fe_Transform_GetLocalEulerAngles(JSContext *ctx,
+                                                   JSValueConst this_value,
+                                                   int argc,
+                                                   JSValueConst *argv) {
+    JS_FE_COUNT_CALL(9);
+    float3 value;
+    Transform *self =
+        (Transform *)JS_GetOpaque2(ctx, this_value, js_fe_Transform_class_id);
+    if (!self) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+
+    value = quat_to_euler(self->localRotation);
+
+    if (JSValueStore<float3>(ctx, argv[0], value)) return JS_EXCEPTION;
+    return JS_DupValue(ctx, argv[0]);
 }
 // float3 localEulerAngles setter
 static JSValue js_fe_Transform_localEulerAngles_setter(JSContext *ctx,
                                                        JSValueConst this_val,
                                                        JSValue val) {
+    JS_FE_COUNT_CALL(10);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
@@ -133,19 +278,33 @@ static JSValue js_fe_Transform_localEulerAngles_setter(JSContext *ctx,
 // float3 localScale getter
 static JSValue js_fe_Transform_localScale_getter(JSContext *ctx,
                                                  JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(11);
     float3 value;
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->localScale;
-    ret = JSValueFrom<float3>(ctx, value);
-    return ret;
+    return JSValueFrom<float3>(ctx, value);
+}
+// float3 localScale getter into argv[0]
+static JSValue js_fe_Transform_GetLocalScale(JSContext *ctx,
+                                             JSValueConst this_value, int argc,
+                                             JSValueConst *argv) {
+    JS_FE_COUNT_CALL(12);
+    float3 value;
+    Transform *self =
+        (Transform *)JS_GetOpaque2(ctx, this_value, js_fe_Transform_class_id);
+    if (!self) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    value = self->localScale;
+    if (JSValueStore<float3>(ctx, argv[0], value)) return JS_EXCEPTION;
+    return JS_DupValue(ctx, argv[0]);
 }
 // float3 localScale setter
 static JSValue js_fe_Transform_localScale_setter(JSContext *ctx,
                                                  JSValueConst this_val,
                                                  JSValue val) {
+    JS_FE_COUNT_CALL(13);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
@@ -160,7 +319,7 @@ static JSValue js_fe_Transform_localScale_setter(JSContext *ctx,
 // float3 position getter
 static JSValue js_fe_Transform_position_getter(JSContext *ctx,
                                                JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(14);
     float3 value;
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
@@ -168,13 +327,29 @@ static JSValue js_fe_Transform_position_getter(JSContext *ctx,
 
     value = TransformGetPosition(defaultWorld, self);
 
-    ret = JSValueFrom<float3>(ctx, value);
-    return ret;
+    return JSValueFrom<float3>(ctx, value);
+}
+// float3 position getter into argv[0]
+static JSValue js_fe_Transform_GetPosition(JSContext *ctx,
+                                           JSValueConst this_value, int argc,
+                                           JSValueConst *argv) {
+    JS_FE_COUNT_CALL(15);
+    float3 value;
+    Transform *self =
+        (Transform *)JS_GetOpaque2(ctx, this_value, js_fe_Transform_class_id);
+    if (!self) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+
+    value = TransformGetPosition(defaultWorld, self);
+
+    if (JSValueStore<float3>(ctx, argv[0], value)) return JS_EXCEPTION;
+    return JS_DupValue(ctx, argv[0]);
 }
 // float4x4 localMatrix setter
 static JSValue js_fe_Transform_localMatrix_setter(JSContext *ctx,
                                                   JSValueConst this_val,
                                                   JSValue val) {
+    JS_FE_COUNT_CALL(16);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_val, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
@@ -190,13 +365,13 @@ static JSValue js_fe_Transform_localMatrix_setter(JSContext *ctx,
 
 static JSValue js_fe_Transform_LookAt(JSContext *ctx, JSValueConst this_value,
                                       int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(17);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_value, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     float3 target;
     if (JSValueTo<float3>(ctx, &target, argv[0])) return JS_EXCEPTION;
 
@@ -209,13 +384,13 @@ static JSValue js_fe_Transform_LookAt(JSContext *ctx, JSValueConst this_value,
 static JSValue js_fe_Transform_Translate(JSContext *ctx,
                                          JSValueConst this_value, int argc,
                                          JSValueConst *argv) {
+    JS_FE_COUNT_CALL(18);
     Transform *self =
         (Transform *)JS_GetOpaque2(ctx, this_value, js_fe_Transform_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 2) return JS_EXCEPTION;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     float3 translate;
     if (JSValueTo<float3>(ctx, &translate, argv[0])) return JS_EXCEPTION;
     enum Space space;
@@ -242,6 +417,11 @@ static const JSCFunctionListEntry js_fe_Transform_proto_funcs[] = {
                    js_fe_Transform_localScale_setter),
     JS_CGETSET_DEF("position", js_fe_Transform_position_getter, NULL),
     JS_CGETSET_DEF("localMatrix", NULL, js_fe_Transform_localMatrix_setter),
+    JS_CFUNC_DEF("GetLocalPosition", 1, js_fe_Transform_GetLocalPosition),
+    JS_CFUNC_DEF("GetLocalRotation", 1, js_fe_Transform_GetLocalRotation),
+    JS_CFUNC_DEF("GetLocalEulerAngles", 1, js_fe_Transform_GetLocalEulerAngles),
+    JS_CFUNC_DEF("GetLocalScale", 1, js_fe_Transform_GetLocalScale),
+    JS_CFUNC_DEF("GetPosition", 1, js_fe_Transform_GetPosition),
     JS_CFUNC_DEF("LookAt", 1, js_fe_Transform_LookAt),
     JS_CFUNC_DEF("Translate", 2, js_fe_Transform_Translate),
 };
@@ -263,19 +443,19 @@ static JSClassDef js_fe_Camera_class = {
 // float fieldOfView getter
 static JSValue js_fe_Camera_fieldOfView_getter(JSContext *ctx,
                                                JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(19);
     float value;
     Camera *self =
         (Camera *)JS_GetOpaque2(ctx, this_val, js_fe_Camera_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->fieldOfView;
-    ret = JSValueFrom<float>(ctx, value);
-    return ret;
+    return JS_NewFloat64(ctx, value);
 }
 // float fieldOfView setter
 static JSValue js_fe_Camera_fieldOfView_setter(JSContext *ctx,
                                                JSValueConst this_val,
                                                JSValue val) {
+    JS_FE_COUNT_CALL(20);
     Camera *self =
         (Camera *)JS_GetOpaque2(ctx, this_val, js_fe_Camera_class_id);
     if (!self) return JS_EXCEPTION;
@@ -287,19 +467,19 @@ static JSValue js_fe_Camera_fieldOfView_setter(JSContext *ctx,
 // float nearClipPlane getter
 static JSValue js_fe_Camera_nearClipPlane_getter(JSContext *ctx,
                                                  JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(21);
     float value;
     Camera *self =
         (Camera *)JS_GetOpaque2(ctx, this_val, js_fe_Camera_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->nearClipPlane;
-    ret = JSValueFrom<float>(ctx, value);
-    return ret;
+    return JS_NewFloat64(ctx, value);
 }
 // float nearClipPlane setter
 static JSValue js_fe_Camera_nearClipPlane_setter(JSContext *ctx,
                                                  JSValueConst this_val,
                                                  JSValue val) {
+    JS_FE_COUNT_CALL(22);
     Camera *self =
         (Camera *)JS_GetOpaque2(ctx, this_val, js_fe_Camera_class_id);
     if (!self) return JS_EXCEPTION;
@@ -311,19 +491,19 @@ static JSValue js_fe_Camera_nearClipPlane_setter(JSContext *ctx,
 // float farClipPlane getter
 static JSValue js_fe_Camera_farClipPlane_getter(JSContext *ctx,
                                                 JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(23);
     float value;
     Camera *self =
         (Camera *)JS_GetOpaque2(ctx, this_val, js_fe_Camera_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->farClipPlane;
-    ret = JSValueFrom<float>(ctx, value);
-    return ret;
+    return JS_NewFloat64(ctx, value);
 }
 // float farClipPlane setter
 static JSValue js_fe_Camera_farClipPlane_setter(JSContext *ctx,
                                                 JSValueConst this_val,
                                                 JSValue val) {
+    JS_FE_COUNT_CALL(24);
     Camera *self =
         (Camera *)JS_GetOpaque2(ctx, this_val, js_fe_Camera_class_id);
     if (!self) return JS_EXCEPTION;
@@ -336,9 +516,7 @@ static JSValue js_fe_Camera_farClipPlane_setter(JSContext *ctx,
 static JSValue js_fe_Camera_GetMainCamera(JSContext *ctx,
                                           JSValueConst this_value, int argc,
                                           JSValueConst *argv) {
-    if (argc != 0) return JS_EXCEPTION;
-
-    // TODO: goto fail and clear values if exception
+    JS_FE_COUNT_CALL(25);
     Camera *ret;
 
     ret = CameraGetMainCamera(defaultWorld);
@@ -374,6 +552,7 @@ static JSValue js_fe_Texture_ctor(JSContext *ctx, JSValueConst new_target,
     Texture *self = NULL;
     JSValue proto;
     JSValue obj = JS_UNDEFINED;
+    JS_FE_COUNT_CALL(26);
 
     proto = JS_GetPropertyStr(ctx, new_target, "prototype");
     if (JS_IsException(proto)) return proto;
@@ -394,67 +573,63 @@ static JSValue js_fe_Texture_ctor(JSContext *ctx, JSValueConst new_target,
 // uint32_t width getter
 static JSValue js_fe_Texture_width_getter(JSContext *ctx,
                                           JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(27);
     uint32_t value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->width;
-    ret = JSValueFrom<uint32_t>(ctx, value);
-    return ret;
+    return JS_NewInt64(ctx, value);
 }
 // uint32_t height getter
 static JSValue js_fe_Texture_height_getter(JSContext *ctx,
                                            JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(28);
     uint32_t value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->height;
-    ret = JSValueFrom<uint32_t>(ctx, value);
-    return ret;
+    return JS_NewInt64(ctx, value);
 }
 // uint32_t mipmaps getter
 static JSValue js_fe_Texture_mipmaps_getter(JSContext *ctx,
                                             JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(29);
     uint32_t value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->mipmaps;
-    ret = JSValueFrom<uint32_t>(ctx, value);
-    return ret;
+    return JS_NewInt64(ctx, value);
 }
 // TextureDimension dimension getter
 static JSValue js_fe_Texture_dimension_getter(JSContext *ctx,
                                               JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(30);
     TextureDimension value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->dimension;
-    ret = JSValueFrom<TextureDimension>(ctx, value);
-    return ret;
+    return JSValueFrom<TextureDimension>(ctx, value);
 }
 // FilterMode filterMode getter
 static JSValue js_fe_Texture_filterMode_getter(JSContext *ctx,
                                                JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(31);
     FilterMode value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->filterMode;
-    ret = JSValueFrom<FilterMode>(ctx, value);
-    return ret;
+    return JSValueFrom<FilterMode>(ctx, value);
 }
 // FilterMode filterMode setter
 static JSValue js_fe_Texture_filterMode_setter(JSContext *ctx,
                                                JSValueConst this_val,
                                                JSValue val) {
+    JS_FE_COUNT_CALL(32);
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
@@ -466,19 +641,19 @@ static JSValue js_fe_Texture_filterMode_setter(JSContext *ctx,
 // TextureWrapMode wrapModeU getter
 static JSValue js_fe_Texture_wrapModeU_getter(JSContext *ctx,
                                               JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(33);
     TextureWrapMode value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->wrapModeU;
-    ret = JSValueFrom<TextureWrapMode>(ctx, value);
-    return ret;
+    return JSValueFrom<TextureWrapMode>(ctx, value);
 }
 // TextureWrapMode wrapModeU setter
 static JSValue js_fe_Texture_wrapModeU_setter(JSContext *ctx,
                                               JSValueConst this_val,
                                               JSValue val) {
+    JS_FE_COUNT_CALL(34);
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
@@ -490,19 +665,19 @@ static JSValue js_fe_Texture_wrapModeU_setter(JSContext *ctx,
 // TextureWrapMode wrapModeV getter
 static JSValue js_fe_Texture_wrapModeV_getter(JSContext *ctx,
                                               JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(35);
     TextureWrapMode value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->wrapModeV;
-    ret = JSValueFrom<TextureWrapMode>(ctx, value);
-    return ret;
+    return JSValueFrom<TextureWrapMode>(ctx, value);
 }
 // TextureWrapMode wrapModeV setter
 static JSValue js_fe_Texture_wrapModeV_setter(JSContext *ctx,
                                               JSValueConst this_val,
                                               JSValue val) {
+    JS_FE_COUNT_CALL(36);
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
@@ -514,19 +689,19 @@ static JSValue js_fe_Texture_wrapModeV_setter(JSContext *ctx,
 // TextureWrapMode wrapModeW getter
 static JSValue js_fe_Texture_wrapModeW_getter(JSContext *ctx,
                                               JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(37);
     TextureWrapMode value;
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->wrapModeW;
-    ret = JSValueFrom<TextureWrapMode>(ctx, value);
-    return ret;
+    return JSValueFrom<TextureWrapMode>(ctx, value);
 }
 // TextureWrapMode wrapModeW setter
 static JSValue js_fe_Texture_wrapModeW_setter(JSContext *ctx,
                                               JSValueConst this_val,
                                               JSValue val) {
+    JS_FE_COUNT_CALL(38);
     Texture *self =
         (Texture *)JS_GetOpaque2(ctx, this_val, js_fe_Texture_class_id);
     if (!self) return JS_EXCEPTION;
@@ -539,9 +714,10 @@ static JSValue js_fe_Texture_wrapModeW_setter(JSContext *ctx,
 static JSValue js_fe_Texture_FromDDSFile(JSContext *ctx,
                                          JSValueConst this_value, int argc,
                                          JSValueConst *argv) {
-    if (argc != 1) return JS_EXCEPTION;
+    JS_FE_COUNT_CALL(39);
+
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     string path;
     if (JSValueTo<string>(ctx, &path, argv[0])) return JS_EXCEPTION;
     Texture *ret;
@@ -587,6 +763,7 @@ static JSValue js_fe_Shader_ctor(JSContext *ctx, JSValueConst new_target,
     Shader *self = NULL;
     JSValue proto;
     JSValue obj = JS_UNDEFINED;
+    JS_FE_COUNT_CALL(40);
 
     proto = JS_GetPropertyStr(ctx, new_target, "prototype");
     if (JS_IsException(proto)) return proto;
@@ -602,9 +779,10 @@ static JSValue js_fe_Shader_ctor(JSContext *ctx, JSValueConst new_target,
 
 static JSValue js_fe_Shader_FromFile(JSContext *ctx, JSValueConst this_value,
                                      int argc, JSValueConst *argv) {
-    if (argc != 1) return JS_EXCEPTION;
+    JS_FE_COUNT_CALL(41);
+
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     string path;
     if (JSValueTo<string>(ctx, &path, argv[0])) return JS_EXCEPTION;
     Shader *ret;
@@ -618,9 +796,10 @@ static JSValue js_fe_Shader_FromFile(JSContext *ctx, JSValueConst this_value,
 static JSValue js_fe_Shader_PropertyToID(JSContext *ctx,
                                          JSValueConst this_value, int argc,
                                          JSValueConst *argv) {
-    if (argc != 1) return JS_EXCEPTION;
+    JS_FE_COUNT_CALL(42);
+
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     string name;
     if (JSValueTo<string>(ctx, &name, argv[0])) return JS_EXCEPTION;
     int ret;
@@ -629,7 +808,7 @@ static JSValue js_fe_Shader_PropertyToID(JSContext *ctx,
 
     JSValueFree<string>(ctx, name);
 
-    return JSValueFrom<int>(ctx, ret);
+    return JS_NewInt32(ctx, ret);
 }
 
 static const JSCFunctionListEntry js_fe_Shader_proto_funcs[] = {};
@@ -653,6 +832,7 @@ static JSValue js_fe_Skin_ctor(JSContext *ctx, JSValueConst new_target,
     Skin *self = NULL;
     JSValue proto;
     JSValue obj = JS_UNDEFINED;
+    JS_FE_COUNT_CALL(43);
 
     proto = JS_GetPropertyStr(ctx, new_target, "prototype");
     if (JS_IsException(proto)) return proto;
@@ -670,17 +850,17 @@ static JSValue js_fe_Skin_ctor(JSContext *ctx, JSValueConst new_target,
 
 // Entity root getter
 static JSValue js_fe_Skin_root_getter(JSContext *ctx, JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(44);
     Entity value;
     Skin *self = (Skin *)JS_GetOpaque2(ctx, this_val, js_fe_Skin_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->root;
-    ret = JSValueFrom<Entity>(ctx, value);
-    return ret;
+    return JS_NewInt64(ctx, value);
 }
 // Entity root setter
 static JSValue js_fe_Skin_root_setter(JSContext *ctx, JSValueConst this_val,
                                       JSValue val) {
+    JS_FE_COUNT_CALL(45);
     Skin *self = (Skin *)JS_GetOpaque2(ctx, this_val, js_fe_Skin_class_id);
     if (!self) return JS_EXCEPTION;
     Entity value;
@@ -691,17 +871,17 @@ static JSValue js_fe_Skin_root_setter(JSContext *ctx, JSValueConst this_val,
 // uint32_t minJoint getter
 static JSValue js_fe_Skin_minJoint_getter(JSContext *ctx,
                                           JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(46);
     uint32_t value;
     Skin *self = (Skin *)JS_GetOpaque2(ctx, this_val, js_fe_Skin_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->minJoint;
-    ret = JSValueFrom<uint32_t>(ctx, value);
-    return ret;
+    return JS_NewInt64(ctx, value);
 }
 // uint32_t minJoint setter
 static JSValue js_fe_Skin_minJoint_setter(JSContext *ctx, JSValueConst this_val,
                                           JSValue val) {
+    JS_FE_COUNT_CALL(47);
     Skin *self = (Skin *)JS_GetOpaque2(ctx, this_val, js_fe_Skin_class_id);
     if (!self) return JS_EXCEPTION;
     uint32_t value;
@@ -713,6 +893,7 @@ static JSValue js_fe_Skin_minJoint_setter(JSContext *ctx, JSValueConst this_val,
 static JSValue js_fe_Skin_inverseBindMatrices_setter(JSContext *ctx,
                                                      JSValueConst this_val,
                                                      JSValue val) {
+    JS_FE_COUNT_CALL(48);
     Skin *self = (Skin *)JS_GetOpaque2(ctx, this_val, js_fe_Skin_class_id);
     if (!self) return JS_EXCEPTION;
     TypedArray value;
@@ -737,6 +918,7 @@ static JSValue js_fe_Skin_inverseBindMatrices_setter(JSContext *ctx,
 // TypedArray joints setter
 static JSValue js_fe_Skin_joints_setter(JSContext *ctx, JSValueConst this_val,
                                         JSValue val) {
+    JS_FE_COUNT_CALL(49);
     Skin *self = (Skin *)JS_GetOpaque2(ctx, this_val, js_fe_Skin_class_id);
     if (!self) return JS_EXCEPTION;
     TypedArray value;
@@ -778,6 +960,7 @@ static JSValue js_fe_Mesh_ctor(JSContext *ctx, JSValueConst new_target,
     Mesh *self = NULL;
     JSValue proto;
     JSValue obj = JS_UNDEFINED;
+    JS_FE_COUNT_CALL(50);
 
     proto = JS_GetPropertyStr(ctx, new_target, "prototype");
     if (JS_IsException(proto)) return proto;
@@ -797,6 +980,7 @@ static JSValue js_fe_Mesh_ctor(JSContext *ctx, JSValueConst new_target,
 // TypedArray triangles setter
 static JSValue js_fe_Mesh_triangles_setter(JSContext *ctx,
                                            JSValueConst this_val, JSValue val) {
+    JS_FE_COUNT_CALL(51);
     Mesh *self = (Mesh *)JS_GetOpaque2(ctx, this_val, js_fe_Mesh_class_id);
     if (!self) return JS_EXCEPTION;
     TypedArray value;
@@ -811,25 +995,22 @@ static JSValue js_fe_Mesh_triangles_setter(JSContext *ctx,
 
 static JSValue js_fe_Mesh_Clear(JSContext *ctx, JSValueConst this_value,
                                 int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(52);
     Mesh *self = (Mesh *)JS_GetOpaque2(ctx, this_value, js_fe_Mesh_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 0) return JS_EXCEPTION;
-
-    // TODO: goto fail and clear values if exception
-
     MeshClear(self);
 
     return JS_UNDEFINED;
 }
 static JSValue js_fe_Mesh_SetVertices(JSContext *ctx, JSValueConst this_value,
                                       int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(53);
     Mesh *self = (Mesh *)JS_GetOpaque2(ctx, this_value, js_fe_Mesh_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 5) return JS_EXCEPTION;
+    if (argc < 5) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     enum VertexAttr attr;
     if (JSValueTo<enum VertexAttr>(ctx, &attr, argv[0])) return JS_EXCEPTION;
     ArrayBuffer buf;
@@ -856,22 +1037,20 @@ static JSValue js_fe_Mesh_SetVertices(JSContext *ctx, JSValueConst this_value,
 static JSValue js_fe_Mesh_UploadMeshData(JSContext *ctx,
                                          JSValueConst this_value, int argc,
                                          JSValueConst *argv) {
+    JS_FE_COUNT_CALL(54);
     Mesh *self = (Mesh *)JS_GetOpaque2(ctx, this_value, js_fe_Mesh_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 0) return JS_EXCEPTION;
-
-    // TODO: goto fail and clear values if exception
-
     MeshUploadMeshData(self);
 
     return JS_UNDEFINED;
 }
 static JSValue js_fe_Mesh_CombineMeshes(JSContext *ctx, JSValueConst this_value,
                                         int argc, JSValueConst *argv) {
-    if (argc != 1) return JS_EXCEPTION;
+    JS_FE_COUNT_CALL(55);
+
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     Array array;
     if (JSValueTo<Array>(ctx, &array, argv[0])) return JS_EXCEPTION;
     Mesh *ret;
@@ -919,6 +1098,7 @@ static JSValue js_fe_Material_ctor(JSContext *ctx, JSValueConst new_target,
     Material *self = NULL;
     JSValue proto;
     JSValue obj = JS_UNDEFINED;
+    JS_FE_COUNT_CALL(56);
 
     proto = JS_GetPropertyStr(ctx, new_target, "prototype");
     if (JS_IsException(proto)) return proto;
@@ -937,19 +1117,19 @@ static JSValue js_fe_Material_ctor(JSContext *ctx, JSValueConst new_target,
 // Texture * mainTexture getter
 static JSValue js_fe_Material_mainTexture_getter(JSContext *ctx,
                                                  JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(57);
     Texture *value;
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_val, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->mainTexture;
-    ret = JSValueFrom<Texture *>(ctx, value);
-    return ret;
+    return JSValueFrom<Texture *>(ctx, value);
 }
 // Texture * mainTexture setter
 static JSValue js_fe_Material_mainTexture_setter(JSContext *ctx,
                                                  JSValueConst this_val,
                                                  JSValue val) {
+    JS_FE_COUNT_CALL(58);
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_val, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
@@ -961,18 +1141,31 @@ static JSValue js_fe_Material_mainTexture_setter(JSContext *ctx,
 // float4 color getter
 static JSValue js_fe_Material_color_getter(JSContext *ctx,
                                            JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(59);
     float4 value;
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_val, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->color;
-    ret = JSValueFrom<float4>(ctx, value);
-    return ret;
+    return JSValueFrom<float4>(ctx, value);
+}
+// float4 color getter into argv[0]
+static JSValue js_fe_Material_GetColor(JSContext *ctx, JSValueConst this_value,
+                                       int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(60);
+    float4 value;
+    Material *self =
+        (Material *)JS_GetOpaque2(ctx, this_value, js_fe_Material_class_id);
+    if (!self) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    value = self->color;
+    if (JSValueStore<float4>(ctx, argv[0], value)) return JS_EXCEPTION;
+    return JS_DupValue(ctx, argv[0]);
 }
 // float4 color setter
 static JSValue js_fe_Material_color_setter(JSContext *ctx,
                                            JSValueConst this_val, JSValue val) {
+    JS_FE_COUNT_CALL(61);
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_val, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
@@ -984,17 +1177,20 @@ static JSValue js_fe_Material_color_setter(JSContext *ctx,
 
 static JSValue js_fe_Material_SetFloat(JSContext *ctx, JSValueConst this_value,
                                        int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(62);
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_value, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 2) return JS_EXCEPTION;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     string name;
     if (JSValueTo<string>(ctx, &name, argv[0])) return JS_EXCEPTION;
     float value;
-    if (JSValueTo<float>(ctx, &value, argv[1])) return JS_EXCEPTION;
+    if (JSValueTo<float>(ctx, &value, argv[1])) {
+        JSValueFree<string>(ctx, name);
+        return JS_EXCEPTION;
+    }
 
     int nameID = ShaderPropertyToID(name);
     MaterialSetFloat(self, nameID, value);
@@ -1006,17 +1202,20 @@ static JSValue js_fe_Material_SetFloat(JSContext *ctx, JSValueConst this_value,
 }
 static JSValue js_fe_Material_SetVector(JSContext *ctx, JSValueConst this_value,
                                         int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(63);
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_value, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 2) return JS_EXCEPTION;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     string name;
     if (JSValueTo<string>(ctx, &name, argv[0])) return JS_EXCEPTION;
     float4 value;
-    if (JSValueTo<float4>(ctx, &value, argv[1])) return JS_EXCEPTION;
+    if (JSValueTo<float4>(ctx, &value, argv[1])) {
+        JSValueFree<string>(ctx, name);
+        return JS_EXCEPTION;
+    }
 
     int nameID = ShaderPropertyToID(name);
     MaterialSetVector(self, nameID, value);
@@ -1029,17 +1228,20 @@ static JSValue js_fe_Material_SetVector(JSContext *ctx, JSValueConst this_value,
 static JSValue js_fe_Material_SetTexture(JSContext *ctx,
                                          JSValueConst this_value, int argc,
                                          JSValueConst *argv) {
+    JS_FE_COUNT_CALL(64);
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_value, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 2) return JS_EXCEPTION;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     string name;
     if (JSValueTo<string>(ctx, &name, argv[0])) return JS_EXCEPTION;
     Texture *value;
-    if (JSValueTo<Texture *>(ctx, &value, argv[1])) return JS_EXCEPTION;
+    if (JSValueTo<Texture *>(ctx, &value, argv[1])) {
+        JSValueFree<string>(ctx, name);
+        return JS_EXCEPTION;
+    }
 
     int nameID = ShaderPropertyToID(name);
     MaterialSetTexture(self, nameID, value);
@@ -1051,13 +1253,13 @@ static JSValue js_fe_Material_SetTexture(JSContext *ctx,
 }
 static JSValue js_fe_Material_SetShader(JSContext *ctx, JSValueConst this_value,
                                         int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(65);
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_value, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     Shader *shader;
     if (JSValueTo<Shader *>(ctx, &shader, argv[0])) return JS_EXCEPTION;
 
@@ -1070,13 +1272,13 @@ static JSValue js_fe_Material_SetShader(JSContext *ctx, JSValueConst this_value,
 static JSValue js_fe_Material_EnableKeyword(JSContext *ctx,
                                             JSValueConst this_value, int argc,
                                             JSValueConst *argv) {
+    JS_FE_COUNT_CALL(66);
     Material *self =
         (Material *)JS_GetOpaque2(ctx, this_value, js_fe_Material_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     string keyword;
     if (JSValueTo<string>(ctx, &keyword, argv[0])) return JS_EXCEPTION;
 
@@ -1092,6 +1294,7 @@ static const JSCFunctionListEntry js_fe_Material_proto_funcs[] = {
                    js_fe_Material_mainTexture_setter),
     JS_CGETSET_DEF("color", js_fe_Material_color_getter,
                    js_fe_Material_color_setter),
+    JS_CFUNC_DEF("GetColor", 1, js_fe_Material_GetColor),
     JS_CFUNC_DEF("SetFloat", 2, js_fe_Material_SetFloat),
     JS_CFUNC_DEF("SetVector", 2, js_fe_Material_SetVector),
     JS_CFUNC_DEF("SetTexture", 2, js_fe_Material_SetTexture),
@@ -1116,19 +1319,19 @@ static JSClassDef js_fe_Renderable_class = {
 // Mesh * mesh getter
 static JSValue js_fe_Renderable_mesh_getter(JSContext *ctx,
                                             JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(67);
     Mesh *value;
     Renderable *self =
         (Renderable *)JS_GetOpaque2(ctx, this_val, js_fe_Renderable_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->mesh;
-    ret = JSValueFrom<Mesh *>(ctx, value);
-    return ret;
+    return JSValueFrom<Mesh *>(ctx, value);
 }
 // Mesh * mesh setter
 static JSValue js_fe_Renderable_mesh_setter(JSContext *ctx,
                                             JSValueConst this_val,
                                             JSValue val) {
+    JS_FE_COUNT_CALL(68);
     Renderable *self =
         (Renderable *)JS_GetOpaque2(ctx, this_val, js_fe_Renderable_class_id);
     if (!self) return JS_EXCEPTION;
@@ -1142,19 +1345,19 @@ static JSValue js_fe_Renderable_mesh_setter(JSContext *ctx,
 // Material * material getter
 static JSValue js_fe_Renderable_material_getter(JSContext *ctx,
                                                 JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(69);
     Material *value;
     Renderable *self =
         (Renderable *)JS_GetOpaque2(ctx, this_val, js_fe_Renderable_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->material;
-    ret = JSValueFrom<Material *>(ctx, value);
-    return ret;
+    return JSValueFrom<Material *>(ctx, value);
 }
 // Material * material setter
 static JSValue js_fe_Renderable_material_setter(JSContext *ctx,
                                                 JSValueConst this_val,
                                                 JSValue val) {
+    JS_FE_COUNT_CALL(70);
     Renderable *self =
         (Renderable *)JS_GetOpaque2(ctx, this_val, js_fe_Renderable_class_id);
     if (!self) return JS_EXCEPTION;
@@ -1166,19 +1369,19 @@ static JSValue js_fe_Renderable_material_setter(JSContext *ctx,
 // Skin * skin getter
 static JSValue js_fe_Renderable_skin_getter(JSContext *ctx,
                                             JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(71);
     Skin *value;
     Renderable *self =
         (Renderable *)JS_GetOpaque2(ctx, this_val, js_fe_Renderable_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->skin;
-    ret = JSValueFrom<Skin *>(ctx, value);
-    return ret;
+    return JSValueFrom<Skin *>(ctx, value);
 }
 // Skin * skin setter
 static JSValue js_fe_Renderable_skin_setter(JSContext *ctx,
                                             JSValueConst this_val,
                                             JSValue val) {
+    JS_FE_COUNT_CALL(72);
     Renderable *self =
         (Renderable *)JS_GetOpaque2(ctx, this_val, js_fe_Renderable_class_id);
     if (!self) return JS_EXCEPTION;
@@ -1191,13 +1394,13 @@ static JSValue js_fe_Renderable_skin_setter(JSContext *ctx,
 static JSValue js_fe_Renderable_MapBoneToEntity(JSContext *ctx,
                                                 JSValueConst this_value,
                                                 int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(73);
     Renderable *self =
         (Renderable *)JS_GetOpaque2(ctx, this_value, js_fe_Renderable_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 2) return JS_EXCEPTION;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     uint32_t bone;
     if (JSValueTo<uint32_t>(ctx, &bone, argv[0])) return JS_EXCEPTION;
     uint32_t entity;
@@ -1241,6 +1444,7 @@ static JSValue js_fe_AnimationClip_ctor(JSContext *ctx, JSValueConst new_target,
     AnimationClip *self = NULL;
     JSValue proto;
     JSValue obj = JS_UNDEFINED;
+    JS_FE_COUNT_CALL(74);
 
     proto = JS_GetPropertyStr(ctx, new_target, "prototype");
     if (JS_IsException(proto)) return proto;
@@ -1259,19 +1463,19 @@ static JSValue js_fe_AnimationClip_ctor(JSContext *ctx, JSValueConst new_target,
 // float frameRate getter
 static JSValue js_fe_AnimationClip_frameRate_getter(JSContext *ctx,
                                                     JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(75);
     float value;
     AnimationClip *self = (AnimationClip *)JS_GetOpaque2(
         ctx, this_val, js_fe_AnimationClip_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->frameRate;
-    ret = JSValueFrom<float>(ctx, value);
-    return ret;
+    return JS_NewFloat64(ctx, value);
 }
 // float frameRate setter
 static JSValue js_fe_AnimationClip_frameRate_setter(JSContext *ctx,
                                                     JSValueConst this_val,
                                                     JSValue val) {
+    JS_FE_COUNT_CALL(76);
     AnimationClip *self = (AnimationClip *)JS_GetOpaque2(
         ctx, this_val, js_fe_AnimationClip_class_id);
     if (!self) return JS_EXCEPTION;
@@ -1283,26 +1487,25 @@ static JSValue js_fe_AnimationClip_frameRate_setter(JSContext *ctx,
 // float length getter
 static JSValue js_fe_AnimationClip_length_getter(JSContext *ctx,
                                                  JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(77);
     float value;
     AnimationClip *self = (AnimationClip *)JS_GetOpaque2(
         ctx, this_val, js_fe_AnimationClip_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->length;
-    ret = JSValueFrom<float>(ctx, value);
-    return ret;
+    return JS_NewFloat64(ctx, value);
 }
 
 static JSValue js_fe_AnimationClip_SetCurve(JSContext *ctx,
                                             JSValueConst this_value, int argc,
                                             JSValueConst *argv) {
+    JS_FE_COUNT_CALL(78);
     AnimationClip *self = (AnimationClip *)JS_GetOpaque2(
         ctx, this_value, js_fe_AnimationClip_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 4) return JS_EXCEPTION;
+    if (argc < 4) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     Entity target;
     if (JSValueTo<Entity>(ctx, &target, argv[0])) return JS_EXCEPTION;
     TypedArray input;
@@ -1375,13 +1578,13 @@ static JSClassDef js_fe_Animation_class = {
 
 static JSValue js_fe_Animation_Play(JSContext *ctx, JSValueConst this_value,
                                     int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(79);
     Animation *self =
         (Animation *)JS_GetOpaque2(ctx, this_value, js_fe_Animation_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     World *world;
     if (JSValueTo<World *>(ctx, &world, argv[0])) return JS_EXCEPTION;
 
@@ -1393,13 +1596,13 @@ static JSValue js_fe_Animation_Play(JSContext *ctx, JSValueConst this_value,
 }
 static JSValue js_fe_Animation_AddClip(JSContext *ctx, JSValueConst this_value,
                                        int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(80);
     Animation *self =
         (Animation *)JS_GetOpaque2(ctx, this_value, js_fe_Animation_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     AnimationClip *clip;
     if (JSValueTo<AnimationClip *>(ctx, &clip, argv[0])) return JS_EXCEPTION;
 
@@ -1412,13 +1615,13 @@ static JSValue js_fe_Animation_AddClip(JSContext *ctx, JSValueConst this_value,
 static JSValue js_fe_Animation_SetEntityOffset(JSContext *ctx,
                                                JSValueConst this_value,
                                                int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(81);
     Animation *self =
         (Animation *)JS_GetOpaque2(ctx, this_value, js_fe_Animation_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     int entityOffset;
     if (JSValueTo<int>(ctx, &entityOffset, argv[0])) return JS_EXCEPTION;
 
@@ -1431,13 +1634,13 @@ static JSValue js_fe_Animation_SetEntityOffset(JSContext *ctx,
 static JSValue js_fe_Animation_SetEntityRemap(JSContext *ctx,
                                               JSValueConst this_value, int argc,
                                               JSValueConst *argv) {
+    JS_FE_COUNT_CALL(82);
     Animation *self =
         (Animation *)JS_GetOpaque2(ctx, this_value, js_fe_Animation_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 2) return JS_EXCEPTION;
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     uint32_t e1;
     if (JSValueTo<uint32_t>(ctx, &e1, argv[0])) return JS_EXCEPTION;
     int e2;
@@ -1475,17 +1678,17 @@ static JSClassDef js_fe_Light_class = {
 
 // enum LightType type getter
 static JSValue js_fe_Light_type_getter(JSContext *ctx, JSValueConst this_val) {
-    JSValue ret;
+    JS_FE_COUNT_CALL(83);
     enum LightType value;
     Light *self = (Light *)JS_GetOpaque2(ctx, this_val, js_fe_Light_class_id);
     if (!self) return JS_EXCEPTION;
     value = self->type;
-    ret = JSValueFrom<enum LightType>(ctx, value);
-    return ret;
+    return JSValueFrom<enum LightType>(ctx, value);
 }
 // enum LightType type setter
 static JSValue js_fe_Light_type_setter(JSContext *ctx, JSValueConst this_val,
                                        JSValue val) {
+    JS_FE_COUNT_CALL(84);
     Light *self = (Light *)JS_GetOpaque2(ctx, this_val, js_fe_Light_class_id);
     if (!self) return JS_EXCEPTION;
     enum LightType value;
@@ -1515,13 +1718,13 @@ static JSClassDef js_fe_SingletonInput_class = {
 static JSValue js_fe_SingletonInput_GetKeyDown(JSContext *ctx,
                                                JSValueConst this_value,
                                                int argc, JSValueConst *argv) {
+    JS_FE_COUNT_CALL(85);
     SingletonInput *self = (SingletonInput *)JS_GetOpaque2(
         ctx, this_value, js_fe_SingletonInput_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     enum KeyCode code;
     if (JSValueTo<enum KeyCode>(ctx, &code, argv[0])) return JS_EXCEPTION;
     bool ret;
@@ -1530,18 +1733,18 @@ static JSValue js_fe_SingletonInput_GetKeyDown(JSContext *ctx,
 
     JSValueFree<enum KeyCode>(ctx, code);
 
-    return JSValueFrom<bool>(ctx, ret);
+    return JS_NewBool(ctx, ret);
 }
 static JSValue js_fe_SingletonInput_GetKeyUp(JSContext *ctx,
                                              JSValueConst this_value, int argc,
                                              JSValueConst *argv) {
+    JS_FE_COUNT_CALL(86);
     SingletonInput *self = (SingletonInput *)JS_GetOpaque2(
         ctx, this_value, js_fe_SingletonInput_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     enum KeyCode code;
     if (JSValueTo<enum KeyCode>(ctx, &code, argv[0])) return JS_EXCEPTION;
     bool ret;
@@ -1550,18 +1753,18 @@ static JSValue js_fe_SingletonInput_GetKeyUp(JSContext *ctx,
 
     JSValueFree<enum KeyCode>(ctx, code);
 
-    return JSValueFrom<bool>(ctx, ret);
+    return JS_NewBool(ctx, ret);
 }
 static JSValue js_fe_SingletonInput_GetKey(JSContext *ctx,
                                            JSValueConst this_value, int argc,
                                            JSValueConst *argv) {
+    JS_FE_COUNT_CALL(87);
     SingletonInput *self = (SingletonInput *)JS_GetOpaque2(
         ctx, this_value, js_fe_SingletonInput_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     enum KeyCode code;
     if (JSValueTo<enum KeyCode>(ctx, &code, argv[0])) return JS_EXCEPTION;
     bool ret;
@@ -1570,18 +1773,18 @@ static JSValue js_fe_SingletonInput_GetKey(JSContext *ctx,
 
     JSValueFree<enum KeyCode>(ctx, code);
 
-    return JSValueFrom<bool>(ctx, ret);
+    return JS_NewBool(ctx, ret);
 }
 static JSValue js_fe_SingletonInput_GetAxis(JSContext *ctx,
                                             JSValueConst this_value, int argc,
                                             JSValueConst *argv) {
+    JS_FE_COUNT_CALL(88);
     SingletonInput *self = (SingletonInput *)JS_GetOpaque2(
         ctx, this_value, js_fe_SingletonInput_class_id);
     if (!self) return JS_EXCEPTION;
 
-    if (argc != 1) return JS_EXCEPTION;
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
 
-    // TODO: goto fail and clear values if exception
     enum Axis axis;
     if (JSValueTo<enum Axis>(ctx, &axis, argv[0])) return JS_EXCEPTION;
     float ret;
@@ -1590,7 +1793,7 @@ static JSValue js_fe_SingletonInput_GetAxis(JSContext *ctx,
 
     JSValueFree<enum Axis>(ctx, axis);
 
-    return JSValueFrom<float>(ctx, ret);
+    return JS_NewFloat64(ctx, ret);
 }
 
 static const JSCFunctionListEntry js_fe_SingletonInput_proto_funcs[] = {
@@ -1603,15 +1806,17 @@ static const JSCFunctionListEntry js_fe_SingletonInput_proto_funcs[] = {
 extern "C" {
 int js_init_module_fishengine_extra(JSContext *ctx, JSModuleDef *m);
 int js_fe_init_extra(JSContext *ctx, JSModuleDef *m);
+void js_fe_print_binding_calls(uint32_t top);
 }
 
 int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Transform_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Transform_class);
+        if (js_fe_Transform_class_id == 0)
+            JS_NewClassID(&js_fe_Transform_class_id);
+        JSClassID class_id = js_fe_Transform_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Transform_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Transform_proto_funcs,
                                    countof(js_fe_Transform_proto_funcs));
@@ -1620,10 +1825,10 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Camera_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Camera_class);
+        if (js_fe_Camera_class_id == 0) JS_NewClassID(&js_fe_Camera_class_id);
+        JSClassID class_id = js_fe_Camera_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Camera_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Camera_proto_funcs,
                                    countof(js_fe_Camera_proto_funcs));
@@ -1640,10 +1845,10 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Texture_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Texture_class);
+        if (js_fe_Texture_class_id == 0) JS_NewClassID(&js_fe_Texture_class_id);
+        JSClassID class_id = js_fe_Texture_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Texture_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Texture_proto_funcs,
                                    countof(js_fe_Texture_proto_funcs));
@@ -1661,10 +1866,10 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Shader_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Shader_class);
+        if (js_fe_Shader_class_id == 0) JS_NewClassID(&js_fe_Shader_class_id);
+        JSClassID class_id = js_fe_Shader_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Shader_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Shader_proto_funcs,
                                    countof(js_fe_Shader_proto_funcs));
@@ -1685,10 +1890,10 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Skin_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Skin_class);
+        if (js_fe_Skin_class_id == 0) JS_NewClassID(&js_fe_Skin_class_id);
+        JSClassID class_id = js_fe_Skin_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Skin_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Skin_proto_funcs,
                                    countof(js_fe_Skin_proto_funcs));
@@ -1703,10 +1908,10 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Mesh_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Mesh_class);
+        if (js_fe_Mesh_class_id == 0) JS_NewClassID(&js_fe_Mesh_class_id);
+        JSClassID class_id = js_fe_Mesh_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Mesh_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Mesh_proto_funcs,
                                    countof(js_fe_Mesh_proto_funcs));
@@ -1724,10 +1929,11 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Material_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Material_class);
+        if (js_fe_Material_class_id == 0)
+            JS_NewClassID(&js_fe_Material_class_id);
+        JSClassID class_id = js_fe_Material_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Material_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Material_proto_funcs,
                                    countof(js_fe_Material_proto_funcs));
@@ -1742,10 +1948,11 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Renderable_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Renderable_class);
+        if (js_fe_Renderable_class_id == 0)
+            JS_NewClassID(&js_fe_Renderable_class_id);
+        JSClassID class_id = js_fe_Renderable_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Renderable_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Renderable_proto_funcs,
                                    countof(js_fe_Renderable_proto_funcs));
@@ -1754,10 +1961,12 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_AnimationClip_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_AnimationClip_class);
+        if (js_fe_AnimationClip_class_id == 0)
+            JS_NewClassID(&js_fe_AnimationClip_class_id);
+        JSClassID class_id = js_fe_AnimationClip_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id,
+                        &js_fe_AnimationClip_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_AnimationClip_proto_funcs,
                                    countof(js_fe_AnimationClip_proto_funcs));
@@ -1772,10 +1981,11 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Animation_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Animation_class);
+        if (js_fe_Animation_class_id == 0)
+            JS_NewClassID(&js_fe_Animation_class_id);
+        JSClassID class_id = js_fe_Animation_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Animation_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Animation_proto_funcs,
                                    countof(js_fe_Animation_proto_funcs));
@@ -1784,10 +1994,10 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_Light_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Light_class);
+        if (js_fe_Light_class_id == 0) JS_NewClassID(&js_fe_Light_class_id);
+        JSClassID class_id = js_fe_Light_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_Light_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_Light_proto_funcs,
                                    countof(js_fe_Light_proto_funcs));
@@ -1796,10 +2006,12 @@ int js_fe_init_extra(JSContext *ctx, JSModuleDef *m) {
 
     {
         JSValue proto;
-        JSClassID class_id = 0;
-        JS_NewClassID(&class_id);
-        js_fe_SingletonInput_class_id = class_id;
-        JS_NewClass(JS_GetRuntime(ctx), class_id, &js_fe_SingletonInput_class);
+        if (js_fe_SingletonInput_class_id == 0)
+            JS_NewClassID(&js_fe_SingletonInput_class_id);
+        JSClassID class_id = js_fe_SingletonInput_class_id;
+        if (!JS_IsRegisteredClass(JS_GetRuntime(ctx), class_id))
+            JS_NewClass(JS_GetRuntime(ctx), class_id,
+                        &js_fe_SingletonInput_class);
         proto = JS_NewObject(ctx);
         JS_SetPropertyFunctionList(ctx, proto, js_fe_SingletonInput_proto_funcs,
                                    countof(js_fe_SingletonInput_proto_funcs));
@@ -1823,3 +2035,25 @@ int js_init_module_fishengine_extra(JSContext *ctx, JSModuleDef *m) {
     JS_AddModuleExport(ctx, m, "SingletonInput");
     return 0;
 }
+
+// the `top` most called bindings so far, debug builds only
+void js_fe_print_binding_calls(uint32_t top) {
+#ifndef NDEBUG
+    const uint32_t *calls = js_fe_binding_calls;
+    uint32_t order[countof(js_fe_binding_names)];
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < countof(js_fe_binding_names); ++i) {
+        if (calls[i] == 0) continue;
+        uint32_t j = count++;
+        while (j > 0 && calls[order[j - 1]] < calls[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    if (count == 0) return;
+    printf("binding calls:\n");
+    for (uint32_t i = 0; i < count && i < top; ++i)
+        printf("  %-36s %u\n", js_fe_binding_names[order[i]], calls[order[i]]);
+#endif
+}
@@ -12,8 +12,16 @@ extern "C" {
 void SetDefaultWorld(World *w);
 JSModuleDef *js_init_module_fishengine(JSContext *ctx, const char *module_name);
 JSModuleDef *js_init_module_imgui(JSContext *ctx, const char *module_name);
+// FishEngine for a script worker: the constants only, nothing that touches
+// the world, the assets or the renderer
+JSModuleDef *js_init_module_fishengine_worker(JSContext *ctx,
+                                              const char *module_name);
 
 void js_fishengine_free_handlers(JSRuntime *rt);
+// the label strings the imgui module holds on to
+void js_imgui_free_labels();
+// prints the `top` most called generated bindings, in debug builds
+void js_fe_print_binding_calls(uint32_t top);
 
 #ifdef __cplusplus
 }
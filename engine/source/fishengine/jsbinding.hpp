@@ -6,6 +6,7 @@
 #include <quickjs.h>
 
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 
 #include "ecs.h"
@@ -71,13 +72,26 @@ int JSValueTo(JSContext *ctx, std::enable_if_t<std::is_pointer_v<T>, T> *v,
     return *v == NULL;
 }
 
+// numbers are read here, the rest goes through the conversions of QuickJS
 template <>
 inline int JSValueTo<int32_t>(JSContext *ctx, int32_t *v, JSValue val) {
+    if (JS_VALUE_GET_TAG(val) == JS_TAG_INT) {
+        *v = JS_VALUE_GET_INT(val);
+        return 0;
+    }
     return JS_ToInt32(ctx, v, val);
 }
 
 template <>
 inline int JSValueTo<float>(JSContext *ctx, float *v, JSValue val) {
+    switch (JS_VALUE_GET_NORM_TAG(val)) {
+        case JS_TAG_INT:
+            *v = (float)JS_VALUE_GET_INT(val);
+            return 0;
+        case JS_TAG_FLOAT64:
+            *v = (float)JS_VALUE_GET_FLOAT64(val);
+            return 0;
+    }
     double f;
     int ret = JS_ToFloat64(ctx, &f, val);
     if (ret == 0) *v = (float)f;
@@ -86,6 +100,10 @@ inline int JSValueTo<float>(JSContext *ctx, float *v, JSValue val) {
 
 template <>
 inline int JSValueTo<uint32_t>(JSContext *ctx, uint32_t *v, JSValue val) {
+    if (JS_VALUE_GET_TAG(val) == JS_TAG_INT) {
+        *v = (uint32_t)JS_VALUE_GET_INT(val);
+        return 0;
+    }
     return JS_ToUint32(ctx, v, val);
 }
 
@@ -97,10 +115,38 @@ inline int JSValueTo<string>(JSContext *ctx, string *v, JSValue val) {
     return str == NULL;
 }
 
+// the floats of a Float32Array with at least `count` elements, read and
+// written in place; any typed array of 4 byte elements passes. NULL with an
+// exception for anything else
+inline float *JSFloat32ArrayData(JSContext *ctx, JSValueConst val,
+                                 uint32_t count) {
+    size_t byteOffset, byteLength, bytesPerElement, bufferSize;
+    JSValue arrayBuffer = JS_GetTypedArrayBuffer(ctx, val, &byteOffset,
+                                                 &byteLength, &bytesPerElement);
+    if (JS_IsException(arrayBuffer)) return NULL;
+    uint8_t *buffer = JS_GetArrayBuffer(ctx, &bufferSize, arrayBuffer);
+    JS_FreeValue(ctx, arrayBuffer);
+    if (!buffer) return NULL;
+    if (bytesPerElement != sizeof(float) ||
+        byteLength < count * sizeof(float)) {
+        JS_ThrowTypeError(ctx, "expecting a Float32Array of %u", count);
+        return NULL;
+    }
+    return (float *)(buffer + byteOffset);
+}
+
+// vectors and matrices are an Array or a Float32Array
 template <>
 inline int JSValueTo<float3>(JSContext *ctx, float3 *v, JSValue val) {
     int ret;
-    if (!JS_IsArray(ctx, val)) return 1;
+    if (!JS_IsArray(ctx, val)) {
+        const float *f = JSFloat32ArrayData(ctx, val, 3);
+        if (!f) return -1;
+        v->x = f[0];
+        v->y = f[1];
+        v->z = f[2];
+        return 0;
+    }
     ret = JSValueTo<float>(ctx, &v->x, JS_GetPropertyUint32(ctx, val, 0));
     ret =
         ret || JSValueTo<float>(ctx, &v->y, JS_GetPropertyUint32(ctx, val, 1));
@@ -112,7 +158,12 @@ inline int JSValueTo<float3>(JSContext *ctx, float3 *v, JSValue val) {
 template <>
 inline int JSValueTo<float4>(JSContext *ctx, float4 *v, JSValue val) {
     int ret;
-    if (!JS_IsArray(ctx, val)) return 1;
+    if (!JS_IsArray(ctx, val)) {
+        const float *f = JSFloat32ArrayData(ctx, val, 4);
+        if (!f) return -1;
+        *v = float4_make(f[0], f[1], f[2], f[3]);
+        return 0;
+    }
     float x = 0, y = 0, z = 0, w = 0;
     ret = JSValueTo<float>(ctx, &x, JS_GetPropertyUint32(ctx, val, 0));
     ret = ret || JSValueTo<float>(ctx, &y, JS_GetPropertyUint32(ctx, val, 1));
@@ -125,7 +176,12 @@ inline int JSValueTo<float4>(JSContext *ctx, float4 *v, JSValue val) {
 template <>
 inline int JSValueTo<float4x4>(JSContext *ctx, float4x4 *v, JSValue val) {
     int ret = 0;
-    if (!JS_IsArray(ctx, val)) return 1;
+    if (!JS_IsArray(ctx, val)) {
+        const float *f = JSFloat32ArrayData(ctx, val, 16);
+        if (!f) return -1;
+        memcpy(v->a, f, sizeof(v->a));
+        return 0;
+    }
     for (int i = 0; i < 16; ++i)
         ret = ret || JSValueTo<float>(ctx, &v->a[i],
                                       JS_GetPropertyUint32(ctx, val, i));
@@ -201,8 +257,8 @@ inline JSValue JSValueFrom<int32_t>(JSContext *ctx, int32_t v) {
 
 template <>
 inline JSValue JSValueFrom<uint32_t>(JSContext *ctx, uint32_t v) {
-    // TODO: JS_NewUint32 is not public
-    return JS_NewInt32(ctx, v);
+    // JS_NewUint32 is not public
+    return JS_NewInt64(ctx, v);
 }
 
 template <>
@@ -259,6 +315,43 @@ inline JSValue JSValueFrom(JSContext *ctx, float4 v) {
     return e;
 }
 
+// writes v into an existing Array or Float32Array, for the Get<Name>(target)
+// methods of the vector properties; 0 or -1 with an exception
+template <typename T>
+int JSValueStore(JSContext *ctx, JSValueConst target, T v);
+
+inline int JSValueStoreFloats(JSContext *ctx, JSValueConst target,
+                              const float *f, uint32_t count) {
+    if (JS_IsArray(ctx, target)) {
+        for (uint32_t i = 0; i < count; ++i) {
+            JSValue e = JS_NewFloat64(ctx, f[i]);
+            if (JS_SetPropertyUint32(ctx, target, i, e) < 0) return -1;
+        }
+        return 0;
+    }
+    float *data = JSFloat32ArrayData(ctx, target, count);
+    if (!data) return -1;
+    memcpy(data, f, count * sizeof(float));
+    return 0;
+}
+
+template <>
+inline int JSValueStore(JSContext *ctx, JSValueConst target, float3 v) {
+    const float f[3] = {v.x, v.y, v.z};
+    return JSValueStoreFloats(ctx, target, f, 3);
+}
+
+template <>
+inline int JSValueStore(JSContext *ctx, JSValueConst target, float4 v) {
+    const float f[4] = {v.x, v.y, v.z, v.w};
+    return JSValueStoreFloats(ctx, target, f, 4);
+}
+
+template <>
+inline int JSValueStore(JSContext *ctx, JSValueConst target, float4x4 v) {
+    return JSValueStoreFloats(ctx, target, v.a, 16);
+}
+
 template <typename T>
 void JSValueFree(JSContext *ctx, T v) {
     // do nothing
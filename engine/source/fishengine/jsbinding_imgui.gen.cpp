@@ -0,0 +1,553 @@
+/* auto generated by codegen tools, do NOT modified this file directly. see
+ * engine/source/codegen*/
+#include <imgui.h>
+
+#include "jsbinding_imgui.hpp"
+
+static inline int JSImGuiToFloat(JSContext *ctx, float *v, JSValueConst val) {
+    double d;
+    int ret = JS_ToFloat64(ctx, &d, val);
+    *v = (float)d;
+    return ret;
+}
+
+static JSValue js_imgui_Begin(JSContext *ctx, JSValueConst this_value, int argc,
+                              JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *name = JSImGuiLabel(ctx, argv[0]);
+    if (!name) return JS_EXCEPTION;
+    bool ret;
+    ret = ImGui::Begin(name);
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_End(JSContext *ctx, JSValueConst this_value, int argc,
+                            JSValueConst *argv) {
+    ImGui::End();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_BeginChild(JSContext *ctx, JSValueConst this_value,
+                                   int argc, JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *id = JSImGuiLabel(ctx, argv[0]);
+    if (!id) return JS_EXCEPTION;
+    float width = 0;
+    if (argc > 1 && JSImGuiToFloat(ctx, &width, argv[1])) return JS_EXCEPTION;
+    float height = 0;
+    if (argc > 2 && JSImGuiToFloat(ctx, &height, argv[2])) return JS_EXCEPTION;
+    bool border = argc > 3 ? JS_ToBool(ctx, argv[3]) > 0 : false;
+    bool ret;
+    ret = ImGui::BeginChild(id, ImVec2(width, height), border);
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_EndChild(JSContext *ctx, JSValueConst this_value,
+                                 int argc, JSValueConst *argv) {
+    ImGui::EndChild();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_SetNextWindowPos(JSContext *ctx,
+                                         JSValueConst this_value, int argc,
+                                         JSValueConst *argv) {
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
+    float x;
+    if (JSImGuiToFloat(ctx, &x, argv[0])) return JS_EXCEPTION;
+    float y;
+    if (JSImGuiToFloat(ctx, &y, argv[1])) return JS_EXCEPTION;
+    ImGui::SetNextWindowPos(ImVec2(x, y));
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_SetNextWindowSize(JSContext *ctx,
+                                          JSValueConst this_value, int argc,
+                                          JSValueConst *argv) {
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
+    float width;
+    if (JSImGuiToFloat(ctx, &width, argv[0])) return JS_EXCEPTION;
+    float height;
+    if (JSImGuiToFloat(ctx, &height, argv[1])) return JS_EXCEPTION;
+    ImGui::SetNextWindowSize(ImVec2(width, height));
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_PushID(JSContext *ctx, JSValueConst this_value,
+                               int argc, JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *id = JSImGuiLabel(ctx, argv[0]);
+    if (!id) return JS_EXCEPTION;
+    ImGui::PushID(id);
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_PopID(JSContext *ctx, JSValueConst this_value, int argc,
+                              JSValueConst *argv) {
+    ImGui::PopID();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_Text(JSContext *ctx, JSValueConst this_value, int argc,
+                             JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    JSImGuiString text(ctx, argv[0]);
+    if (!text) return JS_EXCEPTION;
+    ImGui::TextUnformatted(text);
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_Separator(JSContext *ctx, JSValueConst this_value,
+                                  int argc, JSValueConst *argv) {
+    ImGui::Separator();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_SameLine(JSContext *ctx, JSValueConst this_value,
+                                 int argc, JSValueConst *argv) {
+    ImGui::SameLine();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_Spacing(JSContext *ctx, JSValueConst this_value,
+                                int argc, JSValueConst *argv) {
+    ImGui::Spacing();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_Indent(JSContext *ctx, JSValueConst this_value,
+                               int argc, JSValueConst *argv) {
+    ImGui::Indent();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_Unindent(JSContext *ctx, JSValueConst this_value,
+                                 int argc, JSValueConst *argv) {
+    ImGui::Unindent();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_Button(JSContext *ctx, JSValueConst this_value,
+                               int argc, JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    bool ret;
+    ret = ImGui::Button(label);
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_SmallButton(JSContext *ctx, JSValueConst this_value,
+                                    int argc, JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    bool ret;
+    ret = ImGui::SmallButton(label);
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_Selectable(JSContext *ctx, JSValueConst this_value,
+                                   int argc, JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    bool selected = argc > 1 ? JS_ToBool(ctx, argv[1]) > 0 : false;
+    bool ret;
+    ret = ImGui::Selectable(label, selected);
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_Checkbox(JSContext *ctx, JSValueConst this_value,
+                                 int argc, JSValueConst *argv) {
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    bool v = JS_ToBool(ctx, argv[1]) > 0;
+    [[maybe_unused]] bool ret;
+    ret = ImGui::Checkbox(label, &v);
+    return JS_NewBool(ctx, v);
+}
+
+static JSValue js_imgui_SliderFloat(JSContext *ctx, JSValueConst this_value,
+                                    int argc, JSValueConst *argv) {
+    if (argc < 4) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    float v;
+    if (JSImGuiToFloat(ctx, &v, argv[1])) return JS_EXCEPTION;
+    float min;
+    if (JSImGuiToFloat(ctx, &min, argv[2])) return JS_EXCEPTION;
+    float max;
+    if (JSImGuiToFloat(ctx, &max, argv[3])) return JS_EXCEPTION;
+    [[maybe_unused]] bool ret;
+    ret = ImGui::SliderFloat(label, &v, min, max);
+    return JS_NewFloat64(ctx, v);
+}
+
+static JSValue js_imgui_SliderInt(JSContext *ctx, JSValueConst this_value,
+                                  int argc, JSValueConst *argv) {
+    if (argc < 4) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    int v;
+    if (JS_ToInt32(ctx, &v, argv[1])) return JS_EXCEPTION;
+    int min;
+    if (JS_ToInt32(ctx, &min, argv[2])) return JS_EXCEPTION;
+    int max;
+    if (JS_ToInt32(ctx, &max, argv[3])) return JS_EXCEPTION;
+    [[maybe_unused]] bool ret;
+    ret = ImGui::SliderInt(label, &v, min, max);
+    return JS_NewInt32(ctx, v);
+}
+
+static JSValue js_imgui_DragFloat(JSContext *ctx, JSValueConst this_value,
+                                  int argc, JSValueConst *argv) {
+    if (argc < 2) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    float v;
+    if (JSImGuiToFloat(ctx, &v, argv[1])) return JS_EXCEPTION;
+    float speed = 1;
+    if (argc > 2 && JSImGuiToFloat(ctx, &speed, argv[2])) return JS_EXCEPTION;
+    float min = 0;
+    if (argc > 3 && JSImGuiToFloat(ctx, &min, argv[3])) return JS_EXCEPTION;
+    float max = 0;
+    if (argc > 4 && JSImGuiToFloat(ctx, &max, argv[4])) return JS_EXCEPTION;
+    [[maybe_unused]] bool ret;
+    ret = ImGui::DragFloat(label, &v, speed, min, max);
+    return JS_NewFloat64(ctx, v);
+}
+
+static JSValue js_imgui_TreeNode(JSContext *ctx, JSValueConst this_value,
+                                 int argc, JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    bool ret;
+    ret = ImGui::TreeNode(label);
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_TreePop(JSContext *ctx, JSValueConst this_value,
+                                int argc, JSValueConst *argv) {
+    ImGui::TreePop();
+    return JS_UNDEFINED;
+}
+
+static JSValue js_imgui_CollapsingHeader(JSContext *ctx,
+                                         JSValueConst this_value, int argc,
+                                         JSValueConst *argv) {
+    if (argc < 1) return JS_ThrowTypeError(ctx, "too few arguments");
+    const char *label = JSImGuiLabel(ctx, argv[0]);
+    if (!label) return JS_EXCEPTION;
+    bool ret;
+    ret = ImGui::CollapsingHeader(label);
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_IsItemHovered(JSContext *ctx, JSValueConst this_value,
+                                      int argc, JSValueConst *argv) {
+    bool ret;
+    ret = ImGui::IsItemHovered();
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_IsItemFocused(JSContext *ctx, JSValueConst this_value,
+                                      int argc, JSValueConst *argv) {
+    bool ret;
+    ret = ImGui::IsItemFocused();
+    return JS_NewBool(ctx, ret);
+}
+
+static JSValue js_imgui_IsItemClicked(JSContext *ctx, JSValueConst this_value,
+                                      int argc, JSValueConst *argv) {
+    bool ret;
+    ret = ImGui::IsItemClicked();
+    return JS_NewBool(ctx, ret);
+}
+
+const uint8_t js_imgui_op_words[] = {
+    2,  // Begin
+    0,  // End
+    5,  // BeginChild
+    0,  // EndChild
+    2,  // SetNextWindowPos
+    2,  // SetNextWindowSize
+    1,  // PushID
+    0,  // PopID
+    1,  // Text
+    0,  // Separator
+    0,  // SameLine
+    0,  // Spacing
+    0,  // Indent
+    0,  // Unindent
+    2,  // Button
+    2,  // SmallButton
+    3,  // Selectable
+    3,  // Checkbox
+    5,  // SliderFloat
+    5,  // SliderInt
+    6,  // DragFloat
+    2,  // TreeNode
+    0,  // TreePop
+    2,  // CollapsingHeader
+    1,  // IsItemHovered
+    1,  // IsItemFocused
+    1,  // IsItemClicked
+};
+const uint32_t js_imgui_op_count = 27;
+
+bool JSImGuiRunCommand(JSImGuiCommands *c, uint32_t op) {
+    uint32_t *w = c->words + c->pos;
+    switch (op) {
+        case 0: {  // Begin
+            const char *name = JSImGuiCommandLabel(c, w[0]);
+            if (!name) return false;
+            bool ret;
+            ret = ImGui::Begin(name);
+            w[1] = ret;
+            break;
+        }
+        case 1: {  // End
+            ImGui::End();
+            break;
+        }
+        case 2: {  // BeginChild
+            const char *id = JSImGuiCommandLabel(c, w[0]);
+            if (!id) return false;
+            float width = JSImGuiWordToFloat(w[1]);
+            float height = JSImGuiWordToFloat(w[2]);
+            bool border = w[3] != 0;
+            bool ret;
+            ret = ImGui::BeginChild(id, ImVec2(width, height), border);
+            w[4] = ret;
+            break;
+        }
+        case 3: {  // EndChild
+            ImGui::EndChild();
+            break;
+        }
+        case 4: {  // SetNextWindowPos
+            float x = JSImGuiWordToFloat(w[0]);
+            float y = JSImGuiWordToFloat(w[1]);
+            ImGui::SetNextWindowPos(ImVec2(x, y));
+            break;
+        }
+        case 5: {  // SetNextWindowSize
+            float width = JSImGuiWordToFloat(w[0]);
+            float height = JSImGuiWordToFloat(w[1]);
+            ImGui::SetNextWindowSize(ImVec2(width, height));
+            break;
+        }
+        case 6: {  // PushID
+            const char *id = JSImGuiCommandLabel(c, w[0]);
+            if (!id) return false;
+            ImGui::PushID(id);
+            break;
+        }
+        case 7: {  // PopID
+            ImGui::PopID();
+            break;
+        }
+        case 8: {  // Text
+            const char *text = JSImGuiCommandLabel(c, w[0]);
+            if (!text) return false;
+            ImGui::TextUnformatted(text);
+            break;
+        }
+        case 9: {  // Separator
+            ImGui::Separator();
+            break;
+        }
+        case 10: {  // SameLine
+            ImGui::SameLine();
+            break;
+        }
+        case 11: {  // Spacing
+            ImGui::Spacing();
+            break;
+        }
+        case 12: {  // Indent
+            ImGui::Indent();
+            break;
+        }
+        case 13: {  // Unindent
+            ImGui::Unindent();
+            break;
+        }
+        case 14: {  // Button
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            bool ret;
+            ret = ImGui::Button(label);
+            w[1] = ret;
+            break;
+        }
+        case 15: {  // SmallButton
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            bool ret;
+            ret = ImGui::SmallButton(label);
+            w[1] = ret;
+            break;
+        }
+        case 16: {  // Selectable
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            bool selected = w[1] != 0;
+            bool ret;
+            ret = ImGui::Selectable(label, selected);
+            w[2] = ret;
+            break;
+        }
+        case 17: {  // Checkbox
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            bool v = w[1] != 0;
+            bool ret;
+            ret = ImGui::Checkbox(label, &v);
+            w[1] = v;
+            w[2] = ret;
+            break;
+        }
+        case 18: {  // SliderFloat
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            float v = JSImGuiWordToFloat(w[1]);
+            float min = JSImGuiWordToFloat(w[2]);
+            float max = JSImGuiWordToFloat(w[3]);
+            bool ret;
+            ret = ImGui::SliderFloat(label, &v, min, max);
+            w[1] = JSImGuiFloatToWord(v);
+            w[4] = ret;
+            break;
+        }
+        case 19: {  // SliderInt
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            int v = (int32_t)w[1];
+            int min = (int32_t)w[2];
+            int max = (int32_t)w[3];
+            bool ret;
+            ret = ImGui::SliderInt(label, &v, min, max);
+            w[1] = (uint32_t)v;
+            w[4] = ret;
+            break;
+        }
+        case 20: {  // DragFloat
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            float v = JSImGuiWordToFloat(w[1]);
+            float speed = JSImGuiWordToFloat(w[2]);
+            float min = JSImGuiWordToFloat(w[3]);
+            float max = JSImGuiWordToFloat(w[4]);
+            bool ret;
+            ret = ImGui::DragFloat(label, &v, speed, min, max);
+            w[1] = JSImGuiFloatToWord(v);
+            w[5] = ret;
+            break;
+        }
+        case 21: {  // TreeNode
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            bool ret;
+            ret = ImGui::TreeNode(label);
+            w[1] = ret;
+            break;
+        }
+        case 22: {  // TreePop
+            ImGui::TreePop();
+            break;
+        }
+        case 23: {  // CollapsingHeader
+            const char *label = JSImGuiCommandLabel(c, w[0]);
+            if (!label) return false;
+            bool ret;
+            ret = ImGui::CollapsingHeader(label);
+            w[1] = ret;
+            break;
+        }
+        case 24: {  // IsItemHovered
+            bool ret;
+            ret = ImGui::IsItemHovered();
+            w[0] = ret;
+            break;
+        }
+        case 25: {  // IsItemFocused
+            bool ret;
+            ret = ImGui::IsItemFocused();
+            w[0] = ret;
+            break;
+        }
+        case 26: {  // IsItemClicked
+            bool ret;
+            ret = ImGui::IsItemClicked();
+            w[0] = ret;
+            break;
+        }
+    }
+    return true;
+}
+
+static const JSCFunctionListEntry js_imgui_ops[] = {
+    JS_PROP_INT32_DEF("Begin", 0, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("End", 1, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("BeginChild", 2, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("EndChild", 3, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("SetNextWindowPos", 4, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("SetNextWindowSize", 5, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("PushID", 6, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("PopID", 7, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Text", 8, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Separator", 9, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("SameLine", 10, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Spacing", 11, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Indent", 12, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Unindent", 13, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Button", 14, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("SmallButton", 15, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Selectable", 16, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("Checkbox", 17, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("SliderFloat", 18, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("SliderInt", 19, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("DragFloat", 20, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("TreeNode", 21, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("TreePop", 22, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("CollapsingHeader", 23, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("IsItemHovered", 24, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("IsItemFocused", 25, JS_PROP_CONFIGURABLE),
+    JS_PROP_INT32_DEF("IsItemClicked", 26, JS_PROP_CONFIGURABLE),
+};
+
+const JSCFunctionListEntry js_imgui_gen_funcs[] = {
+    JS_CFUNC_DEF("Begin", 1, js_imgui_Begin),
+    JS_CFUNC_DEF("End", 0, js_imgui_End),
+    JS_CFUNC_DEF("BeginChild", 4, js_imgui_BeginChild),
+    JS_CFUNC_DEF("EndChild", 0, js_imgui_EndChild),
+    JS_CFUNC_DEF("SetNextWindowPos", 2, js_imgui_SetNextWindowPos),
+    JS_CFUNC_DEF("SetNextWindowSize", 2, js_imgui_SetNextWindowSize),
+    JS_CFUNC_DEF("PushID", 1, js_imgui_PushID),
+    JS_CFUNC_DEF("PopID", 0, js_imgui_PopID),
+    JS_CFUNC_DEF("Text", 1, js_imgui_Text),
+    JS_CFUNC_DEF("Separator", 0, js_imgui_Separator),
+    JS_CFUNC_DEF("SameLine", 0, js_imgui_SameLine),
+    JS_CFUNC_DEF("Spacing", 0, js_imgui_Spacing),
+    JS_CFUNC_DEF("Indent", 0, js_imgui_Indent),
+    JS_CFUNC_DEF("Unindent", 0, js_imgui_Unindent),
+    JS_CFUNC_DEF("Button", 1, js_imgui_Button),
+    JS_CFUNC_DEF("SmallButton", 1, js_imgui_SmallButton),
+    JS_CFUNC_DEF("Selectable", 2, js_imgui_Selectable),
+    JS_CFUNC_DEF("Checkbox", 2, js_imgui_Checkbox),
+    JS_CFUNC_DEF("SliderFloat", 4, js_imgui_SliderFloat),
+    JS_CFUNC_DEF("SliderInt", 4, js_imgui_SliderInt),
+    JS_CFUNC_DEF("DragFloat", 5, js_imgui_DragFloat),
+    JS_CFUNC_DEF("TreeNode", 1, js_imgui_TreeNode),
+    JS_CFUNC_DEF("TreePop", 0, js_imgui_TreePop),
+    JS_CFUNC_DEF("CollapsingHeader", 1, js_imgui_CollapsingHeader),
+    JS_CFUNC_DEF("IsItemHovered", 0, js_imgui_IsItemHovered),
+    JS_CFUNC_DEF("IsItemFocused", 0, js_imgui_IsItemFocused),
+    JS_CFUNC_DEF("IsItemClicked", 0, js_imgui_IsItemClicked),
+    JS_OBJECT_DEF("Op", js_imgui_ops, countof(js_imgui_ops),
+                  JS_PROP_CONFIGURABLE),
+};
+const size_t js_imgui_gen_func_count = countof(js_imgui_gen_funcs);
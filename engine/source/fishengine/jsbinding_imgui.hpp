@@ -0,0 +1,70 @@
+#ifndef JSBINDING_IMGUI_HPP
+#define JSBINDING_IMGUI_HPP
+
+#include <cutils.h>
+#include <quickjs.h>
+
+#include <cstdint>
+#include <cstring>
+
+// The imgui module. The widget functions are generated by codegen.py from
+// codegen/imgui.json into jsbinding_imgui.gen.cpp, once as JS functions and
+// once as ops of the command buffer that imgui.Submit runs.
+
+// the C string of a JS string, cached by the string so that a label that
+// stays the same is converted once; valid until the next call
+const char *JSImGuiLabel(JSContext *ctx, JSValueConst v);
+
+// a string that is converted on every call, for text that changes
+struct JSImGuiString {
+    JSContext *ctx;
+    const char *str = NULL;
+    JSImGuiString(JSContext *ctx, JSValueConst v)
+        : ctx(ctx), str(JS_ToCString(ctx, v)) {}
+    ~JSImGuiString() {
+        if (str) JS_FreeCString(ctx, str);
+    }
+    operator const char *() const { return str; }
+};
+
+// imgui.Submit(words, count, strings): words is a Uint32Array of `count`
+// words, an op (imgui.Op) followed by one word for every parameter of the
+// widget; labels and strings are indices into the array `strings` and floats
+// are stored as their bits. An op that returns a bool has one more word that
+// gets the result, inout parameters get the new value.
+// A widget function with an inout parameter returns its new value instead.
+struct JSImGuiCommands {
+    JSContext *ctx;
+    JSValueConst strings;
+    uint32_t *words;
+    uint32_t count;
+    uint32_t pos;  // of the first word after the op
+};
+
+inline float JSImGuiWordToFloat(uint32_t w) {
+    float f;
+    memcpy(&f, &w, 4);
+    return f;
+}
+
+inline uint32_t JSImGuiFloatToWord(float f) {
+    uint32_t w;
+    memcpy(&w, &f, 4);
+    return w;
+}
+
+// strings[index] as a label
+const char *JSImGuiCommandLabel(JSImGuiCommands *c, uint32_t index);
+
+// generated; words after every op, results included
+extern const uint8_t js_imgui_op_words[];
+extern const uint32_t js_imgui_op_count;
+
+// generated; runs `op` with the words at c->pos, which are all there; false
+// with an exception thrown for a bad string
+bool JSImGuiRunCommand(JSImGuiCommands *c, uint32_t op);
+
+extern const JSCFunctionListEntry js_imgui_gen_funcs[];
+extern const size_t js_imgui_gen_func_count;
+
+#endif /* JSBINDING_IMGUI_HPP */
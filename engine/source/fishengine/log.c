@@ -0,0 +1,330 @@
+#include "log.h"
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "debug.h"
+#include "statistics.h"
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE Thread;
+typedef SRWLOCK Mutex;
+#define MutexInitializer SRWLOCK_INIT
+#define MutexLock(m) AcquireSRWLockExclusive(m)
+#define MutexUnlock(m) ReleaseSRWLockExclusive(m)
+#define ThreadLocal __declspec(thread)
+static void SleepMilliseconds(uint32_t ms) { Sleep(ms); }
+static uint64_t AtomicLoad(volatile uint64_t *p) {
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)p, 0, 0);
+}
+static void AtomicStore(volatile uint64_t *p, uint64_t v) {
+    InterlockedExchange64((volatile LONG64 *)p, (LONG64)v);
+}
+static uint64_t AtomicFetchAdd(volatile uint64_t *p, uint64_t v) {
+    return (uint64_t)InterlockedExchangeAdd64((volatile LONG64 *)p,
+                                              (LONG64)v);
+}
+static void *AtomicLoadPointer(void *volatile *p) {
+    return InterlockedCompareExchangePointer(p, NULL, NULL);
+}
+static void AtomicStorePointer(void *volatile *p, void *v) {
+    InterlockedExchangePointer(p, v);
+}
+// *expected is updated when it fails
+static bool AtomicCompareExchange(volatile uint64_t *p, uint64_t *expected,
+                                  uint64_t desired) {
+    const uint64_t old = (uint64_t)InterlockedCompareExchange64(
+        (volatile LONG64 *)p, (LONG64)desired, (LONG64)*expected);
+    if (old == *expected) return true;
+    *expected = old;
+    return false;
+}
+#else
+#include <pthread.h>
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+#define MutexInitializer PTHREAD_MUTEX_INITIALIZER
+#define MutexLock(m) pthread_mutex_lock(m)
+#define MutexUnlock(m) pthread_mutex_unlock(m)
+#define ThreadLocal _Thread_local
+static void SleepMilliseconds(uint32_t ms) {
+    struct timespec ts = {0, (long)ms * 1000000};
+    nanosleep(&ts, NULL);
+}
+static uint64_t AtomicLoad(volatile uint64_t *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static void AtomicStore(volatile uint64_t *p, uint64_t v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+static uint64_t AtomicFetchAdd(volatile uint64_t *p, uint64_t v) {
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+}
+static void *AtomicLoadPointer(void *volatile *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static void AtomicStorePointer(void *volatile *p, void *v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+// *expected is updated when it fails
+static bool AtomicCompareExchange(volatile uint64_t *p, uint64_t *expected,
+                                  uint64_t desired) {
+    return __atomic_compare_exchange_n(p, expected, desired, true,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#endif
+
+#define LogSlotSize 64
+#define LogMaxCategories 256
+
+typedef struct {
+    volatile uint64_t sequence;  // position + 1 once the record is published
+    char data[LogSlotSize - 8];
+} LogSlot;
+
+typedef struct {
+    uint64_t time;    // ns since LogInit
+    uint32_t length;  // of the text
+    uint16_t category;
+    uint16_t slots;  // of the record, this one included
+    uint16_t thread;
+    uint8_t level;
+} LogHeader;
+
+// text in the first slot of a record and in each of the others
+#define LogFirstTextSize (sizeof(((LogSlot *)0)->data) - sizeof(LogHeader))
+#define LogSlotTextSize sizeof(((LogSlot *)0)->data)
+
+static struct {
+    LogSlot *slots;
+    uint64_t mask;
+    struct timespec start;
+    void *volatile output;  // FILE, set while the log thread runs
+    char *text;  // a record put together, for the log thread
+
+    // writers; the head and the tail on cache lines of their own
+    char pad0[64];
+    volatile uint64_t head;  // next position to claim
+    char pad1[56];
+    volatile uint64_t tail;  // next position to read, by the log thread only
+    char pad2[56];
+    volatile uint64_t written;
+    volatile uint64_t dropped;
+    volatile uint64_t nextThread;
+
+    Thread thread;
+    volatile uint64_t quit;
+    // set once the ring is ready, read by every writer
+    volatile uint64_t running;
+
+    Mutex categoryLock;
+    const char *categories[LogMaxCategories];
+    uint32_t categoryCount;
+} g_Log = {
+    .categoryLock = MutexInitializer,
+    .categories = {"log"},
+    .categoryCount = 1,
+};
+
+static ThreadLocal uint32_t t_threadIndex = 0;  // 1 based, 0 before the first
+
+static const char *g_LevelNames[] = {"debug", "info", "warning", "error"};
+
+static uint64_t Nanoseconds() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)(ts.tv_sec - g_Log.start.tv_sec) * 1000000000u +
+           (uint64_t)ts.tv_nsec - (uint64_t)g_Log.start.tv_nsec;
+}
+
+static uint32_t SlotCount(uint32_t length) {
+    if (length <= LogFirstTextSize) return 1;
+    return 1 + (uint32_t)((length - LogFirstTextSize + LogSlotTextSize - 1) /
+                          LogSlotTextSize);
+}
+
+static void WriteLine(FILE *output, const LogHeader *h, const char *text) {
+    if (h->level == LogLevelError) debug_add_error(text);
+    if (!output) return;
+    // set before the id was returned, and the id before the record
+    fprintf(output, "%9.3f t%-2u [%s] ", h->time * 1e-9, h->thread,
+            g_Log.categories[h->category]);
+    if (h->level != LogLevelInfo)
+        fprintf(output, "%s: ", g_LevelNames[h->level]);
+    fwrite(text, 1, h->length, output);
+    fputc('\n', output);
+}
+
+// the records published from the tail on; the slots go back to the writers
+// once a record is written
+static uint32_t Drain() {
+    FILE *output = AtomicLoadPointer(&g_Log.output);
+    uint32_t count = 0;
+    for (;;) {
+        const uint64_t tail = g_Log.tail;
+        LogSlot *first = &g_Log.slots[tail & g_Log.mask];
+        if (AtomicLoad(&first->sequence) != tail + 1) break;
+        LogHeader h;
+        memcpy(&h, first->data, sizeof(h));
+        uint32_t copied = h.length < LogFirstTextSize ? h.length
+                                                      : LogFirstTextSize;
+        memcpy(g_Log.text, first->data + sizeof(h), copied);
+        for (uint32_t i = 1; i < h.slots; ++i) {
+            const LogSlot *s = &g_Log.slots[(tail + i) & g_Log.mask];
+            uint32_t n = h.length - copied;
+            if (n > LogSlotTextSize) n = LogSlotTextSize;
+            memcpy(g_Log.text + copied, s->data, n);
+            copied += n;
+        }
+        g_Log.text[h.length] = '\0';
+        WriteLine(output, &h, g_Log.text);
+        AtomicStore(&g_Log.tail, tail + h.slots);
+        count++;
+    }
+    if (count > 0 && output) fflush(output);
+    return count;
+}
+
+// polls, writers never wake it
+static void LogLoop() {
+    while (!AtomicLoad(&g_Log.quit)) {
+        if (Drain() == 0) SleepMilliseconds(1);
+    }
+    Drain();
+}
+
+#ifdef _WIN32
+static DWORD WINAPI LogMain(LPVOID arg) {
+    LogLoop();
+    return 0;
+}
+#else
+static void *LogMain(void *arg) {
+    LogLoop();
+    return NULL;
+}
+#endif
+
+void LogInit(uint32_t capacity) {
+    if (AtomicLoad(&g_Log.running)) return;
+    assert((capacity & (capacity - 1)) == 0);
+    // room for a few of the longest records
+    const uint32_t minCapacity = 4 * SlotCount(LogMaxTextLength);
+    while (capacity < minCapacity) capacity *= 2;
+    g_Log.slots = calloc(capacity, sizeof(LogSlot));
+    count_heap_allocation();
+    g_Log.text = malloc(LogMaxTextLength + 1);
+    count_heap_allocation();
+    g_Log.mask = capacity - 1;
+    g_Log.head = g_Log.tail = 0;
+    g_Log.quit = 0;
+    timespec_get(&g_Log.start, TIME_UTC);
+    g_Log.output = stdout;
+#ifdef _WIN32
+    g_Log.thread = CreateThread(NULL, 0, LogMain, NULL, 0, NULL);
+#else
+    pthread_create(&g_Log.thread, NULL, LogMain, NULL);
+#endif
+    AtomicStore(&g_Log.running, 1);
+}
+
+void LogShutdown() {
+    if (!AtomicLoad(&g_Log.running)) return;
+    AtomicStore(&g_Log.quit, 1);
+#ifdef _WIN32
+    WaitForSingleObject(g_Log.thread, INFINITE);
+    CloseHandle(g_Log.thread);
+#else
+    pthread_join(g_Log.thread, NULL);
+#endif
+    AtomicStore(&g_Log.running, 0);
+    free(g_Log.slots);
+    free(g_Log.text);
+    g_Log.slots = NULL;
+    g_Log.text = NULL;
+}
+
+void LogSetOutput(FILE *file) { AtomicStorePointer(&g_Log.output, file); }
+
+uint16_t LogCategory(const char *name) {
+    uint16_t id = 0;
+    MutexLock(&g_Log.categoryLock);
+    while (id < g_Log.categoryCount && strcmp(g_Log.categories[id], name) != 0)
+        id++;
+    if (id == g_Log.categoryCount) {
+        if (id < LogMaxCategories)
+            g_Log.categories[g_Log.categoryCount++] = name;
+        else
+            id = 0;
+    }
+    MutexUnlock(&g_Log.categoryLock);
+    return id;
+}
+
+static void Write(LogLevel level, uint16_t category, const char *text,
+                  size_t length) {
+    if (length > LogMaxTextLength) length = LogMaxTextLength;
+    if (!AtomicLoad(&g_Log.running)) {
+        printf("%.*s\n", (int)length, text);
+        return;
+    }
+    const uint32_t slots = SlotCount((uint32_t)length);
+    uint64_t head = AtomicLoad(&g_Log.head);
+    do {
+        if (head + slots - AtomicLoad(&g_Log.tail) > g_Log.mask + 1) {
+            AtomicFetchAdd(&g_Log.dropped, 1);
+            return;
+        }
+    } while (!AtomicCompareExchange(&g_Log.head, &head, head + slots));
+
+    if (t_threadIndex == 0)
+        t_threadIndex = (uint32_t)AtomicFetchAdd(&g_Log.nextThread, 1) + 1;
+    const LogHeader h = {Nanoseconds(), (uint32_t)length, category,
+                         (uint16_t)slots, (uint16_t)t_threadIndex,
+                         (uint8_t)level};
+    LogSlot *first = &g_Log.slots[head & g_Log.mask];
+    memcpy(first->data, &h, sizeof(h));
+    size_t copied = length < LogFirstTextSize ? length : LogFirstTextSize;
+    memcpy(first->data + sizeof(h), text, copied);
+    for (uint32_t i = 1; i < slots; ++i) {
+        LogSlot *s = &g_Log.slots[(head + i) & g_Log.mask];
+        size_t n = length - copied;
+        if (n > LogSlotTextSize) n = LogSlotTextSize;
+        memcpy(s->data, text + copied, n);
+        copied += n;
+    }
+    // the log thread reads nothing of the record before this
+    AtomicStore(&first->sequence, head + 1);
+    AtomicFetchAdd(&g_Log.written, 1);
+}
+
+void LogWrite(LogLevel level, uint16_t category, const char *text) {
+    Write(level, category, text, strlen(text));
+}
+
+void LogWriteF(LogLevel level, uint16_t category, const char *format, ...) {
+    char text[1024];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (length < 0) return;
+    if (length >= (int)sizeof(text)) length = sizeof(text) - 1;
+    Write(level, category, text, (size_t)length);
+}
+
+void LogFlush() {
+    if (!AtomicLoad(&g_Log.running)) return;
+    const uint64_t head = AtomicLoad(&g_Log.head);
+    while (AtomicLoad(&g_Log.tail) < head) SleepMilliseconds(1);
+}
+
+LogStats LogGetStats() {
+    LogStats stats = {AtomicLoad(&g_Log.written), AtomicLoad(&g_Log.dropped)};
+    return stats;
+}
@@ -0,0 +1,63 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The engine log: any thread writes binary records to a bounded ring without
+// taking a lock, a log thread turns them into lines on stdout and gives the
+// errors to the console of debug.h.
+//
+// A record is a header (time, level, thread, category) followed by the text,
+// over as many 64 byte slots as it needs. A writer claims its slots with a
+// compare and swap on the head and publishes them by writing their sequence
+// numbers, the header last. When the ring has no room for a record the record
+// is dropped and counted, nothing already written is overwritten.
+
+typedef enum {
+    LogLevelDebug,
+    LogLevelInfo,
+    LogLevelWarning,
+    LogLevelError,
+} LogLevel;
+
+// the text of longer records is cut
+#define LogMaxTextLength (16 << 10)
+
+// `capacity` slots, a power of two; starts the log thread
+void LogInit(uint32_t capacity);
+// writes what is in the ring and stops the log thread, once the other
+// threads stopped logging
+void LogShutdown();
+// where the lines go after LogInit, stdout; NULL for nowhere, the errors
+// still go to the console
+void LogSetOutput(FILE *file);
+
+// the id of a category by its name, which must stay valid; registering
+// takes a lock, callers keep the id
+uint16_t LogCategory(const char *name);
+
+// copies `text` to the ring; before LogInit the line is printed right away
+void LogWrite(LogLevel level, uint16_t category, const char *text);
+// formats on the calling thread, the line is made on the log thread
+void LogWriteF(LogLevel level, uint16_t category, const char *format, ...);
+
+// waits until the log thread has written what was logged before the call
+void LogFlush();
+
+typedef struct {
+    uint64_t written;  // records
+    uint64_t dropped;  // the ring was full
+} LogStats;
+
+LogStats LogGetStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_H */
@@ -20,6 +20,8 @@
 #include "app.h"
 #include "render_d3d12.hpp"
 #include "input.h"
+#include "log.h"
+#include "script_worker.h"
 
 extern "C" {
 const char* ApplicationFilePath();
@@ -198,6 +200,8 @@ int main(int, char**)
     CleanupDeviceD3D();
     glfwDestroyWindow(window);
     glfwTerminate();
+    ScriptWorkersShutdown();
+    LogShutdown();
 
     return 0;
 }
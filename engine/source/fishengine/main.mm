@@ -9,6 +9,8 @@
 #include <imgui_impl_metal.h>
 #include <stdio.h>
 #include "app.h"
+#include "log.h"
+#include "script_worker.h"
 #include "render_metal.h"
 
 #define GLFW_INCLUDE_NONE
@@ -172,6 +174,8 @@ int main(int, char **) {
 
     glfwDestroyWindow(window);
     glfwTerminate();
+    ScriptWorkersShutdown();
+    LogShutdown();
 
     return 0;
 }
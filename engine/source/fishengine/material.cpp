@@ -7,7 +7,9 @@
 #include <set>
 
 #include "asset.h"
+#include "bindless.h"
 #include "material_internal.hpp"
+#include "rhi.h"
 #include "shader.h"
 #include "shader_internal.hpp"
 
@@ -37,6 +39,7 @@ struct MaterialPropertyBlock {
     // void SetBuffer(int nameID, const ComputeBuffer& value);
     // void SetTexture(std::string_view name, const )
     void SetTexture(int nameID, Texture *value) { m_Textures[nameID] = value; }
+    const std::map<int, Texture *> &GetTextures() const { return m_Textures; }
     //	void SetFloatArray(int nameID, const std::vector<float>& values) {
     //		SetFloats(nameID, values.data(), (int)values.size());
     //	}
@@ -194,7 +197,7 @@ struct MaterialImpl {
 void *MaterialNew() {
     Material *mat = (Material *)malloc(sizeof(Material));
     memset(mat, 0, sizeof(Material));
-    AssetAdd(AssetTypeMaterial, mat);
+    mat->assetID = AssetAdd(AssetTypeMaterial, mat);
     mat->impl = new MaterialImpl();
     return mat;
 }
@@ -228,6 +231,17 @@ Texture *MaterialGetTexture(Material *mat, int nameID) {
     return MaterialGetImpl(mat)->m_PropertyBlock.GetTexture(nameID);
 }
 
+uint32_t MaterialGetTextures(Material *mat, Texture **textures,
+                             uint32_t capacity) {
+    uint32_t count = 0;
+    for (auto &it : MaterialGetImpl(mat)->m_PropertyBlock.GetTextures()) {
+        if (it.second == nullptr) continue;
+        if (count == capacity) break;
+        textures[count++] = it.second;
+    }
+    return count;
+}
+
 inline int NextMultipleOf8(int x) { return (x + 7) & (-8); }
 
 void MaterialSetShader(Material *mat, Shader *shader) {
@@ -323,3 +337,33 @@ uint32_t MaterialGetVariantIndex(Material *material, uint32_t passIdx) {
     MaterialImpl *impl = MaterialGetImpl(material);
     return impl->shaderPassCache[passIdx];
 }
+
+uint32_t MaterialBuildConstants(Material *material, uint32_t pass,
+                                uint32_t variant, void *buffer) {
+    ShaderVariant &var =
+        ShaderGetImpl(material->shader)->passes[pass].variants[variant];
+    const ShaderReflectCBType &globals = var.reflect.ps.globals;
+    if (buffer == NULL) return globals.block_size;
+
+    uint8_t *p = (uint8_t *)buffer;
+    for (auto &m : globals.members) {
+        if (!m.used) continue;
+        if (m.kind == ShaderConstantTextureIndex) {
+            Texture *tex = MaterialGetTexture(material, m.nameID);
+            uint32_t index = BindlessMissingTexture;
+            if (tex != nullptr) index = GetTextureBindlessIndex(tex->handle);
+            memcpy(p + m.offset, &index, sizeof(index));
+        } else if (m.kind == ShaderConstantSamplerIndex) {
+            Texture *tex = MaterialGetTexture(material, m.nameID);
+            uint32_t index = BindlessSamplerIndexOf(tex);
+            memcpy(p + m.offset, &index, sizeof(index));
+        } else if (m.type == "float") {
+            float v = MaterialGetFloat(material, m.nameID);
+            memcpy(p + m.offset, &v, sizeof(v));
+        } else if (m.type == "vec2" || m.type == "vec3" || m.type == "vec4") {
+            float4 v = MaterialGetVector(material, m.nameID);
+            memcpy(p + m.offset, &v, m.bytes);
+        }
+    }
+    return globals.block_size;
+}
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "asset.h"
 #include "shader.h"
 #include "simd_math.h"
 #include "texture.h"
@@ -14,6 +15,7 @@ extern "C" {
 #endif
 
 struct Material {
+    AssetID assetID;
     Shader *shader;
     Texture *mainTexture;
     float4 color;
@@ -30,12 +32,23 @@ void MaterialSetVector(Material *mat, int nameID, float4 value);
 float4 MaterialGetVector(Material *mat, int nameID);
 void MaterialSetTexture(Material *mat, int nameID, Texture *texture);
 Texture *MaterialGetTexture(Material *mat, int nameID);
+// the textures set on the material, at most capacity of them; returns the
+// count
+uint32_t MaterialGetTextures(Material *mat, Texture **textures,
+                             uint32_t capacity);
 
 bool MaterialIsKeywordEnabled(Material *mat, const char *keyword);
 void MaterialSetKeyword(Material *mat, const char *keyword, bool enabled);
 void MaterialEnableKeyword(Material *mat, const char *keyword);
 void MaterialDisableKeyword(Material *mat, const char *keyword);
 
+// fills the pixel shader constant buffer (cb0) of a pass variant: property
+// values, and the bindless slots of the material's textures and samplers
+// (bindless.h). Returns the size of the buffer; with buffer == NULL it only
+// returns the size.
+uint32_t MaterialBuildConstants(Material *mat, uint32_t pass, uint32_t variant,
+                                void *buffer);
+
 #ifdef __cplusplus
 }
 #endif
@@ -6,13 +6,21 @@
 #include "rhi.h"
 #include "statistics.h"
 
+const VertexDeclElement MeshVertexLayout[MeshVertexLayoutCount] = {
+    {VertexAttributePosition, VertexAttributeTypeFloat, 4},
+    {VertexAttributeNormal, VertexAttributeTypeFloat, 4},
+    {VertexAttributeTangent, VertexAttributeTypeFloat, 4},
+    {VertexAttributeTexCoord0, VertexAttributeTypeFloat, 2},
+    {VertexAttributeTexCoord1, VertexAttributeTypeFloat, 2},
+};
+
 Skin *SkinNew() {
     Skin *s = (Skin *)malloc(sizeof(Skin));
     memset(s, 0, sizeof(*s));
     s->inverseBindMatrices.stride = sizeof(float4x4);
     s->joints.stride = sizeof(Entity);
     s->boneMats.stride = sizeof(float4x4);
-    AssetAdd(AssetTypeSkin, s);
+    s->assetID = AssetAdd(AssetTypeSkin, s);
     return s;
 }
 
@@ -55,7 +63,7 @@ void MeshFree(void *m) {
     DeleteBuffer(mesh->vb);
     DeleteBuffer(mesh->ib);
     DeleteBuffer(mesh->sb);
-    DeleteBuffer(mesh->skinnedvb);
+    // skinnedvb belongs to the backend, it is shared by all skinned meshes
 
     // TODO: g_meshes
     free(mesh);
@@ -111,6 +119,7 @@ void _MeshSetVertices(Mesh *m, enum VertexAttr attr, void *buffer, int count,
         q += stride;
     }
     m->attributes |= (1 << attr);
+    if (attr == VertexAttrPosition) MeshRecalculateBounds(m);
 }
 
 void _MeshSetVertices2(Mesh *m, enum VertexAttr attr, void *buffer, int count,
@@ -229,6 +238,7 @@ Mesh *MeshCombine(Mesh **meshes, uint32_t count) {
         array_get_bytelength(&combined->vertices);
     g_statistics.cpu.indexBufferSize +=
         array_get_bytelength(&combined->triangles);
+    MeshRecalculateBounds(combined);
 
     return combined;
 }
@@ -259,6 +269,34 @@ static uint32_t MeshGetIndexAt2(Mesh *mesh, int faceIdx, int vertexIdx) {
     return MeshGetIndexAt(mesh, faceIdx * 3 + vertexIdx);
 }
 
+void MeshRecalculateBounds(Mesh *mesh) {
+    const Vertex *v = mesh->vertices.ptr;
+    const uint32_t count = mesh->vertices.size;
+    if (count == 0) {
+        memset(&mesh->bounds, 0, sizeof(mesh->bounds));
+        mesh->boundingRadius = 0;
+        return;
+    }
+    float3 min = {v[0].position.x, v[0].position.y, v[0].position.z};
+    float3 max = min;
+    for (uint32_t i = 1; i < count; ++i) {
+        min.x = fminf(min.x, v[i].position.x);
+        min.y = fminf(min.y, v[i].position.y);
+        min.z = fminf(min.z, v[i].position.z);
+        max.x = fmaxf(max.x, v[i].position.x);
+        max.y = fmaxf(max.y, v[i].position.y);
+        max.z = fmaxf(max.z, v[i].position.z);
+    }
+    mesh->bounds = BoundsFromMinMax(min, max);
+    float r2 = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        float3 p = {v[i].position.x, v[i].position.y, v[i].position.z};
+        float3 d = float3_subtract(p, mesh->bounds.center);
+        r2 = fmaxf(r2, float3_dot(d, d));
+    }
+    mesh->boundingRadius = sqrtf(r2);
+}
+
 void MeshRecalculateNormals(Mesh *mesh) {
     uint32_t icount = MeshGetTriangleCount(mesh);
     uint32_t vcount = MeshGetVertexCount(mesh);
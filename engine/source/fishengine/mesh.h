@@ -5,6 +5,7 @@
 
 #include "asset.h"
 #include "array.h"
+#include "bounds.h"
 #include "ecs.h"
 #include "simd_math.h"
 #include "vertexdecl.h"
@@ -33,6 +34,10 @@ struct Vertex {
 };
 typedef struct Vertex Vertex;
 
+// Vertex as vertex shader input, what every pipeline is built with
+#define MeshVertexLayoutCount 5
+extern const VertexDeclElement MeshVertexLayout[MeshVertexLayoutCount];
+
 struct BoneWeight {
     uint32_t boneIndex[4];
     float weights[4];
@@ -46,6 +51,7 @@ struct Skin {
     uint32_t minJoint;
 
     array boneMats;  // vector<float4x4>;
+    AssetID assetID;
 };
 typedef struct Skin Skin;
 
@@ -63,9 +69,16 @@ struct Mesh {
     uint32_t vb;
     uint32_t ib;
     uint32_t sb;
+    // the backend's skinned vertex arena and the first vertex of this mesh
+    // in it, set by GPUSkinning every frame
     uint32_t skinnedvb;  // TODO: move to Renderable
+    uint32_t skinnedOffset;
     int refcount;
     uint32_t attributes;
+
+    // local space, kept up to date by MeshSetVertices
+    Bounds bounds;
+    float boundingRadius;  // sphere around bounds.center
 };
 typedef struct Mesh Mesh;
 
@@ -92,6 +105,7 @@ void MeshUploadMeshData(Mesh *m);
 Mesh *MeshCombine(Mesh **meshes, uint32_t count);
 void MeshRecalculateNormals(Mesh *mesh);
 void MeshRecalculateTangents(Mesh *mesh);
+void MeshRecalculateBounds(Mesh *mesh);
 
 static inline void MeshRelease(Mesh *m) { m->refcount--; }
 
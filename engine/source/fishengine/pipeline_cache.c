@@ -0,0 +1,342 @@
+#include "pipeline_cache.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "statistics.h"
+
+// the records are written as they are in memory
+static_assert(sizeof(PipelineDesc) == 40, "PipelineDesc has padding");
+static_assert(sizeof(PipelineCacheRecord) == 64,
+              "PipelineCacheRecord has padding");
+
+PipelineRenderState PipelineRenderStateDefault() {
+    PipelineRenderState s;
+    s.cullMode = PipelineCullBack;
+    s.depthTest = PipelineCompareLess;
+    s.depthWrite = 1;
+    s.blendMode = PipelineBlendOpaque;
+    return s;
+}
+
+uint64_t PipelineHashBytes(const void *data, size_t size, uint64_t seed) {
+    uint64_t h = seed;
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static uint64_t HashU64(uint64_t h, uint64_t v) {
+    return PipelineHashBytes(&v, sizeof(v), h);
+}
+
+uint64_t PipelineDescHash(const PipelineDesc *d) {
+    uint64_t h = PipelineHashSeed;
+    h = HashU64(h, d->vsHash);
+    h = HashU64(h, d->psHash);
+    h = HashU64(h, d->vertexLayoutHash);
+    h = HashU64(h, d->state.cullMode);
+    h = HashU64(h, d->state.depthTest);
+    h = HashU64(h, d->state.depthWrite);
+    h = HashU64(h, d->state.blendMode);
+    h = HashU64(h, d->colorFormat);
+    h = HashU64(h, d->depthFormat);
+    h = HashU64(h, d->sampleCount);
+    return h;
+}
+
+uint64_t PipelineVertexLayoutHash(const VertexDeclElement *elements,
+                                  uint32_t count) {
+    uint64_t h = PipelineHashSeed;
+    for (uint32_t i = 0; i < count; ++i) {
+        h = HashU64(h, elements[i].attrib);
+        h = HashU64(h, elements[i].type);
+        h = HashU64(h, (uint64_t)elements[i].count);
+    }
+    return h;
+}
+
+void PipelineCacheInit(PipelineCache *c, uint64_t deviceId) {
+    array_init(&c->entries, sizeof(PipelineCacheEntry), 64);
+    array_init(&c->blobs, 1, 64 * 1024);
+    c->deviceId = deviceId;
+    c->dirty = false;
+}
+
+void PipelineCacheFree(PipelineCache *c) {
+    array_free(&c->entries);
+    array_free(&c->blobs);
+}
+
+// index of the first entry with entry.key >= key
+static uint32_t LowerBound(const PipelineCache *c, uint64_t key) {
+    const PipelineCacheEntry *e = (const PipelineCacheEntry *)c->entries.ptr;
+    uint32_t lo = 0, hi = c->entries.size;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (e[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+PipelineCacheEntry *PipelineCacheFind(PipelineCache *c, uint64_t key) {
+    uint32_t i = LowerBound(c, key);
+    PipelineCacheEntry *e = (PipelineCacheEntry *)c->entries.ptr;
+    if (i < c->entries.size && e[i].key == key) return e + i;
+    return NULL;
+}
+
+static uint32_t AppendBlob(PipelineCache *c, const void *blob, uint32_t size) {
+    uint32_t offset = c->blobs.size;
+    if (size == 0) return offset;
+    if (offset + size > c->blobs.capacity) {
+        uint32_t capacity = c->blobs.capacity * 2;
+        if (capacity < offset + size) capacity = (offset + size + 15) & ~15u;
+        array_reserve(&c->blobs, capacity);
+    }
+    c->blobs.size = offset + size;
+    memcpy((uint8_t *)c->blobs.ptr + offset, blob, size);
+    return offset;
+}
+
+// drops the blob of a replaced entry, the ones after it move down
+static void RemoveBlob(PipelineCache *c, uint32_t offset, uint32_t size) {
+    if (size == 0) return;
+    uint8_t *blobs = (uint8_t *)c->blobs.ptr;
+    memmove(blobs + offset, blobs + offset + size,
+            c->blobs.size - offset - size);
+    c->blobs.size -= size;
+    PipelineCacheEntry *e = (PipelineCacheEntry *)c->entries.ptr;
+    for (uint32_t i = 0; i < c->entries.size; ++i) {
+        if (e[i].blobSize > 0 && e[i].blobOffset > offset)
+            e[i].blobOffset -= size;
+    }
+}
+
+static PipelineCacheEntry *Insert(PipelineCache *c, uint64_t key) {
+    uint32_t i = LowerBound(c, key);
+    array_push(&c->entries);
+    PipelineCacheEntry *e = (PipelineCacheEntry *)c->entries.ptr;
+    memmove(e + i + 1, e + i,
+            (c->entries.size - 1 - i) * sizeof(PipelineCacheEntry));
+    memset(e + i, 0, sizeof(PipelineCacheEntry));
+    e[i].key = key;
+    return e + i;
+}
+
+void PipelineCacheStore(PipelineCache *c, const PipelineDesc *desc,
+                        const void *blob, uint32_t blobSize) {
+    uint64_t key = PipelineDescHash(desc);
+    PipelineCacheEntry *e = PipelineCacheFind(c, key);
+    if (e == NULL) e = Insert(c, key);
+    e->desc = *desc;
+    if (blob != NULL && blobSize > 0) {
+        if (e->blobSize == blobSize) {
+            memcpy((uint8_t *)c->blobs.ptr + e->blobOffset, blob, blobSize);
+        } else {
+            RemoveBlob(c, e->blobOffset, e->blobSize);
+            e->blobOffset = AppendBlob(c, blob, blobSize);
+            e->blobSize = blobSize;
+        }
+    }
+    e->flags |= PipelineCacheEntryUsed;
+    c->dirty = true;
+}
+
+const void *PipelineCacheGetBlob(const PipelineCache *c,
+                                 const PipelineCacheEntry *e) {
+    if (e->blobSize == 0) return NULL;
+    return (const uint8_t *)c->blobs.ptr + e->blobOffset;
+}
+
+static void Clear(PipelineCache *c) {
+    c->entries.size = 0;
+    c->blobs.size = 0;
+    c->dirty = false;
+}
+
+bool PipelineCacheLoadFromMemory(PipelineCache *c, Memory file) {
+    Clear(c);
+    const uint8_t *base = (const uint8_t *)file.buffer;
+    if (base == NULL || file.byteLength < sizeof(PipelineCacheHeader))
+        return false;
+    PipelineCacheHeader h;
+    memcpy(&h, base, sizeof(h));
+    if (h.magic != PipelineCacheMagic || h.version != PipelineCacheVersion ||
+        h.deviceId != c->deviceId)
+        return false;
+    const uint64_t recordsSize =
+        (uint64_t)h.recordCount * sizeof(PipelineCacheRecord);
+    const uint64_t blobStart = sizeof(PipelineCacheHeader) + recordsSize;
+    if (blobStart + h.blobSize != file.byteLength || h.blobSize > UINT32_MAX)
+        return false;
+
+    const uint8_t *blobs = base + blobStart;
+    uint64_t lastKey = 0;
+    for (uint32_t i = 0; i < h.recordCount; ++i) {
+        PipelineCacheRecord r;
+        memcpy(&r, base + sizeof(h) + i * sizeof(r), sizeof(r));
+        // sorted and unique, and the key has to match the description
+        if ((i > 0 && r.key <= lastKey) ||
+            r.key != PipelineDescHash(&r.desc) ||
+            r.blobOffset > h.blobSize ||
+            r.blobSize > h.blobSize - r.blobOffset) {
+            Clear(c);
+            return false;
+        }
+        lastKey = r.key;
+        PipelineCacheEntry *e = (PipelineCacheEntry *)array_push(&c->entries);
+        e->key = r.key;
+        e->desc = r.desc;
+        e->blobOffset = AppendBlob(c, blobs + r.blobOffset, r.blobSize);
+        e->blobSize = r.blobSize;
+        e->flags = 0;
+    }
+    return true;
+}
+
+bool PipelineCacheLoad(PipelineCache *c, const char *path) {
+    Clear(c);
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = false;
+    if (size > 0) {
+        void *buffer = malloc((size_t)size);
+        count_heap_allocation();
+        if (buffer == NULL) {
+            fclose(f);
+            return false;
+        }
+        if (fread(buffer, 1, (size_t)size, f) == (size_t)size)
+            ok = PipelineCacheLoadFromMemory(c,
+                                             MemoryMake(buffer, (size_t)size));
+        free(buffer);
+    }
+    fclose(f);
+    return ok;
+}
+
+bool PipelineCacheSaveToMemory(const PipelineCache *c, array *out) {
+    const PipelineCacheEntry *entries =
+        (const PipelineCacheEntry *)c->entries.ptr;
+    uint32_t recordCount = 0;
+    uint64_t blobSize = 0;
+    for (uint32_t i = 0; i < c->entries.size; ++i) {
+        if (!(entries[i].flags & PipelineCacheEntryUsed)) continue;
+        recordCount++;
+        blobSize += entries[i].blobSize;
+    }
+    if (blobSize > UINT32_MAX) return false;
+
+    PipelineCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = PipelineCacheMagic;
+    h.version = PipelineCacheVersion;
+    h.recordCount = recordCount;
+    h.deviceId = c->deviceId;
+    h.blobSize = blobSize;
+    const uint32_t blobStart =
+        (uint32_t)(sizeof(PipelineCacheHeader) +
+                   recordCount * sizeof(PipelineCacheRecord));
+    // aligned_alloc wants a multiple of the alignment
+    array_init(out, 1, (blobStart + (uint32_t)blobSize + 16) & ~15u);
+    array_resize(out, blobStart + (uint32_t)blobSize);
+    uint8_t *p = (uint8_t *)out->ptr;
+    memcpy(p, &h, sizeof(h));
+
+    // entries are sorted by key, so are the records
+    uint32_t record = 0;
+    uint64_t blobOffset = 0;
+    for (uint32_t i = 0; i < c->entries.size; ++i) {
+        const PipelineCacheEntry *e = entries + i;
+        if (!(e->flags & PipelineCacheEntryUsed)) continue;
+        PipelineCacheRecord r;
+        memset(&r, 0, sizeof(r));
+        r.key = e->key;
+        r.desc = e->desc;
+        r.blobOffset = blobOffset;
+        r.blobSize = e->blobSize;
+        memcpy(p + sizeof(h) + record * sizeof(r), &r, sizeof(r));
+        if (e->blobSize > 0)
+            memcpy(p + blobStart + blobOffset, PipelineCacheGetBlob(c, e),
+                   e->blobSize);
+        blobOffset += e->blobSize;
+        record++;
+    }
+    return true;
+}
+
+bool PipelineCacheSave(const PipelineCache *c, const char *path) {
+    array bytes;
+    if (!PipelineCacheSaveToMemory(c, &bytes)) return false;
+    bool ok = false;
+    FILE *f = fopen(path, "wb");
+    if (f != NULL) {
+        ok = fwrite(bytes.ptr, 1, bytes.size, f) == bytes.size;
+        ok = fclose(f) == 0 && ok;
+    }
+    array_free(&bytes);
+    if (!ok) printf("[pipeline cache] failed to write %s\n", path);
+    return ok;
+}
+
+void PipelineSortIDsInit(PipelineSortIDs *s) {
+    array_init(&s->pairs, sizeof(PipelineSortID), 64);
+    array_init(&s->released, sizeof(uint32_t), 16);
+}
+
+void PipelineSortIDsFree(PipelineSortIDs *s) {
+    array_free(&s->pairs);
+    array_free(&s->released);
+}
+
+uint32_t PipelineSortIDsGet(PipelineSortIDs *s, ShaderHandle vs,
+                            ShaderHandle ps) {
+    const uint64_t key = ((uint64_t)vs << 32) | ps;
+    PipelineSortID *p = (PipelineSortID *)s->pairs.ptr;
+    uint32_t lo = 0, hi = s->pairs.size;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (p[mid].key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < s->pairs.size && p[lo].key == key) return p[lo].id;
+
+    // every id handed out is either in pairs or released
+    uint32_t id = s->pairs.size;
+    if (s->released.size > 0)
+        id = ((uint32_t *)s->released.ptr)[--s->released.size];
+    array_push(&s->pairs);
+    p = (PipelineSortID *)s->pairs.ptr;
+    memmove(p + lo + 1, p + lo, (s->pairs.size - 1 - lo) * sizeof(*p));
+    p[lo].key = key;
+    p[lo].id = id;
+    return id;
+}
+
+void PipelineSortIDsRelease(PipelineSortIDs *s, ShaderHandle shader) {
+    PipelineSortID *p = (PipelineSortID *)s->pairs.ptr;
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < s->pairs.size; ++i) {
+        const uint32_t vs = (uint32_t)(p[i].key >> 32);
+        const uint32_t ps = (uint32_t)p[i].key;
+        if (vs == shader || ps == shader)
+            *(uint32_t *)array_push(&s->released) = p[i].id;
+        else
+            p[kept++] = p[i];
+    }
+    s->pairs.size = kept;
+}
@@ -0,0 +1,179 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+#include "rhi.h"
+#include "vertexdecl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Backend independent half of the pipeline state cache: the description
+// every pipeline is keyed on, and the file that carries compiled pipelines
+// (and with them the list of pipelines to warm up) from one session to the
+// next.
+
+// the faces ShaderLab's Cull removes; the engine's meshes are wound the other
+// way round, the backends flip front and back
+enum PipelineCullMode {
+    PipelineCullOff = 0,
+    PipelineCullFront,
+    PipelineCullBack,
+};
+
+enum PipelineCompare {
+    PipelineCompareLess = 0,
+    PipelineCompareLessEqual,
+    PipelineCompareGreater,
+    PipelineCompareGreaterEqual,
+    PipelineCompareEqual,
+    PipelineCompareAlways,
+};
+
+enum PipelineBlendMode {
+    PipelineBlendOpaque = 0,
+    PipelineBlendAlpha,     // SrcAlpha OneMinusSrcAlpha
+    PipelineBlendAdditive,  // One One
+};
+
+// fixed function state of a shader pass (the Cull, ZTest, ZWrite and Blend
+// of the .shader file)
+struct PipelineRenderState {
+    uint8_t cullMode;   // PipelineCullMode
+    uint8_t depthTest;  // PipelineCompare
+    uint8_t depthWrite;
+    uint8_t blendMode;  // PipelineBlendMode
+};
+typedef struct PipelineRenderState PipelineRenderState;
+
+// Cull Back, ZWrite On and no blending like ShaderLab; ZTest Less rather than
+// LEqual, it is what the engine always drew with
+PipelineRenderState PipelineRenderStateDefault();
+
+// Everything a pipeline is compiled from. Shaders are identified by a hash
+// of their bytecode rather than by handle, so a key means the same thing in
+// every session.
+struct PipelineDesc {
+    uint64_t vsHash;
+    uint64_t psHash;
+    uint64_t vertexLayoutHash;
+    PipelineRenderState state;
+    uint32_t colorFormat;  // backend format values
+    uint32_t depthFormat;
+    uint32_t sampleCount;
+};
+typedef struct PipelineDesc PipelineDesc;
+
+// FNV-1a, the same as ShaderArchiveHash
+uint64_t PipelineHashBytes(const void *data, size_t size, uint64_t seed);
+#define PipelineHashSeed 0xcbf29ce484222325ull
+
+// hashes the fields one by one, padding never reaches the key
+uint64_t PipelineDescHash(const PipelineDesc *desc);
+uint64_t PipelineVertexLayoutHash(const VertexDeclElement *elements,
+                                  uint32_t count);
+
+// pipeline_cache.bin:
+//   PipelineCacheHeader
+//   PipelineCacheRecord records[recordCount]
+//   blob data, referenced by the records
+// All integers are little-endian. A file from another version, device or
+// driver is thrown away as a whole (deviceId); the blobs are opaque to this
+// file and only mean something to the backend that wrote them.
+#define PipelineCacheMagic 0x43504546u  // "FEPC"
+#define PipelineCacheVersion 1
+
+typedef struct PipelineCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t reserved;
+    uint64_t deviceId;  // backend defined, e.g. adapter and driver version
+    uint64_t blobSize;
+} PipelineCacheHeader;
+
+typedef struct PipelineCacheRecord {
+    uint64_t key;  // PipelineDescHash(&desc), checked on load
+    PipelineDesc desc;
+    uint64_t blobOffset;  // from the start of the blob data
+    uint32_t blobSize;
+    uint32_t reserved;
+} PipelineCacheRecord;
+
+enum PipelineCacheEntryFlags {
+    PipelineCacheEntryUsed = 1,       // created in this session
+    PipelineCacheEntryRequested = 2,  // warm-up compile already started
+};
+
+struct PipelineCacheEntry {
+    uint64_t key;
+    PipelineDesc desc;
+    uint32_t blobOffset;  // in PipelineCache.blobs
+    uint32_t blobSize;
+    uint32_t flags;
+};
+typedef struct PipelineCacheEntry PipelineCacheEntry;
+
+// The entries loaded from the last session are this session's warm-up list.
+// Only entries that were used again are saved, so pipelines of shaders that
+// are gone fall out of the file by themselves.
+struct PipelineCache {
+    array entries;  // PipelineCacheEntry, sorted by key
+    array blobs;    // uint8_t
+    uint64_t deviceId;
+    bool dirty;
+};
+typedef struct PipelineCache PipelineCache;
+
+void PipelineCacheInit(PipelineCache *c, uint64_t deviceId);
+void PipelineCacheFree(PipelineCache *c);
+
+// replaces the entries with the ones in the file; a missing, malformed or
+// foreign file leaves the cache empty and returns false
+bool PipelineCacheLoadFromMemory(PipelineCache *c, Memory file);
+bool PipelineCacheLoad(PipelineCache *c, const char *path);
+// writes the used entries; out is an uninitialized array that receives the
+// bytes of the file
+bool PipelineCacheSaveToMemory(const PipelineCache *c, array *out);
+bool PipelineCacheSave(const PipelineCache *c, const char *path);
+
+PipelineCacheEntry *PipelineCacheFind(PipelineCache *c, uint64_t key);
+// adds or replaces the entry of desc and marks it used; blob may be NULL
+void PipelineCacheStore(PipelineCache *c, const PipelineDesc *desc,
+                        const void *blob, uint32_t blobSize);
+// blob of an entry, NULL if it has none
+const void *PipelineCacheGetBlob(const PipelineCache *c,
+                                 const PipelineCacheEntry *e);
+
+// Small ids of the (vs, ps) pairs the render queue sorts on. Backends keep
+// one with the device and release the pairs of a shader when it is deleted,
+// so a recycled handle never gets the id of a pipeline that is gone; the ids
+// released are handed out again, they stay within RenderKeyPipelineBits.
+struct PipelineSortID {
+    uint64_t key;  // vs << 32 | ps
+    uint32_t id;
+};
+typedef struct PipelineSortID PipelineSortID;
+
+struct PipelineSortIDs {
+    array pairs;     // PipelineSortID, sorted by key
+    array released;  // uint32_t
+};
+typedef struct PipelineSortIDs PipelineSortIDs;
+
+void PipelineSortIDsInit(PipelineSortIDs *s);
+void PipelineSortIDsFree(PipelineSortIDs *s);
+uint32_t PipelineSortIDsGet(PipelineSortIDs *s, ShaderHandle vs,
+                            ShaderHandle ps);
+// forgets every pair the shader is part of
+void PipelineSortIDsRelease(PipelineSortIDs *s, ShaderHandle shader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIPELINE_CACHE_H */
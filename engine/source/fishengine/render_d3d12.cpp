@@ -9,32 +9,43 @@
 
 #include <cassert>
 using Microsoft::WRL::ComPtr;
-#include <DDSTextureLoader.h>
 #include <DescriptorHeap.h>
 #include <DirectXHelpers.h>
 #include <DirectXTex.h>
 #include <EffectPipelineStateDescription.h>
 #include <GraphicsMemory.h>
-#include <ResourceUploadBatch.h>
 #include <fmt/format.h>
 #include <pix.h>
 
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <mutex>
 #include <system_error>
+#include <thread>
+#include <unordered_map>
 namespace fs = std::filesystem;
 
+#include "bindless.h"
 #include "camera.h"
 #include "ecs.h"
+#include "frame_alloc.hpp"
+#include "fs.hpp"
+#include "handle_pool.h"
 #include "light.h"
 #include "material_internal.hpp"
+#include "mesh.h"
+#include "pipeline_cache.h"
+#include "render_queue.h"
 #include "renderable.h"
 #include "rhi.h"
 #include "shader.h"
 #include "shader_internal.hpp"
+#include "skinning_batch.h"
 #include "statistics.h"
 #include "texture.h"
 #include "transform.h"
-#include "statistics.h"
+#include "upload_ring.h"
 
 #if _DEBUG
 #define DX12_ENABLE_DEBUG_LAYER
@@ -77,33 +88,60 @@ static HANDLE g_hSwapChainWaitableObject = NULL;
 static ID3D12Resource* g_mainRenderTargetResource[NUM_BACK_BUFFERS] = {};
 static D3D12_CPU_DESCRIPTOR_HANDLE
     g_mainRenderTargetDescriptor[NUM_BACK_BUFFERS] = {};
-static DirectX::ResourceUploadBatch* g_GPUResourceUploader = nullptr;
-static std::vector<ID3D12Resource*> g_PendingResources[NUM_FRAMES_IN_FLIGHT];
+// resources that are replaced in place (buffer resize), released once the
+// gpu has finished the frame they were last used in
+struct PendingResource {
+    ID3D12Resource* resource;
+    uint64_t frame;
+};
+static std::vector<PendingResource> g_PendingResources;
+
+// Dynamic per-frame data (constants, instance matrices, bones) is written
+// straight into one persistently mapped upload buffer, small static uploads
+// are staged there too. Retired per frame, see upload_ring.h.
+constexpr uint64_t UploadRingFrameSize = 8 << 20;
+constexpr uint64_t UploadRingSize = UploadRingFrameSize * NUM_FRAMES_IN_FLIGHT;
+// static uploads above this get a staging buffer of their own
+constexpr uint64_t LargeUploadSize = 1 << 20;
+static UploadRing g_UploadRing;
+static ID3D12Resource* g_UploadRingBuffer = NULL;
+static uint8_t* g_UploadRingCpu = NULL;
+static D3D12_GPU_VIRTUAL_ADDRESS g_UploadRingGpu = 0;
+
+// Static uploads are recorded on a copy queue and submitted once per frame;
+// the graphics queue waits for them on the gpu, never the cpu.
+static ID3D12CommandQueue* g_CopyQueue = NULL;
+static ID3D12GraphicsCommandList* g_CopyCommandList = NULL;
+static ID3D12CommandAllocator* g_CopyAllocators[NUM_FRAMES_IN_FLIGHT] = {};
+static UINT64 g_CopyAllocatorFence[NUM_FRAMES_IN_FLIGHT] = {};
+static ID3D12Fence* g_CopyFence = NULL;
+static UINT64 g_CopyFenceLastSignaledValue = 0;
+static uint64_t g_CopySubmitCount = 0;
+static bool g_CopyListOpen = false;
+// the batch overwrites a buffer that earlier frames may still read
+static bool g_CopyWaitsForGraphics = false;
+// dedicated staging buffers of the open batch
+static std::vector<ID3D12Resource*> g_CopyStaging;
 static UINT g_CurrentBackBufferIndex = 0;
 static ComPtr<ID3D12RootSignature> g_TestRootSignature;
 // static ID3D12PipelineState* g_TestPSO = NULL;
 static DirectX::GraphicsMemory* g_CBVMemory = nullptr;
 DirectX::DescriptorPile* g_RTVDescriptorHeap;
 DirectX::DescriptorPile* g_DSVDescriptorHeap;
-DirectX::DescriptorPile* g_StaticSamplerDescriptorHeap;
 DirectX::DescriptorPile* g_StaticSrvDescriptorHeap;
 DirectX::DescriptorPile* g_StaticUavDescriptorHeap;
-DirectX::DescriptorPile* g_DynamicSrvUavDescriptorHeaps[NUM_FRAMES_IN_FLIGHT];
-DirectX::DescriptorPile* g_DynamicSamplerDescriptorHeaps[NUM_FRAMES_IN_FLIGHT];
+// the shader visible tables of bindless.h, bound once per pass: slot i of
+// the srv heap is the texture with bindless slot i, the sampler heap holds
+// one sampler per BindlessSamplerIndex
+DirectX::DescriptorHeap* g_BindlessSrvHeap;
+DirectX::DescriptorHeap* g_BindlessSamplerHeap;
+static BindlessTable g_BindlessTextures;
 TextureHandle g_MainDepthRTs[3] = {0, 0, 0};
 D3D12_CPU_DESCRIPTOR_HANDLE emptySRV2D;
 D3D12_CPU_DESCRIPTOR_HANDLE emptySRV3D;
 
 std::vector<DirectX::GraphicsResource> g_CBVInFlight[NUM_FRAMES_IN_FLIGHT];
 
-inline DirectX::DescriptorPile* GetCurrentSrvDescriptorHeap() {
-    return g_DynamicSrvUavDescriptorHeaps[g_CurrentBackBufferIndex];
-}
-
-inline DirectX::DescriptorPile* GetCurrentSamplerDescriptorHeap() {
-    return g_DynamicSamplerDescriptorHeaps[g_CurrentBackBufferIndex];
-}
-
 struct StatedD3D12Resource {
     ID3D12Resource* resource = nullptr;
     D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_COMMON;
@@ -125,14 +163,23 @@ struct StatedD3D12Resource {
 struct BufferWrap : public StatedD3D12Resource {
     uint32_t byteLength = 0;
     GPUResourceUsageFlags usage = GPUResourceUsageNone;
+    // BindlessTable handle of the raw srv, shader resources only
+    uint32_t bindless = 0;
 };
 
 struct TextureWrap : public StatedD3D12Resource {
     DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
     uint32_t width = 1;
     uint32_t height = 1;
+    uint64_t byteSize = 0;
+    bool renderTexture = false;
+    // descriptor slots survive the texture and are reused by the next
+    // texture in the same handle slot (rtv/dsv only if isDepth matches)
+    bool isDepth = false;
     size_t srvIndex = (size_t)-1;
     size_t uavIndex = (size_t)-1;
+    // BindlessTable handle, the slot is released with the texture
+    uint32_t bindless = 0;
     union {
         size_t rtvIndex = (size_t)-1;
         size_t dsvIndex;
@@ -141,11 +188,95 @@ struct TextureWrap : public StatedD3D12Resource {
 
 constexpr int FE_MAX_TEXTURE_COUNT = 1024;
 
+// indexed by HandleIndex(), see handle_pool.h
 static std::vector<BufferWrap> g_Buffers;
 static std::vector<ID3DBlob*> g_Shaders;
+// PipelineHashBytes of the bytecode, what pipelines are keyed on
+static std::vector<uint64_t> g_ShaderHashes;
 static std::vector<TextureWrap> g_Textures;
+static std::vector<ID3D12PipelineState*> g_PipelineStates;
 static std::vector<D3D12_INPUT_LAYOUT_DESC> g_vertexDescriptors;
 
+static HandlePool g_BufferHandles;
+static HandlePool g_TextureHandles;
+static HandlePool g_ShaderHandles;
+static HandlePool g_PipelineHandles;
+
+template <class T>
+static uint32_t AllocHandle(HandlePool& pool, std::vector<T>& table) {
+    uint32_t handle = HandlePoolAlloc(&pool);
+    if (table.size() < HandlePoolGetSlotCount(&pool))
+        table.resize(HandlePoolGetSlotCount(&pool));
+    return handle;
+}
+
+inline BufferWrap& GetBuffer(BufferHandle handle) {
+    assert(HandlePoolIsAlive(&g_BufferHandles, handle));
+    return g_Buffers[HandleIndex(handle)];
+}
+
+inline TextureWrap& GetTexture(TextureHandle handle) {
+    assert(HandlePoolIsAlive(&g_TextureHandles, handle));
+    return g_Textures[HandleIndex(handle)];
+}
+
+// copies the texture's srv into its slot of the bindless table, once per
+// texture instead of once per draw
+static void SetupBindlessSlot(TextureWrap& t) {
+    if (t.bindless == 0) t.bindless = BindlessTableAlloc(&g_BindlessTextures);
+    // a full table leaves the texture on BindlessMissingTexture
+    if (t.bindless == 0) return;
+    g_Device->CopyDescriptorsSimple(
+        1, g_BindlessSrvHeap->GetCpuHandle(HandleIndex(t.bindless)),
+        g_StaticSrvDescriptorHeap->GetCpuHandle(t.srvIndex),
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    g_statistics.gpu.bindlessTextureCount =
+        BindlessTableGetCount(&g_BindlessTextures);
+}
+
+uint32_t GetTextureBindlessIndex(TextureHandle handle) {
+    if (handle == 0) return BindlessMissingTexture;
+    return HandleIndex(GetTexture(handle).bindless);
+}
+
+// buffers share the texture table, as ByteAddressBuffer FEBuffers[] (see
+// Internal-Skinning.comp). The view covers the resource, a resized buffer
+// gets a new slot since the old one may still be read by a frame in flight.
+static void SetupBufferBindlessSlot(BufferWrap& b) {
+    if (!(b.usage & GPUResourceUsageShaderResource)) return;
+    b.bindless = BindlessTableAlloc(&g_BindlessTextures);
+    if (b.bindless == 0) return;
+    D3D12_SHADER_RESOURCE_VIEW_DESC desc = {};
+    desc.Format = DXGI_FORMAT_R32_TYPELESS;
+    desc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    desc.Buffer.NumElements = b.byteLength / 4;
+    desc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
+    g_Device->CreateShaderResourceView(
+        b.resource, &desc,
+        g_BindlessSrvHeap->GetCpuHandle(HandleIndex(b.bindless)));
+    g_statistics.gpu.bindlessTextureCount =
+        BindlessTableGetCount(&g_BindlessTextures);
+}
+
+static void ReleaseBufferBindlessSlot(BufferWrap& b) {
+    if (b.bindless == 0) return;
+    BindlessTableRelease(&g_BindlessTextures, b.bindless, g_frameIndex);
+    b.bindless = 0;
+    g_statistics.gpu.bindlessTextureCount =
+        BindlessTableGetCount(&g_BindlessTextures);
+}
+
+uint32_t GetBufferBindlessIndex(BufferHandle handle) {
+    if (handle == 0) return 0;
+    return HandleIndex(GetBuffer(handle).bindless);
+}
+
+inline ID3DBlob* GetShaderBlob(ShaderHandle handle) {
+    assert(HandlePoolIsAlive(&g_ShaderHandles, handle));
+    return g_Shaders[HandleIndex(handle)];
+}
+
 static void ThrowIfFailed(HRESULT hr) {
     if (FAILED(hr)) {
         std::string message = std::system_category().message(hr);
@@ -205,38 +336,121 @@ static ID3D12Resource* InternalCreateBuffer(uint32_t byteSize, int bufferUsage,
     return ret;
 }
 
-static void InternalUpdateBuffer(ID3D12Resource* buffer,
-                                 D3D12_RESOURCE_STATES& state,
-                                 const Memory& data) {
-    D3D12_SUBRESOURCE_DATA subresource;
-    subresource.pData = data.buffer;
-    subresource.RowPitch = data.byteLength;
-    subresource.SlicePitch = data.byteLength;
-#if _DEBUG
-    auto desc = buffer->GetDesc();
-    assert(desc.Width >= data.byteLength);
-#endif
-    if (state != D3D12_RESOURCE_STATE_COPY_DEST) {
-        g_GPUResourceUploader->Transition(buffer, state,
-                                          D3D12_RESOURCE_STATE_COPY_DEST);
-        state = D3D12_RESOURCE_STATE_COPY_DEST;
+static void WaitForFence(ID3D12Fence* fence, UINT64 value) {
+    if (fence->GetCompletedValue() >= value) return;
+    fence->SetEventOnCompletion(value, g_fenceEvent);
+    WaitForSingleObject(g_fenceEvent, INFINITE);
+}
+
+struct DynamicAllocation {
+    void* cpu;
+    D3D12_GPU_VIRTUAL_ADDRESS gpu;
+};
+
+// valid for the current frame only
+static DynamicAllocation AllocateDynamic(uint64_t size, uint64_t alignment) {
+    g_statistics.gpu.dynamicUploadSize += size;
+    uint64_t offset = UploadRingAlloc(&g_UploadRing, size, alignment);
+    if (offset == UploadRingInvalidOffset) {
+        // ring is full, GraphicsMemory grows on demand
+        auto mem = g_CBVMemory->Allocate(size, alignment);
+        DynamicAllocation a = {mem.Memory(), mem.GpuAddress()};
+        g_CBVInFlight[g_CurrentBackBufferIndex].emplace_back(std::move(mem));
+        return a;
+    }
+    return {g_UploadRingCpu + offset, g_UploadRingGpu + offset};
+}
+
+struct StagingAllocation {
+    ID3D12Resource* resource;
+    uint64_t offset;
+    uint8_t* cpu;
+};
+
+static StagingAllocation AllocateStaging(uint64_t size, uint64_t alignment) {
+    if (size <= LargeUploadSize) {
+        uint64_t offset = UploadRingAlloc(&g_UploadRing, size, alignment);
+        if (offset != UploadRingInvalidOffset)
+            return {g_UploadRingBuffer, offset, g_UploadRingCpu + offset};
+    }
+    ID3D12Resource* staging = nullptr;
+    auto heap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+    auto desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    ThrowIfFailed(g_Device->CreateCommittedResource(
+        &heap, D3D12_HEAP_FLAG_NONE, &desc, D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr, IID_PPV_ARGS(&staging)));
+    void* cpu = nullptr;
+    ThrowIfFailed(staging->Map(0, nullptr, &cpu));
+    g_CopyStaging.push_back(staging);
+    return {staging, 0, (uint8_t*)cpu};
+}
+
+static ID3D12GraphicsCommandList* GetCopyCommandList() {
+    if (!g_CopyListOpen) {
+        const uint64_t i = g_CopySubmitCount % NUM_FRAMES_IN_FLIGHT;
+        // one submit per frame, so this is already done in practice
+        WaitForFence(g_CopyFence, g_CopyAllocatorFence[i]);
+        g_CopyAllocators[i]->Reset();
+        g_CopyCommandList->Reset(g_CopyAllocators[i], NULL);
+        g_CopyListOpen = true;
     }
-    g_GPUResourceUploader->Upload(buffer, 0, &subresource, 1);
+    return g_CopyCommandList;
+}
+
+// submits the recorded uploads and makes the next graphics submit wait for
+// them on the gpu
+static void SubmitUploads() {
+    if (!g_CopyListOpen) return;
+    g_CopyCommandList->Close();
+    if (g_CopyWaitsForGraphics)
+        g_CopyQueue->Wait(g_fence, g_fenceLastSignaledValue);
+    g_CopyQueue->ExecuteCommandLists(
+        1, (ID3D12CommandList* const*)&g_CopyCommandList);
+    UINT64 fenceValue = g_CopyFenceLastSignaledValue + 1;
+    g_CopyQueue->Signal(g_CopyFence, fenceValue);
+    g_CopyFenceLastSignaledValue = fenceValue;
+    g_CopyAllocatorFence[g_CopySubmitCount % NUM_FRAMES_IN_FLIGHT] =
+        fenceValue;
+    g_CopySubmitCount++;
+    g_pCommandQueue->Wait(g_CopyFence, fenceValue);
+    // the graphics frame waits for the copy, so its fence covers both
+    for (ID3D12Resource* staging : g_CopyStaging)
+        g_PendingResources.push_back({staging, g_frameIndex});
+    g_CopyStaging.clear();
+    g_CopyListOpen = false;
+    g_CopyWaitsForGraphics = false;
+}
+
+UploadTicket GetUploadTicket() {
+    return g_CopyFenceLastSignaledValue + (g_CopyListOpen ? 1 : 0);
+}
+
+bool IsUploadComplete(UploadTicket ticket) {
+    return g_CopyFence->GetCompletedValue() >= ticket;
+}
+
+// buffers decay to COMMON after every ExecuteCommandLists, so the copy
+// queue can always write them without a barrier
+static void InternalUpdateBuffer(BufferWrap& b, const Memory& data) {
+    assert(b.byteLength >= data.byteLength);
+    StagingAllocation staging = AllocateStaging(data.byteLength, 4);
+    memcpy(staging.cpu, data.buffer, data.byteLength);
+    GetCopyCommandList()->CopyBufferRegion(b.resource, 0, staging.resource,
+                                           staging.offset, data.byteLength);
+    b.state = D3D12_RESOURCE_STATE_COMMON;
+    g_statistics.gpu.staticUploadSize += data.byteLength;
 }
 
 BufferHandle CreateBuffer(Memory data, GPUResourceUsageFlags usage) {
     assert(data.byteLength > 0);
-    BufferHandle handle = g_Buffers.size();
-    BufferWrap& b = g_Buffers.emplace_back();
+    BufferHandle handle = AllocHandle(g_BufferHandles, g_Buffers);
+    BufferWrap& b = GetBuffer(handle);
     b.usage = usage;
     b.byteLength = data.byteLength;
-    b.state = D3D12_RESOURCE_STATE_COPY_DEST;
+    b.state = D3D12_RESOURCE_STATE_COMMON;
     b.resource = InternalCreateBuffer(b.byteLength, b.usage, b.state);
-    if (data.buffer != nullptr) {
-        InternalUpdateBuffer(b.resource, b.state, data);
-        // fmt::print("{}: {}, on frame {} {}\n", __FUNCTION__, handle,
-        //           g_frameIndex, g_CurrentBackBufferIndex);
-    }
+    SetupBufferBindlessSlot(b);
+    if (data.buffer != nullptr) InternalUpdateBuffer(b, data);
 #if _DEBUG
     std::wstring name = fmt::format(L"Buffer{}", handle);
     SetDebugObjectName(b.resource, name.c_str());
@@ -244,77 +458,202 @@ BufferHandle CreateBuffer(Memory data, GPUResourceUsageFlags usage) {
     return handle;
 }
 
+// replaces the resource of b with a bigger, empty one; the handle stays
+static void GrowBuffer(BufferWrap& b, uint32_t byteLength) {
+    g_PendingResources.push_back({b.resource, g_frameIndex});
+    g_statistics.gpu.bufferCount--;
+    g_statistics.gpu.bufferSize -= b.byteLength;
+    ReleaseBufferBindlessSlot(b);
+    b.byteLength = byteLength;
+    b.state = D3D12_RESOURCE_STATE_COMMON;
+    b.resource = InternalCreateBuffer(byteLength, b.usage, b.state);
+    SetupBufferBindlessSlot(b);
+}
+
 void UpdateBuffer(BufferHandle handle, Memory data) {
-    assert(handle < g_Buffers.size());
-    BufferWrap& b = g_Buffers[handle];
-    if (data.byteLength > b.byteLength) {  // need resize
-        DeleteBuffer(handle);
-        b.byteLength = data.byteLength;
-        b.state = D3D12_RESOURCE_STATE_COPY_DEST;
-        b.resource = InternalCreateBuffer(data.byteLength, b.usage, b.state);
+    BufferWrap& b = GetBuffer(handle);
+    if (data.byteLength > b.byteLength) {  // need resize, same handle
+        GrowBuffer(b, data.byteLength);
+    } else {
+        g_CopyWaitsForGraphics = true;
     }
-    InternalUpdateBuffer(b.resource, b.state, data);
+    InternalUpdateBuffer(b, data);
 }
 
+// the resource itself goes away in DestroyBuffer, once the gpu is done
 void DeleteBuffer(BufferHandle handle) {
-    assert(handle < g_Buffers.size());
-    auto& b = g_Buffers[handle];
-    auto res = b.resource;
-    if (res != nullptr) {
-        g_PendingResources[g_CurrentBackBufferIndex].push_back(res);
-        // fmt::print("{}: {}, on frame {} {}\n", __FUNCTION__, handle,
-        // g_frameIndex, g_CurrentBackBufferIndex);
-        b.resource = nullptr;
+    if (handle == 0 || g_Device == NULL) return;
+    auto& b = GetBuffer(handle);
+    if (b.resource != nullptr) {
         g_statistics.gpu.bufferCount--;
         g_statistics.gpu.bufferSize -= b.byteLength;
     }
-    b.byteLength = 0;
+    ReleaseBufferBindlessSlot(b);
+    HandlePoolRelease(&g_BufferHandles, handle, g_frameIndex);
 }
 
-uint32_t CreateTexture(Memory memory, TextureDesc* desc) {
-    ID3D12Resource* texture = nullptr;
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-    HRESULT hr = DirectX::CreateDDSTextureFromMemoryEx(
-        g_Device, *g_GPUResourceUploader, (uint8_t*)memory.buffer,
-        memory.byteLength, 0, D3D12_RESOURCE_FLAG_NONE,
-        DirectX::DDS_LOADER_DEFAULT | DirectX::DDS_LOADER_MIP_RESERVE,
-        &texture);
-    assert(SUCCEEDED(hr));
-    size_t idx = g_StaticSrvDescriptorHeap->Allocate();
+static void DestroyBuffer(void* ctx, uint32_t handle) {
+    BufferWrap& b = g_Buffers[HandleIndex(handle)];
+    SAFE_RELEASE(b.resource);
+    b = BufferWrap();
+}
+
+// records the upload of the subresources and gives the texture a handle
+static TextureHandle AddTexture(ID3D12Resource* texture,
+                                const D3D12_SUBRESOURCE_DATA* subresources,
+                                UINT count, TextureDimension dimension) {
+    {
+        const uint64_t size = GetRequiredIntermediateSize(texture, 0, count);
+        StagingAllocation staging =
+            AllocateStaging(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        ID3D12GraphicsCommandList* list = GetCopyCommandList();
+        UpdateSubresources(list, texture, staging.resource, staging.offset, 0,
+                           count, subresources);
+        // COMMON is the only state both queues can hand over
+        auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+            texture, D3D12_RESOURCE_STATE_COPY_DEST,
+            D3D12_RESOURCE_STATE_COMMON);
+        list->ResourceBarrier(1, &barrier);
+        g_statistics.gpu.staticUploadSize += size;
+    }
+    uint32_t handle = AllocHandle(g_TextureHandles, g_Textures);
+    auto& t = GetTexture(handle);
+    if (t.srvIndex == (size_t)-1)
+        t.srvIndex = g_StaticSrvDescriptorHeap->Allocate();
+    const bool cube = dimension == TextureDimensionCube ||
+                      dimension == TextureDimensionCubeArray;
     DirectX::CreateShaderResourceView(
-        g_Device, texture, g_StaticSrvDescriptorHeap->GetCpuHandle(idx));
-    uint32_t handle = g_Textures.size();
-    auto& t = g_Textures.emplace_back();
+        g_Device, texture, g_StaticSrvDescriptorHeap->GetCpuHandle(t.srvIndex),
+        cube);
+    // the bindless table is Texture2D[], other dimensions would need tables
+    // of their own
+    if (dimension == TextureDimensionTex2D) SetupBindlessSlot(t);
     //auto size = DirectX::GetTextureSize(texture);
     const auto texDesc = texture->GetDesc();
-    t.srvIndex = idx;
     t.resource = texture;
     t.width = texDesc.Width;
     t.height = texDesc.Height;
-    t.state = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+    t.state = D3D12_RESOURCE_STATE_COMMON;
 
     const auto allocInfo = g_Device->GetResourceAllocationInfo(0, 1, &texDesc);
+    t.byteSize = allocInfo.SizeInBytes;
+    t.renderTexture = false;
     g_statistics.gpu.textureCount++;
     g_statistics.gpu.textureSize += allocInfo.SizeInBytes;
+    return handle;
+}
 
-    if (desc) {
-        desc->width = t.width;
-        desc->height = t.height;
-        desc->mipmaps = texDesc.MipLevels;
-
-        TextureFormat format = TextureFormatInvalid;
-        switch (texDesc.Format) {
-            case DXGI_FORMAT_BC1_UNORM:
-                format = TextureFormatDXT1;
-                break;
-        }
-        desc->format = format;
+inline DXGI_FORMAT Translate(TextureFormat format) {
+    switch (format) {
+        case TextureFormatAlpha8:
+            return DXGI_FORMAT_A8_UNORM;
+        case TextureFormatBGRA8Unorm:
+            return DXGI_FORMAT_B8G8R8A8_UNORM;
+        case TextureFormatBGRA8Unorm_sRGB:
+            return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+        case TextureFormatRGBA8Unorm:
+            return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case TextureFormatRGBA8Unorm_sRGB:
+            return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+        case TextureFormatR32Float:
+            return DXGI_FORMAT_R32_FLOAT;
+        case TextureFormatDXT1:
+            return DXGI_FORMAT_BC1_UNORM;
+        case TextureFormatDXT5:
+            return DXGI_FORMAT_BC3_UNORM;
+        case TextureFormatR8Unorm:
+            return DXGI_FORMAT_R8_UNORM;
+        case TextureFormatRG8Unorm:
+            return DXGI_FORMAT_R8G8_UNORM;
+        case TextureFormatRGBA16Float:
+            return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case TextureFormatRGBA32Float:
+            return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        case TextureFormatDXT1_sRGB:
+            return DXGI_FORMAT_BC1_UNORM_SRGB;
+        case TextureFormatDXT3:
+            return DXGI_FORMAT_BC2_UNORM;
+        case TextureFormatDXT3_sRGB:
+            return DXGI_FORMAT_BC2_UNORM_SRGB;
+        case TextureFormatDXT5_sRGB:
+            return DXGI_FORMAT_BC3_UNORM_SRGB;
+        case TextureFormatBC4:
+            return DXGI_FORMAT_BC4_UNORM;
+        case TextureFormatBC5:
+            return DXGI_FORMAT_BC5_UNORM;
+        case TextureFormatBC6H:
+            return DXGI_FORMAT_BC6H_UF16;
+        case TextureFormatBC7:
+            return DXGI_FORMAT_BC7_UNORM;
+        case TextureFormatBC7_sRGB:
+            return DXGI_FORMAT_BC7_UNORM_SRGB;
+        default:
+            return DXGI_FORMAT_UNKNOWN;
     }
+}
 
-    return handle;
+TextureHandle CreateTextureFromSubresources(const TextureDesc* desc,
+                                            const Memory* subresources) {
+    const DXGI_FORMAT format = Translate(desc->format);
+    assert(format != DXGI_FORMAT_UNKNOWN);
+    if (format == DXGI_FORMAT_UNKNOWN) return 0;
+    const uint32_t layers = TextureDescLayerCount(desc);
+    const auto texDesc =
+        desc->dimension == TextureDimensionTex3D
+            ? CD3DX12_RESOURCE_DESC::Tex3D(format, desc->width, desc->height,
+                                           (UINT16)desc->depth,
+                                           (UINT16)desc->mipmaps)
+            : CD3DX12_RESOURCE_DESC::Tex2D(format, desc->width, desc->height,
+                                           (UINT16)layers,
+                                           (UINT16)desc->mipmaps);
+    auto heap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    ID3D12Resource* texture = nullptr;
+    ThrowIfFailed(g_Device->CreateCommittedResource(
+        &heap, D3D12_HEAP_FLAG_NONE, &texDesc, D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr, IID_PPV_ARGS(&texture)));
+
+    const uint32_t count = layers * desc->mipmaps;
+    // the streamer creates textures every frame, so no heap here
+    FrameMemoryResource frame;
+    std::pmr::vector<D3D12_SUBRESOURCE_DATA> data(count, &frame);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t mip = i % desc->mipmaps;
+        const uint32_t width = std::max(desc->width >> mip, 1u);
+        const uint32_t height = std::max(desc->height >> mip, 1u);
+        data[i].pData = subresources[i].buffer;
+        data[i].RowPitch = TextureFormatRowPitch(desc->format, width);
+        // of a depth slice for volumes
+        data[i].SlicePitch =
+            data[i].RowPitch * TextureFormatRowCount(desc->format, height);
+    }
+    return AddTexture(texture, data.data(), count, desc->dimension);
+}
+
+static void ReleaseTexture(TextureHandle handle) {
+    if (handle == 0 || g_Device == NULL) return;
+    auto& t = GetTexture(handle);
+    if (t.renderTexture) {
+        g_statistics.gpu.renderTextureCount--;
+        g_statistics.gpu.renderTextureSize -= t.byteSize;
+    } else {
+        g_statistics.gpu.textureCount--;
+        g_statistics.gpu.textureSize -= t.byteSize;
+    }
+    BindlessTableRelease(&g_BindlessTextures, t.bindless, g_frameIndex);
+    t.bindless = 0;
+    g_statistics.gpu.bindlessTextureCount =
+        BindlessTableGetCount(&g_BindlessTextures);
+    HandlePoolRelease(&g_TextureHandles, handle, g_frameIndex);
 }
 
-void DeleteTexture(uint32_t textureID) {}
+void DeleteTexture(uint32_t textureID) { ReleaseTexture(textureID); }
+
+static void DestroyTexture(void* ctx, uint32_t handle) {
+    TextureWrap& t = g_Textures[HandleIndex(handle)];
+    SAFE_RELEASE(t.resource);
+    t.state = D3D12_RESOURCE_STATE_COMMON;
+    t.byteSize = 0;
+}
 
 uint32_t CreateShader(const char* path, const char* vs_name,
                       const char* ps_name) {
@@ -329,10 +668,18 @@ inline std::wstring ConvertString(const std::string& s) {
     return std::wstring(wszDest);
 }
 
+static void ShaderLoadedForWarmUp(ShaderHandle shader);
+
 ShaderHandle CreateShaderFromBlob(ID3DBlob* shaderBlob) {
     assert(shaderBlob != nullptr);
-    ShaderHandle handle = g_Shaders.size();
-    g_Shaders.push_back(shaderBlob);
+    ShaderHandle handle = AllocHandle(g_ShaderHandles, g_Shaders);
+    g_Shaders[HandleIndex(handle)] = shaderBlob;
+    if (g_ShaderHashes.size() < g_Shaders.size())
+        g_ShaderHashes.resize(g_Shaders.size());
+    g_ShaderHashes[HandleIndex(handle)] =
+        PipelineHashBytes(shaderBlob->GetBufferPointer(),
+                          shaderBlob->GetBufferSize(), PipelineHashSeed);
+    ShaderLoadedForWarmUp(handle);
     return handle;
 }
 
@@ -350,6 +697,14 @@ ShaderHandle CreateShaderFromCompiledFile(const char* path) {
     return ret;
 }
 
+ShaderHandle CreateShaderFromMemory(Memory bytecode) {
+    ID3DBlob* shaderBlob;
+    ThrowIfFailed(D3DCreateBlob(bytecode.byteLength, &shaderBlob));
+    memcpy(shaderBlob->GetBufferPointer(), bytecode.buffer,
+           bytecode.byteLength);
+    return CreateShaderFromBlob(shaderBlob);
+}
+
 #define LogInfo fmt::print
 
 void ReflectShader(ID3D10Blob* shader, ShaderType shaderType) {
@@ -430,7 +785,17 @@ void ReflectShader(ID3D10Blob* shader, ShaderType shaderType) {
     }
 }
 
-void DeleteShader(uint32_t shaderID) {}
+void ReleasePipelineStates(ShaderHandle shader);
+
+void DeleteShader(uint32_t shaderID) {
+    if (shaderID == 0 || g_Device == NULL) return;
+    ReleasePipelineStates(shaderID);
+    HandlePoolRelease(&g_ShaderHandles, shaderID, g_frameIndex);
+}
+
+static void DestroyShader(void* ctx, uint32_t handle) {
+    SAFE_RELEASE(g_Shaders[HandleIndex(handle)]);
+}
 
 enum class RenderTextureCreationFlags : uint32_t {
     MipMap = 1 << 0,
@@ -606,16 +971,13 @@ TextureHandle InternalCreateRenderTexture(const RenderTextureDescriptor& desc) {
         colorDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
     }
 
-    // bool newCreated = !handle.IsValid();
-    // if (newCreated) handle.id = g_Textures.Next();
-    TextureHandle handle = g_Textures.size();
-    bool newCreated = true;
-
-    auto& t = g_Textures.emplace_back();
+    TextureHandle handle = AllocHandle(g_TextureHandles, g_Textures);
+    auto& t = GetTexture(handle);
     assert(t.resource == nullptr);
+    // a recycled slot keeps its descriptors
+    bool newCreated = t.rtvIndex == (size_t)-1 || t.isDepth != isDepth;
 
     D3D12_RESOURCE_STATES initState = D3D12_RESOURCE_STATE_COMMON;
-    if (!newCreated) initState = t.state;
     auto heap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
     ThrowIfFailed(g_Device->CreateCommittedResource(
         &heap, D3D12_HEAP_FLAG_NONE, &colorDesc, initState, &colorClearValue,
@@ -626,6 +988,9 @@ TextureHandle InternalCreateRenderTexture(const RenderTextureDescriptor& desc) {
     g_statistics.gpu.renderTextureCount++;
     g_statistics.gpu.renderTextureSize += allocInfo.SizeInBytes;
 
+    t.byteSize = allocInfo.SizeInBytes;
+    t.renderTexture = true;
+    t.isDepth = isDepth;
     t.resource = texture;
     t.state = initState;
     t.format = dxgiFormat;
@@ -661,11 +1026,8 @@ TextureHandle InternalCreateRenderTexture(const RenderTextureDescriptor& desc) {
         g_Device->CreateRenderTargetView(texture, &rtv, rtvHandle);
     }
     {
-        // if (newCreated)
-        {
-            size_t start = g_StaticSrvDescriptorHeap->Allocate();
-            // assert(start == handle.id);
-            t.srvIndex = start;
+        if (t.srvIndex == (size_t)-1) {
+            t.srvIndex = g_StaticSrvDescriptorHeap->Allocate();
         }
         D3D12_CPU_DESCRIPTOR_HANDLE srvHandle =
             g_StaticSrvDescriptorHeap->GetCpuHandle(t.srvIndex);
@@ -693,17 +1055,12 @@ TextureHandle InternalCreateRenderTexture(const RenderTextureDescriptor& desc) {
             abort();
         }
         g_Device->CreateShaderResourceView(texture, &srvDesc, srvHandle);
+        SetupBindlessSlot(t);
     }
     return handle;
 }
 
-void DeleteRenderTexture(TextureHandle handle) {
-    assert(handle < g_Textures.size());
-    auto& tex = g_Textures[handle];
-    auto res = tex.resource;
-    g_PendingResources[g_CurrentBackBufferIndex].push_back(res);
-    tex.resource = nullptr;
-}
+void DeleteRenderTexture(TextureHandle handle) { ReleaseTexture(handle); }
 
 struct PerDrawUniforms {
     float4x4 MATRIX_MVP;
@@ -722,263 +1079,239 @@ struct PerCameraUniforms {
     float4 WorldSpaceCameraDir;  // w = 0, not used
 };
 
+// StructuredBuffer<InstanceData> Instances, ShaderVariables.hlsl
+struct InstanceData {
+    float4x4 MATRIX_M;
+    float4x4 MATRIX_IT_M;
+};
+
 struct LightingUniforms {
     float4 LightPos;  // w=1 not used
     float4 LightDir;  // w=0 not used
 };
 
-struct BuiltinConstantBuffers {
-    struct PerDrawUniforms cb1;
-    struct PerCameraUniforms cb2;
-    struct LightingUniforms cb3;
-};
-
 extern "C" {
 extern World* defaultWorld;
 }
 
-void MaterialBuildGloblsCB(Material* mat, ShaderReflect& reflect, Memory& mem) {
-    assert(mem.byteLength >= reflect.ps.globals.block_size &&
-           mem.buffer != NULL);
+ID3D12PipelineState* GetPipelineState(ShaderHandle vs, ShaderHandle ps,
+                                      const PipelineRenderState& state);
+
+// state of the last BindView, cb2 and cb3 are uploaded once per view
+static struct {
+    bool valid = false;
+    float4x4 V;
+    float4x4 VP;
+    D3D12_GPU_VIRTUAL_ADDRESS cameraCB = 0;
+    D3D12_GPU_VIRTUAL_ADDRESS lightingCB = 0;
+} g_View;
+
+// variant of the last BindPipeline, decides which per-draw matrices to build
+static const ShaderVariant* g_BoundVariant = nullptr;
+
+// root parameters 4 and 7 are the texture table, viewed as Texture2D[] and
+// TextureCube[], 5 the sampler table (see Common.hlsl)
+static void SetBindlessRootParameters() {
+    D3D12_GPU_DESCRIPTOR_HANDLE textures =
+        g_BindlessSrvHeap->GetFirstGpuHandle();
+    g_pCommandList->SetGraphicsRootDescriptorTable(4, textures);
+    g_pCommandList->SetGraphicsRootDescriptorTable(7, textures);
+    g_pCommandList->SetGraphicsRootDescriptorTable(
+        5, g_BindlessSamplerHeap->GetFirstGpuHandle());
+}
 
-    for (auto& m : reflect.ps.globals.members) {
-        if (!m.used) continue;
-        if (m.type == "float") {
-            float v = MaterialGetFloat(mat, m.nameID);
-            float* ptr = (float*)((uint8_t*)mem.buffer + m.offset);
-            *ptr = v;
-        } else if (m.type == "vec2" || m.type == "vec3" || m.type == "vec4") {
-            float4 v = MaterialGetVector(mat, m.nameID);
-            memcpy((uint8_t*)mem.buffer + m.offset, &v, m.bytes);
-        }
-    }
+static void SetViewRootParameters() {
+    g_pCommandList->SetGraphicsRootConstantBufferView(2, g_View.cameraCB);
+    g_pCommandList->SetGraphicsRootConstantBufferView(3, g_View.lightingCB);
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE GetSampler(FilterMode filterMode,
-                                       TextureWrapMode wrapModeU,
-                                       TextureWrapMode wrapModeV,
-                                       TextureWrapMode wrapModeW,
-                                       UINT anisoLevel = 1) {
-    assert(anisoLevel == 1);
-    uint32_t i = filterMode, j = wrapModeU, k = wrapModeV, l = wrapModeW;
-    uint32_t hash = (((((i << 2) | j) << 2) | k) << 2) | l;
-    return g_StaticSamplerDescriptorHeap->GetCpuHandle(hash);
+void BindView(const RenderView* view) {
+    const float4x4& p = view->projection;
+
+    // keep V and VP on the cpu side, the upload heap is write-combined
+    g_View.V = view->view;
+    g_View.VP = float4x4_mul(p, view->view);
+
+    auto cb2 = AllocateDynamic(sizeof(PerCameraUniforms),
+                               D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    PerCameraUniforms* camera = (PerCameraUniforms*)cb2.cpu;
+    camera->MATRIX_P = p;
+    camera->MATRIX_V = g_View.V;
+    camera->MATRIX_I_V = float4x4_inverse(view->view);
+    camera->MATRIX_VP = g_View.VP;
+    const float3 pos = view->cameraPos, dir = view->cameraDir;
+    camera->WorldSpaceCameraPos = float4_make(pos.x, pos.y, pos.z, 1);
+    camera->WorldSpaceCameraDir = float4_make(dir.x, dir.y, dir.z, 0);
+
+    auto cb3 = AllocateDynamic(sizeof(LightingUniforms),
+                               D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    LightingUniforms* lighting = (LightingUniforms*)cb3.cpu;
+    const float3 lp = view->lightPos, ld = view->lightDir;
+    lighting->LightPos = float4_make(lp.x, lp.y, lp.z, 1);
+    lighting->LightDir = float4_make(ld.x, ld.y, ld.z, 0);
+
+    g_View.valid = true;
+    g_View.cameraCB = cb2.gpu;
+    g_View.lightingCB = cb3.gpu;
+    SetViewRootParameters();
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE GetSampler(FilterMode filterMode,
-                                       TextureWrapMode wrapMode) {
-    return GetSampler(filterMode, wrapMode, wrapMode, wrapMode);
+bool BindPipeline(Shader* shader, uint32_t pass, uint32_t variant) {
+    ShaderPass& sp = ShaderGetImpl(shader)->passes[pass];
+    ShaderVariant& var = sp.variants[variant];
+    ID3D12PipelineState* pso =
+        GetPipelineState(var.vertexShader, var.pixelShader, sp.renderState);
+    if (pso == nullptr) return false;
+    g_pCommandList->SetPipelineState(pso);
+    g_BoundVariant = &var;
+    return true;
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE GetSampler(Texture* tex) {
-    return GetSampler(tex->filterMode, tex->wrapModeU, tex->wrapModeV,
-                      tex->wrapModeW, tex->anisoLevel);
+void BindMaterial(Material* material, uint32_t pass, uint32_t variant) {
+    ShaderVariant& var =
+        ShaderGetImpl(material->shader)->passes[pass].variants[variant];
+
+    // textures are read through the bindless table, the material only
+    // writes their slots into cb0; their state is still tracked here
+    for (auto& m : var.reflect.ps.globals.members) {
+        if (!m.used || m.kind != ShaderConstantTextureIndex) continue;
+        Texture* tex = MaterialGetTexture(material, m.nameID);
+        if (tex == nullptr || tex->handle == 0) continue;
+        GetTexture(tex->handle).Transition(
+            g_pCommandList, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+
+    // built in frame memory, the upload heap is write-combined
+    Memory mem;
+    mem.byteLength = MaterialBuildConstants(material, pass, variant, NULL);
+    mem.buffer = FrameAllocArray<uint8_t>(mem.byteLength);
+    MaterialBuildConstants(material, pass, variant, mem.buffer);
+    auto _cb0 = AllocateDynamic(mem.byteLength,
+                                D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    memcpy(_cb0.cpu, mem.buffer, mem.byteLength);
+    g_pCommandList->SetGraphicsRootConstantBufferView(1, _cb0.gpu);
 }
 
-ID3D12PipelineState* GetPipelineState(ShaderHandle vs, ShaderHandle ps);
+void BindMesh(Mesh* mesh, bool skinned) {
+    BufferHandle vbHandle = skinned ? mesh->skinnedvb : mesh->vb;
+    {
+        D3D12_VERTEX_BUFFER_VIEW vbv = {};
+        auto& b = GetBuffer(vbHandle);
+        b.Transition(g_pCommandList,
+                     D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+        // the arena holds all skinned meshes, this one starts at
+        // skinnedOffset
+        const uint32_t offset =
+            skinned ? mesh->skinnedOffset * (uint32_t)sizeof(Vertex) : 0;
+        vbv.BufferLocation = b.resource->GetGPUVirtualAddress() + offset;
+        vbv.SizeInBytes = b.byteLength - offset;
+        vbv.StrideInBytes = sizeof(Vertex);
+        g_pCommandList->IASetVertexBuffers(0, 1, &vbv);
+    }
+    if (mesh->ib != 0) {
+        D3D12_INDEX_BUFFER_VIEW ibv = {};
+        auto& b = GetBuffer(mesh->ib);
+        ibv.BufferLocation = b.resource->GetGPUVirtualAddress();
+        if (mesh->triangles.stride == 4)
+            ibv.Format = DXGI_FORMAT_R32_UINT;
+        else
+            ibv.Format = DXGI_FORMAT_R16_UINT;
+        ibv.SizeInBytes = b.byteLength;
+        g_pCommandList->IASetIndexBuffer(&ibv);
+    }
+    g_pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
 
-constexpr int srvRootRange = 5;
+void DrawMesh(Mesh* mesh, const float4x4* localToWorld) {
+    assert(g_View.valid && g_BoundVariant != nullptr);
+    const float4x4& l2w = *localToWorld;
+    auto cb1 = AllocateDynamic(sizeof(PerDrawUniforms),
+                               D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    PerDrawUniforms* perDraw = (PerDrawUniforms*)cb1.cpu;
+    perDraw->MATRIX_MVP = float4x4_mul(g_View.VP, l2w);
+    perDraw->MATRIX_MV = float4x4_mul(g_View.V, l2w);
+    perDraw->MATRIX_M = l2w;
+    if (g_BoundVariant->UsesMatrixITM())
+        perDraw->MATRIX_IT_M = float4x4_transpose(float4x4_inverse(l2w));
+    g_pCommandList->SetGraphicsRootConstantBufferView(0, cb1.gpu);
+
+    if (mesh->ib != 0) {
+        g_pCommandList->DrawIndexedInstanced(MeshGetIndexCount(mesh), 1, 0, 0,
+                                             0);
+    } else {
+        g_pCommandList->DrawInstanced(MeshGetVertexCount(mesh), 1, 0, 0);
+    }
+    g_statistics.gpu.drawCall++;
+}
+
+void DrawMeshInstanced(Mesh* mesh, const float4x4* localToWorld,
+                       uint32_t instanceCount) {
+    assert(g_View.valid && g_BoundVariant != nullptr);
+    assert(instanceCount > 0);
+    auto instances = AllocateDynamic(instanceCount * sizeof(InstanceData),
+                                     alignof(InstanceData));
+    InstanceData* data = (InstanceData*)instances.cpu;
+    const bool itm = g_BoundVariant->UsesMatrixITM();
+    for (uint32_t i = 0; i < instanceCount; ++i) {
+        data[i].MATRIX_M = localToWorld[i];
+        if (itm)
+            data[i].MATRIX_IT_M =
+                float4x4_transpose(float4x4_inverse(localToWorld[i]));
+    }
+    g_pCommandList->SetGraphicsRootShaderResourceView(6, instances.gpu);
+
+    if (mesh->ib != 0) {
+        g_pCommandList->DrawIndexedInstanced(MeshGetIndexCount(mesh),
+                                             instanceCount, 0, 0, 0);
+    } else {
+        g_pCommandList->DrawInstanced(MeshGetVertexCount(mesh), instanceCount,
+                                      0, 0);
+    }
+    g_statistics.gpu.drawCall++;
+    g_statistics.gpu.instancedDrawCall++;
+    g_statistics.gpu.instanceCount += instanceCount;
+}
 
 struct Renderable;
 // struct Transform;
 int SimpleDraw(Transform* t, struct Renderable* r) {
     if (!t || !r || !r->mesh || !r->material || !r->material->shader) return 0;
+    if (CameraGetMainCamera(defaultWorld) == NULL) return 1;
+    bool skinned = r->skin && (r->mesh->sb != 0) && (r->mesh->skinnedvb != 0);
+    if (!skinned && r->mesh->vb == 0) return 1;
 
     BeginRenderEvent("SimpleDraw");
-    g_pCommandList->SetGraphicsRootSignature(g_TestRootSignature.Get());
-
-    World* w = defaultWorld;
-    Camera* camera = CameraGetMainCamera(w);
-    if (camera == NULL) return 1;
-    Entity cameraEntity = ComponentGetEntity(w, camera, CameraID);
-
-    float4x4 l2w = TransformGetLocalToWorldMatrix(w, t);
-
-    float4x4 view;
-    float3 cameraPos, cameraDir;
-    {
-        Transform* cameraT =
-            (Transform*)EntityGetComponent(cameraEntity, w, TransformID);
-        cameraDir = TransformGetForward(w, cameraT);
-        cameraPos = TransformGetPosition(w, cameraT);
-        float3 up = TransformGetUp(w, cameraT);
-        view = float4x4_look_to(cameraPos, cameraDir, up);
-        //		float4x4 camera2world =
-        // TransformGetLocalToWorldMatrix(tm, w, cameraEntity);
-        //        view = float4x4_inverse(camera2world); // this view mat
-        //        contains local scale
-        // reverse-z
-        //		view = float4x4_mul(view, float4x4_diagonal(1, 1, -1,
-        // 1));
-    }
-    const float aspect = (float)g_SwapChainWidth / g_SwapChainHeight;
-    float4x4 p =
-        float4x4_perspective(camera->fieldOfView, aspect, camera->nearClipPlane,
-                             camera->farClipPlane);
-    float4x4 mvp = float4x4_mul(p, float4x4_mul(view, l2w));
-
-    struct BuiltinConstantBuffers g_cbuffers = {};
-    g_cbuffers.cb1.MATRIX_MVP = mvp;
-    g_cbuffers.cb1.MATRIX_MV = float4x4_mul(view, l2w);
-    g_cbuffers.cb1.MATRIX_M = l2w;
-    g_cbuffers.cb1.MATRIX_IT_M = float4x4_transpose(float4x4_inverse(l2w));
-
-    g_cbuffers.cb2.MATRIX_P = p;
-    g_cbuffers.cb2.MATRIX_V = view;
-    g_cbuffers.cb2.MATRIX_I_V = float4x4_inverse(view);
-    g_cbuffers.cb2.MATRIX_VP = float4x4_mul(p, view);
-    g_cbuffers.cb2.WorldSpaceCameraPos =
-        float4_make(cameraPos.x, cameraPos.y, cameraPos.z, 1);
-    g_cbuffers.cb2.WorldSpaceCameraDir =
-        float4_make(cameraDir.x, cameraDir.y, cameraDir.z, 0);
-
-    {
-        Light* light = (Light*)WorldGetComponentAt(w, LightID, 0);
-        Entity lightEntity = ComponentGetEntity(w, light, LightID);
-        float3 p = TransformGetPosition(w, TransformGet(w, lightEntity));
-        float3 f = TransformGetForward(w, TransformGet(w, lightEntity));
-        g_cbuffers.cb3.LightPos = float4_make(p.x, p.y, p.z, 1);
-        g_cbuffers.cb3.LightDir = float4_make(-f.x, -f.y, -f.z, 0);
+    BeginPass();
+    // the view is set up on the first draw of the frame only
+    if (!g_View.valid) {
+        RenderView view;
+        const float aspect = (float)g_SwapChainWidth / g_SwapChainHeight;
+        RenderViewSetup(&view, defaultWorld, aspect);
+        BindView(&view);
     }
 
-    {
-        BufferHandle vbHandle = r->mesh->vb;
-        if (r->skin && (r->mesh->sb != 0) && (r->mesh->skinnedvb != 0)) {
-            vbHandle = r->mesh->skinnedvb;
-        }
-        if (vbHandle == 0) return 1;
-        {
-            D3D12_VERTEX_BUFFER_VIEW vbv = {};
-            auto& b = g_Buffers[vbHandle];
-            b.Transition(g_pCommandList,
-                         D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-            vbv.BufferLocation = b.resource->GetGPUVirtualAddress();
-            vbv.SizeInBytes = b.byteLength;
-            vbv.StrideInBytes = sizeof(Vertex);
-            g_pCommandList->IASetVertexBuffers(0, 1, &vbv);
-        }
-        g_pCommandList->IASetPrimitiveTopology(
-            D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    }
-
-    auto cb1 = g_CBVMemory->AllocateConstant<PerDrawUniforms>();
-    memcpy(cb1.Memory(), &g_cbuffers.cb1, sizeof(g_cbuffers.cb1));
-
-    auto cb2 = g_CBVMemory->AllocateConstant<PerCameraUniforms>();
-    memcpy(cb2.Memory(), &g_cbuffers.cb2, sizeof(g_cbuffers.cb2));
-
-    auto cb3 = g_CBVMemory->AllocateConstant<LightingUniforms>();
-    memcpy(cb3.Memory(), &g_cbuffers.cb3, sizeof(g_cbuffers.cb3));
-
-    ShaderImpl* shaderImpl = ShaderGetImpl(r->material->shader);
+    float4x4 l2w = TransformGetLocalToWorldMatrix(defaultWorld, t);
+    BindMesh(r->mesh, skinned);
     for (int passIdx = 0; passIdx < r->material->shader->passCount; ++passIdx) {
-        ShaderPass& pass = shaderImpl->passes[passIdx];
-        ShaderVariant& var =
-            pass.variants[MaterialGetVariantIndex(r->material, passIdx)];
-
-        ID3D12PipelineState* pso =
-            GetPipelineState(var.vertexShader, var.pixelShader);
-
-        g_pCommandList->SetPipelineState(pso);
-        g_pCommandList->SetGraphicsRootSignature(g_TestRootSignature.Get());
-        g_pCommandList->SetGraphicsRootConstantBufferView(0, cb1.GpuAddress());
-        g_pCommandList->SetGraphicsRootConstantBufferView(2, cb2.GpuAddress());
-        g_pCommandList->SetGraphicsRootConstantBufferView(3, cb3.GpuAddress());
-
-        uint32_t srvCount = var.reflect.ps.images.size();
-        if (srvCount > 0) {
-            auto heap = GetCurrentSrvDescriptorHeap();
-            size_t start, end;
-            heap->AllocateRange(srvRootRange, start, end);
-            for (int i = 0; i < srvCount; ++i) {
-                auto& img = var.reflect.ps.images[i];
-                Texture* tex = MaterialGetTexture(r->material, img.nameID);
-                D3D12_CPU_DESCRIPTOR_HANDLE src = emptySRV2D;
-                if (tex != nullptr) {
-                    TextureWrap& t = g_Textures[tex->handle];
-                    t.Transition(g_pCommandList,
-                                 D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-                    src = g_StaticSrvDescriptorHeap->GetCpuHandle(t.srvIndex);
-                } else {
-                    printf("texture not set\n");
-                }
-                D3D12_CPU_DESCRIPTOR_HANDLE dst = heap->GetCpuHandle(start + i);
-                g_Device->CopyDescriptorsSimple(1, dst, src, heap->Type());
-            }
-            for (int i = srvCount; i < srvRootRange; ++i) {
-                D3D12_CPU_DESCRIPTOR_HANDLE src = emptySRV2D;
-                D3D12_CPU_DESCRIPTOR_HANDLE dst = heap->GetCpuHandle(start + i);
-                g_Device->CopyDescriptorsSimple(1, dst, src, heap->Type());
-            }
-            D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = heap->GetGpuHandle(start);
-            g_pCommandList->SetGraphicsRootDescriptorTable(4, gpuHandle);
+        uint32_t variant = MaterialGetVariantIndex(r->material, passIdx);
+        if (!BindPipeline(r->material->shader, passIdx, variant)) {
+            g_statistics.gpu.drawsSkipped++;
+            continue;
         }
-        if (srvCount > 0) {
-            auto heap = GetCurrentSamplerDescriptorHeap();
-            size_t start, end;
-            heap->AllocateRange(srvRootRange, start, end);
-            D3D12_CPU_DESCRIPTOR_HANDLE defaultSampler =
-                GetSampler(FilterModeBilinear, TextureWrapModeClamp);
-            for (int i = 0; i < srvCount; ++i) {
-                auto& img = var.reflect.ps.images[i];
-                Texture* tex = MaterialGetTexture(r->material, img.nameID);
-                D3D12_CPU_DESCRIPTOR_HANDLE src;
-                if (tex != nullptr) {
-                    src = GetSampler(tex);
-                } else {
-                    printf("texture not set\n");
-                    src = defaultSampler;
-                }
-                D3D12_CPU_DESCRIPTOR_HANDLE dst = heap->GetCpuHandle(start + i);
-                g_Device->CopyDescriptorsSimple(1, dst, src, heap->Type());
-            }
-            for (int i = srvCount; i < srvRootRange; ++i) {
-                D3D12_CPU_DESCRIPTOR_HANDLE src = defaultSampler;
-                D3D12_CPU_DESCRIPTOR_HANDLE dst = heap->GetCpuHandle(start + i);
-                g_Device->CopyDescriptorsSimple(1, dst, src, heap->Type());
-            }
-            D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = heap->GetGpuHandle(start);
-            g_pCommandList->SetGraphicsRootDescriptorTable(5, gpuHandle);
-        }
-
-        std::vector<uint8_t> cb0(var.reflect.ps.globals.block_size, 0);
-        Memory mem;
-        mem.buffer = cb0.data();
-        mem.byteLength = cb0.size();
-        MaterialBuildGloblsCB(r->material, var.reflect, mem);
-        auto _cb0 = g_CBVMemory->Allocate(
-            mem.byteLength, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
-        memcpy(_cb0.Memory(), mem.buffer, mem.byteLength);
-        g_pCommandList->SetGraphicsRootConstantBufferView(1, _cb0.GpuAddress());
-        g_CBVInFlight[g_CurrentBackBufferIndex].emplace_back(std::move(_cb0));
-
-        if (r->mesh->ib != 0) {
-            D3D12_INDEX_BUFFER_VIEW ibv = {};
-            auto& b = g_Buffers[r->mesh->ib];
-            ibv.BufferLocation = b.resource->GetGPUVirtualAddress();
-            if (r->mesh->triangles.stride == 4)
-                ibv.Format = DXGI_FORMAT_R32_UINT;
-            else
-                ibv.Format = DXGI_FORMAT_R16_UINT;
-            ibv.SizeInBytes = b.byteLength;
-            g_pCommandList->IASetIndexBuffer(&ibv);
-            g_pCommandList->DrawIndexedInstanced(MeshGetIndexCount(r->mesh), 1,
-                                                 0, 0, 0);
-        } else {
-            g_pCommandList->DrawInstanced(MeshGetVertexCount(r->mesh), 1, 0, 0);
-        }
-        g_statistics.gpu.drawCall++;
+        BindMaterial(r->material, passIdx, variant);
+        DrawMesh(r->mesh, &l2w);
     }
 
-    g_CBVInFlight[g_CurrentBackBufferIndex].emplace_back(std::move(cb1));
-    g_CBVInFlight[g_CurrentBackBufferIndex].emplace_back(std::move(cb2));
-    g_CBVInFlight[g_CurrentBackBufferIndex].emplace_back(std::move(cb3));
-
     EndRenderEvent();
     return 0;
 }
 
-void BeginPass() {}
+void BeginPass() {
+    g_pCommandList->SetGraphicsRootSignature(g_TestRootSignature.Get());
+    // root parameters are reset with the root signature
+    SetBindlessRootParameters();
+    if (g_View.valid) SetViewRootParameters();
+}
 
 bool CreateDeviceD3D(HWND hWnd);
 void CleanupDeviceD3D();
@@ -995,21 +1328,43 @@ ID3D12GraphicsCommandList* GetCurrentGraphicsCommandList() {
 ID3D12DescriptorHeap* GetRTVDescriptorHeap() { return g_pRtvDescHeap->Heap(); }
 ID3D12DescriptorHeap* GetSRVDescriptorHeap() { return g_pSrvDescHeap->Heap(); }
 
+static void DestroyPipelineState(void* ctx, uint32_t handle);
+static void UpdatePipelines();
+
+// destroys everything released in a frame the gpu has finished
+static void CollectResources(uint64_t completedFrame) {
+    size_t kept = 0;
+    for (auto& p : g_PendingResources) {
+        if (p.frame <= completedFrame)
+            SAFE_RELEASE(p.resource);
+        else
+            g_PendingResources[kept++] = p;
+    }
+    g_PendingResources.resize(kept);
+    UploadRingRetire(&g_UploadRing, completedFrame);
+    HandlePoolCollect(&g_BufferHandles, completedFrame, DestroyBuffer, NULL);
+    HandlePoolCollect(&g_TextureHandles, completedFrame, DestroyTexture,
+                      NULL);
+    BindlessTableCollect(&g_BindlessTextures, completedFrame);
+    HandlePoolCollect(&g_PipelineHandles, completedFrame,
+                      DestroyPipelineState, NULL);
+    HandlePoolCollect(&g_ShaderHandles, completedFrame, DestroyShader, NULL);
+}
+
 void FrameBegin() {
     const float clear_color[4] = {0.45f, 0.55f, 0.60f, 1.00f};
+    FrameAllocReset();
 
     UINT backBufferIdx = g_pSwapChain->GetCurrentBackBufferIndex();
     g_CurrentBackBufferIndex = backBufferIdx;
-    for (ID3D12Resource* res : g_PendingResources[g_CurrentBackBufferIndex]) {
-        if (res) {
-            res->Release();
-        }
-    }
-    g_PendingResources[g_CurrentBackBufferIndex].clear();
     g_CBVInFlight[g_CurrentBackBufferIndex].clear();
 
     FrameContext* frameCtxt = WaitForNextFrameResources();
     frameCtxt->CommandAllocator->Reset();
+    // the wait above retired frame g_frameIndex - NUM_FRAMES_IN_FLIGHT
+    if (g_frameIndex >= NUM_FRAMES_IN_FLIGHT)
+        CollectResources(g_frameIndex - NUM_FRAMES_IN_FLIGHT);
+    UpdatePipelines();
 
     auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
         g_mainRenderTargetResource[backBufferIdx], D3D12_RESOURCE_STATE_PRESENT,
@@ -1021,26 +1376,25 @@ void FrameBegin() {
         g_mainRenderTargetDescriptor[backBufferIdx], (float*)&clear_color, 0,
         NULL);
 
-    auto& depth = g_Textures[g_MainDepthRTs[g_CurrentBackBufferIndex]];
+    auto& depth = GetTexture(g_MainDepthRTs[g_CurrentBackBufferIndex]);
     if (depth.width != g_SwapChainWidth || depth.height != g_SwapChainHeight) {
         RenderTextureDescriptor depthRTDesc(g_SwapChainWidth, g_SwapChainHeight,
                                             RenderTextureFormatDepth);
+        DeleteRenderTexture(g_MainDepthRTs[g_CurrentBackBufferIndex]);
         g_MainDepthRTs[g_CurrentBackBufferIndex] =
             InternalCreateRenderTexture(depthRTDesc);
     }
     auto depthHandle = g_DSVDescriptorHeap->GetCpuHandle(
-        g_Textures[g_MainDepthRTs[g_CurrentBackBufferIndex]].dsvIndex);
-    g_Textures[g_MainDepthRTs[g_CurrentBackBufferIndex]].Transition(
+        GetTexture(g_MainDepthRTs[g_CurrentBackBufferIndex]).dsvIndex);
+    GetTexture(g_MainDepthRTs[g_CurrentBackBufferIndex]).Transition(
         g_pCommandList, D3D12_RESOURCE_STATE_DEPTH_WRITE);
     g_pCommandList->ClearDepthStencilView(depthHandle, D3D12_CLEAR_FLAG_DEPTH,
                                           1, 0, 0, NULL);
     g_pCommandList->OMSetRenderTargets(
         1, &g_mainRenderTargetDescriptor[backBufferIdx], FALSE, &depthHandle);
 
-    GetCurrentSrvDescriptorHeap()->Reset();
-    GetCurrentSamplerDescriptorHeap()->Reset();
-    ID3D12DescriptorHeap* heaps[] = {GetCurrentSrvDescriptorHeap()->Heap(),
-                                     GetCurrentSamplerDescriptorHeap()->Heap()};
+    ID3D12DescriptorHeap* heaps[] = {g_BindlessSrvHeap->Heap(),
+                                     g_BindlessSamplerHeap->Heap()};
     g_pCommandList->SetDescriptorHeaps(2, heaps);
 
     UINT width = g_SwapChainWidth;
@@ -1050,16 +1404,28 @@ void FrameBegin() {
     CD3DX12_RECT rect(0, 0, LONG_MAX, LONG_MAX);
     g_pCommandList->RSSetScissorRects(1, &rect);
 
+    g_View.valid = false;
+    g_BoundVariant = nullptr;
+
     g_statistics.gpu.drawCall = 0;
+    g_statistics.gpu.pipelineChanges = 0;
+    g_statistics.gpu.materialChanges = 0;
+    g_statistics.gpu.meshChanges = 0;
+    g_statistics.gpu.redundantBindsSkipped = 0;
+    g_statistics.gpu.instancedDrawCall = 0;
+    g_statistics.gpu.instanceCount = 0;
+    g_statistics.gpu.dynamicUploadSize = 0;
+    g_statistics.gpu.staticUploadSize = 0;
+    g_statistics.gpu.drawsSkipped = 0;
+    g_statistics.gpu.skinningDispatches = 0;
+    g_statistics.gpu.skinnedVertices = 0;
 }
 
 void FrameEnd() {
-    {
-        std::future<void> result = g_GPUResourceUploader->End(g_pCommandQueue);
-        g_CBVMemory->Commit(g_pCommandQueue);
-        result.get();
-        g_GPUResourceUploader->Begin();
-    }
+    // no cpu wait: the graphics queue waits for the copy queue
+    SubmitUploads();
+    UploadRingEndFrame(&g_UploadRing, g_frameIndex);
+    g_CBVMemory->Commit(g_pCommandQueue);
 
     UINT backBufferIdx = g_pSwapChain->GetCurrentBackBufferIndex();
     auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(
@@ -1084,8 +1450,8 @@ void FrameEnd() {
     frameCtxt->FenceValue = fenceValue;
 
     {
-        const auto info = g_CBVMemory->GetStatistics(); 
-        g_statistics.cpu.uploadHeapSize = info.totalMemory;
+        const auto info = g_CBVMemory->GetStatistics();
+        g_statistics.cpu.uploadHeapSize = info.totalMemory + UploadRingSize;
     }
 }
 
@@ -1168,7 +1534,11 @@ inline D3D12_TEXTURE_ADDRESS_MODE Translate(TextureWrapMode w) {
     return ret;
 }
 
+static void InitPipelineCache();
+static void ShutdownPipelineCache();
+
 bool CreateDeviceD3D(HWND hWnd) {
+    TextureStreamingSetViewportHeight(g_SwapChainHeight);
     // Setup swap chain
     DXGI_SWAP_CHAIN_DESC1 sd;
     {
@@ -1234,14 +1604,28 @@ bool CreateDeviceD3D(HWND hWnd) {
     g_vertexDescriptors.reserve(1024);
     g_Shaders.reserve(1024);
     // 0 is reserved
-    g_Buffers.resize(1);
-    g_Textures.resize(1);
     g_vertexDescriptors.resize(1);
-    g_Shaders.resize(1);
+    HandlePoolInit(&g_BufferHandles, "buffer");
+    HandlePoolInit(&g_TextureHandles, "texture");
+    HandlePoolInit(&g_ShaderHandles, "shader");
+    HandlePoolInit(&g_PipelineHandles, "pipeline");
 
     g_CBVMemory = new DirectX::GraphicsMemory(g_Device);
-    g_GPUResourceUploader = new DirectX::ResourceUploadBatch(g_Device);
-    g_GPUResourceUploader->Begin();
+    {
+        auto heap = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+        auto desc = CD3DX12_RESOURCE_DESC::Buffer(UploadRingSize);
+        ThrowIfFailed(g_Device->CreateCommittedResource(
+            &heap, D3D12_HEAP_FLAG_NONE, &desc,
+            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+            IID_PPV_ARGS(&g_UploadRingBuffer)));
+        SetDebugObjectName(g_UploadRingBuffer, L"UploadRing");
+        // stays mapped, upload heaps are write-combined: never read it
+        CD3DX12_RANGE noRead(0, 0);
+        ThrowIfFailed(
+            g_UploadRingBuffer->Map(0, &noRead, (void**)&g_UploadRingCpu));
+        g_UploadRingGpu = g_UploadRingBuffer->GetGPUVirtualAddress();
+        UploadRingInit(&g_UploadRing, UploadRingSize);
+    }
 
     {
         D3D12_DESCRIPTOR_HEAP_DESC desc = {};
@@ -1284,15 +1668,12 @@ bool CreateDeviceD3D(HWND hWnd) {
     }
 
     {
-        constexpr UINT COUNT = 2048;
         D3D12_DESCRIPTOR_HEAP_DESC desc = {};
         desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        desc.NumDescriptors = COUNT;
+        desc.NumDescriptors = BindlessMaxTextures;
         desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;  // GPU visible
-        for (int i = 0; i < NUM_FRAMES_IN_FLIGHT; ++i) {
-            g_DynamicSrvUavDescriptorHeaps[i] =
-                new DirectX::DescriptorPile(g_Device, &desc);
-        }
+        g_BindlessSrvHeap = new DirectX::DescriptorHeap(g_Device, &desc);
+        BindlessTableInit(&g_BindlessTextures, BindlessMaxTextures);
         desc.NumDescriptors = FE_MAX_TEXTURE_COUNT;
         desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;  // CPU only
         g_StaticSrvDescriptorHeap =
@@ -1323,20 +1704,17 @@ bool CreateDeviceD3D(HWND hWnd) {
             srvDesc.Texture3D.MipLevels = 1;
             g_Device->CreateShaderResourceView(nullptr, &srvDesc, emptySRV3D);
         }
+        g_Device->CopyDescriptorsSimple(
+            1, g_BindlessSrvHeap->GetCpuHandle(BindlessMissingTexture),
+            emptySRV2D, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
     }
 
     {
         D3D12_DESCRIPTOR_HEAP_DESC desc = {};
         desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
-        desc.NumDescriptors = D3D12_MAX_SHADER_VISIBLE_SAMPLER_HEAP_SIZE;
+        desc.NumDescriptors = BindlessSamplerCount;
         desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;  // GPU visible
-        for (int i = 0; i < NUM_FRAMES_IN_FLIGHT; ++i) {
-            g_DynamicSamplerDescriptorHeaps[i] =
-                new DirectX::DescriptorPile(g_Device, &desc);
-        }
-        desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;  // CPU only
-        g_StaticSamplerDescriptorHeap =
-            new DirectX::DescriptorPile(g_Device, &desc);
+        g_BindlessSamplerHeap = new DirectX::DescriptorHeap(g_Device, &desc);
     }
 
     {
@@ -1365,6 +1743,31 @@ bool CreateDeviceD3D(HWND hWnd) {
                               IID_PPV_ARGS(&g_fence)) != S_OK)
         return false;
 
+    {
+        D3D12_COMMAND_QUEUE_DESC desc = {};
+        desc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+        desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+        desc.NodeMask = 1;
+        if (g_Device->CreateCommandQueue(&desc,
+                                         IID_PPV_ARGS(&g_CopyQueue)) != S_OK)
+            return false;
+        SetDebugObjectName(g_CopyQueue, L"CopyQueue");
+        for (UINT i = 0; i < NUM_FRAMES_IN_FLIGHT; i++)
+            if (g_Device->CreateCommandAllocator(
+                    D3D12_COMMAND_LIST_TYPE_COPY,
+                    IID_PPV_ARGS(&g_CopyAllocators[i])) != S_OK)
+                return false;
+        if (g_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY,
+                                        g_CopyAllocators[0], NULL,
+                                        IID_PPV_ARGS(&g_CopyCommandList)) !=
+                S_OK ||
+            g_CopyCommandList->Close() != S_OK)
+            return false;
+        if (g_Device->CreateFence(0, D3D12_FENCE_FLAG_NONE,
+                                  IID_PPV_ARGS(&g_CopyFence)) != S_OK)
+            return false;
+    }
+
     g_fenceEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
     if (g_fenceEvent == NULL) return false;
 
@@ -1384,60 +1787,55 @@ bool CreateDeviceD3D(HWND hWnd) {
     }
 
     CreateRenderTarget();
-    g_Textures.resize(3);
 
     RenderTextureDescriptor depthRTDesc(1280, 800, RenderTextureFormatDepth);
     for (int i = 0; i < NUM_FRAMES_IN_FLIGHT; ++i) {
         g_MainDepthRTs[i] = InternalCreateRenderTexture(depthRTDesc);
     }
     {
-        CD3DX12_ROOT_PARAMETER1 rootParameters[6];
+        CD3DX12_ROOT_PARAMETER1 rootParameters[8];
         D3D12_ROOT_DESCRIPTOR_FLAGS flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE;
         D3D12_SHADER_VISIBILITY v = D3D12_SHADER_VISIBILITY_VERTEX;
         rootParameters[0].InitAsConstantBufferView(1, 0, flags, v);
+        // instance data, register(t0, space1)
+        rootParameters[6].InitAsShaderResourceView(0, 1, flags, v);
+        // instanced vertex shaders read MATRIX_VP
+        rootParameters[2].InitAsConstantBufferView(
+            2, 0, flags, D3D12_SHADER_VISIBILITY_ALL);
         v = D3D12_SHADER_VISIBILITY_PIXEL;
         rootParameters[1].InitAsConstantBufferView(0, 0, flags, v);
-        rootParameters[2].InitAsConstantBufferView(2, 0, flags, v);
         rootParameters[3].InitAsConstantBufferView(3, 0, flags, v);
+        // bindless tables, Common.hlsl. Slots are written while earlier
+        // frames are in flight, so the descriptors are volatile
+        const auto volatileDescriptors =
+            D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE;
         CD3DX12_DESCRIPTOR_RANGE1 range(D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
-                                        srvRootRange, 0, 0);
+                                        UINT_MAX, 0, 2, volatileDescriptors);
         rootParameters[4].InitAsDescriptorTable(1, &range, v);
         CD3DX12_DESCRIPTOR_RANGE1 range2(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER,
-                                         srvRootRange, 0, 0);
+                                         BindlessSamplerCount, 0, 2);
         rootParameters[5].InitAsDescriptorTable(1, &range2, v);
+        CD3DX12_DESCRIPTOR_RANGE1 range3(D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
+                                         UINT_MAX, 0, 3, volatileDescriptors);
+        rootParameters[7].InitAsDescriptorTable(1, &range3, v);
         g_TestRootSignature =
-            CreateRootSignatureFromRootParameters(rootParameters, 6);
+            CreateRootSignatureFromRootParameters(rootParameters, 8);
     }
 
     {
         D3D12_SAMPLER_DESC desc;
         ZeroMemory(&desc, sizeof(desc));
 
-        for (int i = 0; i < _FilterModeCount; ++i) {
-            if (i == FilterModePoint) {
-                desc.Filter = D3D12_FILTER_MIN_MAG_MIP_POINT;
-            } else if (i == FilterModeBilinear) {
-                desc.Filter = D3D12_FILTER_MIN_MAG_LINEAR_MIP_POINT;
-            } else {
-                desc.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-            }
-            desc.Filter = Translate(FilterMode(i));
-            for (int j = 0; j < _TextureWrapModeCount; ++j) {
-                desc.AddressU = Translate((TextureWrapMode)j);
-                for (int k = 0; k < _TextureWrapModeCount; ++k) {
-                    desc.AddressV = Translate((TextureWrapMode)k);
-                    for (int l = 0; l < _TextureWrapModeCount; ++l) {
-                        desc.AddressW = Translate((TextureWrapMode)l);
-                        uint32_t hash = (((((i << 2) | j) << 2) | k) << 2) | l;
-                        size_t offset =
-                            g_StaticSamplerDescriptorHeap->Allocate();
-                        assert(hash == offset);
-                        D3D12_CPU_DESCRIPTOR_HANDLE handle =
-                            g_StaticSamplerDescriptorHeap->GetCpuHandle(offset);
-                        g_Device->CreateSampler(&desc, handle);
-                    }
-                }
-            }
+        for (uint32_t i = 0; i < BindlessSamplerCount; ++i) {
+            FilterMode filter;
+            TextureWrapMode u, v, w;
+            BindlessSamplerKey(i, &filter, &u, &v, &w);
+            desc.Filter = Translate(filter);
+            desc.AddressU = Translate(u);
+            desc.AddressV = Translate(v);
+            desc.AddressW = Translate(w);
+            g_Device->CreateSampler(&desc,
+                                    g_BindlessSamplerHeap->GetCpuHandle(i));
         }
     }
 
@@ -1451,52 +1849,398 @@ bool CreateDeviceD3D(HWND hWnd) {
     //    g_Device, *g_GPUResourceUploader, path, &sky);
     // assert(SUCCEEDED(hr));
 
+    InitPipelineCache();
     return true;
 }
 
-struct PSOCache {
-    std::map<uint32_t, ID3D12PipelineState*> psos;
+// Pipelines are keyed on their full description (pipeline_cache.h) and are
+// created on worker threads, BindPipeline skips the draws of a pipeline that
+// is not ready yet instead of stalling the frame. Created pipelines are kept
+// in pipeline_cache.bin next to the executable: the next session creates
+// them from their cached blobs, and compiles the ones it used last time as
+// soon as their shaders are loaded.
+constexpr uint32_t PipelineCompileThreadCount = 2;
+
+struct PipelineSlot {
+    ShaderHandle vs = 0;
+    ShaderHandle ps = 0;
+    uint32_t handle = 0;  // g_PipelineHandles, 0 until created
+    bool pending = false;
 };
 
-PSOCache g_PSOCache;
+// PipelineDescHash -> pipeline of this session
+static std::unordered_map<uint64_t, PipelineSlot> g_Pipelines;
+static PipelineCache g_PipelineCache;
+static std::string g_PipelineCachePath;
+// live shaders by content hash, for the warm-up
+static std::unordered_map<uint64_t, ShaderHandle> g_ShadersByHash;
+static PipelineSortIDs g_PipelineSortIDs;
+static bool g_WarmUpPending = false;
+
+struct PipelineCompileJob {
+    uint64_t key;
+    PipelineDesc desc;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC d3dDesc;
+    // referenced until the job is finished, the shaders may be deleted
+    // meanwhile
+    ID3DBlob* vs;
+    ID3DBlob* ps;
+    std::vector<uint8_t> cachedBlob;
+    bool cacheHit = false;
+    ID3D12PipelineState* pso = nullptr;
+};
 
-ID3D12PipelineState* GetPipelineState(ShaderHandle vs, ShaderHandle ps) {
-    assert(vs < (1 << 16) && ps < (1 << 16));
-    uint32_t hash = (vs << 16) + ps;
-    auto it = g_PSOCache.psos.find(hash);
-    if (it != g_PSOCache.psos.end()) return it->second;
+static struct {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<PipelineCompileJob*> queue;
+    std::vector<PipelineCompileJob*> done;
+    std::vector<std::thread> threads;
+    bool quit = false;
+} g_PipelineCompiler;
+
+// MeshVertexLayout, the input layout of every pipeline
+static const D3D12_INPUT_LAYOUT_DESC& GetMeshInputLayout() {
+    static const D3D12_INPUT_LAYOUT_DESC layout = [] {
+        VertexDeclElement elements[MeshVertexLayoutCount];
+        memcpy(elements, MeshVertexLayout, sizeof(elements));
+        VertexDecl decl =
+            BuildVertexDeclFromElements(elements, MeshVertexLayoutCount);
+        return GetVerextDecl(decl.handle);
+    }();
+    return layout;
+}
 
-    VertexDeclElement elements[] = {
-        {VertexAttributePosition, VertexAttributeTypeFloat, 4},
-        {VertexAttributeNormal, VertexAttributeTypeFloat, 4},
-        {VertexAttributeTangent, VertexAttributeTypeFloat, 4},
-        {VertexAttributeTexCoord0, VertexAttributeTypeFloat, 2},
-        {VertexAttributeTexCoord1, VertexAttributeTypeFloat, 2},
-    };
-    VertexDecl decl = BuildVertexDeclFromElements(elements, countof(elements));
+static uint64_t GetMeshVertexLayoutHash() {
+    static const uint64_t hash =
+        PipelineVertexLayoutHash(MeshVertexLayout, MeshVertexLayoutCount);
+    return hash;
+}
+
+// the engine's meshes are wound the other way round
+inline D3D12_CULL_MODE TranslateCull(uint8_t mode) {
+    switch (mode) {
+        case PipelineCullOff:
+            return D3D12_CULL_MODE_NONE;
+        case PipelineCullFront:
+            return D3D12_CULL_MODE_BACK;
+        default:
+            return D3D12_CULL_MODE_FRONT;
+    }
+}
 
-    D3D12_INPUT_LAYOUT_DESC inputLayout = GetVerextDecl(decl.handle);
+inline D3D12_COMPARISON_FUNC TranslateCompare(uint8_t compare) {
+    switch (compare) {
+        case PipelineCompareLessEqual:
+            return D3D12_COMPARISON_FUNC_LESS_EQUAL;
+        case PipelineCompareGreater:
+            return D3D12_COMPARISON_FUNC_GREATER;
+        case PipelineCompareGreaterEqual:
+            return D3D12_COMPARISON_FUNC_GREATER_EQUAL;
+        case PipelineCompareEqual:
+            return D3D12_COMPARISON_FUNC_EQUAL;
+        case PipelineCompareAlways:
+            return D3D12_COMPARISON_FUNC_ALWAYS;
+        default:
+            return D3D12_COMPARISON_FUNC_LESS;
+    }
+}
+
+inline D3D12_BLEND_DESC TranslateBlend(uint8_t mode) {
     CD3DX12_BLEND_DESC blend(D3D12_DEFAULT);
-    CD3DX12_DEPTH_STENCIL_DESC depthStencil(D3D12_DEFAULT);
+    auto& rt = blend.RenderTarget[0];
+    if (mode == PipelineBlendAlpha) {
+        rt.BlendEnable = TRUE;
+        rt.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        rt.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+    } else if (mode == PipelineBlendAdditive) {
+        rt.BlendEnable = TRUE;
+        rt.SrcBlend = D3D12_BLEND_ONE;
+        rt.DestBlend = D3D12_BLEND_ONE;
+    }
+    return blend;
+}
+
+static PipelineDesc MakePipelineDesc(ShaderHandle vs, ShaderHandle ps,
+                                     const PipelineRenderState& state) {
+    PipelineDesc desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.vsHash = g_ShaderHashes[HandleIndex(vs)];
+    desc.psHash = g_ShaderHashes[HandleIndex(ps)];
+    desc.vertexLayoutHash = GetMeshVertexLayoutHash();
+    desc.state = state;
+    desc.colorFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.depthFormat =
+        GetTexture(g_MainDepthRTs[g_CurrentBackBufferIndex]).format;
+    desc.sampleCount = 1;
+    return desc;
+}
+
+static void PipelineCompileThread() {
+    auto& c = g_PipelineCompiler;
+    for (;;) {
+        PipelineCompileJob* job;
+        {
+            std::unique_lock<std::mutex> lock(c.mutex);
+            c.wake.wait(lock, [&c] { return c.quit || !c.queue.empty(); });
+            if (c.quit) return;
+            job = c.queue.front();
+            c.queue.pop_front();
+        }
+        HRESULT hr = g_Device->CreateGraphicsPipelineState(
+            &job->d3dDesc, IID_PPV_ARGS(&job->pso));
+        job->cacheHit = SUCCEEDED(hr) && !job->cachedBlob.empty();
+        // a blob of another driver version is refused, start over without
+        if (FAILED(hr) && !job->cachedBlob.empty()) {
+            job->d3dDesc.CachedPSO = {};
+            hr = g_Device->CreateGraphicsPipelineState(&job->d3dDesc,
+                                                       IID_PPV_ARGS(&job->pso));
+        }
+        if (FAILED(hr)) job->pso = nullptr;
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.done.push_back(job);
+    }
+}
+
+// queues the creation of the pipeline desc describes, vs and ps are its
+// shaders
+static void RequestPipeline(uint64_t key, const PipelineDesc& desc,
+                            ShaderHandle vs, ShaderHandle ps) {
+    PipelineSlot& slot = g_Pipelines[key];
+    slot.vs = vs;
+    slot.ps = ps;
+    slot.handle = 0;
+    slot.pending = true;
+
+    auto job = new PipelineCompileJob();
+    job->key = key;
+    job->desc = desc;
+    job->vs = GetShaderBlob(vs);
+    job->vs->AddRef();
+    job->ps = GetShaderBlob(ps);
+    job->ps->AddRef();
+    if (PipelineCacheEntry* e = PipelineCacheFind(&g_PipelineCache, key)) {
+        e->flags |= PipelineCacheEntryRequested;
+        auto blob = (const uint8_t*)PipelineCacheGetBlob(&g_PipelineCache, e);
+        if (blob != nullptr) job->cachedBlob.assign(blob, blob + e->blobSize);
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC& d = job->d3dDesc;
+    memset(&d, 0, sizeof(d));
+    d.pRootSignature = g_TestRootSignature.Get();
+    d.VS = {job->vs->GetBufferPointer(), job->vs->GetBufferSize()};
+    d.PS = {job->ps->GetBufferPointer(), job->ps->GetBufferSize()};
+    d.BlendState = TranslateBlend(desc.state.blendMode);
+    d.SampleMask = UINT_MAX;
     CD3DX12_RASTERIZER_DESC rasterizer(D3D12_DEFAULT);
-    rasterizer.CullMode = D3D12_CULL_MODE_FRONT;
-    auto& depth = g_Textures[g_MainDepthRTs[g_CurrentBackBufferIndex]];
-    DirectX::RenderTargetState renderTarget(DXGI_FORMAT_R8G8B8A8_UNORM,
-                                            depth.format);
-    DirectX::EffectPipelineStateDescription desc(
-        &inputLayout, blend, depthStencil, rasterizer, renderTarget);
-    ID3D10Blob* vsblob = g_Shaders[vs];
-    D3D12_SHADER_BYTECODE _vs = {vsblob->GetBufferPointer(),
-                                 vsblob->GetBufferSize()};
-    ID3D10Blob* psblob = g_Shaders[ps];
-    D3D12_SHADER_BYTECODE _ps = {psblob->GetBufferPointer(),
-                                 psblob->GetBufferSize()};
+    rasterizer.CullMode = TranslateCull(desc.state.cullMode);
+    d.RasterizerState = rasterizer;
+    CD3DX12_DEPTH_STENCIL_DESC depthStencil(D3D12_DEFAULT);
+    depthStencil.DepthFunc = TranslateCompare(desc.state.depthTest);
+    depthStencil.DepthWriteMask = desc.state.depthWrite
+                                      ? D3D12_DEPTH_WRITE_MASK_ALL
+                                      : D3D12_DEPTH_WRITE_MASK_ZERO;
+    d.DepthStencilState = depthStencil;
+    d.InputLayout = GetMeshInputLayout();
+    d.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    d.NumRenderTargets = 1;
+    d.RTVFormats[0] = (DXGI_FORMAT)desc.colorFormat;
+    d.DSVFormat = (DXGI_FORMAT)desc.depthFormat;
+    d.SampleDesc.Count = desc.sampleCount;
+    d.CachedPSO = {job->cachedBlob.data(), job->cachedBlob.size()};
 
-    ID3D12PipelineState* pso = nullptr;
-    desc.CreatePipelineState(g_Device, g_TestRootSignature.Get(), _vs, _ps,
-                             &pso);
-    g_PSOCache.psos[hash] = pso;
-    return pso;
+    {
+        std::lock_guard<std::mutex> lock(g_PipelineCompiler.mutex);
+        g_PipelineCompiler.queue.push_back(job);
+    }
+    g_PipelineCompiler.wake.notify_one();
+    g_statistics.gpu.pipelinesPending++;
+}
+
+// hands the pipelines the workers have finished to their slots, and their
+// blobs to the cache
+static void FinishPipelines() {
+    std::vector<PipelineCompileJob*> done;
+    {
+        std::lock_guard<std::mutex> lock(g_PipelineCompiler.mutex);
+        if (g_PipelineCompiler.done.empty()) return;
+        done.swap(g_PipelineCompiler.done);
+    }
+    for (PipelineCompileJob* job : done) {
+        SAFE_RELEASE(job->vs);
+        SAFE_RELEASE(job->ps);
+        g_statistics.gpu.pipelinesPending--;
+        auto it = g_Pipelines.find(job->key);
+        // a shader of it was deleted meanwhile
+        if (it == g_Pipelines.end() || !it->second.pending) {
+            SAFE_RELEASE(job->pso);
+            delete job;
+            continue;
+        }
+        PipelineSlot& slot = it->second;
+        slot.pending = false;
+        if (job->pso == nullptr) {
+            // the slot stays empty, its draws are skipped
+            printf("[pipeline] failed to create pipeline %016llx\n",
+                   (unsigned long long)job->key);
+            delete job;
+            continue;
+        }
+        slot.handle = AllocHandle(g_PipelineHandles, g_PipelineStates);
+        g_PipelineStates[HandleIndex(slot.handle)] = job->pso;
+        g_statistics.gpu.pipelineCount++;
+        ComPtr<ID3DBlob> blob;
+        if (job->cacheHit) {
+            g_statistics.gpu.pipelineCacheHits++;
+            PipelineCacheStore(&g_PipelineCache, &job->desc, NULL, 0);
+        } else if (SUCCEEDED(job->pso->GetCachedBlob(&blob))) {
+            PipelineCacheStore(&g_PipelineCache, &job->desc,
+                               blob->GetBufferPointer(),
+                               (uint32_t)blob->GetBufferSize());
+        } else {
+            PipelineCacheStore(&g_PipelineCache, &job->desc, NULL, 0);
+        }
+        delete job;
+    }
+}
+
+static void ShaderLoadedForWarmUp(ShaderHandle shader) {
+    g_ShadersByHash[g_ShaderHashes[HandleIndex(shader)]] = shader;
+    g_WarmUpPending = true;
+}
+
+// requests the pipelines of the last session whose shaders are all loaded
+static void WarmUpPipelines() {
+    if (!g_WarmUpPending) return;
+    g_WarmUpPending = false;
+    auto entries = (const PipelineCacheEntry*)g_PipelineCache.entries.ptr;
+    for (uint32_t i = 0; i < g_PipelineCache.entries.size; ++i) {
+        const PipelineCacheEntry& e = entries[i];
+        const uint32_t started =
+            PipelineCacheEntryUsed | PipelineCacheEntryRequested;
+        if ((e.flags & started) != 0 ||
+            e.desc.vertexLayoutHash != GetMeshVertexLayoutHash() ||
+            g_Pipelines.count(e.key) != 0)
+            continue;
+        auto vs = g_ShadersByHash.find(e.desc.vsHash);
+        auto ps = g_ShadersByHash.find(e.desc.psHash);
+        if (vs == g_ShadersByHash.end() || ps == g_ShadersByHash.end())
+            continue;
+        RequestPipeline(e.key, e.desc, vs->second, ps->second);
+    }
+}
+
+static void UpdatePipelines() {
+    FinishPipelines();
+    WarmUpPipelines();
+}
+
+// nullptr while the pipeline is being created
+ID3D12PipelineState* GetPipelineState(ShaderHandle vs, ShaderHandle ps,
+                                      const PipelineRenderState& state) {
+    PipelineDesc desc = MakePipelineDesc(vs, ps, state);
+    uint64_t key = PipelineDescHash(&desc);
+    auto it = g_Pipelines.find(key);
+    if (it == g_Pipelines.end()) {
+        RequestPipeline(key, desc, vs, ps);
+        it = g_Pipelines.find(key);
+    }
+    // it may have been finished since the start of the frame
+    if (it->second.pending) FinishPipelines();
+    uint32_t handle = it->second.handle;
+    return handle != 0 ? g_PipelineStates[HandleIndex(handle)] : nullptr;
+}
+
+uint32_t GetPipelineSortID(ShaderHandle vs, ShaderHandle ps) {
+    return PipelineSortIDsGet(&g_PipelineSortIDs, vs, ps);
+}
+
+// drops every pipeline built from the shader
+void ReleasePipelineStates(ShaderHandle shader) {
+    PipelineSortIDsRelease(&g_PipelineSortIDs, shader);
+    auto byHash = g_ShadersByHash.find(g_ShaderHashes[HandleIndex(shader)]);
+    if (byHash != g_ShadersByHash.end() && byHash->second == shader)
+        g_ShadersByHash.erase(byHash);
+    for (auto it = g_Pipelines.begin(); it != g_Pipelines.end();) {
+        const PipelineSlot& slot = it->second;
+        if (slot.vs == shader || slot.ps == shader) {
+            if (slot.handle != 0)
+                HandlePoolRelease(&g_PipelineHandles, slot.handle,
+                                  g_frameIndex);
+            it = g_Pipelines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// adapter and driver version, the blobs are only valid for both
+static uint64_t GetPipelineCacheDeviceId() {
+    uint64_t id = PipelineHashSeed;
+    IDXGIFactory4* factory = NULL;
+    IDXGIAdapter1* adapter = NULL;
+    if (CreateDXGIFactory1(IID_PPV_ARGS(&factory)) == S_OK &&
+        factory->EnumAdapterByLuid(g_Device->GetAdapterLuid(),
+                                   IID_PPV_ARGS(&adapter)) == S_OK) {
+        DXGI_ADAPTER_DESC1 desc;
+        adapter->GetDesc1(&desc);
+        LARGE_INTEGER driver = {};
+        adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driver);
+        const uint32_t ids[] = {desc.VendorId, desc.DeviceId, desc.SubSysId,
+                                desc.Revision};
+        id = PipelineHashBytes(ids, sizeof(ids), id);
+        id = PipelineHashBytes(&driver.QuadPart, sizeof(driver.QuadPart), id);
+    }
+    SAFE_RELEASE(adapter);
+    SAFE_RELEASE(factory);
+    return id;
+}
+
+static void InitPipelineCache() {
+    PipelineCacheInit(&g_PipelineCache, GetPipelineCacheDeviceId());
+    PipelineSortIDsInit(&g_PipelineSortIDs);
+    g_PipelineCachePath =
+        (fs::path(ApplicationFilePath()) / "pipeline_cache.bin").string();
+    if (PipelineCacheLoad(&g_PipelineCache, g_PipelineCachePath.c_str()))
+        printf("[pipeline] %u pipelines in %s\n",
+               g_PipelineCache.entries.size, g_PipelineCachePath.c_str());
+    g_PipelineCompiler.quit = false;
+    for (uint32_t i = 0; i < PipelineCompileThreadCount; ++i)
+        g_PipelineCompiler.threads.emplace_back(PipelineCompileThread);
+}
+
+static void ShutdownPipelineCache() {
+    auto& c = g_PipelineCompiler;
+    {
+        std::lock_guard<std::mutex> lock(c.mutex);
+        c.quit = true;
+    }
+    c.wake.notify_all();
+    for (auto& t : c.threads) t.join();
+    c.threads.clear();
+    for (PipelineCompileJob* job : c.queue) {
+        SAFE_RELEASE(job->vs);
+        SAFE_RELEASE(job->ps);
+        g_statistics.gpu.pipelinesPending--;
+        delete job;
+    }
+    c.queue.clear();
+    FinishPipelines();
+
+    for (auto& [key, slot] : g_Pipelines) {
+        if (slot.handle != 0)
+            HandlePoolRelease(&g_PipelineHandles, slot.handle, g_frameIndex);
+    }
+    g_Pipelines.clear();
+    g_ShadersByHash.clear();
+    PipelineSortIDsFree(&g_PipelineSortIDs);
+    if (g_PipelineCache.dirty)
+        PipelineCacheSave(&g_PipelineCache, g_PipelineCachePath.c_str());
+    PipelineCacheFree(&g_PipelineCache);
+}
+
+static void DestroyPipelineState(void* ctx, uint32_t handle) {
+    SAFE_RELEASE(g_PipelineStates[HandleIndex(handle)]);
 }
 
 void CreateRenderTarget() {
@@ -1571,6 +2315,7 @@ void ResizeSwapChain(HWND hWnd, int width, int height) {
     sd.Height = height;
     g_SwapChainWidth = width;
     g_SwapChainHeight = height;
+    TextureStreamingSetViewportHeight(height);
 
     // IDXGIFactory4* dxgiFactory = NULL;
     // g_pSwapChain->GetParent(IID_PPV_ARGS(&dxgiFactory));
@@ -1613,8 +2358,6 @@ struct ComputeShader {
     std::string m_Name;
 };
 
-std::string ApplicationFilePath();
-
 ComputeShader* ComputeShader::Find(const char* name) {
     ComputeShader* s = new ComputeShader;
     s->m_Name = name;
@@ -1626,7 +2369,7 @@ ComputeShader* ComputeShader::Find(const char* name) {
 }
 
 inline D3D12_SHADER_BYTECODE TranslateS(ShaderHandle handle) {
-    ID3D10Blob* blob = g_Shaders[handle];
+    ID3D10Blob* blob = GetShaderBlob(handle);
     return {blob->GetBufferPointer(), blob->GetBufferSize()};
 }
 
@@ -1634,13 +2377,22 @@ struct GPUSkinningPass {
     ComPtr<ID3D12RootSignature> rootSignature;
     ComputeShader* shader = nullptr;
     ComPtr<ID3D12PipelineState> pso;
+    // this frame's skinned meshes, and the vertex buffer they are all skinned
+    // into; the arena grows but keeps its handle
+    SkinningBatch batch;
+    BufferHandle arena = 0;
 
     ~GPUSkinningPass() { Clean(); }
 
     void Clean() {
+        if (!init) return;
         rootSignature.Reset();
         pso.Reset();
+        if (shader) DeleteShader(shader->m_Kernels[0].handle);
         SAFE_DELETE(shader);
+        SkinningBatchFree(&batch);
+        DeleteBuffer(arena);
+        arena = 0;
         init = false;
     }
 
@@ -1649,12 +2401,17 @@ struct GPUSkinningPass {
         if (init) return;
         shader = ComputeShader::Find("Internal-Skinning");
 
+        // the source vertices and bone weights are read through the bindless
+        // table, so one root signature serves every mesh of the batch
+        CD3DX12_DESCRIPTOR_RANGE1 buffers;
+        buffers.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, BindlessMaxTextures, 0,
+                     4, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
         CD3DX12_ROOT_PARAMETER1 rootParameters[5];
-        rootParameters[0].InitAsConstants(1, 0);
-        rootParameters[1].InitAsShaderResourceView(0);
-        rootParameters[2].InitAsShaderResourceView(1);
-        rootParameters[3].InitAsShaderResourceView(2);
-        rootParameters[4].InitAsUnorderedAccessView(0);
+        rootParameters[0].InitAsConstants(1, 0);               // g_JobCount
+        rootParameters[1].InitAsShaderResourceView(0);         // g_Jobs
+        rootParameters[2].InitAsShaderResourceView(1);         // g_Palette
+        rootParameters[3].InitAsUnorderedAccessView(0);        // g_MeshVertsOut
+        rootParameters[4].InitAsDescriptorTable(1, &buffers);  // FEBuffers
         rootSignature =
             CreateRootSignatureFromRootParameters(rootParameters, 5);
 
@@ -1667,79 +2424,119 @@ struct GPUSkinningPass {
         HRESULT hr =
             g_Device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pso));
         assert(SUCCEEDED(hr));
+        SkinningBatchInit(&batch);
         init = true;
     }
 };
 
 GPUSkinningPass g_GPUSkinningPass;
 
-inline ID3D12Resource* Translate(BufferHandle handle) {
-    return g_Buffers[handle].resource;
-}
-
 int GPUSkinning(Renderable* r) {
-    BeginRenderEvent("GPUSkinning");
-    g_GPUSkinningPass.Init();
     assert(r && r->skin && r->mesh);
     if (!(r && r->skin && r->mesh)) return 1;
+    g_GPUSkinningPass.Init();
     Mesh* mesh = r->mesh;
-    auto& skinnedVB = mesh->skinnedvb;
-    auto VB = mesh->vb;
-    auto skin = mesh->sb;
-    auto& bones = r->bonesBuffer;
-    if (skinnedVB == 0) {
+    const uint32_t sourceVertices = GetBufferBindlessIndex(mesh->vb);
+    const uint32_t sourceSkin = GetBufferBindlessIndex(mesh->sb);
+    // a full bindless table, the mesh is drawn in its bind pose
+    if (sourceVertices == 0 || sourceSkin == 0) {
+        mesh->skinnedvb = 0;
+        return 1;
+    }
+    auto& pass = g_GPUSkinningPass;
+    const uint32_t vertexCount = MeshGetVertexCount(mesh);
+    mesh->skinnedOffset = SkinningBatchAdd(
+        &pass.batch, vertexCount, (const float4x4*)r->skin->boneMats.ptr,
+        r->skin->boneMats.size, sourceVertices, sourceSkin);
+    if (pass.arena == 0) {
         Memory m = {};
-        m.byteLength = array_get_bytelength(&r->mesh->vertices);
-        skinnedVB = CreateBuffer(m, GPUResourceUsageUnorderedAccess);
+        m.byteLength = vertexCount * sizeof(Vertex);
+        pass.arena = CreateBuffer(m, GPUResourceUsageUnorderedAccess);
     }
-    {
-        Memory m = {};
-        m.buffer = r->skin->boneMats.ptr;
-        m.byteLength = array_get_bytelength(&r->skin->boneMats);
-        if (bones == 0)
-            bones = CreateBuffer(m, GPUResourceUsageShaderResource);
-        else
-            InternalUpdateBuffer(g_Buffers[bones].resource,
-                                 g_Buffers[bones].state, m);
-    }
-
-    uint32_t vertexCount = MeshGetVertexCount(mesh);
+    mesh->skinnedvb = pass.arena;
 
-    g_Buffers[VB].Transition(
+    // no-ops once the mesh has been skinned before
+    GetBuffer(mesh->vb).Transition(
         g_pCommandList, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
                             D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-    g_Buffers[skin].Transition(g_pCommandList,
-                               D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-    g_Buffers[bones].Transition(g_pCommandList,
-                                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-    g_Buffers[skinnedVB].Transition(g_pCommandList,
-                                    D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    GetBuffer(mesh->sb).Transition(
+        g_pCommandList, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    return 0;
+}
 
-    g_GPUSkinningPass.Init();
-    g_pCommandList->SetPipelineState(g_GPUSkinningPass.pso.Get());
-    g_pCommandList->SetComputeRootSignature(
-        g_GPUSkinningPass.rootSignature.Get());
-    g_pCommandList->SetComputeRoot32BitConstant(0, vertexCount, 0);
-    g_pCommandList->SetComputeRootShaderResourceView(
-        1, g_Buffers[r->mesh->vb].resource->GetGPUVirtualAddress());
-    g_pCommandList->SetComputeRootShaderResourceView(
-        2, Translate(skin)->GetGPUVirtualAddress());
-    g_pCommandList->SetComputeRootShaderResourceView(
-        3, Translate(bones)->GetGPUVirtualAddress());
+void GPUSkinningSubmit() {
+    auto& pass = g_GPUSkinningPass;
+    if (!pass.init || pass.batch.jobs.size == 0) return;
+    SkinningBatch& batch = pass.batch;
+    BeginRenderEvent("GPUSkinning");
+
+    BufferWrap& arena = GetBuffer(pass.arena);
+    const uint32_t arenaSize = batch.vertexCount * sizeof(Vertex);
+    if (arenaSize > arena.byteLength)
+        GrowBuffer(arena, std::max(arenaSize, arena.byteLength * 2));
+
+    // new every frame, read straight from the upload ring
+    const uint32_t jobsSize = array_get_bytelength(&batch.jobs);
+    auto jobs = AllocateDynamic(jobsSize, 16);
+    memcpy(jobs.cpu, batch.jobs.ptr, jobsSize);
+    const uint32_t paletteSize =
+        std::max(array_get_bytelength(&batch.palette), 16u);
+    auto palette = AllocateDynamic(paletteSize, 16);
+    memcpy(palette.cpu, batch.palette.ptr,
+           array_get_bytelength(&batch.palette));
+
+    // one barrier for all meshes, BindMesh moves the arena back to vertex
+    // buffer on the first skinned draw
+    arena.Transition(g_pCommandList, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    g_pCommandList->SetPipelineState(pass.pso.Get());
+    g_pCommandList->SetComputeRootSignature(pass.rootSignature.Get());
+    g_pCommandList->SetComputeRoot32BitConstant(0, batch.jobs.size, 0);
+    g_pCommandList->SetComputeRootShaderResourceView(1, jobs.gpu);
+    g_pCommandList->SetComputeRootShaderResourceView(2, palette.gpu);
     g_pCommandList->SetComputeRootUnorderedAccessView(
-        4, Translate(skinnedVB)->GetGPUVirtualAddress());
-    UINT x = static_cast<UINT>(std::ceil(vertexCount / 64.0f));
-    g_pCommandList->Dispatch(x, 1, 1);
+        3, arena.resource->GetGPUVirtualAddress());
+    g_pCommandList->SetComputeRootDescriptorTable(
+        4, g_BindlessSrvHeap->GetFirstGpuHandle());
+    assert(batch.groupCount <=
+           D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION);
+    g_pCommandList->Dispatch(batch.groupCount, 1, 1);
+
+    g_statistics.gpu.skinningDispatches++;
+    g_statistics.gpu.skinnedVertices = batch.vertexCount;
+    SkinningBatchClear(&batch);
     EndRenderEvent();
-    return 0;
 }
 
 void CleanupDeviceD3D() {
-    { g_GPUResourceUploader->End(g_pCommandQueue); }
+    SubmitUploads();
+    WaitForFence(g_CopyFence, g_CopyFenceLastSignaledValue);
     g_GPUSkinningPass.Clean();
+
+    // after the backend's own objects are gone, whatever is still alive was
+    // never deleted by its owner
+    WaitForLastSubmittedFrame();
+    for (TextureHandle& rt : g_MainDepthRTs) {
+        DeleteRenderTexture(rt);
+        rt = 0;
+    }
+    ShutdownPipelineCache();
+    CollectResources(UINT64_MAX);
+    HandlePoolReportLeaks(&g_BufferHandles);
+    HandlePoolReportLeaks(&g_TextureHandles);
+    HandlePoolReportLeaks(&g_ShaderHandles);
     for (auto& b : g_Buffers) {
         SAFE_RELEASE(b.resource);
     }
+    for (auto& t : g_Textures) {
+        SAFE_RELEASE(t.resource);
+    }
+    for (auto& blob : g_Shaders) {
+        SAFE_RELEASE(blob);
+    }
+    HandlePoolFree(&g_BufferHandles);
+    HandlePoolFree(&g_TextureHandles);
+    HandlePoolFree(&g_ShaderHandles);
+    HandlePoolFree(&g_PipelineHandles);
     CleanupRenderTarget();
     SAFE_RELEASE(g_pSwapChain);
     if (g_hSwapChainWaitableObject != NULL) {
@@ -1750,37 +2547,31 @@ void CleanupDeviceD3D() {
             g_frameContext[i].CommandAllocator->Release();
             g_frameContext[i].CommandAllocator = NULL;
         }
-    for (int i = 0; i < NUM_FRAMES_IN_FLIGHT; ++i) {
-        g_Textures[i].resource = nullptr;
-    }
     for (int i = 0; i < NUM_FRAMES_IN_FLIGHT; ++i) {
         g_CBVInFlight[i].clear();
     }
-    for (int i = NUM_FRAMES_IN_FLIGHT; i < g_Textures.size(); ++i) {
-        SAFE_RELEASE(g_Textures[i].resource);
-    }
     SAFE_RELEASE(g_pCommandQueue);
     SAFE_RELEASE(g_pCommandList);
+    for (auto& allocator : g_CopyAllocators) {
+        SAFE_RELEASE(allocator);
+    }
+    SAFE_RELEASE(g_CopyCommandList);
+    SAFE_RELEASE(g_CopyQueue);
+    SAFE_RELEASE(g_CopyFence);
+    if (g_UploadRingBuffer != NULL) g_UploadRingBuffer->Unmap(0, nullptr);
+    SAFE_RELEASE(g_UploadRingBuffer);
     // SAFE_RELEASE(g_TestPSO);
-    for (auto& [k, v] : g_PSOCache.psos) {
-        SAFE_RELEASE(v);
-    }
     g_TestRootSignature.Reset();
     SAFE_DELETE(g_CBVMemory);
-    SAFE_DELETE(g_GPUResourceUploader);
     SAFE_DELETE(g_pRtvDescHeap);
     SAFE_DELETE(g_pSrvDescHeap);
     SAFE_DELETE(g_RTVDescriptorHeap);
     SAFE_DELETE(g_DSVDescriptorHeap);
-    SAFE_DELETE(g_StaticSamplerDescriptorHeap);
     SAFE_DELETE(g_StaticSrvDescriptorHeap);
     SAFE_DELETE(g_StaticUavDescriptorHeap);
-    for (auto& heap : g_DynamicSrvUavDescriptorHeaps) {
-        SAFE_DELETE(heap);
-    }
-    for (auto& heap : g_DynamicSamplerDescriptorHeaps) {
-        SAFE_DELETE(heap);
-    }
+    SAFE_DELETE(g_BindlessSrvHeap);
+    SAFE_DELETE(g_BindlessSamplerHeap);
+    BindlessTableFree(&g_BindlessTextures);
     SAFE_RELEASE(g_fence);
     if (g_fenceEvent) {
         CloseHandle(g_fenceEvent);
@@ -1801,7 +2592,7 @@ D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(Texture* texture) {
     auto heap = g_pSrvDescHeap;
     D3D12_GPU_DESCRIPTOR_HANDLE handle = heap->GetFirstGpuHandle();
     if (texture != NULL) {
-        auto idx = g_Textures[texture->handle].srvIndex;
+        auto idx = GetTexture(texture->handle).srvIndex;
         auto src = g_StaticSrvDescriptorHeap->GetCpuHandle(idx);
         size_t start = 0;
         try {
@@ -1,10 +1,12 @@
 #include "render_metal.h"
 #import <Metal/Metal.h>
 #import <MetalKit/MetalKit.h>
+#include "bindless.h"
 #include "camera.h"
 #include "component.h"
 #include "ecs.h"
 #include "light.h"
+#include "log.h"
 #include "mesh.h"
 #include "rhi.h"
 #include "shader.h"
@@ -147,32 +149,77 @@ void DeleteRenderTexture(uint32_t textureid) {
     }
 }
 
-static bool IsPowerOfTwo(uint32_t v) { return !(v & (v - 1)); }
+static MTLPixelFormat ConvertTextureFormat(TextureFormat format) {
+    switch (format) {
+        case TextureFormatAlpha8: return MTLPixelFormatA8Unorm;
+        case TextureFormatBGRA8Unorm: return MTLPixelFormatBGRA8Unorm;
+        case TextureFormatBGRA8Unorm_sRGB: return MTLPixelFormatBGRA8Unorm_sRGB;
+        case TextureFormatRGBA8Unorm: return MTLPixelFormatRGBA8Unorm;
+        case TextureFormatRGBA8Unorm_sRGB: return MTLPixelFormatRGBA8Unorm_sRGB;
+        case TextureFormatR32Float: return MTLPixelFormatR32Float;
+        case TextureFormatR8Unorm: return MTLPixelFormatR8Unorm;
+        case TextureFormatRG8Unorm: return MTLPixelFormatRG8Unorm;
+        case TextureFormatRGBA16Float: return MTLPixelFormatRGBA16Float;
+        case TextureFormatRGBA32Float: return MTLPixelFormatRGBA32Float;
+        case TextureFormatDXT1: return MTLPixelFormatBC1_RGBA;
+        case TextureFormatDXT1_sRGB: return MTLPixelFormatBC1_RGBA_sRGB;
+        case TextureFormatDXT3: return MTLPixelFormatBC2_RGBA;
+        case TextureFormatDXT3_sRGB: return MTLPixelFormatBC2_RGBA_sRGB;
+        case TextureFormatDXT5: return MTLPixelFormatBC3_RGBA;
+        case TextureFormatDXT5_sRGB: return MTLPixelFormatBC3_RGBA_sRGB;
+        case TextureFormatBC4: return MTLPixelFormatBC4_RUnorm;
+        case TextureFormatBC5: return MTLPixelFormatBC5_RGUnorm;
+        case TextureFormatBC6H: return MTLPixelFormatBC6H_RGBUfloat;
+        case TextureFormatBC7: return MTLPixelFormatBC7_RGBAUnorm;
+        case TextureFormatBC7_sRGB: return MTLPixelFormatBC7_RGBAUnorm_sRGB;
+        default: return MTLPixelFormatInvalid;
+    }
+}
 
-uint32_t CreateTexture(uint32_t width, uint32_t height, uint32_t mipmaps, Memory memory) {
-    if (!IsPowerOfTwo(width) || !IsPowerOfTwo(height)) return 0;
+// the layers of D3D order are Metal slices, cube faces included
+TextureHandle CreateTextureFromSubresources(const TextureDesc *desc, const Memory *subresources) {
     MTLTextureDescriptor *texDesc = [MTLTextureDescriptor new];
-    texDesc.width = width;
-    texDesc.height = height;
-    texDesc.mipmapLevelCount = mipmaps;
-    texDesc.pixelFormat = MTLPixelFormatBC1_RGBA;
+    switch (desc->dimension) {
+        case TextureDimensionTex2D: texDesc.textureType = MTLTextureType2D; break;
+        case TextureDimensionTex2DArray: texDesc.textureType = MTLTextureType2DArray; break;
+        case TextureDimensionTex3D: texDesc.textureType = MTLTextureType3D; break;
+        case TextureDimensionCube: texDesc.textureType = MTLTextureTypeCube; break;
+        case TextureDimensionCubeArray: texDesc.textureType = MTLTextureTypeCubeArray; break;
+        default: return 0;
+    }
+    texDesc.pixelFormat = ConvertTextureFormat(desc->format);
+    if (texDesc.pixelFormat == MTLPixelFormatInvalid) return 0;
+    texDesc.width = desc->width;
+    texDesc.height = desc->height;
+    texDesc.depth = desc->depth;
+    if (desc->dimension == TextureDimensionTex2DArray ||
+        desc->dimension == TextureDimensionCubeArray)
+        texDesc.arrayLength = desc->arraySize;
+    texDesc.mipmapLevelCount = desc->mipmaps;
     texDesc.storageMode = MTLStorageModeManaged;
     texDesc.usage = MTLTextureUsageShaderRead;
     id<MTLTexture> t = [g_device newTextureWithDescriptor:texDesc];
-    uint32_t w = width, h = height;
-    uint8_t *p = (uint8_t *)memory.buffer;
-    uint32_t size = 0;
-    for (int i = 0; i < mipmaps; ++i) {
-        [t replaceRegion:MTLRegionMake2D(0, 0, w, h)
-             mipmapLevel:i
-               withBytes:p
-             bytesPerRow:w * 2];  // bc1 uses 4x4 block
-        size += w * h * 2 / 4;
-        p += w * h * 2 / 4;
-        if (w > 4) w /= 2;
-        if (h > 4) h /= 2;
+    if (t == nil) return 0;
+
+    const uint32_t layers = TextureDescLayerCount(desc);
+    for (uint32_t layer = 0; layer < layers; ++layer) {
+        for (uint32_t mip = 0; mip < desc->mipmaps; ++mip) {
+            const Memory &m = subresources[layer * desc->mipmaps + mip];
+            const uint32_t w = MAX(desc->width >> mip, 1u);
+            const uint32_t h = MAX(desc->height >> mip, 1u);
+            const uint32_t d = MAX(desc->depth >> mip, 1u);
+            const uint32_t rowPitch = TextureFormatRowPitch(desc->format, w);
+            const uint32_t slicePitch = rowPitch * TextureFormatRowCount(desc->format, h);
+            assert(m.byteLength >= (size_t)slicePitch * d);
+            [t replaceRegion:MTLRegionMake3D(0, 0, 0, w, h, d)
+                 mipmapLevel:mip
+                       slice:layer
+                   withBytes:m.buffer
+                 bytesPerRow:rowPitch
+               bytesPerImage:slicePitch];
+        }
     }
-    assert(size == memory.byteLength);
+
     uint32_t idx = g_nextTexture;
     g_textures[g_nextTexture++] = t;
 
@@ -552,6 +599,9 @@ int GPUSkinning(Renderable *r) {
     return 0;
 }
 
+// meshes are still skinned one dispatch each here, see the D3D12 backend
+void GPUSkinningSubmit() {}
+
 int SimpleDraw(Transform *t, struct Renderable *r) {
     if (!r || !r->mesh || !r->material) return 1;
     Mesh *mesh = r->mesh;
@@ -663,6 +713,69 @@ int SimpleDraw(Transform *t, struct Renderable *r) {
     return 0;
 }
 
+// The render queue (render_queue.h) is not ported to this backend yet, the
+// Metal app still draws with SimpleDraw. These only say so, once each.
+#define MetalUnsupported()                                                        \
+    do {                                                                          \
+        static bool logged = false;                                               \
+        if (!logged) {                                                            \
+            logged = true;                                                        \
+            LogWriteF(LogLevelWarning, LogCategory("metal"), "%s is unsupported", \
+                      __func__);                                                  \
+        }                                                                         \
+    } while (0)
+
+// draws are skipped while it returns false
+bool BindPipeline(struct Shader *shader, uint32_t pass, uint32_t variant) {
+    MetalUnsupported();
+    return false;
+}
+
+uint32_t GetPipelineSortID(ShaderHandle vs, ShaderHandle ps) {
+    MetalUnsupported();
+    return 0;
+}
+
+void BindMaterial(struct Material *material, uint32_t pass, uint32_t variant) {
+    MetalUnsupported();
+}
+
+void BindMesh(struct Mesh *mesh, bool skinned) { MetalUnsupported(); }
+
+void DrawMesh(struct Mesh *mesh, const float4x4 *localToWorld) { MetalUnsupported(); }
+
+void BindView(const RenderView *view) { MetalUnsupported(); }
+
+void DrawMeshInstanced(struct Mesh *mesh, const float4x4 *localToWorld,
+                       uint32_t instanceCount) {
+    MetalUnsupported();
+}
+
+// shaders are built from the .metal sources with CreateShader here
+ShaderHandle CreateShaderFromCompiledFile(const char *path) {
+    MetalUnsupported();
+    return 0;
+}
+
+ShaderHandle CreateShaderFromMemory(Memory bytecode) {
+    MetalUnsupported();
+    return 0;
+}
+
+// buffers and textures are filled by the cpu before the create calls
+// return, uploads are done as soon as they are recorded
+UploadTicket GetUploadTicket() { return 0; }
+
+bool IsUploadComplete(UploadTicket ticket) { return true; }
+
+// no bindless table on this backend, materials bind their textures
+uint32_t GetTextureBindlessIndex(TextureHandle handle) {
+    if (handle != 0) MetalUnsupported();
+    return BindlessMissingTexture;
+}
+
+uint32_t GetBufferBindlessIndex(BufferHandle handle) { return 0; }
+
 void FrameEnd() {
     [encoder endEncoding];
     g_drawable = nil;
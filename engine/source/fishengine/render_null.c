@@ -0,0 +1,484 @@
+#include "render_null.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "array.h"
+#include "bindless.h"
+#include "camera.h"
+#include "frame_alloc.h"
+#include "handle_pool.h"
+#include "material.h"
+#include "mesh.h"
+#include "pipeline_cache.h"
+#include "render_queue.h"
+#include "renderable.h"
+#include "shader.h"
+#include "skinning_batch.h"
+#include "statistics.h"
+#include "upload_ring.h"
+
+extern World *defaultWorld;
+
+// same latency as the D3D12 backend, so that deferred destruction behaves
+// the same
+#define NullFramesInFlight 3
+// dynamic data is only accounted, with the sizes and alignments of the
+// D3D12 backend
+#define NullUploadRingSize ((8 << 20) * NullFramesInFlight)
+#define NullConstantAlignment 256
+
+struct NullResource {
+    uint32_t byteLength;
+    uint32_t usage;
+    uint32_t bindless;  // BindlessTable handle, textures and shader resources
+    uint64_t hash;      // shaders: PipelineHashBytes of the bytecode
+};
+typedef struct NullResource NullResource;
+
+static bool g_Recording = false;
+static array g_Commands;
+// NullResource, indexed by HandleIndex()
+static array g_Buffers;
+static array g_Textures;
+static array g_Shaders;
+static HandlePool g_BufferHandles;
+static HandlePool g_TextureHandles;
+static HandlePool g_ShaderHandles;
+static UploadRing g_UploadRing;
+static BindlessTable g_BindlessTextures;
+// compiling is free here, the cache only has keys (no blobs): what the
+// pipelines of the D3D12 backend are keyed on, and its file format
+static PipelineCache g_PipelineCache;
+static PipelineSortIDs g_PipelineSortIDs;
+// the skinning batch of the frame and the buffer it is skinned into, owned
+// by the backend like in D3D12
+static SkinningBatch g_SkinningBatch;
+static BufferHandle g_SkinnedArena = 0;
+static uint64_t g_Frame = 0;
+static float g_AspectRatio = 1280.f / 800.f;
+static bool g_ViewValid = false;
+
+static void Record(uint32_t type, uint32_t a0, uint32_t a1, uint32_t a2,
+                   const void *object) {
+    if (!g_Recording) return;
+    NullCommand *c = (NullCommand *)array_push(&g_Commands);
+    c->type = type;
+    c->args[0] = a0;
+    c->args[1] = a1;
+    c->args[2] = a2;
+    c->object = object;
+}
+
+static uint32_t NewResource(HandlePool *pool, array *table,
+                            uint32_t byteLength, uint32_t usage) {
+    if (table->ptr == NULL) {
+        HandlePoolInit(&g_BufferHandles, "buffer");
+        HandlePoolInit(&g_TextureHandles, "texture");
+        HandlePoolInit(&g_ShaderHandles, "shader");
+        array_init(&g_Buffers, sizeof(NullResource), 1024);
+        array_init(&g_Textures, sizeof(NullResource), 1024);
+        array_init(&g_Shaders, sizeof(NullResource), 1024);
+        BindlessTableInit(&g_BindlessTextures, BindlessMaxTextures);
+    }
+    uint32_t handle = HandlePoolAlloc(pool);
+    uint32_t slotCount = HandlePoolGetSlotCount(pool);
+    if (table->size < slotCount) array_resize(table, slotCount);
+    NullResource *r = (NullResource *)array_at(table, HandleIndex(handle));
+    r->byteLength = byteLength;
+    r->usage = usage;
+    r->bindless = 0;
+    r->hash = 0;
+    return handle;
+}
+
+static NullResource *GetResource(HandlePool *pool, array *table,
+                                 uint32_t handle) {
+    assert(HandlePoolIsAlive(pool, handle));
+    return (NullResource *)array_at(table, HandleIndex(handle));
+}
+
+void NullSetRecording(bool enabled) {
+    if (enabled && g_Commands.ptr == NULL)
+        array_init(&g_Commands, sizeof(NullCommand), 1024);
+    g_Recording = enabled;
+}
+
+const NullCommand *NullGetCommands(uint32_t *count) {
+    *count = g_Commands.size;
+    return (const NullCommand *)g_Commands.ptr;
+}
+
+static void AllocateDynamic(uint32_t size, uint32_t alignment) {
+    if (g_UploadRing.capacity == 0)
+        UploadRingInit(&g_UploadRing, NullUploadRingSize);
+    UploadRingAlloc(&g_UploadRing, size, alignment);
+    g_statistics.gpu.dynamicUploadSize += size;
+}
+
+const UploadRing *NullGetUploadRing() { return &g_UploadRing; }
+
+const BindlessTable *NullGetBindlessTable() { return &g_BindlessTextures; }
+
+PipelineCache *NullGetPipelineCache() {
+    if (g_PipelineCache.entries.ptr == NULL)
+        PipelineCacheInit(&g_PipelineCache, NullPipelineCacheDeviceId);
+    return &g_PipelineCache;
+}
+
+void NullSetViewport(uint32_t width, uint32_t height) {
+    if (width > 0 && height > 0) g_AspectRatio = (float)width / height;
+    TextureStreamingSetViewportHeight(height);
+}
+
+uint32_t NullReportLiveResources() {
+    if (g_Buffers.ptr == NULL) return 0;
+    // the backend's own buffer is not a leak
+    DeleteBuffer(g_SkinnedArena);
+    g_SkinnedArena = 0;
+    return HandlePoolReportLeaks(&g_BufferHandles) +
+           HandlePoolReportLeaks(&g_TextureHandles) +
+           HandlePoolReportLeaks(&g_ShaderHandles);
+}
+
+BufferHandle CreateBuffer(Memory memory, GPUResourceUsageFlags usage) {
+    assert(memory.byteLength > 0);
+    BufferHandle handle = NewResource(&g_BufferHandles, &g_Buffers,
+                                      (uint32_t)memory.byteLength, usage);
+    if (usage & GPUResourceUsageShaderResource) {
+        NullResource *b = GetResource(&g_BufferHandles, &g_Buffers, handle);
+        b->bindless = BindlessTableAlloc(&g_BindlessTextures);
+        g_statistics.gpu.bindlessTextureCount =
+            BindlessTableGetCount(&g_BindlessTextures);
+    }
+    g_statistics.gpu.bufferCount++;
+    g_statistics.gpu.bufferSize += memory.byteLength;
+    Record(NullCommandCreateBuffer, handle, (uint32_t)memory.byteLength, usage,
+           NULL);
+    if (memory.buffer != NULL) {
+        Record(NullCommandUpload, handle, (uint32_t)memory.byteLength, 0,
+               NULL);
+        g_statistics.gpu.staticUploadSize += memory.byteLength;
+    }
+    return handle;
+}
+
+// a resized buffer gets a new view, so a new bindless slot as well
+static void GrowBuffer(NullResource *b, uint32_t byteLength) {
+    g_statistics.gpu.bufferSize -= b->byteLength;
+    b->byteLength = byteLength;
+    g_statistics.gpu.bufferSize += b->byteLength;
+    if (b->bindless != 0) {
+        BindlessTableRelease(&g_BindlessTextures, b->bindless, g_Frame);
+        b->bindless = BindlessTableAlloc(&g_BindlessTextures);
+    }
+}
+
+void UpdateBuffer(BufferHandle handle, Memory memory) {
+    NullResource *b = GetResource(&g_BufferHandles, &g_Buffers, handle);
+    if (memory.byteLength > b->byteLength) GrowBuffer(b, memory.byteLength);
+    Record(NullCommandUpload, handle, (uint32_t)memory.byteLength, 0, NULL);
+    g_statistics.gpu.staticUploadSize += memory.byteLength;
+}
+
+uint32_t GetBufferBindlessIndex(BufferHandle handle) {
+    if (handle == 0) return 0;
+    return HandleIndex(
+        GetResource(&g_BufferHandles, &g_Buffers, handle)->bindless);
+}
+
+void DeleteBuffer(BufferHandle handle) {
+    if (handle == 0) return;
+    NullResource *b = GetResource(&g_BufferHandles, &g_Buffers, handle);
+    g_statistics.gpu.bufferCount--;
+    g_statistics.gpu.bufferSize -= b->byteLength;
+    Record(NullCommandDeleteBuffer, handle, b->byteLength, 0, NULL);
+    if (b->bindless != 0) {
+        BindlessTableRelease(&g_BindlessTextures, b->bindless, g_Frame);
+        g_statistics.gpu.bindlessTextureCount =
+            BindlessTableGetCount(&g_BindlessTextures);
+    }
+    HandlePoolRelease(&g_BufferHandles, handle, g_Frame);
+}
+
+// nothing is uploaded, only the size is what a real backend would allocate
+TextureHandle CreateTextureFromSubresources(const TextureDesc *desc,
+                                            const Memory *subresources) {
+    if (TextureFormatBlockSize(desc->format) == 0) return 0;
+    const uint32_t count = TextureDescSubresourceCount(desc);
+    uint32_t byteLength = 0;
+    for (uint32_t i = 0; i < count; ++i)
+        byteLength += (uint32_t)subresources[i].byteLength;
+    uint32_t handle =
+        NewResource(&g_TextureHandles, &g_Textures, byteLength, 0);
+    NullResource *t = GetResource(&g_TextureHandles, &g_Textures, handle);
+    // the bindless table is Texture2D[], see render_d3d12.cpp
+    if (desc->dimension == TextureDimensionTex2D) {
+        t->bindless = BindlessTableAlloc(&g_BindlessTextures);
+        g_statistics.gpu.bindlessTextureCount =
+            BindlessTableGetCount(&g_BindlessTextures);
+    }
+    g_statistics.gpu.textureCount++;
+    g_statistics.gpu.textureSize += byteLength;
+    Record(NullCommandCreateTexture, handle, byteLength, desc->mipmaps, NULL);
+    g_statistics.gpu.staticUploadSize += byteLength;
+    return handle;
+}
+
+void DeleteTexture(uint32_t textureID) {
+    if (textureID == 0) return;
+    NullResource *t = GetResource(&g_TextureHandles, &g_Textures, textureID);
+    g_statistics.gpu.textureCount--;
+    g_statistics.gpu.textureSize -= t->byteLength;
+    Record(NullCommandDeleteTexture, textureID, t->byteLength, 0, NULL);
+    BindlessTableRelease(&g_BindlessTextures, t->bindless, g_Frame);
+    t->bindless = 0;
+    g_statistics.gpu.bindlessTextureCount =
+        BindlessTableGetCount(&g_BindlessTextures);
+    HandlePoolRelease(&g_TextureHandles, textureID, g_Frame);
+}
+
+uint32_t GetTextureBindlessIndex(TextureHandle handle) {
+    if (handle == 0) return BindlessMissingTexture;
+    NullResource *t = GetResource(&g_TextureHandles, &g_Textures, handle);
+    return HandleIndex(t->bindless);
+}
+
+ShaderHandle CreateShader(const char *path, const char *vs_name,
+                          const char *ps_name) {
+    return 0;
+}
+
+// the bytecode is only hashed, for the pipeline keys
+ShaderHandle CreateShaderFromCompiledFile(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        printf("[null] shader not found: %s\n", path);
+        return 0;
+    }
+    uint64_t hash = PipelineHashSeed;
+    uint32_t byteLength = 0;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        hash = PipelineHashBytes(buffer, n, hash);
+        byteLength += (uint32_t)n;
+    }
+    fclose(f);
+    ShaderHandle handle =
+        NewResource(&g_ShaderHandles, &g_Shaders, byteLength, 0);
+    GetResource(&g_ShaderHandles, &g_Shaders, handle)->hash = hash;
+    return handle;
+}
+
+ShaderHandle CreateShaderFromMemory(Memory bytecode) {
+    ShaderHandle handle = NewResource(&g_ShaderHandles, &g_Shaders,
+                                      (uint32_t)bytecode.byteLength, 0);
+    GetResource(&g_ShaderHandles, &g_Shaders, handle)->hash =
+        PipelineHashBytes(bytecode.buffer, bytecode.byteLength,
+                          PipelineHashSeed);
+    return handle;
+}
+
+void DeleteShader(uint32_t shaderID) {
+    if (shaderID == 0) return;
+    if (g_PipelineSortIDs.pairs.ptr != NULL)
+        PipelineSortIDsRelease(&g_PipelineSortIDs, shaderID);
+    HandlePoolRelease(&g_ShaderHandles, shaderID, g_Frame);
+}
+
+// uploads are "submitted" at the end of the frame they were recorded in
+UploadTicket GetUploadTicket() { return g_Frame; }
+
+bool IsUploadComplete(UploadTicket ticket) {
+    return g_Frame >= NullFramesInFlight &&
+           ticket <= g_Frame - NullFramesInFlight;
+}
+
+void BeginRenderEvent(const char *label) {}
+void EndRenderEvent() {}
+
+void FrameBegin() {
+    FrameAllocReset();
+    // nothing to destroy, but slots are recycled on the same schedule as on
+    // a gpu
+    g_Frame++;
+    if (g_Frame >= NullFramesInFlight) {
+        uint64_t completed = g_Frame - NullFramesInFlight;
+        if (g_Buffers.ptr != NULL) {
+            HandlePoolCollect(&g_BufferHandles, completed, NULL, NULL);
+            HandlePoolCollect(&g_TextureHandles, completed, NULL, NULL);
+            HandlePoolCollect(&g_ShaderHandles, completed, NULL, NULL);
+            BindlessTableCollect(&g_BindlessTextures, completed);
+        }
+        UploadRingRetire(&g_UploadRing, completed);
+    }
+    g_Commands.size = 0;
+    g_ViewValid = false;
+    g_statistics.gpu.drawCall = 0;
+    g_statistics.gpu.pipelineChanges = 0;
+    g_statistics.gpu.materialChanges = 0;
+    g_statistics.gpu.meshChanges = 0;
+    g_statistics.gpu.redundantBindsSkipped = 0;
+    g_statistics.gpu.instancedDrawCall = 0;
+    g_statistics.gpu.instanceCount = 0;
+    g_statistics.gpu.dynamicUploadSize = 0;
+    g_statistics.gpu.staticUploadSize = 0;
+    g_statistics.gpu.drawsSkipped = 0;
+    g_statistics.gpu.skinningDispatches = 0;
+    g_statistics.gpu.skinnedVertices = 0;
+}
+
+void FrameEnd() {
+    if (g_UploadRing.capacity != 0) UploadRingEndFrame(&g_UploadRing, g_Frame);
+}
+
+void BeginPass() {}
+
+// camera and lighting constants
+void BindView(const RenderView *view) {
+    AllocateDynamic(sizeof(float4x4) * 4 + sizeof(float4) * 2,
+                    NullConstantAlignment);
+    AllocateDynamic(sizeof(float4) * 2, NullConstantAlignment);
+    g_ViewValid = true;
+    Record(NullCommandBindView, 0, 0, 0, view);
+}
+
+// the same description as the D3D12 backend, with its back buffer formats
+// (DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_D32_FLOAT_S8X24_UINT)
+bool BindPipeline(Shader *shader, uint32_t pass, uint32_t variant) {
+    ShaderHandle vs, ps;
+    PipelineDesc desc;
+    memset(&desc, 0, sizeof(desc));
+    ShaderGetPipelineInputs(shader, pass, variant, &vs, &ps, &desc.state);
+    // a stage that failed to load (its .cso is missing) has no pipeline,
+    // the draws are skipped like a pipeline D3D12 could not create
+    if (vs == 0 || ps == 0) return false;
+    desc.vsHash = GetResource(&g_ShaderHandles, &g_Shaders, vs)->hash;
+    desc.psHash = GetResource(&g_ShaderHandles, &g_Shaders, ps)->hash;
+    desc.vertexLayoutHash =
+        PipelineVertexLayoutHash(MeshVertexLayout, MeshVertexLayoutCount);
+    desc.colorFormat = 28;
+    desc.depthFormat = 20;
+    desc.sampleCount = 1;
+
+    PipelineCache *cache = NullGetPipelineCache();
+    PipelineCacheEntry *e = PipelineCacheFind(cache, PipelineDescHash(&desc));
+    if (e == NULL || !(e->flags & PipelineCacheEntryUsed)) {
+        // first use in this session; an entry without the flag came from
+        // the file
+        if (e != NULL) g_statistics.gpu.pipelineCacheHits++;
+        g_statistics.gpu.pipelineCount++;
+        PipelineCacheStore(cache, &desc, NULL, 0);
+    }
+    Record(NullCommandBindPipeline, pass, variant, 0, shader);
+    return true;
+}
+
+uint32_t GetPipelineSortID(ShaderHandle vs, ShaderHandle ps) {
+    if (g_PipelineSortIDs.pairs.ptr == NULL)
+        PipelineSortIDsInit(&g_PipelineSortIDs);
+    return PipelineSortIDsGet(&g_PipelineSortIDs, vs, ps);
+}
+
+// the constants are built for real, with the bindless slots of the
+// material's textures
+void BindMaterial(Material *material, uint32_t pass, uint32_t variant) {
+    uint32_t size = MaterialBuildConstants(material, pass, variant, NULL);
+    void *constants = FrameAlloc(0, size, 16);
+    memset(constants, 0, size);
+    MaterialBuildConstants(material, pass, variant, constants);
+    AllocateDynamic(size, NullConstantAlignment);
+    Record(NullCommandBindMaterial, pass, variant, size, material);
+}
+
+void BindMesh(Mesh *mesh, bool skinned) {
+    Record(NullCommandBindMesh, skinned, mesh->vb, mesh->ib, mesh);
+}
+
+void DrawMesh(Mesh *mesh, const float4x4 *localToWorld) {
+    AllocateDynamic(sizeof(float4x4) * 4, NullConstantAlignment);
+    Record(NullCommandDraw, MeshGetIndexCount(mesh), 1, 0, mesh);
+    g_statistics.gpu.drawCall++;
+}
+
+void DrawMeshInstanced(Mesh *mesh, const float4x4 *localToWorld,
+                       uint32_t instanceCount) {
+    // InstanceData: MATRIX_M and MATRIX_IT_M
+    AllocateDynamic(sizeof(float4x4) * 2 * instanceCount, 16);
+    Record(NullCommandDrawInstanced, MeshGetIndexCount(mesh), instanceCount, 0,
+           mesh);
+    g_statistics.gpu.drawCall++;
+    g_statistics.gpu.instancedDrawCall++;
+    g_statistics.gpu.instanceCount += instanceCount;
+}
+
+// same checks as the D3D12 SimpleDraw; the passes are issued through a one
+// renderable queue since variant selection lives on the C++ side
+int SimpleDraw(Transform *t, struct Renderable *r) {
+    if (!t || !r || !r->mesh || !r->material || !r->material->shader) return 0;
+    if (CameraGetMainCamera(defaultWorld) == NULL) return 1;
+    bool skinned = r->skin && (r->mesh->sb != 0) && (r->mesh->skinnedvb != 0);
+    if (!skinned && r->mesh->vb == 0) return 1;
+
+    BeginPass();
+    // the view is set up on the first draw of the frame only
+    static RenderView view;
+    if (!g_ViewValid) {
+        RenderViewSetup(&view, defaultWorld, g_AspectRatio);
+        BindView(&view);
+    }
+
+    static RenderQueue queue;
+    if (queue.packets.ptr == NULL) RenderQueueInit(&queue);
+    float4x4 l2w = TransformGetLocalToWorldMatrix(defaultWorld, t);
+    RenderQueueClear(&queue);
+    RenderQueueAdd(&queue, r, &l2w, 0);
+    RenderQueueSubmit(&queue);
+    return 0;
+}
+
+// builds the same batch as the D3D12 backend; the dispatch writes the jobs
+// and the bone palette to the upload ring and is recorded once per frame
+int GPUSkinning(struct Renderable *r) {
+    assert(r && r->skin && r->mesh);
+    if (!(r && r->skin && r->mesh)) return 1;
+    Mesh *mesh = r->mesh;
+    const uint32_t sourceVertices = GetBufferBindlessIndex(mesh->vb);
+    const uint32_t sourceSkin = GetBufferBindlessIndex(mesh->sb);
+    if (sourceVertices == 0 || sourceSkin == 0) {
+        mesh->skinnedvb = 0;
+        return 1;
+    }
+    if (g_SkinningBatch.jobs.ptr == NULL) SkinningBatchInit(&g_SkinningBatch);
+    const uint32_t vertexCount = MeshGetVertexCount(mesh);
+    mesh->skinnedOffset = SkinningBatchAdd(
+        &g_SkinningBatch, vertexCount, (const float4x4 *)r->skin->boneMats.ptr,
+        r->skin->boneMats.size, sourceVertices, sourceSkin);
+    if (g_SkinnedArena == 0) {
+        Memory m = {0};
+        m.byteLength = vertexCount * sizeof(Vertex);
+        g_SkinnedArena = CreateBuffer(m, GPUResourceUsageUnorderedAccess);
+    }
+    mesh->skinnedvb = g_SkinnedArena;
+    return 0;
+}
+
+void GPUSkinningSubmit() {
+    SkinningBatch *batch = &g_SkinningBatch;
+    if (batch->jobs.ptr == NULL || batch->jobs.size == 0) return;
+    NullResource *arena =
+        GetResource(&g_BufferHandles, &g_Buffers, g_SkinnedArena);
+    const uint32_t arenaSize = batch->vertexCount * sizeof(Vertex);
+    if (arenaSize > arena->byteLength) {
+        uint32_t size = arena->byteLength * 2;
+        GrowBuffer(arena, size > arenaSize ? size : arenaSize);
+    }
+    AllocateDynamic(array_get_bytelength(&batch->jobs), 16);
+    AllocateDynamic(array_get_bytelength(&batch->palette), 16);
+    Record(NullCommandDispatch, batch->groupCount, 1, 1, batch->jobs.ptr);
+    g_statistics.gpu.skinningDispatches++;
+    g_statistics.gpu.skinnedVertices = batch->vertexCount;
+    SkinningBatchClear(batch);
+}
@@ -0,0 +1,67 @@
+#ifndef RENDER_NULL_H
+#define RENDER_NULL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bindless.h"
+#include "pipeline_cache.h"
+#include "rhi.h"
+#include "upload_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Headless rhi backend. Nothing reaches a GPU; the backend keeps handle
+// tables with the byte size of every buffer, texture and shader (accounted in
+// g_statistics like the real backends do) and, when recording is on, a
+// compact stream of the commands the renderer issued.
+
+enum NullCommandType {
+    NullCommandBindPipeline = 0,
+    NullCommandBindMaterial,  // args: pass, variant, constant bytes
+    NullCommandBindMesh,
+    NullCommandDraw,
+    NullCommandBindView,
+    NullCommandDrawInstanced,
+    NullCommandCreateBuffer,   // args: handle, byteLength, usage
+    NullCommandDeleteBuffer,   // args: handle, byteLength
+    NullCommandUpload,         // args: buffer handle, byteLength
+    NullCommandCreateTexture,  // args: handle, byteLength, mipmaps
+    NullCommandDeleteTexture,  // args: handle, byteLength
+    NullCommandDispatch,       // args: groups x, y, z; object: the jobs
+};
+
+struct NullCommand {
+    uint32_t type;
+    uint32_t args[3];
+    const void *object;
+};
+typedef struct NullCommand NullCommand;
+
+void FrameBegin();
+void FrameEnd();
+
+void NullSetRecording(bool enabled);
+// commands recorded since the last FrameBegin
+const NullCommand *NullGetCommands(uint32_t *count);
+// aspect ratio of the imaginary back buffer, used by SimpleDraw
+void NullSetViewport(uint32_t width, uint32_t height);
+// accounting of the per-frame dynamic data (constants, instances, bones)
+const UploadRing *NullGetUploadRing();
+// slots of the bindless texture table
+const BindlessTable *NullGetBindlessTable();
+// every pipeline the renderer asked for, keyed like on D3D12; load it before
+// the first frame to count how many of them a previous run already had
+#define NullPipelineCacheDeviceId 0x6c6c756eull  // "null"
+PipelineCache *NullGetPipelineCache();
+// prints every buffer, texture and shader that is still alive, returns the
+// count
+uint32_t NullReportLiveResources();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RENDER_NULL_H */
@@ -0,0 +1,322 @@
+#include "render_queue.h"
+
+#include "camera.h"
+#include "light.h"
+#include "material_internal.hpp"
+#include "rhi.h"
+#include "shader_internal.hpp"
+#include "statistics.h"
+#include "texture.h"
+
+void RenderQueueInit(RenderQueue *q) {
+    array_init(&q->packets, sizeof(RenderPacket), 256);
+    array_init(&q->items, sizeof(RenderSortItem), 256);
+    array_init(&q->scratch, sizeof(RenderSortItem), 256);
+    array_init(&q->instances, sizeof(float4x4), 64);
+    array_init(&q->candidates, sizeof(Renderable *), 256);
+    CullingGroupInit(&q->culling);
+}
+
+void RenderQueueFree(RenderQueue *q) {
+    array_free(&q->packets);
+    array_free(&q->items);
+    array_free(&q->scratch);
+    array_free(&q->instances);
+    array_free(&q->candidates);
+    CullingGroupFree(&q->culling);
+}
+
+void RenderQueueClear(RenderQueue *q) {
+    q->packets.size = 0;
+    q->items.size = 0;
+}
+
+static ShaderVariant &GetVariant(Material *mat, uint32_t pass,
+                                 uint32_t variant) {
+    return ShaderGetImpl(mat->shader)->passes[pass].variants[variant];
+}
+
+void RenderQueueAdd(RenderQueue *q, Renderable *r, const float4x4 *l2w,
+                    float depth) {
+    Material *mat = r->material;
+    const uint32_t maxDepth = (1u << RenderKeyDepthBits) - 1;
+    depth = depth < 0 ? 0 : (depth > 1 ? 1 : depth);
+    uint32_t depthBucket = (uint32_t)(depth * maxDepth);
+    for (uint32_t pass = 0; pass < mat->shader->passCount; ++pass) {
+        uint32_t variant = MaterialGetVariantIndex(mat, pass);
+        RenderPacket *p = (RenderPacket *)array_push(&q->packets);
+        p->localToWorld = *l2w;
+        p->renderable = r;
+        p->pass = pass;
+        p->variant = variant;
+
+        const ShaderVariant &var = GetVariant(mat, pass, variant);
+        uint32_t pipeline =
+            GetPipelineSortID(var.vertexShader, var.pixelShader);
+        RenderSortItem *item = (RenderSortItem *)array_push(&q->items);
+        item->key = RenderKeyMake(pass, pipeline, mat->assetID, depthBucket,
+                                  r->mesh->assetID);
+        item->index = q->packets.size - 1;
+    }
+}
+
+bool RenderViewSetup(RenderView *view, World *w, float aspect) {
+    Camera *camera = CameraGetMainCamera(w);
+    if (camera == NULL) return false;
+    Transform *t = (Transform *)ComponentGetSiblingComponent(w, camera, CameraID,
+                                                             TransformID);
+    view->cameraPos = TransformGetPosition(w, t);
+    view->cameraDir = TransformGetForward(w, t);
+    float3 up = TransformGetUp(w, t);
+    view->view = float4x4_look_to(view->cameraPos, view->cameraDir, up);
+    view->fieldOfView = camera->fieldOfView;
+    view->nearClipPlane = camera->nearClipPlane;
+    view->farClipPlane = camera->farClipPlane;
+    view->projection = float4x4_perspective(
+        camera->fieldOfView, aspect, camera->nearClipPlane, camera->farClipPlane);
+
+    view->lightPos = float3_zero;
+    view->lightDir = float3_up;
+    Light *light = (Light *)WorldGetComponentAt(w, LightID, 0);
+    if (light) {
+        Transform *lt = (Transform *)ComponentGetSiblingComponent(
+            w, light, LightID, TransformID);
+        view->lightPos = TransformGetPosition(w, lt);
+        view->lightDir = float3_negate(TransformGetForward(w, lt));
+    }
+    return true;
+}
+
+static void AddRenderable(RenderQueue *q, World *w, Renderable *r,
+                          Transform *t, const RenderView *view) {
+    float4x4 l2w = TransformGetLocalToWorldMatrix(w, t);
+    float3 pos = {l2w.m03, l2w.m13, l2w.m23};
+    float depth =
+        float3_dot(float3_subtract(pos, view->cameraPos), view->cameraDir);
+    RenderQueueAdd(q, r, &l2w, depth / view->farClipPlane);
+}
+
+void RenderQueueGather(RenderQueue *q, World *w, const RenderView *view) {
+    CullingGroupClear(&q->culling);
+    q->candidates.size = 0;
+    uint32_t skinned = 0;
+
+    ComponentArray *a = w->componentArrays + RenderableID;
+    Renderable *r = (Renderable *)a->m.ptr;
+    for (uint32_t i = 0; i < a->m.size; ++i, ++r) {
+        if (!r->mesh || !r->material || !r->material->shader) continue;
+        if (r->mesh->vb == 0) continue;
+        Transform *t = (Transform *)ComponentGetSiblingComponent(
+            w, r, RenderableID, TransformID);
+        if (!t) continue;
+        // mesh bounds are in bind pose
+        if (r->skin) {
+            AddRenderable(q, w, r, t, view);
+            skinned++;
+            continue;
+        }
+        RenderableUpdateWorldBounds(r, w, t);
+        CullingGroupAdd(&q->culling, r->worldBounds);
+        *(Renderable **)array_push(&q->candidates) = r;
+    }
+
+    Frustum frustum;
+    float4x4 viewProj = float4x4_mul(view->projection, view->view);
+    FrustumFromMatrix(&frustum, &viewProj);
+    const uint32_t visibleCount = CullingGroupCull(&q->culling, &frustum);
+    const uint32_t *visible = (const uint32_t *)q->culling.visible.ptr;
+    Renderable **candidates = (Renderable **)q->candidates.ptr;
+    for (uint32_t i = 0; i < visibleCount; ++i) {
+        Renderable *c = candidates[visible[i]];
+        Transform *t = (Transform *)ComponentGetSiblingComponent(
+            w, c, RenderableID, TransformID);
+        AddRenderable(q, w, c, t, view);
+    }
+    g_statistics.cpu.visibleRenderables = visibleCount + skinned;
+    g_statistics.cpu.culledRenderables = q->candidates.size - visibleCount;
+}
+
+void RenderQueueSort(RenderQueue *q) {
+    const uint32_t n = q->items.size;
+    if (n < 2) return;
+    array_resize(&q->scratch, n);
+    RenderSortItem *src = (RenderSortItem *)q->items.ptr;
+    RenderSortItem *dst = (RenderSortItem *)q->scratch.ptr;
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        uint32_t count[256] = {0};
+        for (uint32_t i = 0; i < n; ++i) count[(src[i].key >> shift) & 0xFF]++;
+        // every key has the same digit, nothing to move
+        if (count[(src[0].key >> shift) & 0xFF] == n) continue;
+        uint32_t offset = 0;
+        for (uint32_t d = 0; d < 256; ++d) {
+            uint32_t c = count[d];
+            count[d] = offset;
+            offset += c;
+        }
+        for (uint32_t i = 0; i < n; ++i)
+            dst[count[(src[i].key >> shift) & 0xFF]++] = src[i];
+        RenderSortItem *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != q->items.ptr) {
+        // odd number of scatter passes, result is in scratch
+        array tmp = q->items;
+        q->items = q->scratch;
+        q->scratch = tmp;
+    }
+}
+
+static bool IsSkinned(const Renderable *r) {
+    return r->skin && r->mesh->sb != 0 && r->mesh->skinnedvb != 0;
+}
+
+static bool SameBatch(const RenderPacket *a, const RenderPacket *b) {
+    const Renderable *ra = a->renderable, *rb = b->renderable;
+    return a->pass == b->pass && a->variant == b->variant &&
+           ra->material == rb->material && ra->mesh == rb->mesh &&
+           IsSkinned(ra) == IsSkinned(rb);
+}
+
+void RenderQueueSubmit(RenderQueue *q) {
+    const RenderSortItem *items = (const RenderSortItem *)q->items.ptr;
+    const RenderPacket *packets = (const RenderPacket *)q->packets.ptr;
+    const uint32_t n = q->items.size;
+
+    ShaderHandle lastVS = 0, lastPS = 0;
+    Material *lastMaterial = NULL;
+    uint32_t lastPass = UINT32_MAX;
+    Mesh *lastMesh = NULL;
+    bool lastSkinned = false;
+
+    for (uint32_t i = 0; i < n;) {
+        const RenderPacket *p = packets + items[i].index;
+        Renderable *r = p->renderable;
+        Material *mat = r->material;
+        Mesh *mesh = r->mesh;
+
+        uint32_t end = i + 1;
+        while (end < n && SameBatch(p, packets + items[end].index)) ++end;
+        const uint32_t count = end - i;
+
+        uint32_t variant = p->variant;
+        ShaderVariant *var = &GetVariant(mat, p->pass, variant);
+        const bool instanced =
+            count >= RenderQueueMinInstances && var->instancedVariant >= 0;
+        if (instanced) {
+            variant = (uint32_t)var->instancedVariant;
+            var = &GetVariant(mat, p->pass, variant);
+        }
+
+        bool pipelineChanged =
+            var->vertexShader != lastVS || var->pixelShader != lastPS;
+        if (pipelineChanged) {
+            if (!BindPipeline(mat->shader, p->pass, variant)) {
+                // not compiled yet, the run shows up in a later frame
+                g_statistics.gpu.drawsSkipped += count;
+                lastVS = lastPS = 0;
+                i = end;
+                continue;
+            }
+            lastVS = var->vertexShader;
+            lastPS = var->pixelShader;
+            g_statistics.gpu.pipelineChanges++;
+        } else {
+            g_statistics.gpu.redundantBindsSkipped++;
+        }
+
+        // material bindings follow the variant's reflection, so a new
+        // pipeline always rebinds them
+        if (pipelineChanged || mat != lastMaterial || p->pass != lastPass) {
+            BindMaterial(mat, p->pass, variant);
+            lastMaterial = mat;
+            lastPass = p->pass;
+            g_statistics.gpu.materialChanges++;
+        } else {
+            g_statistics.gpu.redundantBindsSkipped++;
+        }
+
+        bool skinned = IsSkinned(r);
+        if (mesh != lastMesh || skinned != lastSkinned) {
+            BindMesh(mesh, skinned);
+            lastMesh = mesh;
+            lastSkinned = skinned;
+            g_statistics.gpu.meshChanges++;
+        } else {
+            g_statistics.gpu.redundantBindsSkipped++;
+        }
+
+        if (instanced) {
+            array_resize(&q->instances, count);
+            float4x4 *matrices = (float4x4 *)q->instances.ptr;
+            for (uint32_t k = 0; k < count; ++k)
+                matrices[k] = packets[items[i + k].index].localToWorld;
+            DrawMeshInstanced(mesh, matrices, count);
+        } else {
+            // all three binds are shared by the rest of the run
+            g_statistics.gpu.redundantBindsSkipped += 3 * (count - 1);
+            for (uint32_t k = i; k < end; ++k)
+                DrawMesh(mesh, &packets[items[k].index].localToWorld);
+        }
+        i = end;
+    }
+}
+
+// asks texture streaming for the mips the visible renderables need, from
+// the size of their bounding spheres on screen
+static void RequestTextureMips(RenderQueue *q, const RenderView *view) {
+    const RenderPacket *packets = (const RenderPacket *)q->packets.ptr;
+    Texture *textures[16];
+    for (uint32_t i = 0; i < q->packets.size; ++i) {
+        const RenderPacket *p = packets + i;
+        if (p->pass != 0) continue;  // once per renderable
+        const Renderable *r = p->renderable;
+        float3 center = r->worldBounds.center;
+        float radius = float3_length(r->worldBounds.extents);
+        if (r->skin) {
+            // skinned renderables skip culling, their world bounds are stale
+            float3 origin = {p->localToWorld.m03, p->localToWorld.m13,
+                             p->localToWorld.m23};
+            center = origin;
+            radius = r->mesh->boundingRadius;
+        }
+        float distance =
+            float3_length(float3_subtract(center, view->cameraPos));
+        float size =
+            TextureStreamingScreenSize(radius, distance, view->fieldOfView);
+        uint32_t n = MaterialGetTextures(r->material, textures,
+                                         (uint32_t)countof(textures));
+        for (uint32_t k = 0; k < n; ++k)
+            TextureStreamingRequest(textures[k], size);
+    }
+}
+
+bool RenderQueueRenderWorld(RenderQueue *q, World *w, float aspect) {
+    ComponentArray *a = w->componentArrays + RenderableID;
+    Renderable *renderables = (Renderable *)a->m.ptr;
+    for (uint32_t i = 0; i < a->m.size; ++i) {
+        Renderable *r = renderables + i;
+        if (r->mesh && !MeshIsUploaded(r->mesh)) MeshUploadMeshData(r->mesh);
+    }
+    for (uint32_t i = 0; i < a->m.size; ++i) {
+        Renderable *r = renderables + i;
+        if (r->skin) {
+            RenderableUpdateBones(r, w);
+            GPUSkinning(r);
+        }
+    }
+    GPUSkinningSubmit();
+
+    RenderView view;
+    if (!RenderViewSetup(&view, w, aspect)) return false;
+    RenderQueueClear(q);
+    RenderQueueGather(q, w, &view);
+    RequestTextureMips(q, &view);
+    RenderQueueSort(q);
+    BeginPass();
+    BindView(&view);
+    RenderQueueSubmit(q);
+    // new mips are bound from the next frame on
+    TextureStreamingUpdate();
+    return true;
+}
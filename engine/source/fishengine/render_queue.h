@@ -0,0 +1,99 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <stdint.h>
+
+#include "array.h"
+#include "culling.h"
+#include "ecs.h"
+#include "renderable.h"
+#include "rhi.h"
+#include "transform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// sort key, from the most significant bits:
+// | pass 4 | pipeline 16 | material 16 | mesh 16 | depth 12 |
+// mesh comes before depth so that repeated mesh+material pairs end up next
+// to each other and can be drawn instanced
+#define RenderKeyPassBits 4
+#define RenderKeyPipelineBits 16
+#define RenderKeyMaterialBits 16
+#define RenderKeyMeshBits 16
+#define RenderKeyDepthBits 12
+
+// smallest run of identical packets that is drawn instanced
+#define RenderQueueMinInstances 2
+
+static inline uint64_t RenderKeyMake(uint32_t pass, uint32_t pipeline,
+                                     uint32_t material, uint32_t depth,
+                                     uint32_t mesh) {
+    uint64_t key = pass & ((1u << RenderKeyPassBits) - 1);
+    key = (key << RenderKeyPipelineBits) |
+          (pipeline & ((1u << RenderKeyPipelineBits) - 1));
+    key = (key << RenderKeyMaterialBits) |
+          (material & ((1u << RenderKeyMaterialBits) - 1));
+    key = (key << RenderKeyMeshBits) |
+          (mesh & ((1u << RenderKeyMeshBits) - 1));
+    key = (key << RenderKeyDepthBits) |
+          (depth & ((1u << RenderKeyDepthBits) - 1));
+    return key;
+}
+
+struct RenderPacket {
+    float4x4 localToWorld;
+    Renderable *renderable;
+    uint32_t pass;
+    uint32_t variant;
+};
+typedef struct RenderPacket RenderPacket;
+
+struct RenderSortItem {
+    uint64_t key;
+    uint32_t index;  // into RenderQueue.packets
+};
+typedef struct RenderSortItem RenderSortItem;
+
+struct RenderQueue {
+    array packets;  // RenderPacket
+    array items;    // RenderSortItem, sorted by RenderQueueSort
+    array scratch;  // RenderSortItem
+    array instances;  // float4x4, matrices of the current instanced draw
+    array candidates;  // Renderable*, one per bounds in culling
+    CullingGroup culling;
+};
+typedef struct RenderQueue RenderQueue;
+
+void RenderQueueInit(RenderQueue *q);
+void RenderQueueFree(RenderQueue *q);
+void RenderQueueClear(RenderQueue *q);
+
+void RenderQueueAdd(RenderQueue *q, Renderable *r, const float4x4 *l2w,
+                    float depth);
+// fills the view from the main camera and the first light, returns false if
+// the world has no camera
+bool RenderViewSetup(RenderView *view, World *w, float aspect);
+
+// one packet per shader pass of every drawable Renderable in the world whose
+// world bounds intersect the view frustum (skinned ones are never culled);
+// depth is measured along the view's forward axis
+void RenderQueueGather(RenderQueue *q, World *w, const RenderView *view);
+// LSD radix sort on the 64-bit keys
+void RenderQueueSort(RenderQueue *q);
+// issues the sorted packets through the rhi, skipping redundant binds; runs
+// of packets sharing pass, variant, material, mesh and skin state become one
+// instanced draw when the shader has an INSTANCING_ON variant
+void RenderQueueSubmit(RenderQueue *q);
+
+// the whole frame of a world: uploads new meshes, skins, then gathers, sorts
+// and submits everything the main camera sees; returns false if the world
+// has no camera
+bool RenderQueueRenderWorld(RenderQueue *q, World *w, float aspect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RENDER_QUEUE_H */
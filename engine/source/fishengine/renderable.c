@@ -1,7 +1,52 @@
 #include "renderable.h"
 
+#include "asset.h"
 #include "transform.h"
 
+// the asset id of `x` where its pointer was
+#define AssetIDInPointer(T, x) ((T *)(uintptr_t)((x) ? (x)->assetID : 0))
+
+void RenderableSave(void *_r, array *extra) {
+    Renderable *r = _r;
+    r->mesh = AssetIDInPointer(Mesh, r->mesh);
+    r->material = AssetIDInPointer(Material, r->material);
+    r->skin = AssetIDInPointer(Skin, r->skin);
+    r->worldBoundsMesh = NULL;
+    r->worldBoundsVersion = 0;
+}
+
+// the asset saved as its id by AssetIDInPointer, NULL for no asset or for an
+// id that is not an asset of `type`
+static Asset *AssetOfType(const void *id, AssetType type) {
+    if ((uintptr_t)id > UINT32_MAX) return NULL;
+    Asset *a = id ? AssetGet((AssetID)(uintptr_t)id) : NULL;
+    return a && a->type == type ? a : NULL;
+}
+
+static bool AssetIDValid(const void *id, AssetType type) {
+    return id == NULL || AssetOfType(id, type) != NULL;
+}
+
+bool RenderableCheck(const void *_r, const uint8_t *extra,
+                     uint32_t extraSize) {
+    const Renderable *r = _r;
+    return AssetIDValid(r->mesh, AssetTypeMesh) &&
+           AssetIDValid(r->material, AssetTypeMaterial) &&
+           AssetIDValid(r->skin, AssetTypeSkin);
+}
+
+static void *AssetPointer(const void *id, AssetType type) {
+    Asset *a = AssetOfType(id, type);
+    return a ? a->ptr : NULL;
+}
+
+void RenderableLoad(void *_r, const uint8_t *extra) {
+    Renderable *r = _r;
+    r->mesh = AssetPointer(r->mesh, AssetTypeMesh);
+    r->material = AssetPointer(r->material, AssetTypeMaterial);
+    r->skin = AssetPointer(r->skin, AssetTypeSkin);
+}
+
 void RenderableUpdateBones(Renderable *r, World *w) {
     if (r->skin == NULL) return;
     int boneCount = r->skin->inverseBindMatrices.size;
@@ -28,3 +73,18 @@ void RenderableUpdateBones(Renderable *r, World *w) {
             bindpose);
     }
 }
+
+void RenderableUpdateWorldBounds(Renderable *r, World *w, Transform *t) {
+    if (r->mesh == NULL) return;
+    SingletonTransformManager *tm =
+        WorldGetSingletonComponent(w, SingletonTransformManagerID);
+    TransformUpdateLocalToWorldMatrix(w, t);
+    uint32_t idx = TransformGetIndex(w, t);
+    // H[idx].modified also carries the parents' changes once updated
+    uint32_t version = tm->H[idx].modified + 1;
+    if (r->worldBoundsVersion == version && r->worldBoundsMesh == r->mesh)
+        return;
+    r->worldBounds = BoundsTransform(&tm->LocalToWorld[idx], r->mesh->bounds);
+    r->worldBoundsMesh = r->mesh;
+    r->worldBoundsVersion = version;
+}
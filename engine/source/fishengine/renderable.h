@@ -8,9 +8,13 @@ struct Renderable {
     Mesh *mesh;
     Material *material;
     Skin *skin;
-    uint32_t bonesBuffer;
     //    array bones;  // vector<float4x4>;
 
+    // see RenderableUpdateWorldBounds
+    Bounds worldBounds;
+    const Mesh *worldBoundsMesh;
+    uint32_t worldBoundsVersion;  // transform's modified counter + 1
+
     Entity boneToEntity[128];
 };
 typedef struct Renderable Renderable;
@@ -35,6 +39,18 @@ static inline void RenderableSetMesh(Renderable *r, Mesh *mesh) {
 
 void RenderableUpdateBones(Renderable *r, World *w);
 
+// for WorldSerialize: the mesh, the material and the skin go in the snapshot
+// as asset ids, the world bounds are computed again
+void RenderableSave(void *r, array *extra);
+void RenderableLoad(void *r, const uint8_t *extra);
+// false if an id is not a mesh, a material or a skin
+bool RenderableCheck(const void *r, const uint8_t *extra, uint32_t extraSize);
+
+struct Transform;
+// recomputes r->worldBounds from the mesh bounds if the transform or the mesh
+// changed since the last call
+void RenderableUpdateWorldBounds(Renderable *r, World *w, struct Transform *t);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,21 +38,84 @@ typedef uint32_t TextureHandle;
 // set memory.buffer = NULL if you want to create an empty buffer
 BufferHandle CreateBuffer(Memory memory, GPUResourceUsageFlags usage);
 void UpdateBuffer(BufferHandle handle, Memory memory);
-uint32_t CreateTexture(Memory memory, TextureDesc *desc);
+// subresources[TextureDescSubresourceCount(desc)] in D3D order, the mips of
+// the first array slice or cube face first (see DDSGetSubresources); the
+// data is copied before the call returns
+TextureHandle CreateTextureFromSubresources(const TextureDesc *desc,
+                                            const Memory *subresources);
 void DeleteBuffer(BufferHandle handle);
 void DeleteTexture(uint32_t textureID);
+// slot of the texture in the bindless texture table (bindless.h),
+// BindlessMissingTexture for handle 0
+uint32_t GetTextureBindlessIndex(TextureHandle handle);
+// buffers created with GPUResourceUsageShaderResource get a slot in the same
+// table (a raw view of the whole buffer); 0 for other buffers
+uint32_t GetBufferBindlessIndex(BufferHandle handle);
+
+// CreateBuffer, UpdateBuffer and CreateTexture only record the upload, it
+// reaches the gpu asynchronously but before any draw submitted after it.
+// Code that must know when the data has landed (streaming) keeps a ticket.
+typedef uint64_t UploadTicket;
+// covers every upload recorded so far
+UploadTicket GetUploadTicket();
+bool IsUploadComplete(UploadTicket ticket);
 
 ShaderHandle CreateShader(const char *path, const char *vs_name,
                       const char *ps_name);
-//ShaderHandle CreateShaderFromCompiledFile(const char *path);
+ShaderHandle CreateShaderFromCompiledFile(const char *path);
+// the same from bytecode in memory, an entry of shaders.pak; it is copied
+ShaderHandle CreateShaderFromMemory(Memory bytecode);
 void DeleteShader(uint32_t shaderID);
 
 struct Renderable;
 // struct Transform;
 int SimpleDraw(Transform *t, struct Renderable *r);
+// adds the renderable to this frame's skinning batch (skinning_batch.h) and
+// points its mesh's skinnedvb/skinnedOffset at its output in the arena
 int GPUSkinning(struct Renderable *r);
+// skins the whole batch with one dispatch, before the first draw that reads
+// the arena
+void GPUSkinningSubmit();
 void BeginPass();
 
+// per-view constants, computed once per frame (RenderViewSetup in
+// render_queue.h) instead of once per draw
+struct RenderView {
+    float4x4 view;
+    float4x4 projection;
+    float3 cameraPos;
+    float3 cameraDir;
+    float fieldOfView;
+    float nearClipPlane;
+    float farClipPlane;
+    float3 lightPos;
+    float3 lightDir;  // towards the light (negated light forward)
+};
+typedef struct RenderView RenderView;
+
+// uploads camera and lighting constants; stays bound until the next BindView,
+// BeginPass keeps it
+void BindView(const RenderView *view);
+
+// used by the render queue (render_queue.h), which only calls Bind* when the
+// bound state actually changes
+struct Shader;
+struct Material;
+struct Mesh;
+// false while the pipeline is still being compiled in the background: the
+// caller skips its draws instead of waiting (g_statistics.gpu.drawsSkipped)
+bool BindPipeline(struct Shader *shader, uint32_t pass, uint32_t variant);
+// small id of the pair for the sort keys, valid until one of the shaders is
+// deleted or the device is destroyed
+uint32_t GetPipelineSortID(ShaderHandle vs, ShaderHandle ps);
+void BindMaterial(struct Material *material, uint32_t pass, uint32_t variant);
+void BindMesh(struct Mesh *mesh, bool skinned);
+void DrawMesh(struct Mesh *mesh, const float4x4 *localToWorld);
+// one draw of instanceCount instances, localToWorld holds one matrix per
+// instance; the bound pipeline must be an INSTANCING_ON variant
+void DrawMeshInstanced(struct Mesh *mesh, const float4x4 *localToWorld,
+                       uint32_t instanceCount);
+
 void BeginRenderEvent(const char *label);
 void EndRenderEvent();
 
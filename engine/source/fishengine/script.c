@@ -0,0 +1,347 @@
+#include "script.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <quickjs-libc.h>
+
+#include "log.h"
+#include "statistics.h"
+
+#define ScriptMaxModules 256
+#define ScriptMaxImports 1024
+#define ScriptPathLength 260
+#define ScriptCacheMagic 0x43534a46  // "FJSC"
+#define ScriptCacheVersion 1
+
+typedef struct {
+    char path[ScriptPathLength];
+    uint64_t hash;  // of the source the loaded module was made from
+    uint32_t generation;
+    bool loaded;
+} ScriptModule;
+
+typedef struct {
+    uint16_t importer;
+    uint16_t imported;
+} ScriptImport;
+
+// <cache directory>/<hash of the module path>.jsc
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceHash;
+    uint64_t size;  // of the bytecode after the header
+} ScriptCacheHeader;
+
+static ScriptModule g_modules[ScriptMaxModules];
+static uint32_t g_moduleCount = 0;
+static ScriptImport g_imports[ScriptMaxImports];
+static uint32_t g_importCount = 0;
+static char g_cacheDirectory[ScriptPathLength];
+static ScriptStats g_stats;
+static uint16_t g_logCategory;  // "script", set by ScriptReset
+
+// FNV-1a
+static uint64_t Hash(const void *data, size_t size) {
+    const uint8_t *p = data;
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// nul terminated, JS_Eval wants that
+static uint8_t *ReadFile(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    const long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = length >= 0 ? malloc((size_t)length + 1) : NULL;
+    if (data != NULL) count_heap_allocation();
+    if (data != NULL && length > 0 && fread(data, (size_t)length, 1, f) != 1) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    if (data != NULL) data[length] = '\0';
+    *size = (size_t)length;
+    return data;
+}
+
+static bool IsSeparator(char c) { return c == '/' || c == '\\'; }
+
+static char *LastSeparator(char *path) {
+    char *slash = strrchr(path, '/');
+    char *backslash = strrchr(path, '\\');
+    if (slash == NULL) return backslash;
+    if (backslash == NULL) return slash;
+    return slash > backslash ? slash : backslash;
+}
+
+// the module path without the generation
+static void StripGeneration(const char *name, char path[ScriptPathLength]) {
+    const char *mark = strrchr(name, '#');
+    size_t length = mark ? (size_t)(mark - name) : strlen(name);
+    if (length >= ScriptPathLength) length = ScriptPathLength - 1;
+    memcpy(path, name, length);
+    path[length] = '\0';
+}
+
+static int FindModule(const char *path) {
+    for (uint32_t i = 0; i < g_moduleCount; ++i) {
+        if (strcmp(g_modules[i].path, path) == 0) return (int)i;
+    }
+    if (g_moduleCount == ScriptMaxModules) return -1;
+    ScriptModule *m = g_modules + g_moduleCount;
+    memset(m, 0, sizeof(*m));
+    snprintf(m->path, sizeof(m->path), "%s", path);
+    return (int)g_moduleCount++;
+}
+
+static void AddImport(int importer, int imported) {
+    if (importer < 0 || imported < 0) return;
+    for (uint32_t i = 0; i < g_importCount; ++i) {
+        if (g_imports[i].importer == importer &&
+            g_imports[i].imported == imported)
+            return;
+    }
+    if (g_importCount == ScriptMaxImports) return;
+    g_imports[g_importCount].importer = (uint16_t)importer;
+    g_imports[g_importCount].imported = (uint16_t)imported;
+    g_importCount++;
+}
+
+void ScriptCacheSetDirectory(const char *directory) {
+    g_cacheDirectory[0] = '\0';
+    if (directory == NULL) return;
+    snprintf(g_cacheDirectory, sizeof(g_cacheDirectory), "%s", directory);
+#ifdef _WIN32
+    _mkdir(directory);
+#else
+    mkdir(directory, 0755);
+#endif
+}
+
+void ScriptReset() {
+    g_logCategory = LogCategory("script");
+    g_moduleCount = 0;
+    g_importCount = 0;
+    memset(&g_stats, 0, sizeof(g_stats));
+}
+
+ScriptStats ScriptResetStats() {
+    ScriptStats stats = g_stats;
+    memset(&g_stats, 0, sizeof(g_stats));
+    return stats;
+}
+
+char *ScriptModuleNormalize(JSContext *ctx, const char *baseName,
+                            const char *name, void *opaque) {
+    // native modules, FishEngine, imgui, std and os
+    if (name[0] != '.') return js_strdup(ctx, name);
+
+    // the directory of the importer, then the leading ./ and ../ of name
+    char path[ScriptPathLength];
+    StripGeneration(baseName, path);
+    const char separator = strchr(path, '\\') ? '\\' : '/';
+    char *slash = LastSeparator(path);
+    size_t length = slash ? (size_t)(slash - path) : 0;
+    path[length] = '\0';
+    for (;;) {
+        if (name[0] == '.' && IsSeparator(name[1])) {
+            name += 2;
+        } else if (name[0] == '.' && name[1] == '.' && IsSeparator(name[2]) &&
+                   length > 0) {
+            slash = LastSeparator(path);
+            if (strcmp(slash ? slash + 1 : path, "..") == 0) break;
+            length = slash ? (size_t)(slash - path) : 0;
+            path[length] = '\0';
+            name += 3;
+        } else {
+            break;
+        }
+    }
+    char resolved[ScriptPathLength];
+    if (length > 0)
+        snprintf(resolved, sizeof(resolved), "%s%c%s", path, separator, name);
+    else
+        snprintf(resolved, sizeof(resolved), "%s", name);
+
+    StripGeneration(baseName, path);
+    const int imported = FindModule(resolved);
+    AddImport(FindModule(path), imported);
+    if (imported >= 0 && g_modules[imported].generation > 0) {
+        char renamed[ScriptPathLength + 16];
+        snprintf(renamed, sizeof(renamed), "%s#%u", resolved,
+                 g_modules[imported].generation);
+        return js_strdup(ctx, renamed);
+    }
+    return js_strdup(ctx, resolved);
+}
+
+static void CachePath(const char *path, char cachePath[ScriptPathLength]) {
+    snprintf(cachePath, ScriptPathLength, "%s/%016llx.jsc", g_cacheDirectory,
+             (unsigned long long)Hash(path, strlen(path)));
+}
+
+// undefined when there is no bytecode for this source
+static JSValue ReadCache(JSContext *ctx, const char *cachePath,
+                         uint64_t sourceHash) {
+    size_t size;
+    uint8_t *data = ReadFile(cachePath, &size);
+    JSValue m = JS_UNDEFINED;
+    ScriptCacheHeader h;
+    if (data != NULL && size >= sizeof(h)) {
+        memcpy(&h, data, sizeof(h));
+        if (h.magic == ScriptCacheMagic && h.version == ScriptCacheVersion &&
+            h.sourceHash == sourceHash && h.size == size - sizeof(h)) {
+            m = JS_ReadObject(ctx, data + sizeof(h), (size_t)h.size,
+                              JS_READ_OBJ_BYTECODE);
+            // written by another version of QuickJS, compiled again
+            if (JS_IsException(m)) {
+                JS_FreeValue(ctx, JS_GetException(ctx));
+                m = JS_UNDEFINED;
+            }
+        }
+    }
+    free(data);
+    return m;
+}
+
+static void WriteCache(JSContext *ctx, const char *cachePath,
+                       uint64_t sourceHash, JSValueConst m) {
+    size_t size;
+    uint8_t *bytecode = JS_WriteObject(ctx, &size, m, JS_WRITE_OBJ_BYTECODE);
+    if (bytecode == NULL) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+        return;
+    }
+    ScriptCacheHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = ScriptCacheMagic;
+    h.version = ScriptCacheVersion;
+    h.sourceHash = sourceHash;
+    h.size = size;
+    FILE *f = fopen(cachePath, "wb");
+    bool ok = f != NULL && fwrite(&h, sizeof(h), 1, f) == 1 &&
+              fwrite(bytecode, size, 1, f) == 1;
+    if (f != NULL) ok = fclose(f) == 0 && ok;
+    if (!ok) {
+        LogWriteF(LogLevelWarning, g_logCategory,
+                  "failed to write %s", cachePath);
+        remove(cachePath);
+    }
+    js_free(ctx, bytecode);
+}
+
+// the uninstantiated module `name`, read from the cache when `path` still
+// has the source it was compiled from
+static JSValue Compile(JSContext *ctx, const char *name, const char *path,
+                       uint64_t *sourceHash) {
+    size_t size;
+    uint8_t *source = ReadFile(path, &size);
+    if (source == NULL)
+        return JS_ThrowReferenceError(ctx, "could not load module '%s'", path);
+    *sourceHash = Hash(source, size);
+    // a renamed module carries its new name in the bytecode, the cache only
+    // keeps the ones under their path
+    const bool cached =
+        g_cacheDirectory[0] != '\0' && strcmp(name, path) == 0;
+    char cachePath[ScriptPathLength];
+    JSValue m = JS_UNDEFINED;
+    if (cached) {
+        CachePath(path, cachePath);
+        m = ReadCache(ctx, cachePath, *sourceHash);
+    }
+    if (JS_IsUndefined(m)) {
+        m = JS_Eval(ctx, (const char *)source, size, name,
+                    JS_EVAL_TYPE_MODULE | JS_EVAL_FLAG_COMPILE_ONLY);
+        if (!JS_IsException(m)) {
+            g_stats.compiled++;
+            if (cached) WriteCache(ctx, cachePath, *sourceHash, m);
+        }
+    } else {
+        g_stats.cached++;
+    }
+    free(source);
+    return m;
+}
+
+static void SetLoaded(const char *path, uint64_t sourceHash) {
+    const int i = FindModule(path);
+    if (i < 0) return;
+    g_modules[i].hash = sourceHash;
+    g_modules[i].loaded = true;
+}
+
+JSModuleDef *ScriptModuleLoader(JSContext *ctx, const char *name,
+                                void *opaque) {
+    char path[ScriptPathLength];
+    StripGeneration(name, path);
+    uint64_t sourceHash;
+    JSValue m = Compile(ctx, name, path, &sourceHash);
+    if (JS_IsException(m)) return NULL;
+    SetLoaded(path, sourceHash);
+    // realpath would not find the renamed modules
+    js_module_set_import_meta(ctx, m, false, false);
+    JSModuleDef *def = JS_VALUE_GET_PTR(m);
+    JS_FreeValue(ctx, m);
+    return def;
+}
+
+int ScriptEvalModule(JSContext *ctx, const char *path) {
+    uint64_t sourceHash;
+    JSValue m = Compile(ctx, path, path, &sourceHash);
+    if (JS_IsException(m)) return -1;
+    SetLoaded(path, sourceHash);
+    // the imports of bytecode are resolved here, compiling does it itself
+    if (JS_ResolveModule(ctx, m) < 0) {
+        JS_FreeValue(ctx, m);
+        return -1;
+    }
+    js_module_set_import_meta(ctx, m, true, true);
+    JSValue ret = JS_EvalFunction(ctx, m);
+    if (JS_IsException(ret)) return -1;
+    JS_FreeValue(ctx, ret);
+    return 0;
+}
+
+uint32_t ScriptInvalidateChanged() {
+    bool changed[ScriptMaxModules] = {false};
+    for (uint32_t i = 0; i < g_moduleCount; ++i) {
+        if (!g_modules[i].loaded) continue;
+        size_t size;
+        uint8_t *source = ReadFile(g_modules[i].path, &size);
+        changed[i] = source == NULL || Hash(source, size) != g_modules[i].hash;
+        free(source);
+    }
+    // the importers are linked to the bindings of the old module
+    for (bool more = true; more;) {
+        more = false;
+        for (uint32_t i = 0; i < g_importCount; ++i) {
+            const ScriptImport *import = g_imports + i;
+            if (changed[import->imported] && !changed[import->importer]) {
+                changed[import->importer] = true;
+                more = true;
+            }
+        }
+    }
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < g_moduleCount; ++i) {
+        if (!changed[i]) continue;
+        g_modules[i].generation++;
+        g_modules[i].loaded = false;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,55 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <quickjs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Module loading for the script runtime. Modules are compiled to QuickJS
+// bytecode once and kept in a cache directory, each file tagged with the hash
+// of the source it was compiled from, so that a start with unchanged sources
+// parses nothing.
+//
+// QuickJS can not unload a module, so a reload gives the modules whose source
+// changed, and the ones importing them, a new name (path#generation). The
+// next import of such a module loads it again, the others stay as they are.
+
+// where the compiled modules go, created when missing; NULL to compile
+// without a cache
+void ScriptCacheSetDirectory(const char *directory);
+
+// forgets all modules, for a new runtime
+void ScriptReset();
+
+// to install with JS_SetModuleLoaderFunc
+char *ScriptModuleNormalize(JSContext *ctx, const char *baseName,
+                            const char *name, void *opaque);
+JSModuleDef *ScriptModuleLoader(JSContext *ctx, const char *name,
+                                void *opaque);
+
+// compiles, or reads from the cache, and evaluates the entry module; -1 when
+// it throws, the exception is left on the context
+int ScriptEvalModule(JSContext *ctx, const char *path);
+
+// hashes the sources of the loaded modules again and renames the changed
+// ones and their importers, returns how many were renamed
+uint32_t ScriptInvalidateChanged();
+
+typedef struct {
+    uint32_t compiled;  // from source
+    uint32_t cached;    // read from the cache directory
+} ScriptStats;
+
+// counts since the last call, and starts over
+ScriptStats ScriptResetStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCRIPT_H */
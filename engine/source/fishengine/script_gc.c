@@ -0,0 +1,67 @@
+#include "script_gc.h"
+
+#include <time.h>
+
+#include "script_profiler.h"
+#include "statistics.h"
+
+static ScriptGCPolicy g_policy = {
+    4 << 20,   // growth
+    64 << 20,  // limit
+    600,       // interval, 10 s at 60 fps
+};
+static size_t g_heapAfterGC = 0;
+static uint32_t g_framesSinceGC = 0;
+static bool g_fullRequested = false;
+static double g_time = 0;  // collecting since the last frame end
+
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// QuickJS moves it to 1.5 times the heap after collecting by itself
+static void SetThreshold(JSRuntime *rt) {
+    JS_SetGCThreshold(rt, g_heapAfterGC + g_policy.limit);
+}
+
+void ScriptGCInit(JSRuntime *rt) {
+    g_heapAfterGC = ScriptProfilerHeapSize();
+    g_framesSinceGC = 0;
+    g_fullRequested = false;
+    SetThreshold(rt);
+}
+
+void ScriptGCSetPolicy(JSRuntime *rt, const ScriptGCPolicy *policy) {
+    g_policy = *policy;
+    SetThreshold(rt);
+}
+
+ScriptGCPolicy ScriptGCGetPolicy() { return g_policy; }
+
+void ScriptGCRequestFull() { g_fullRequested = true; }
+
+void ScriptGCCollect(JSRuntime *rt) {
+    const double start = Now();
+    JS_RunGC(rt);
+    g_time += Now() - start;
+    g_heapAfterGC = ScriptProfilerHeapSize();
+    g_framesSinceGC = 0;
+    g_fullRequested = false;
+    SetThreshold(rt);
+}
+
+void ScriptGCFrameEnd(JSRuntime *rt) {
+    g_framesSinceGC++;
+    // reference counting, or QuickJS, freed some
+    const size_t heap = ScriptProfilerHeapSize();
+    if (heap < g_heapAfterGC) g_heapAfterGC = heap;
+    if (g_fullRequested || heap - g_heapAfterGC > g_policy.growth ||
+        (g_policy.interval > 0 && g_framesSinceGC >= g_policy.interval))
+        ScriptGCCollect(rt);
+    else
+        SetThreshold(rt);
+    g_statistics.cpu.scriptGCTimeUs = (uint32_t)(g_time * 1e6);
+    g_time = 0;
+}
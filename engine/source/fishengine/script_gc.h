@@ -0,0 +1,52 @@
+#ifndef SCRIPT_GC_H
+#define SCRIPT_GC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <quickjs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// When the JS heap is collected. QuickJS frees most objects by reference
+// counting and runs its cycle collector whenever the heap passes a threshold,
+// which can be in the middle of a system or of renderUI. The threshold is
+// kept far above the heap instead and the engine collects at the end of the
+// frame, when the heap grew enough since the last collection.
+// QuickJS has no incremental collector, a collection is always a full one.
+
+typedef struct {
+    // bytes the heap may grow after a collection before the frame end
+    // collects again
+    size_t growth;
+    // and before QuickJS collects by itself, wherever the script is
+    size_t limit;
+    // frames between collections when the heap does not grow, for the cycles
+    // that hold little; 0 for never
+    uint32_t interval;
+} ScriptGCPolicy;
+
+// the heap is measured by the allocator of ScriptProfilerNewRuntime
+void ScriptGCInit(JSRuntime *rt);
+
+void ScriptGCSetPolicy(JSRuntime *rt, const ScriptGCPolicy *policy);
+ScriptGCPolicy ScriptGCGetPolicy();
+
+// the next ScriptGCFrameEnd collects, after a scene load for instance
+void ScriptGCRequestFull();
+
+// now, wherever the script is
+void ScriptGCCollect(JSRuntime *rt);
+
+// collects when the policy says so, and sets the GC time of g_statistics;
+// once a frame, outside of any script
+void ScriptGCFrameEnd(JSRuntime *rt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCRIPT_GC_H */
@@ -0,0 +1,411 @@
+#include "script_profiler.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(_WIN32) || defined(__linux__)
+#include <malloc.h>
+#endif
+
+#include "log.h"
+#include "statistics.h"
+
+#define ScriptMaxNames 256
+#define ScriptNameLength 64
+#define ScriptScopeDepth 16
+#define ScriptTraceEvents 65536  // the last ones are kept for the dump
+#define ScriptTraceFrames 4096
+#define ScriptMaxSamples 256  // distinct stacks
+#define ScriptStackLength 512
+#define ScriptUsageInterval 60  // frames between JS_ComputeMemoryUsage
+#define ScriptMallocOverhead 8  // what QuickJS adds to every block
+
+typedef struct {
+    size_t size;  // live bytes
+    uint32_t allocations;
+    uint64_t allocatedSize;
+    uint64_t freedSize;
+} ScriptHeap;
+
+typedef struct {
+    JSContext *ctx;
+    uint16_t name;
+    double begin;
+} ScriptScope;
+
+typedef struct {
+    uint16_t name;
+    uint16_t depth;
+    double begin, end;
+} ScriptEvent;
+
+typedef struct {
+    double time;
+    uint32_t heapSize;
+    uint32_t allocations;
+    uint32_t freedSize;
+} ScriptFrame;
+
+typedef struct {
+    uint64_t hash;
+    uint16_t name;  // of the scope it was taken in
+    uint32_t count;
+    char stack[ScriptStackLength];
+} ScriptSample;
+
+static struct {
+    ScriptHeap heap;
+    double start;
+    double budget;          // seconds
+    double sampleInterval;  // seconds
+    double nextSample;
+    bool sampling;
+
+    char names[ScriptMaxNames][ScriptNameLength];
+    uint32_t nameCount;
+    double nameTime[ScriptMaxNames];  // this frame
+    uint32_t nameCalls[ScriptMaxNames];
+
+    ScriptScope scopes[ScriptScopeDepth];
+    uint32_t depth;
+    double frameTime;
+    uint32_t frame;
+    uint32_t objectCount;
+
+    ScriptEvent *events;  // ring
+    uint32_t eventCount;
+    ScriptFrame frames[ScriptTraceFrames];  // ring
+    uint32_t frameCount;
+    ScriptSample *samples;
+    uint32_t sampleCount;
+
+    uint16_t logCategory;  // "script"
+} g_profiler;
+
+// wall clock, clock() adds up the time of all threads
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static size_t UsableSize(const void *p) {
+#if defined(__APPLE__)
+    return malloc_size(p);
+#elif defined(_WIN32)
+    return _msize((void *)p);
+#elif defined(__linux__)
+    return malloc_usable_size((void *)p);
+#else
+    return 0;
+#endif
+}
+
+// the allocator of QuickJS with counters, a limit of 0 wraps to no limit
+static void *ScriptMalloc(JSMallocState *s, size_t size) {
+    if (s->malloc_size + size > s->malloc_limit - 1) return NULL;
+    void *p = malloc(size);
+    if (p == NULL) return NULL;
+    const size_t usable = UsableSize(p);
+    ScriptHeap *heap = s->opaque;
+    s->malloc_count++;
+    s->malloc_size += usable + ScriptMallocOverhead;
+    heap->size += usable;
+    heap->allocations++;
+    heap->allocatedSize += usable;
+    return p;
+}
+
+static void ScriptFree(JSMallocState *s, void *p) {
+    if (p == NULL) return;
+    const size_t usable = UsableSize(p);
+    ScriptHeap *heap = s->opaque;
+    s->malloc_count--;
+    s->malloc_size -= usable + ScriptMallocOverhead;
+    heap->size -= usable;
+    heap->freedSize += usable;
+    free(p);
+}
+
+static void *ScriptRealloc(JSMallocState *s, void *p, size_t size) {
+    if (p == NULL) return size > 0 ? ScriptMalloc(s, size) : NULL;
+    if (size == 0) {
+        ScriptFree(s, p);
+        return NULL;
+    }
+    const size_t old = UsableSize(p);
+    if (s->malloc_size + size - old > s->malloc_limit - 1) return NULL;
+    p = realloc(p, size);
+    if (p == NULL) return NULL;
+    const size_t usable = UsableSize(p);
+    ScriptHeap *heap = s->opaque;
+    s->malloc_size += usable - old;
+    heap->size += usable - old;
+    heap->allocations++;
+    heap->allocatedSize += usable;
+    heap->freedSize += old;
+    return p;
+}
+
+static uint16_t Intern(const char *name) {
+    for (uint32_t i = 0; i < g_profiler.nameCount; ++i) {
+        if (strcmp(g_profiler.names[i], name) == 0) return (uint16_t)i;
+    }
+    // the last one takes whatever does not fit
+    if (g_profiler.nameCount == ScriptMaxNames) return ScriptMaxNames - 1;
+    snprintf(g_profiler.names[g_profiler.nameCount], ScriptNameLength, "%s",
+             name);
+    return (uint16_t)g_profiler.nameCount++;
+}
+
+// FNV-1a
+static uint64_t Hash(const char *s) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (; *s; ++s) {
+        h ^= (uint8_t)*s;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static void AddSample(uint16_t name, const char *stack) {
+    const uint64_t hash = Hash(stack) ^ name;
+    for (uint32_t i = 0; i < g_profiler.sampleCount; ++i) {
+        if (g_profiler.samples[i].hash == hash) {
+            g_profiler.samples[i].count++;
+            return;
+        }
+    }
+    if (g_profiler.samples == NULL) {
+        g_profiler.samples = malloc(ScriptMaxSamples * sizeof(ScriptSample));
+        count_heap_allocation();
+    }
+    if (g_profiler.sampleCount == ScriptMaxSamples) return;
+    ScriptSample *s = g_profiler.samples + g_profiler.sampleCount++;
+    s->hash = hash;
+    s->name = name;
+    s->count = 1;
+    snprintf(s->stack, sizeof(s->stack), "%s", stack);
+}
+
+// an Error made here carries the stack of the running function, the way
+// QuickJS makes its "interrupted" error
+static void Sample() {
+    const ScriptScope *scope = g_profiler.scopes + g_profiler.depth - 1;
+    JSContext *ctx = scope->ctx;
+    JSValue error = JS_NewError(ctx);
+    JSValue stack = JS_GetPropertyStr(ctx, error, "stack");
+    const char *str = JS_ToCString(ctx, stack);
+    if (str) {
+        AddSample(scope->name, str);
+        JS_FreeCString(ctx, str);
+    }
+    JS_FreeValue(ctx, stack);
+    JS_FreeValue(ctx, error);
+}
+
+// called by the interpreter every few thousand branches and calls
+static int InterruptHandler(JSRuntime *rt, void *opaque) {
+    if (g_profiler.sampleInterval <= 0 || g_profiler.depth == 0 ||
+        g_profiler.depth > ScriptScopeDepth || g_profiler.sampling)
+        return 0;
+    const double now = Now();
+    if (now >= g_profiler.nextSample) {
+        g_profiler.nextSample = now + g_profiler.sampleInterval;
+        g_profiler.sampling = true;
+        Sample();
+        g_profiler.sampling = false;
+    }
+    return 0;
+}
+
+JSRuntime *ScriptProfilerNewRuntime() {
+    static const JSMallocFunctions functions = {
+        ScriptMalloc, ScriptFree, ScriptRealloc, UsableSize};
+    memset(&g_profiler.heap, 0, sizeof(g_profiler.heap));
+    g_profiler.start = Now();
+    g_profiler.logCategory = LogCategory("script");
+    JSRuntime *rt = JS_NewRuntime2(&functions, &g_profiler.heap);
+    if (rt) JS_SetInterruptHandler(rt, InterruptHandler, NULL);
+    return rt;
+}
+
+void ScriptProfilerSetBudget(double milliseconds) {
+    g_profiler.budget = milliseconds * 1e-3;
+}
+
+void ScriptProfilerSetSampling(double milliseconds) {
+    g_profiler.sampleInterval = milliseconds * 1e-3;
+}
+
+void ScriptProfilerBegin(JSContext *ctx, const char *name) {
+    // too deep ones are counted, not recorded
+    if (g_profiler.depth < ScriptScopeDepth) {
+        ScriptScope *s = g_profiler.scopes + g_profiler.depth;
+        s->ctx = ctx;
+        s->name = Intern(name);
+        s->begin = Now();
+    }
+    g_profiler.depth++;
+}
+
+void ScriptProfilerEnd() {
+    assert(g_profiler.depth > 0);
+    if (--g_profiler.depth >= ScriptScopeDepth) return;
+    const ScriptScope *s = g_profiler.scopes + g_profiler.depth;
+    const double end = Now();
+    g_profiler.nameTime[s->name] += end - s->begin;
+    g_profiler.nameCalls[s->name]++;
+    if (g_profiler.depth == 0) g_profiler.frameTime += end - s->begin;
+
+    if (g_profiler.events == NULL) {
+        g_profiler.events = malloc(ScriptTraceEvents * sizeof(ScriptEvent));
+        count_heap_allocation();
+    }
+    ScriptEvent *e =
+        g_profiler.events + g_profiler.eventCount++ % ScriptTraceEvents;
+    e->name = s->name;
+    e->depth = (uint16_t)g_profiler.depth;
+    e->begin = s->begin;
+    e->end = end;
+}
+
+size_t ScriptProfilerHeapSize() { return g_profiler.heap.size; }
+
+static void LogOverBudget() {
+    char text[512];
+    int n = snprintf(text, sizeof(text),
+                     "frame %u: %.2f ms, over the budget of %.2f ms:",
+                     g_profiler.frame, g_profiler.frameTime * 1e3,
+                     g_profiler.budget * 1e3);
+    // the four most expensive scopes
+    bool listed[ScriptMaxNames] = {false};
+    for (int k = 0; k < 4 && n < (int)sizeof(text); ++k) {
+        int worst = -1;
+        for (uint32_t i = 0; i < g_profiler.nameCount; ++i) {
+            if (listed[i] || g_profiler.nameCalls[i] == 0) continue;
+            if (worst < 0 ||
+                g_profiler.nameTime[i] > g_profiler.nameTime[worst])
+                worst = (int)i;
+        }
+        if (worst < 0) break;
+        listed[worst] = true;
+        n += snprintf(text + n, sizeof(text) - n, "%s %s %.2f ms",
+                      k > 0 ? "," : "", g_profiler.names[worst],
+                      g_profiler.nameTime[worst] * 1e3);
+        if (g_profiler.nameCalls[worst] > 1 && n < (int)sizeof(text))
+            n += snprintf(text + n, sizeof(text) - n, " (%u calls)",
+                          g_profiler.nameCalls[worst]);
+    }
+    LogWrite(LogLevelWarning, g_profiler.logCategory, text);
+}
+
+void ScriptProfilerFrameEnd(JSRuntime *rt) {
+    if (g_profiler.budget > 0 && g_profiler.frameTime > g_profiler.budget)
+        LogOverBudget();
+
+    // walks the whole heap, not every frame
+    if (g_profiler.frame % ScriptUsageInterval == 0) {
+        JSMemoryUsage usage;
+        JS_ComputeMemoryUsage(rt, &usage);
+        g_profiler.objectCount = (uint32_t)usage.obj_count;
+    }
+
+    ScriptHeap *heap = &g_profiler.heap;
+    g_statistics.cpu.scriptTimeUs = (uint32_t)(g_profiler.frameTime * 1e6);
+    g_statistics.cpu.scriptHeapSize = (uint32_t)heap->size;
+    g_statistics.cpu.scriptAllocations = heap->allocations;
+    g_statistics.cpu.scriptAllocatedSize = (uint32_t)heap->allocatedSize;
+    g_statistics.cpu.scriptFreedSize = (uint32_t)heap->freedSize;
+    g_statistics.cpu.scriptObjectCount = g_profiler.objectCount;
+
+    ScriptFrame *f =
+        g_profiler.frames + g_profiler.frameCount++ % ScriptTraceFrames;
+    f->time = Now();
+    f->heapSize = (uint32_t)heap->size;
+    f->allocations = heap->allocations;
+    f->freedSize = (uint32_t)heap->freedSize;
+
+    heap->allocations = 0;
+    heap->allocatedSize = 0;
+    heap->freedSize = 0;
+    g_profiler.frameTime = 0;
+    memset(g_profiler.nameTime, 0, sizeof(g_profiler.nameTime));
+    memset(g_profiler.nameCalls, 0, sizeof(g_profiler.nameCalls));
+    g_profiler.frame++;
+}
+
+static void WriteString(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        const unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            fprintf(f, "\\%c", c);
+        else if (c == '\n')
+            fputs("\\n", f);
+        else if (c < 0x20)
+            fprintf(f, "\\u%04x", c);
+        else
+            fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+// microseconds since the runtime was made
+static double Timestamp(double time) {
+    return (time - g_profiler.start) * 1e6;
+}
+
+bool ScriptProfilerDumpTrace(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (f == NULL) return false;
+    fputs("{\"traceEvents\":[\n", f);
+    bool first = true;
+    const uint32_t eventCount = g_profiler.eventCount < ScriptTraceEvents
+                                    ? g_profiler.eventCount
+                                    : ScriptTraceEvents;
+    for (uint32_t i = g_profiler.eventCount - eventCount;
+         i != g_profiler.eventCount; ++i) {
+        const ScriptEvent *e = g_profiler.events + i % ScriptTraceEvents;
+        fputs(first ? "" : ",\n", f);
+        first = false;
+        fputs("{\"name\":", f);
+        WriteString(f, g_profiler.names[e->name]);
+        fprintf(f,
+                ",\"cat\":\"script\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                "\"ts\":%.1f,\"dur\":%.1f}",
+                Timestamp(e->begin), (e->end - e->begin) * 1e6);
+    }
+    const uint32_t frameCount = g_profiler.frameCount < ScriptTraceFrames
+                                    ? g_profiler.frameCount
+                                    : ScriptTraceFrames;
+    for (uint32_t i = g_profiler.frameCount - frameCount;
+         i != g_profiler.frameCount; ++i) {
+        const ScriptFrame *frame = g_profiler.frames + i % ScriptTraceFrames;
+        fputs(first ? "" : ",\n", f);
+        first = false;
+        fprintf(f,
+                "{\"name\":\"script heap\",\"ph\":\"C\",\"pid\":1,"
+                "\"ts\":%.1f,\"args\":{\"size\":%u,\"allocations\":%u,"
+                "\"freed\":%u}}",
+                Timestamp(frame->time), frame->heapSize, frame->allocations,
+                frame->freedSize);
+    }
+    // not part of the trace format, viewers skip it
+    fputs("\n],\n\"scriptSamples\":[\n", f);
+    for (uint32_t i = 0; i < g_profiler.sampleCount; ++i) {
+        const ScriptSample *s = g_profiler.samples + i;
+        fputs(i == 0 ? "" : ",\n", f);
+        fputs("{\"scope\":", f);
+        WriteString(f, g_profiler.names[s->name]);
+        fprintf(f, ",\"count\":%u,\"stack\":", s->count);
+        WriteString(f, s->stack);
+        fputc('}', f);
+    }
+    fputs("\n]}\n", f);
+    return fclose(f) == 0;
+}
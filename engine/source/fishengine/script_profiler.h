@@ -0,0 +1,47 @@
+#ifndef SCRIPT_PROFILER_H
+#define SCRIPT_PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <quickjs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Where the script time goes: wall time of every JS system and callback, a
+// per-frame budget that names the ones over it, the allocations of the JS
+// heap and, when sampling is on, the JS stacks the interrupt handler finds
+// running. Main thread only.
+
+// a runtime whose allocations are counted and that calls the sampler
+JSRuntime *ScriptProfilerNewRuntime();
+
+// milliseconds of script time per frame, the frames over it are logged with
+// their most expensive scopes; 0 turns it off
+void ScriptProfilerSetBudget(double milliseconds);
+
+// takes a JS stack every `milliseconds` while a scope is open, 0 turns it off
+void ScriptProfilerSetSampling(double milliseconds);
+
+// scopes nest, the time of a scope includes the ones inside it
+void ScriptProfilerBegin(JSContext *ctx, const char *name);
+void ScriptProfilerEnd();
+
+// bytes held by the runtime of ScriptProfilerNewRuntime
+size_t ScriptProfilerHeapSize();
+
+// fills the script statistics of g_statistics and checks the budget
+void ScriptProfilerFrameEnd(JSRuntime *rt);
+
+// the recorded scopes and heap counters of the last frames in the Chrome
+// trace event format (chrome://tracing, Perfetto), and the stack samples
+bool ScriptProfilerDumpTrace(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCRIPT_PROFILER_H */
@@ -0,0 +1,470 @@
+#include "script_worker.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cutils.h>
+#include <quickjs-libc.h>
+
+#include "jsbinding.h"
+#include "statistics.h"
+
+#ifdef _WIN32
+#include <windows.h>
+typedef HANDLE Thread;
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Cond;
+#define MutexInit(m) InitializeSRWLock(m)
+#define MutexDestroy(m)
+#define MutexLock(m) AcquireSRWLockExclusive(m)
+#define MutexUnlock(m) ReleaseSRWLockExclusive(m)
+#define CondInit(c) InitializeConditionVariable(c)
+#define CondDestroy(c)
+#define CondWait(c, m) SleepConditionVariableSRW(c, m, INFINITE, 0)
+#define CondSignal(c) WakeConditionVariable(c)
+#else
+#include <pthread.h>
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Cond;
+#define MutexInit(m) pthread_mutex_init(m, NULL)
+#define MutexDestroy(m) pthread_mutex_destroy(m)
+#define MutexLock(m) pthread_mutex_lock(m)
+#define MutexUnlock(m) pthread_mutex_unlock(m)
+#define CondInit(c) pthread_cond_init(c, NULL)
+#define CondDestroy(c) pthread_cond_destroy(c)
+#define CondWait(c, m) pthread_cond_wait(c, m)
+#define CondSignal(c) pthread_cond_signal(c)
+#endif
+
+extern void fe_js_dump_error(JSContext *ctx);
+
+typedef struct {
+    uint8_t *data;  // malloc'd, NULL once an ArrayBuffer owns it
+    size_t size;
+} ScriptBuffer;
+
+typedef struct ScriptMessage {
+    struct ScriptMessage *next;
+    uint32_t from;  // id of the worker, for the messages to the main thread
+    uint8_t *data;  // JS_WriteObject of the message, after the buffers
+    size_t size;
+    uint32_t bufferCount;
+    ScriptBuffer buffers[];
+} ScriptMessage;
+
+typedef struct {
+    ScriptMessage *head;
+    ScriptMessage *tail;
+} ScriptMessageQueue;
+
+struct ScriptWorker {
+    Thread thread;
+    Mutex lock;
+    Cond wake;
+    bool quit;                  // interrupts the running script too
+    bool done;                  // the thread returned
+    ScriptMessageQueue inbox;   // to the worker
+    ScriptMessageQueue outbox;  // to the main thread
+    // the Worker, not a reference; undefined once it is collected
+    JSValue object;
+    uint32_t id;
+    ScriptWorker *next;
+    char path[512];
+};
+
+// main thread only
+static ScriptWorker *g_workers = NULL;
+static uint32_t g_nextWorkerID = 1;
+
+static void Push(ScriptMessageQueue *q, ScriptMessage *m) {
+    m->next = NULL;
+    if (q->tail)
+        q->tail->next = m;
+    else
+        q->head = m;
+    q->tail = m;
+}
+
+static ScriptMessage *Pop(ScriptMessageQueue *q) {
+    ScriptMessage *m = q->head;
+    if (m) {
+        q->head = m->next;
+        if (!q->head) q->tail = NULL;
+    }
+    return m;
+}
+
+static void FreeMessage(ScriptMessage *m) {
+    for (uint32_t i = 0; i < m->bufferCount; ++i) free(m->buffers[i].data);
+    free(m);
+}
+
+static void FreeQueue(ScriptMessageQueue *q) {
+    ScriptMessage *m;
+    while ((m = Pop(q))) FreeMessage(m);
+}
+
+static void FreeBuffer(JSRuntime *rt, void *opaque, void *ptr) { free(ptr); }
+
+// the buffers in `transfer` are checked and copied before any of them is
+// detached
+static ScriptMessage *NewMessage(JSContext *ctx, JSValueConst message,
+                                 JSValueConst transfer) {
+    uint32_t count = 0;
+    if (!JS_IsUndefined(transfer)) {
+        if (!JS_IsArray(ctx, transfer)) {
+            JS_ThrowTypeError(ctx, "transfer is not an array");
+            return NULL;
+        }
+        JSValue length = JS_GetPropertyStr(ctx, transfer, "length");
+        int ret = JS_ToUint32(ctx, &count, length);
+        JS_FreeValue(ctx, length);
+        if (ret) return NULL;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        size_t size;
+        JSValue buffer = JS_GetPropertyUint32(ctx, transfer, i);
+        uint8_t *data = JS_GetArrayBuffer(ctx, &size, buffer);
+        bool listed = false;
+        for (uint32_t j = 0; data && j < i && !listed; ++j) {
+            JSValue other = JS_GetPropertyUint32(ctx, transfer, j);
+            listed = JS_VALUE_GET_PTR(other) == JS_VALUE_GET_PTR(buffer);
+            JS_FreeValue(ctx, other);
+        }
+        JS_FreeValue(ctx, buffer);
+        if (!data) return NULL;
+        if (listed) {
+            JS_ThrowTypeError(ctx, "an ArrayBuffer is in transfer twice");
+            return NULL;
+        }
+    }
+
+    size_t size;
+    uint8_t *data = JS_WriteObject(ctx, &size, message, 0);
+    if (!data) return NULL;
+    ScriptMessage *m =
+        malloc(sizeof(ScriptMessage) + count * sizeof(ScriptBuffer) + size);
+    count_heap_allocation();
+    m->next = NULL;
+    m->from = 0;
+    m->data = (uint8_t *)(m->buffers + count);
+    m->size = size;
+    memcpy(m->data, data, size);
+    js_free(ctx, data);
+
+    m->bufferCount = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        size_t size;
+        JSValue buffer = JS_GetPropertyUint32(ctx, transfer, i);
+        // a getter of `transfer` may have detached it since
+        uint8_t *data = JS_GetArrayBuffer(ctx, &size, buffer);
+        JS_FreeValue(ctx, buffer);
+        if (!data) {
+            FreeMessage(m);
+            return NULL;
+        }
+        ScriptBuffer *b = &m->buffers[m->bufferCount++];
+        b->data = malloc(size > 0 ? size : 1);
+        count_heap_allocation();
+        b->size = size;
+        memcpy(b->data, data, size);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        JSValue buffer = JS_GetPropertyUint32(ctx, transfer, i);
+        JS_DetachArrayBuffer(ctx, buffer);
+        JS_FreeValue(ctx, buffer);
+    }
+    return m;
+}
+
+// handler(message, buffers) with `this_val`; the buffers move to the
+// ArrayBuffers, the message is still to be freed
+static int Deliver(JSContext *ctx, JSValueConst handler, JSValueConst this_val,
+                   ScriptMessage *m) {
+    JSValue args[2];
+    args[0] = JS_ReadObject(ctx, m->data, m->size, 0);
+    if (JS_IsException(args[0])) return -1;
+    args[1] = JS_NewArray(ctx);
+    for (uint32_t i = 0; i < m->bufferCount; ++i) {
+        ScriptBuffer *b = &m->buffers[i];
+        JSValue buffer =
+            JS_NewArrayBuffer(ctx, b->data, b->size, FreeBuffer, NULL, false);
+        if (JS_IsException(buffer)) {
+            JS_FreeValue(ctx, args[0]);
+            JS_FreeValue(ctx, args[1]);
+            return -1;
+        }
+        b->data = NULL;
+        JS_SetPropertyUint32(ctx, args[1], i, buffer);
+    }
+    int result = 0;
+    // dropped, as on the web, when there is no handler
+    if (JS_IsFunction(ctx, handler)) {
+        JSValue ret = JS_Call(ctx, handler, this_val, 2, args);
+        if (JS_IsException(ret)) result = -1;
+        JS_FreeValue(ctx, ret);
+    }
+    JS_FreeValue(ctx, args[0]);
+    JS_FreeValue(ctx, args[1]);
+    return result;
+}
+
+static bool Stopped(ScriptWorker *w) {
+    MutexLock(&w->lock);
+    const bool quit = w->quit;
+    MutexUnlock(&w->lock);
+    return quit;
+}
+
+// called by the worker runtime every few thousand instructions, so that a
+// script in a long or endless loop does not hold up the main thread
+static int InterruptHandler(JSRuntime *rt, void *opaque) {
+    return Stopped(opaque);
+}
+
+// the exception of an interrupted script is no error
+static void DumpWorkerError(ScriptWorker *w, JSContext *ctx) {
+    if (Stopped(w))
+        JS_FreeValue(ctx, JS_GetException(ctx));
+    else
+        fe_js_dump_error(ctx);
+}
+
+static void RunWorkerJobs(ScriptWorker *w, JSRuntime *rt) {
+    JSContext *jobContext;
+    int ret;
+    while ((ret = JS_ExecutePendingJob(rt, &jobContext)) != 0) {
+        if (ret < 0) DumpWorkerError(w, jobContext);
+    }
+}
+
+static void RunJobs(JSRuntime *rt) {
+    JSContext *jobContext;
+    int ret;
+    while ((ret = JS_ExecutePendingJob(rt, &jobContext)) != 0) {
+        if (ret < 0) fe_js_dump_error(jobContext);
+    }
+}
+
+// postMessage(message, transfer) in the worker
+static JSValue js_worker_postMessage(JSContext *ctx, JSValueConst this_val,
+                                     int argc, JSValueConst *argv) {
+    ScriptWorker *w = JS_GetContextOpaque(ctx);
+    ScriptMessage *m = NewMessage(ctx, argv[0], argv[1]);
+    if (!m) return JS_EXCEPTION;
+    m->from = w->id;
+    MutexLock(&w->lock);
+    Push(&w->outbox, m);
+    MutexUnlock(&w->lock);
+    return JS_UNDEFINED;
+}
+
+static int EvalModule(JSContext *ctx, const char *path) {
+    size_t size;
+    uint8_t *source = js_load_file(ctx, &size, path);
+    if (!source) {
+        JS_ThrowReferenceError(ctx, "could not load module '%s'", path);
+        return -1;
+    }
+    JSValue ret =
+        JS_Eval(ctx, (const char *)source, size, path, JS_EVAL_TYPE_MODULE);
+    js_free(ctx, source);
+    if (JS_IsException(ret)) return -1;
+    JS_FreeValue(ctx, ret);
+    return 0;
+}
+
+// the runtime and its modules are the worker's alone; the quickjs-libc loader
+// keeps no global state, unlike the one of script.c
+static void WorkerLoop(ScriptWorker *w) {
+    JSRuntime *rt = JS_NewRuntime();
+    JS_SetInterruptHandler(rt, InterruptHandler, w);
+    JSContext *ctx = JS_NewContext(rt);
+    JS_SetContextOpaque(ctx, w);
+    js_std_add_helpers(ctx, 0, NULL);
+    js_init_module_std(ctx, "std");
+    js_init_module_fishengine_worker(ctx, "FishEngine");
+    JS_SetModuleLoaderFunc(rt, NULL, js_module_loader, NULL);
+    JSValue global = JS_GetGlobalObject(ctx);
+    JS_SetPropertyStr(
+        ctx, global, "postMessage",
+        JS_NewCFunction(ctx, js_worker_postMessage, "postMessage", 2));
+
+    if (EvalModule(ctx, w->path) < 0) DumpWorkerError(w, ctx);
+    RunWorkerJobs(w, rt);
+
+    MutexLock(&w->lock);
+    for (;;) {
+        while (!w->quit && !w->inbox.head) CondWait(&w->wake, &w->lock);
+        if (w->quit) break;
+        ScriptMessage *m = Pop(&w->inbox);
+        MutexUnlock(&w->lock);
+        JSValue handler = JS_GetPropertyStr(ctx, global, "onmessage");
+        if (Deliver(ctx, handler, global, m) < 0) DumpWorkerError(w, ctx);
+        JS_FreeValue(ctx, handler);
+        FreeMessage(m);
+        RunWorkerJobs(w, rt);
+        MutexLock(&w->lock);
+    }
+    MutexUnlock(&w->lock);
+
+    JS_FreeValue(ctx, global);
+    JS_FreeContext(ctx);
+    JS_FreeRuntime(rt);
+    MutexLock(&w->lock);
+    w->done = true;
+    MutexUnlock(&w->lock);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI WorkerMain(LPVOID arg) {
+    WorkerLoop(arg);
+    return 0;
+}
+#else
+static void *WorkerMain(void *arg) {
+    WorkerLoop(arg);
+    return NULL;
+}
+#endif
+
+ScriptWorker *ScriptWorkerNew(JSContext *ctx, JSValueConst object,
+                              const char *path) {
+    ScriptWorker *w = calloc(1, sizeof(ScriptWorker));
+    count_heap_allocation();
+    if (snprintf(w->path, sizeof(w->path), "%s", path) >=
+        (int)sizeof(w->path)) {
+        free(w);
+        return NULL;
+    }
+    MutexInit(&w->lock);
+    CondInit(&w->wake);
+    w->object = object;
+    w->id = g_nextWorkerID++;
+#ifdef _WIN32
+    w->thread = CreateThread(NULL, 0, WorkerMain, w, 0, NULL);
+    const bool started = w->thread != NULL;
+#else
+    const bool started = pthread_create(&w->thread, NULL, WorkerMain, w) == 0;
+#endif
+    if (!started) {
+        CondDestroy(&w->wake);
+        MutexDestroy(&w->lock);
+        free(w);
+        return NULL;
+    }
+    w->next = g_workers;
+    g_workers = w;
+    return w;
+}
+
+// raises the interrupt of the worker runtime and wakes the thread up
+static void Stop(ScriptWorker *w) {
+    MutexLock(&w->lock);
+    w->quit = true;
+    CondSignal(&w->wake);
+    MutexUnlock(&w->lock);
+}
+
+static void Destroy(ScriptWorker *w) {
+#ifdef _WIN32
+    WaitForSingleObject(w->thread, INFINITE);
+    CloseHandle(w->thread);
+#else
+    pthread_join(w->thread, NULL);
+#endif
+    FreeQueue(&w->inbox);
+    FreeQueue(&w->outbox);
+    CondDestroy(&w->wake);
+    MutexDestroy(&w->lock);
+    if (!JS_IsUndefined(w->object)) JS_SetOpaque(w->object, NULL);
+    for (ScriptWorker **p = &g_workers; *p; p = &(*p)->next) {
+        if (*p == w) {
+            *p = w->next;
+            break;
+        }
+    }
+    free(w);
+}
+
+void ScriptWorkerTerminate(ScriptWorker *w) {
+    Stop(w);
+    Destroy(w);
+}
+
+void ScriptWorkerFree(ScriptWorker *w) {
+    Stop(w);
+    w->object = JS_UNDEFINED;
+}
+
+int ScriptWorkerPost(ScriptWorker *w, JSContext *ctx, JSValueConst message,
+                     JSValueConst transfer) {
+    ScriptMessage *m = NewMessage(ctx, message, transfer);
+    if (!m) return -1;
+    MutexLock(&w->lock);
+    Push(&w->inbox, m);
+    CondSignal(&w->wake);
+    MutexUnlock(&w->lock);
+    return 0;
+}
+
+static ScriptWorker *FindWorker(uint32_t id) {
+    for (ScriptWorker *w = g_workers; w; w = w->next) {
+        if (w->id == id) return w;
+    }
+    return NULL;
+}
+
+// the threads of the workers collected since the last frame, once returned
+static void JoinCollected() {
+    ScriptWorker *w = g_workers;
+    while (w) {
+        ScriptWorker *next = w->next;
+        if (JS_IsUndefined(w->object)) {
+            MutexLock(&w->lock);
+            const bool done = w->done;
+            MutexUnlock(&w->lock);
+            if (done) Destroy(w);
+        }
+        w = next;
+    }
+}
+
+void ScriptWorkersDispatch(JSContext *ctx) {
+    JoinCollected();
+    // taken from every worker first, a handler may create or free workers
+    ScriptMessageQueue queue = {NULL, NULL};
+    for (ScriptWorker *w = g_workers; w; w = w->next) {
+        MutexLock(&w->lock);
+        ScriptMessage *m = w->outbox.head;
+        w->outbox.head = w->outbox.tail = NULL;
+        MutexUnlock(&w->lock);
+        while (m) {
+            ScriptMessage *next = m->next;
+            Push(&queue, m);
+            m = next;
+        }
+    }
+    ScriptMessage *m;
+    while ((m = Pop(&queue))) {
+        // terminated by a handler before, or collected
+        ScriptWorker *w = FindWorker(m->from);
+        if (w && !JS_IsUndefined(w->object)) {
+            // the handler may drop the last reference to the Worker
+            JSValue target = JS_DupValue(ctx, w->object);
+            JSValue handler = JS_GetPropertyStr(ctx, target, "onmessage");
+            if (Deliver(ctx, handler, target, m) < 0) fe_js_dump_error(ctx);
+            JS_FreeValue(ctx, handler);
+            JS_FreeValue(ctx, target);
+        }
+        FreeMessage(m);
+    }
+    RunJobs(JS_GetRuntime(ctx));
+}
+
+void ScriptWorkersShutdown() {
+    while (g_workers) ScriptWorkerTerminate(g_workers);
+}
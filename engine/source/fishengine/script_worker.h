@@ -0,0 +1,57 @@
+#ifndef SCRIPT_WORKER_H
+#define SCRIPT_WORKER_H
+
+#include <stdint.h>
+
+#include <quickjs.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Script workers: a module evaluated in a QuickJS runtime of its own on a
+// thread of its own, for work that would take frames on the main thread, like
+// reading and converting the buffers of a model. A worker gets `std` and a
+// FishEngine module with the constants only; the world, the assets and the
+// renderer belong to the main thread.
+//
+// The two sides talk with postMessage(message, transfer) and
+// onmessage(message, buffers). The message is copied with JS_WriteObject, the
+// ArrayBuffers in `transfer` are detached on the sender and handed to the
+// receiver as `buffers`, in the same order. QuickJS can not move the memory of
+// an ArrayBuffer to another runtime, so a transfer copies each buffer once.
+
+typedef struct ScriptWorker ScriptWorker;
+
+// starts a thread that evaluates the module at `path`; what it posts goes to
+// the onmessage of `object`, which is not referenced and must free the worker
+// in its finalizer. NULL when the thread can not start.
+ScriptWorker *ScriptWorkerNew(JSContext *ctx, JSValueConst object,
+                              const char *path);
+
+// interrupts the script the worker is running, waits for the thread and drops
+// the messages still queued both ways; clears the opaque of the object
+void ScriptWorkerTerminate(ScriptWorker *worker);
+
+// from the finalizer of the object: interrupts the worker without waiting,
+// the thread is joined by ScriptWorkersDispatch once it returned
+void ScriptWorkerFree(ScriptWorker *worker);
+
+// queues a message for the onmessage of the worker; -1 with an exception
+// when the message can not be copied or `transfer` is not an array of
+// ArrayBuffers
+int ScriptWorkerPost(ScriptWorker *worker, JSContext *ctx,
+                     JSValueConst message, JSValueConst transfer);
+
+// calls the onmessage of the Worker objects with what their workers posted,
+// then runs the promise jobs; once a frame, outside of any script
+void ScriptWorkersDispatch(JSContext *ctx);
+
+// terminates all workers, at exit
+void ScriptWorkersShutdown();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCRIPT_WORKER_H */
@@ -1,10 +1,14 @@
 #include "shader.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <map>
 #include <string>
 #include <vector>
 
 #include "asset.h"
+#include "shader_archive.h"
 #include "shader_internal.hpp"
 #include "shader_util.h"
 #include <fmt/format.h>
@@ -74,6 +78,12 @@ void ShaderFree(void* s) {
     if (!s) return;
     Shader* shader = (Shader*)s;
     auto impl = (ShaderImpl*)shader->impl;
+    for (auto& pass : impl->passes) {
+        for (auto& var : pass.variants) {
+            DeleteShader(var.vertexShader);
+            DeleteShader(var.pixelShader);
+        }
+    }
     delete impl;
     free(s);
 }
@@ -85,6 +95,37 @@ void ShaderFree(void* s) {
 #include <vector>
 namespace fs = std::filesystem;
 
+static bool EndsWith(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() > n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// FETexture2D(name) declares nameTextureIndex and nameSamplerIndex; any
+// other uint is a plain value, whatever its name ends in
+ShaderConstantKind ShaderGetConstantKind(const std::string& name,
+                                         std::string* texture) {
+    ShaderConstantKind kind;
+    const char* suffix;
+    if (EndsWith(name, "SamplerIndex")) {
+        kind = ShaderConstantSamplerIndex;
+        suffix = "SamplerIndex";
+    } else if (EndsWith(name, "TextureIndex")) {
+        kind = ShaderConstantTextureIndex;
+        suffix = "TextureIndex";
+    } else {
+        return ShaderConstantValue;
+    }
+    *texture = name.substr(0, name.size() - strlen(suffix));
+    return kind;
+}
+
+static void SetupBindlessConstant(ShaderReflectCBType::Member& mem) {
+    std::string texture;
+    mem.kind = ShaderGetConstantKind(mem.name, &texture);
+    if (mem.kind != ShaderConstantValue)
+        mem.nameID = ShaderPropertyToID(texture.c_str());
+}
+
 static void LoadShaderReflectItemFromMemory(Memory json,
                                             ShaderReflectItem& item) {
     rapidjson::Document d;
@@ -149,22 +190,140 @@ static void LoadShaderReflectItemFromMemory(Memory json,
                 mem.bytes = 12;
             } else if (mem.type == "vec4") {
                 mem.bytes = 16;
+            } else if (mem.type == "uint") {
+                mem.bytes = 4;
             }
             mem.nameID = ShaderPropertyToID(mem.name.c_str());
+            if (mem.type == "uint") {
+                SetupBindlessConstant(mem);
+            }
             mem.offset = m["offset"].GetUint();
+            if (m.HasMember("used")) mem.used = m["used"].GetBool();
             item.globals.members.push_back(mem);
         }
     }
+    if (root.HasMember("types") && root["types"].HasMember("PerDrawUniforms")) {
+        auto& perDraw = root["types"]["PerDrawUniforms"];
+        for (auto& m : perDraw["members"].GetArray()) {
+            std::string name = m["name"].GetString();
+            if (name == "MATRIX_IT_M" && m.HasMember("used")) {
+                item.usesMatrixITM = m["used"].GetBool();
+            }
+        }
+    }
+}
+
+static ShaderArchive* g_shaderArchive = NULL;
+
+bool LoadShaderArchive(const char* directory) {
+    std::string path = directory;
+    path += "/shaders.pak";
+    ShaderArchiveClose(g_shaderArchive);
+    g_shaderArchive = ShaderArchiveOpen(path.c_str());
+    return g_shaderArchive != NULL;
+}
+
+// the archive entry named after the file of `path`, a view into the mapping
+static bool FindInArchive(const std::string& path, Memory* out) {
+    if (g_shaderArchive == NULL) return false;
+    const size_t slash = path.find_last_of("/\\");
+    const char* name =
+        slash == std::string::npos ? path.c_str() : path.c_str() + slash + 1;
+    return ShaderArchiveFind(g_shaderArchive, name, out);
+}
+
+static std::string ReadShaderFile(const std::string& path) {
+    Memory m;
+    if (FindInArchive(path, &m))
+        return std::string((const char*)m.buffer, m.byteLength);
+    return ReadFileAsString(path);
+}
+
+static ShaderHandle LoadCompiledShader(const std::string& path) {
+    Memory m;
+    if (FindInArchive(path, &m)) return CreateShaderFromMemory(m);
+    return CreateShaderFromCompiledFile(path.c_str());
 }
 
 static void LoadShaderReflectItemFromFile(const std::string& json_path,
                                           ShaderReflectItem& item) {
+    Memory m;
+    if (FindInArchive(json_path, &m)) {
+        LoadShaderReflectItemFromMemory(m, item);
+        return;
+    }
     auto json = ReadFileAsString(json_path);
     LoadShaderReflectItemFromMemory(
         MemoryMake((void*)json.c_str(), json.size()), item);
 }
 
-ShaderHandle CreateShaderFromCompiledFile(const char* path);
+// variant indices are mixed-radix numbers over the pass's multi_compiles,
+// the first multi_compile being the lowest digit (see
+// ShaderKeywordCombination in material.cpp)
+static void SetupInstancedVariants(ShaderPass& pass) {
+    uint32_t stride = 1;
+    for (auto& mc : pass.multiCompiles) {
+        auto it = std::find(mc.begin(), mc.end(), "INSTANCING_ON");
+        if (it != mc.end()) {
+            uint32_t on = (uint32_t)std::distance(mc.begin(), it);
+            uint32_t radix = (uint32_t)mc.size();
+            for (uint32_t i = 0; i < pass.variants.size(); ++i) {
+                uint32_t digit = (i / stride) % radix;
+                pass.variants[i].instancedVariant =
+                    (int32_t)(i - digit * stride + on * stride);
+            }
+            return;
+        }
+        stride *= (uint32_t)mc.size();
+    }
+}
+
+static bool EqualsNoCase(const char* a, const char* b) {
+    for (; *a && *b; ++a, ++b)
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b))
+            return false;
+    return *a == *b;
+}
+
+// optional "render_state" of a pass, with ShaderLab's values, e.g.
+//   {"cull": "Off", "ztest": "LEqual", "zwrite": "Off",
+//    "blend": "SrcAlpha OneMinusSrcAlpha"}
+static PipelineRenderState LoadRenderState(const rapidjson::Value& pass) {
+    PipelineRenderState s = PipelineRenderStateDefault();
+    if (!pass.HasMember("render_state")) return s;
+    auto& rs = pass["render_state"];
+    auto get = [&rs](const char* name) {
+        return rs.HasMember(name) && rs[name].IsString() ? rs[name].GetString()
+                                                         : "";
+    };
+
+    const char* cull = get("cull");
+    if (EqualsNoCase(cull, "Off"))
+        s.cullMode = PipelineCullOff;
+    else if (EqualsNoCase(cull, "Front"))
+        s.cullMode = PipelineCullFront;
+
+    static const std::pair<const char*, PipelineCompare> compares[] = {
+        {"Less", PipelineCompareLess},
+        {"LEqual", PipelineCompareLessEqual},
+        {"Greater", PipelineCompareGreater},
+        {"GEqual", PipelineCompareGreaterEqual},
+        {"Equal", PipelineCompareEqual},
+        {"Always", PipelineCompareAlways},
+    };
+    const char* ztest = get("ztest");
+    for (auto& [name, compare] : compares)
+        if (EqualsNoCase(ztest, name)) s.depthTest = compare;
+
+    if (EqualsNoCase(get("zwrite"), "Off")) s.depthWrite = 0;
+
+    const char* blend = get("blend");
+    if (EqualsNoCase(blend, "SrcAlpha OneMinusSrcAlpha"))
+        s.blendMode = PipelineBlendAlpha;
+    else if (EqualsNoCase(blend, "One One"))
+        s.blendMode = PipelineBlendAdditive;
+    return s;
+}
 
 Shader* ShaderFromFile(const char* path) {
     Shader* s = ShaderNew();
@@ -174,7 +333,7 @@ Shader* ShaderFromFile(const char* path) {
         rapidjson::Document d;
         std::string json_path = path;
         json_path += ".json";
-        std::string str = ReadFileAsString(json_path);
+        std::string str = ReadShaderFile(json_path);
         auto &root = d.Parse(str.c_str(), str.length());
         for (auto& kw : root["keywords"].GetArray()) {
             impl->keywords.push_back(kw.GetString());
@@ -198,6 +357,7 @@ Shader* ShaderFromFile(const char* path) {
         s->passCount = root["passes"].GetArray().Size();
         for (auto& p : root["passes"].GetArray()) {
             auto& sp = impl->passes.emplace_back();
+            sp.renderState = LoadRenderState(p);
             uint32_t variantCount = 1;
             for (auto& mc : p["multi_compiles"].GetArray()) {
                 auto& _mc = sp.multiCompiles.emplace_back();
@@ -212,15 +372,16 @@ Shader* ShaderFromFile(const char* path) {
                 auto& var = sp.variants[i];
                 std::string prefix = fmt::format("{}_{}_{}", path, passIdx, i);
                 std::string path = prefix + "_vs.cso";
-                var.vertexShader = CreateShaderFromCompiledFile(path.c_str());
+                var.vertexShader = LoadCompiledShader(path);
                 path = prefix + "_ps.cso";
-                var.pixelShader = CreateShaderFromCompiledFile(path.c_str());
+                var.pixelShader = LoadCompiledShader(path);
                 auto& reflect = var.reflect;
                 LoadShaderReflectItemFromFile(prefix + "_vs.reflect.json",
                                               reflect.vs);
                 LoadShaderReflectItemFromFile(prefix + "_ps.reflect.json",
                                               reflect.ps);
             }
+            SetupInstancedVariants(sp);
 
             passIdx++;
         }
@@ -229,6 +390,16 @@ Shader* ShaderFromFile(const char* path) {
     return s;
 }
 
+void ShaderGetPipelineInputs(Shader* s, uint32_t pass, uint32_t variant,
+                             ShaderHandle* vs, ShaderHandle* ps,
+                             PipelineRenderState* state) {
+    const ShaderPass& sp = ShaderGetImpl(s)->passes[pass];
+    const ShaderVariant& var = sp.variants[variant];
+    *vs = var.vertexShader;
+    *ps = var.pixelShader;
+    *state = sp.renderState;
+}
+
 int ShaderUtilGetPropertyCount(Shader* s) {
     return (int)ShaderGetImpl(s)->properties.size();
 }
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 
+#include "pipeline_cache.h"
 #include "rhi.h"
 
 #ifdef __cplusplus
@@ -46,7 +47,16 @@ typedef struct ShaderDesc ShaderDesc;
 
 Shader *ShaderNew();
 void ShaderFree(void *s);
+// reads the entries of the shader archive named after the files, the loose
+// files when there is no archive or it lacks an entry
 Shader *ShaderFromFile(const char *path);
+// opens shaders.pak in `directory` for ShaderFromFile; false if there is none
+bool LoadShaderArchive(const char *directory);
+
+// what the backends build the pipeline of a pass variant from
+void ShaderGetPipelineInputs(Shader *s, uint32_t pass, uint32_t variant,
+                             ShaderHandle *vs, ShaderHandle *ps,
+                             PipelineRenderState *state);
 
 // static method
 int ShaderPropertyToID(const char *name);
@@ -0,0 +1,154 @@
+#include "shader_archive.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct ShaderArchive {
+    const uint8_t *base;
+    size_t size;
+    const ShaderArchiveHeader *header;
+    const ShaderArchiveEntry *entries;
+    const uint32_t *buckets;
+    const char *names;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+static bool ShaderArchiveValidate(ShaderArchive *a) {
+    if (a->size < sizeof(ShaderArchiveHeader)) return false;
+    const ShaderArchiveHeader *h = (const ShaderArchiveHeader *)a->base;
+    if (h->magic != ShaderArchiveMagic || h->version != ShaderArchiveVersion)
+        return false;
+    if (h->bucketBits == 0 || h->bucketBits > 24) return false;
+    const uint64_t bucketCount = (1ull << h->bucketBits) + 1;
+    // the offsets are compared with what is left after them, a sum could wrap
+    if (h->entriesOffset > a->size ||
+        h->entryCount >
+            (a->size - h->entriesOffset) / sizeof(ShaderArchiveEntry))
+        return false;
+    if (h->bucketsOffset > a->size ||
+        bucketCount > (a->size - h->bucketsOffset) / sizeof(uint32_t))
+        return false;
+    if (h->namesOffset > a->size || h->namesSize > a->size - h->namesOffset)
+        return false;
+
+    a->header = h;
+    a->entries = (const ShaderArchiveEntry *)(a->base + h->entriesOffset);
+    a->buckets = (const uint32_t *)(a->base + h->bucketsOffset);
+    a->names = (const char *)(a->base + h->namesOffset);
+    if (a->buckets[bucketCount - 1] != h->entryCount) return false;
+    for (uint64_t i = 1; i < bucketCount; ++i) {
+        if (a->buckets[i] < a->buckets[i - 1]) return false;
+    }
+    for (uint32_t i = 0; i < h->entryCount; ++i) {
+        const ShaderArchiveEntry *e = a->entries + i;
+        // names are C strings, the data is followed by a zero byte
+        if ((uint64_t)e->nameOffset + e->nameLength >= h->namesSize ||
+            a->names[e->nameOffset + e->nameLength] != '\0')
+            return false;
+        if (e->offset > a->size || e->size >= a->size - e->offset ||
+            a->base[e->offset + e->size] != 0)
+            return false;
+    }
+    return true;
+}
+
+ShaderArchive *ShaderArchiveOpen(const char *path) {
+    ShaderArchive *a = (ShaderArchive *)malloc(sizeof(ShaderArchive));
+    memset(a, 0, sizeof(ShaderArchive));
+#ifdef _WIN32
+    a->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (a->file == INVALID_HANDLE_VALUE) goto FAIL;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(a->file, &size) || size.QuadPart == 0) goto FAIL;
+    a->size = (size_t)size.QuadPart;
+    a->mapping = CreateFileMappingA(a->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (a->mapping == NULL) goto FAIL;
+    a->base = (const uint8_t *)MapViewOfFile(a->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (a->base == NULL) goto FAIL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) goto FAIL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        goto FAIL;
+    }
+    a->size = (size_t)st.st_size;
+    void *p = mmap(NULL, a->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) goto FAIL;
+    a->base = (const uint8_t *)p;
+#endif
+
+    if (!ShaderArchiveValidate(a)) {
+        printf("[shader archive] invalid archive: %s\n", path);
+        goto FAIL;
+    }
+    return a;
+
+FAIL:
+    ShaderArchiveClose(a);
+    return NULL;
+}
+
+void ShaderArchiveClose(ShaderArchive *a) {
+    if (a == NULL) return;
+#ifdef _WIN32
+    if (a->base) UnmapViewOfFile(a->base);
+    if (a->mapping) CloseHandle(a->mapping);
+    if (a->file && a->file != INVALID_HANDLE_VALUE) CloseHandle(a->file);
+#else
+    if (a->base) munmap((void *)a->base, a->size);
+#endif
+    free(a);
+}
+
+uint32_t ShaderArchiveCount(const ShaderArchive *a) {
+    return a->header->entryCount;
+}
+
+const char *ShaderArchiveGetName(const ShaderArchive *a, uint32_t index) {
+    assert(index < a->header->entryCount);
+    return a->names + a->entries[index].nameOffset;
+}
+
+Memory ShaderArchiveGetData(const ShaderArchive *a, uint32_t index) {
+    assert(index < a->header->entryCount);
+    const ShaderArchiveEntry *e = a->entries + index;
+    return MemoryMake((void *)(a->base + e->offset), e->size);
+}
+
+int ShaderArchiveFindIndex(const ShaderArchive *a, const char *name) {
+    const uint64_t hash = ShaderArchiveHash(name);
+    const uint32_t b = ShaderArchiveBucket(hash, a->header->bucketBits);
+    // buckets hold ~1 entry on average, so this is a short linear probe
+    for (uint32_t i = a->buckets[b]; i < a->buckets[b + 1]; ++i) {
+        const ShaderArchiveEntry *e = a->entries + i;
+        if (e->nameHash == hash && strcmp(a->names + e->nameOffset, name) == 0)
+            return (int)i;
+    }
+    return -1;
+}
+
+bool ShaderArchiveFind(const ShaderArchive *a, const char *name, Memory *out) {
+    int index = ShaderArchiveFindIndex(a, name);
+    if (index < 0) return false;
+    *out = ShaderArchiveGetData(a, index);
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef SHADER_ARCHIVE_H
+#define SHADER_ARCHIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rhi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Packed shader archive (shaders.pak), written by tools/shaderpack.
+//
+// layout:
+//   ShaderArchiveHeader
+//   ShaderArchiveEntry entries[entryCount]  sorted by nameHash
+//   uint32_t buckets[(1 << bucketBits) + 1]  first entry of each hash bucket
+//   char names[]                             NUL-terminated entry names
+//   entry data, every entry starts on a ShaderArchiveAlignment boundary and
+//   is followed by at least one zero byte, so text entries (.reflect.json)
+//   can be used as C strings directly.
+//
+// All integers are little-endian.
+
+#define ShaderArchiveMagic 0x41534546u  // "FESA"
+#define ShaderArchiveVersion 1
+#define ShaderArchiveAlignment 4096
+
+typedef struct ShaderArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t bucketBits;
+    uint64_t entriesOffset;
+    uint64_t bucketsOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+} ShaderArchiveHeader;
+
+typedef struct ShaderArchiveEntry {
+    uint64_t nameHash;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+} ShaderArchiveEntry;
+
+typedef struct ShaderArchive ShaderArchive;
+
+// FNV-1a
+static inline uint64_t ShaderArchiveHash(const char *name) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const unsigned char *p = (const unsigned char *)name; *p; ++p) {
+        h ^= *p;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static inline uint32_t ShaderArchiveBucket(uint64_t hash, uint32_t bucketBits) {
+    return (uint32_t)(hash >> (64 - bucketBits));
+}
+
+// maps the whole file; returns NULL if the file is missing or malformed
+ShaderArchive *ShaderArchiveOpen(const char *path);
+void ShaderArchiveClose(ShaderArchive *archive);
+
+uint32_t ShaderArchiveCount(const ShaderArchive *archive);
+const char *ShaderArchiveGetName(const ShaderArchive *archive, uint32_t index);
+// zero-copy view into the mapping, valid until ShaderArchiveClose
+Memory ShaderArchiveGetData(const ShaderArchive *archive, uint32_t index);
+
+// returns the entry index, or -1 if not found
+int ShaderArchiveFindIndex(const ShaderArchive *archive, const char *name);
+bool ShaderArchiveFind(const ShaderArchive *archive, const char *name,
+                       Memory *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SHADER_ARCHIVE_H */
@@ -7,6 +7,20 @@
 
 #include "shader.h"
 
+// what a $Globals member holds; FETexture2D(name) in Common.hlsl declares
+// uint nameTextureIndex and nameSamplerIndex, their nameID is the one of the
+// texture property
+enum ShaderConstantKind {
+    ShaderConstantValue = 0,
+    ShaderConstantTextureIndex,
+    ShaderConstantSamplerIndex,
+};
+
+// the kind of a uint member by its name; for the two slots `texture` gets
+// the name of the texture property
+ShaderConstantKind ShaderGetConstantKind(const std::string& name,
+                                         std::string* texture);
+
 struct ShaderReflectCBType {
     struct Member {
         std::string name;
@@ -16,6 +30,7 @@ struct ShaderReflectCBType {
 
         uint32_t bytes = 0;
         bool used = true;
+        ShaderConstantKind kind = ShaderConstantValue;
     };
 
     std::string name;
@@ -45,6 +60,9 @@ struct ShaderReflectItem {
     std::vector<ShaderReflectTexture> images;
     std::vector<ShaderReflectTexture> samplers;
     uint32_t bindingMask = 0;
+    // PerDrawUniforms.MATRIX_IT_M is read by the shader; true when the
+    // reflection does not say
+    bool usesMatrixITM = true;
 };
 
 struct ShaderProperty {
@@ -65,12 +83,20 @@ struct ShaderVariant {
     ShaderHandle vertexShader = 0;
     ShaderHandle pixelShader = 0;
     ShaderReflect reflect;
+    // index of the same variant with INSTANCING_ON enabled, -1 if the pass
+    // has no instancing keyword
+    int32_t instancedVariant = -1;
+
+    bool UsesMatrixITM() const {
+        return reflect.vs.usesMatrixITM || reflect.ps.usesMatrixITM;
+    }
 };
 
 struct ShaderPass {
     std::vector<std::vector<std::string>> multiCompiles;
     std::vector<std::string> shaderFeatures;
     std::vector<ShaderVariant> variants;
+    PipelineRenderState renderState = PipelineRenderStateDefault();
 };
 
 struct ShaderImpl {
@@ -0,0 +1,66 @@
+#include "skinning_batch.h"
+
+#include <string.h>
+
+void SkinningBatchInit(SkinningBatch *b) {
+    array_init(&b->jobs, sizeof(SkinningJob), 64);
+    array_init(&b->palette, sizeof(float4x4), 1024);
+    b->vertexCount = 0;
+    b->groupCount = 0;
+}
+
+void SkinningBatchFree(SkinningBatch *b) {
+    array_free(&b->jobs);
+    array_free(&b->palette);
+}
+
+void SkinningBatchClear(SkinningBatch *b) {
+    b->jobs.size = 0;
+    b->palette.size = 0;
+    b->vertexCount = 0;
+    b->groupCount = 0;
+}
+
+uint32_t SkinningBatchAdd(SkinningBatch *b, uint32_t vertexCount,
+                          const float4x4 *bones, uint32_t boneCount,
+                          uint32_t sourceVertices, uint32_t sourceSkin) {
+    const uint32_t paletteOffset = b->palette.size;
+    if (paletteOffset + boneCount > b->palette.capacity) {
+        uint32_t capacity = b->palette.capacity * 2;
+        if (capacity < paletteOffset + boneCount)
+            capacity = paletteOffset + boneCount;
+        array_reserve(&b->palette, capacity);
+    }
+    memcpy((float4x4 *)b->palette.ptr + paletteOffset, bones,
+           boneCount * sizeof(float4x4));
+    b->palette.size += boneCount;
+
+    const uint32_t outputOffset = b->vertexCount;
+    // an empty mesh gets no job, a job without groups would break the search
+    if (vertexCount == 0) return outputOffset;
+    SkinningJob *job = (SkinningJob *)array_push(&b->jobs);
+    memset(job, 0, sizeof(*job));
+    job->firstGroup = b->groupCount;
+    job->vertexCount = vertexCount;
+    job->sourceVertices = sourceVertices;
+    job->sourceSkin = sourceSkin;
+    job->paletteOffset = paletteOffset;
+    job->outputOffset = outputOffset;
+    b->vertexCount += vertexCount;
+    b->groupCount += (vertexCount + SkinningGroupSize - 1) / SkinningGroupSize;
+    return outputOffset;
+}
+
+uint32_t SkinningBatchFindJob(const SkinningJob *jobs, uint32_t jobCount,
+                              uint32_t group) {
+    // the last job with firstGroup <= group
+    uint32_t lo = 0, hi = jobCount;
+    while (hi - lo > 1) {
+        uint32_t mid = (lo + hi) / 2;
+        if (jobs[mid].firstGroup <= group)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
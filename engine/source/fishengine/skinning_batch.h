@@ -0,0 +1,63 @@
+#ifndef SKINNING_BATCH_H
+#define SKINNING_BATCH_H
+
+#include <stdint.h>
+
+#include "array.h"
+#include "simd_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The skinned meshes of a frame are skinned together, with one dispatch:
+// their bone palettes are packed into one buffer, their skinned vertices
+// into one arena, and a job table tells every thread group which mesh it
+// works on. Thread groups are handed out per job, so a group never spans two
+// meshes and finds its job with a binary search over firstGroup (see
+// Internal-Skinning.comp). This file only builds the tables, the backends
+// upload them and dispatch.
+
+#define SkinningGroupSize 64
+
+// same layout as SkinningJob in Internal-Skinning.comp
+struct SkinningJob {
+    uint32_t firstGroup;
+    uint32_t vertexCount;
+    uint32_t sourceVertices;  // bindless slot of the mesh's vertices
+    uint32_t sourceSkin;      // bindless slot of its BoneWeights
+    uint32_t paletteOffset;   // first matrix of its bones in the palette
+    uint32_t outputOffset;    // first vertex of its output in the arena
+    uint32_t reserved[2];
+};
+typedef struct SkinningJob SkinningJob;
+
+struct SkinningBatch {
+    array jobs;     // SkinningJob, firstGroup is increasing
+    array palette;  // float4x4
+    uint32_t vertexCount;  // skinned vertices, the size the arena needs
+    uint32_t groupCount;   // of the dispatch
+};
+typedef struct SkinningBatch SkinningBatch;
+
+void SkinningBatchInit(SkinningBatch *b);
+void SkinningBatchFree(SkinningBatch *b);
+// starts the next frame, keeps the memory
+void SkinningBatchClear(SkinningBatch *b);
+
+// adds a mesh with its bones, returns where its skinned vertices start in the
+// arena
+uint32_t SkinningBatchAdd(SkinningBatch *b, uint32_t vertexCount,
+                          const float4x4 *bones, uint32_t boneCount,
+                          uint32_t sourceVertices, uint32_t sourceSkin);
+
+// index of the job thread group `group` works on, the search the shader
+// does; jobCount must not be 0
+uint32_t SkinningBatchFindJob(const SkinningJob *jobs, uint32_t jobCount,
+                              uint32_t group);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SKINNING_BATCH_H */
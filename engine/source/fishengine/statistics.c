@@ -2,6 +2,10 @@
 
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 struct statistics _statistics;
 
 void init_global_statistics() { memset(&_statistics, 0, sizeof(_statistics)); }
@@ -9,3 +13,24 @@ void init_global_statistics() { memset(&_statistics, 0, sizeof(_statistics)); }
 struct statistics *get_global_statistics() {
     return &_statistics;
 }
+
+#ifndef NDEBUG
+static volatile uint32_t g_heapAllocationCount;
+
+void count_heap_allocation() {
+#ifdef _WIN32
+    InterlockedIncrement((volatile LONG *)&g_heapAllocationCount);
+#else
+    __atomic_fetch_add(&g_heapAllocationCount, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+uint32_t reset_heap_allocation_count() {
+#ifdef _WIN32
+    volatile LONG *count = (volatile LONG *)&g_heapAllocationCount;
+    return (uint32_t)InterlockedExchange(count, 0);
+#else
+    return __atomic_exchange_n(&g_heapAllocationCount, 0, __ATOMIC_RELAXED);
+#endif
+}
+#endif
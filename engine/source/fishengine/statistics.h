@@ -5,12 +5,34 @@
 
 struct gpu_statistics {
     uint32_t drawCall;
+    uint32_t pipelineChanges;
+    uint32_t materialChanges;
+    uint32_t meshChanges;
+    uint32_t redundantBindsSkipped;
+    uint32_t instancedDrawCall;  // included in drawCall
+    uint32_t instanceCount;      // objects drawn by instanced draws
     uint32_t bufferCount;
     uint32_t bufferSize;
     uint32_t textureCount;
     uint32_t textureSize;
     uint32_t renderTextureCount;
     uint32_t renderTextureSize;
+    uint32_t dynamicUploadSize;  // written to the upload ring this frame
+    uint32_t staticUploadSize;   // copied by the copy queue this frame
+    uint32_t bindlessTextureCount;  // live slots of the texture table
+    uint32_t pipelineCount;         // pipelines created in this session
+    uint32_t pipelineCacheHits;     // of those, found in the pipeline cache
+    uint32_t pipelinesPending;      // compiling in the background
+    uint32_t drawsSkipped;  // this frame, their pipeline was not ready
+    uint32_t skinningDispatches;  // this frame, 1 with any skinned mesh
+    uint32_t skinnedVertices;     // this frame, size of the skinned arena
+    // texture streaming (texture_streaming.h), sizes in bytes
+    uint32_t streamedTextureCount;
+    uint32_t streamingResidentSize;  // mips on the gpu, tails included
+    uint32_t streamingWantedSize;    // what this frame's views ask for
+    uint32_t streamingBudget;
+    uint32_t mipsStreamedIn;  // this frame
+    uint32_t mipsEvicted;     // this frame
 };
 
 struct asset_statistics {
@@ -24,6 +46,24 @@ struct cpu_statistics {
     uint32_t textureSize;
     uint32_t ecsSize;
     uint32_t uploadHeapSize;
+    uint32_t visibleRenderables;  // last RenderQueueGather
+    uint32_t culledRenderables;
+    uint32_t frameAllocSize;        // frame_alloc.h, last frame, all threads
+    uint32_t frameAllocPeak;        // high-water mark of frameAllocSize
+    uint32_t frameAllocBlockCount;  // blocks kept by all threads
+    // heap allocations counted in the last frame: array growth, frame
+    // allocator blocks and every C++ operator new (heap_count.cpp). The
+    // malloc calls of C code and of the libraries are not seen, the JS
+    // runtime's are in scriptAllocations. 0 in release builds
+    uint32_t heapAllocations;
+    // script_profiler.h, last frame
+    uint32_t scriptTimeUs;         // in JS systems and callbacks
+    uint32_t scriptHeapSize;       // held by the JS runtime
+    uint32_t scriptAllocations;    // made by the JS runtime
+    uint32_t scriptAllocatedSize;
+    uint32_t scriptFreedSize;      // a collection shows up here
+    uint32_t scriptObjectCount;    // refreshed every 60 frames
+    uint32_t scriptGCTimeUs;       // collecting, see script_gc.h
 };
 
 struct statistics {
@@ -37,6 +77,16 @@ extern "C" {
 
 void init_global_statistics();
 struct statistics *get_global_statistics();
+// thread safe, see cpu_statistics.heapAllocations; debug builds only, the
+// counter is left out with NDEBUG
+#ifdef NDEBUG
+static inline void count_heap_allocation() {}
+static inline uint32_t reset_heap_allocation_count() { return 0; }
+#else
+void count_heap_allocation();
+// returns the count since the last call and starts over
+uint32_t reset_heap_allocation_count();
+#endif
 
 #ifdef __cplusplus
 }
@@ -1,10 +1,26 @@
 #include "texture.h"
 
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "asset.h"
 #include "rhi.h"
+#include "statistics.h"
+#include "texture_streaming.h"
+
+static TextureStreamer g_Streamer;
+// requests are made for the current frame, a texture last used in an older
+// one is a candidate for eviction; 0 is "never"
+static uint64_t g_StreamingFrame = 1;
+static uint32_t g_ViewportHeight = 1080;
+
+static TextureStreamer *GetStreamer() {
+    if (g_Streamer.textures.ptr == NULL)
+        TextureStreamerInit(&g_Streamer, TextureStreamingDefaultBudget);
+    return &g_Streamer;
+}
 
 void *TextureNew() {
     Texture *t = malloc(sizeof(Texture));
@@ -21,6 +37,9 @@ void TextureFree(void *t) {
     if (!t) return;
     Texture *texture = t;
     DeleteTexture(texture->handle);
+    if (texture->streaming != 0)
+        TextureStreamerRemove(GetStreamer(), texture->streaming);
+    free(texture->mips);
     free(t);
 }
 
@@ -28,73 +47,158 @@ void TextureSetWrapMode(Texture *t, TextureWrapMode mode) {
     t->wrapModeU = t->wrapModeV = t->wrapModeW = mode;
 }
 
-#if APPLE
+// creates a texture of mips [first, mipmaps) of the mapped file
+static TextureHandle CreateResidentTexture(const Texture *t,
+                                           const uint8_t *data,
+                                           uint32_t first) {
+    const TextureMip *mips = t->mips;
+    Memory m[TextureMaxMips];
+    for (uint32_t i = first; i < t->mipmaps; ++i)
+        m[i - first] =
+            MemoryMake((void *)(data + mips[i].offset), mips[i].byteLength);
+    TextureDesc desc;
+    desc.width = mips[first].width;
+    desc.height = mips[first].height;
+    desc.depth = 1;
+    desc.arraySize = 1;
+    desc.mipmaps = t->mipmaps - first;
+    desc.format = t->format;
+    desc.dimension = TextureDimensionTex2D;
+    return CreateTextureFromSubresources(&desc, m);
+}
 
-#include "ddsloader.h"
+static Texture *NewTexture(const TextureDesc *desc) {
+    Texture *t = TextureNew();
+    t->width = desc->width;
+    t->height = desc->height;
+    t->mipmaps = desc->mipmaps;
+    t->format = desc->format;
+    t->dimension = desc->dimension;
+    return t;
+}
 
-Texture *TextureFromDDSFile(const char *path) {
-    TextureDesc desc;
-    Texture *t = NULL;
-    uint32_t byteLength;
-    uint8_t *bytes = loadDDS(path, &desc, &byteLength);
-    if (!bytes) {
+// everything but the mip tail is streamed in later
+static Texture *LoadMipTail(const DDSFile *f) {
+    Texture *t = NewTexture(&f->desc);
+    t->mips = malloc(f->desc.mipmaps * sizeof(TextureMip));
+    count_heap_allocation();
+    memcpy(t->mips, f->subresources, f->desc.mipmaps * sizeof(TextureMip));
+    t->residentMip =
+        TextureStreamingTailMip(t->width, t->height, t->mipmaps);
+    t->handle = CreateResidentTexture(t, f->data, t->residentMip);
+    if (t->handle == 0) {
+        AssetDelete(t->assetID);
         return NULL;
     }
-    Memory m = MemoryMake(bytes, byteLength);
-    uint32_t handle = CreateTexture(desc.width, desc.height, desc.mipmaps, m);
-    if (handle == 0) {
-        goto fail;
-    }
-    t = TextureNew();
-    t->width = desc.width;
-    t->height = desc.height;
-    t->mipmaps = desc.mipmaps;
-    t->handle = handle;
-fail:
-    free(bytes);
+    uint64_t mipSize[TextureMaxMips];
+    for (uint32_t i = 0; i < t->mipmaps; ++i)
+        mipSize[i] = t->mips[i].byteLength;
+    t->streaming = TextureStreamerAdd(GetStreamer(), mipSize, t->mipmaps,
+                                      t->residentMip, t);
     return t;
 }
 
-#else
-#include "ddsloader.h"
+// cubemaps, arrays, volumes and small textures
+static Texture *LoadWhole(const DDSFile *f) {
+    Memory *m = malloc(f->subresourceCount * sizeof(Memory));
+    count_heap_allocation();
+    for (uint32_t i = 0; i < f->subresourceCount; ++i)
+        m[i] = MemoryMake((void *)(f->data + f->subresources[i].offset),
+                          f->subresources[i].byteLength);
+    TextureHandle handle = CreateTextureFromSubresources(&f->desc, m);
+    free(m);
+    if (handle == 0) return NULL;
+    Texture *t = NewTexture(&f->desc);
+    t->handle = handle;
+    return t;
+}
 
 Texture *TextureFromDDSFile(const char *path) {
-    FILE *f = fopen(path, "rb");
-    if (!f) {
-        return NULL;
-    }
-
-    fseek(f, 0, SEEK_END);
-    size_t byteLength = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    uint8_t *bytes = malloc(byteLength);
-    fread(bytes, byteLength, 1, f);
-    fclose(f);
-
-    if (!bytes) {
+    DDSFile f;
+    DDSResult result = DDSOpen(path, &f);
+    if (result != DDSOk) {
+        printf("[texture] %s: %s\n", path, DDSResultString(result));
         return NULL;
     }
-
     Texture *t = NULL;
-    TextureDesc desc;
-    Memory m = MemoryMake(bytes, byteLength);
-    uint32_t handle = CreateTexture(m, &desc);
-    if (handle == 0) {
-        goto fail;
-    }
-    t = TextureNew();
-    t->width = desc.width;
-    t->height = desc.height;
-    t->mipmaps = desc.mipmaps;
-    t->handle = handle;
+    if (f.desc.dimension == TextureDimensionTex2D &&
+        TextureStreamingTailMip(f.desc.width, f.desc.height, f.desc.mipmaps) >
+            0)
+        t = LoadMipTail(&f);
+    else
+        t = LoadWhole(&f);
+    DDSClose(&f);
+    if (t == NULL) return NULL;
 
     Asset *a = AssetGet(t->assetID);
     a->fromFile = true;
-    strncat(a->filePath, path, min(countof(a->filePath), strlen(path)));
-
-fail:
-    free(bytes);
+    snprintf(a->filePath, sizeof(a->filePath), "%s", path);
     return t;
 }
 
-#endif
\ No newline at end of file
+void TextureStreamingSetBudget(uint64_t bytes) {
+    GetStreamer()->budget = bytes;
+}
+
+void TextureStreamingSetViewportHeight(uint32_t pixels) {
+    if (pixels > 0) g_ViewportHeight = pixels;
+}
+
+float TextureStreamingScreenSize(float radius, float distance,
+                                 float fieldOfView) {
+    // the camera is inside, the object covers the whole view
+    if (distance <= radius) return (float)g_ViewportHeight;
+    float halfHeight = distance * tanf(fieldOfView * 0.5f * 3.14159265f / 180);
+    return g_ViewportHeight * radius / halfHeight;
+}
+
+void TextureStreamingRequest(Texture *t, float screenSize) {
+    if (t->streaming == 0) return;
+    uint32_t mip = TextureStreamingMipForScreenSize(t->width, t->height,
+                                                    t->mipmaps, screenSize);
+    TextureStreamerRequest(GetStreamer(), t->streaming, mip,
+                           g_StreamingFrame);
+}
+
+static uint32_t ClampU32(uint64_t x) {
+    return x > UINT32_MAX ? UINT32_MAX : (uint32_t)x;
+}
+
+void TextureStreamingUpdate() {
+    TextureStreamer *s = GetStreamer();
+    TextureStreamerUpdate(s, g_StreamingFrame, TextureStreamingMaxLoadPerFrame);
+    const TextureStreamingChange *changes =
+        (const TextureStreamingChange *)s->changes.ptr;
+    for (uint32_t i = 0; i < s->changes.size; ++i) {
+        Texture *t = (Texture *)changes[i].user;
+        // the old texture stays alive until the gpu is done with it, the new
+        // one is sampled from the next material bind on
+        TextureHandle handle = 0;
+        DDSFile f;
+        if (DDSOpen(AssetGet(t->assetID)->filePath, &f) == DDSOk) {
+            // the file may have been replaced since the texture was loaded
+            const uint32_t mip = changes[i].residentMip;
+            if (f.desc.dimension == TextureDimensionTex2D &&
+                f.desc.mipmaps == t->mipmaps && f.desc.format == t->format &&
+                memcmp(f.subresources, t->mips,
+                       t->mipmaps * sizeof(TextureMip)) == 0)
+                handle = CreateResidentTexture(t, f.data, mip);
+            DDSClose(&f);
+        }
+        if (handle == 0) {
+            TextureStreamerSetResident(s, t->streaming, t->residentMip);
+            continue;
+        }
+        DeleteTexture(t->handle);
+        t->handle = handle;
+        t->residentMip = changes[i].residentMip;
+    }
+    g_StreamingFrame++;
+
+    g_statistics.gpu.streamedTextureCount = s->textureCount;
+    g_statistics.gpu.streamingResidentSize = ClampU32(s->residentBytes);
+    g_statistics.gpu.streamingWantedSize = ClampU32(s->wantedBytes);
+    g_statistics.gpu.streamingBudget = ClampU32(s->budget);
+    g_statistics.gpu.mipsStreamedIn = s->mipsLoaded;
+    g_statistics.gpu.mipsEvicted = s->mipsEvicted;
+}
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "asset.h"
+#include "ddsloader.h"
 #include "texture_format.h"
 
 #ifdef __cplusplus
@@ -26,18 +27,6 @@ typedef enum {
     _TextureWrapModeCount,
 } TextureWrapMode;
 
-typedef enum {
-    TextureDimensionUnknown = -1,
-    TextureDimensionNone,
-    TextureDimensionAny,
-    TextureDimensionTex2D,
-    TextureDimensionTex2DArray,
-    TextureDimensionTex3D,
-    TextureDimensionCube,
-    TextureDimensionCubeArray,
-} TextureDimension;
-
-
 typedef enum {
     RenderTextureFormatARGB32 = 0,
     RenderTextureFormatDepth,
@@ -89,14 +78,42 @@ struct Texture {
     TextureWrapMode wrapModeV;
     TextureWrapMode wrapModeW;
     uint32_t anisoLevel;
+
+    // streamed textures (texture_streaming.h) only have the mips from
+    // residentMip on in `handle`; width, height and mipmaps are the file's
+    uint32_t streaming;  // TextureStreamer handle, 0 if fully resident
+    uint32_t residentMip;
+    TextureFormat format;
+    TextureMip *mips;  // where the mips are in the file
 };
 typedef struct Texture Texture;
 
 void *TextureNew();
 void TextureFree(void *);
 void TextureSetWrapMode(Texture *t, TextureWrapMode mode);
+// 2D textures bigger than the mip tail are streamed, cubemaps, arrays and
+// volumes are loaded as a whole; NULL for files DDSOpen rejects
 Texture *TextureFromDDSFile(const char *path);
 
+// Texture streaming. The budget covers the mips of streamed textures, tails
+// included; the tails are always resident, even over budget.
+#define TextureStreamingDefaultBudget (512ull << 20)
+// newly resident mips per TextureStreamingUpdate
+#define TextureStreamingMaxLoadPerFrame (16u << 20)
+void TextureStreamingSetBudget(uint64_t bytes);
+// set by the backends, screen sizes are measured in its pixels
+void TextureStreamingSetViewportHeight(uint32_t pixels);
+// pixels covered by an object of bounding radius `radius` at `distance` from
+// a camera with a vertical field of view of fieldOfView degrees
+float TextureStreamingScreenSize(float radius, float distance,
+                                 float fieldOfView);
+// the texture is used by an object of screenSize pixels this frame; a no-op
+// for textures that are not streamed
+void TextureStreamingRequest(Texture *t, float screenSize);
+// once per frame after the requests: recreates the textures whose resident
+// mips changed and updates the residency statistics
+void TextureStreamingUpdate();
+
 #ifdef __cplusplus
 }
 #endif
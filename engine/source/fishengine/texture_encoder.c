@@ -0,0 +1,1045 @@
+#include "texture_encoder.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include "ddsloader.h"
+#include "jobs.h"
+#include "statistics.h"
+
+// part of the tag of every file, bump it when the encoder output changes so
+// that existing files are encoded again
+#define TextureEncoderVersion 1
+
+bool TextureEncodeFormatSupported(TextureFormat format) {
+    switch (format) {
+        case TextureFormatDXT1:
+        case TextureFormatDXT1_sRGB:
+        case TextureFormatDXT5:
+        case TextureFormatDXT5_sRGB:
+        case TextureFormatBC4:
+        case TextureFormatBC5:
+        case TextureFormatBC7:
+        case TextureFormatBC7_sRGB:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const char *TextureEncodeQualityName(TextureEncodeQuality quality) {
+    switch (quality) {
+        case TextureEncodeQualityFast:
+            return "fast";
+        case TextureEncodeQualityNormal:
+            return "normal";
+        case TextureEncodeQualityHigh:
+            return "high";
+        default:
+            return "unknown";
+    }
+}
+
+static bool IsSRGB(TextureFormat format) {
+    return format == TextureFormatDXT1_sRGB ||
+           format == TextureFormatDXT5_sRGB || format == TextureFormatBC7_sRGB;
+}
+
+// refinement passes after the initial endpoints
+static uint32_t Iterations(TextureEncodeQuality quality) {
+    switch (quality) {
+        case TextureEncodeQualityFast:
+            return 0;
+        case TextureEncodeQualityNormal:
+            return 1;
+        default:
+            return 8;
+    }
+}
+
+static float Clamp255(float x) { return x < 0 ? 0 : (x > 255 ? 255 : x); }
+
+// a 4x4 block, channel planar: c[channel][y * 4 + x], values 0..255
+typedef struct {
+    float c[4][16];
+} Block;
+
+// the nearest of the `count` palette entries (channel planar as well) for
+// each pixel over the first `channels` channels, ties go to the lower index;
+// returns the summed squared error
+static float FitIndices(const float (*pixels)[16], const float (*palette)[16],
+                        uint32_t channels, uint32_t count,
+                        uint8_t indices[16]) {
+    float error = 0;
+#if defined(__AVX__)
+    for (int half = 0; half < 16; half += 8) {
+        __m256 p[4];
+        for (uint32_t c = 0; c < channels; ++c)
+            p[c] = _mm256_loadu_ps(pixels[c] + half);
+        __m256 best = _mm256_set1_ps(FLT_MAX);
+        __m256 bestIndex = _mm256_setzero_ps();
+        for (uint32_t i = 0; i < count; ++i) {
+            __m256 d = _mm256_setzero_ps();
+            for (uint32_t c = 0; c < channels; ++c) {
+                __m256 e = _mm256_sub_ps(p[c], _mm256_set1_ps(palette[c][i]));
+                d = _mm256_add_ps(d, _mm256_mul_ps(e, e));
+            }
+            __m256 closer = _mm256_cmp_ps(d, best, _CMP_LT_OQ);
+            best = _mm256_min_ps(d, best);
+            bestIndex =
+                _mm256_blendv_ps(bestIndex, _mm256_set1_ps((float)i), closer);
+        }
+        float e[8];
+        int32_t index[8];
+        _mm256_storeu_ps(e, best);
+        _mm256_storeu_si256((__m256i *)index, _mm256_cvttps_epi32(bestIndex));
+        for (int k = 0; k < 8; ++k) {
+            indices[half + k] = (uint8_t)index[k];
+            error += e[k];
+        }
+    }
+#else
+    // same search pixel by pixel, written so the compiler can vectorize
+    float best[16];
+    uint32_t bestIndex[16];
+    for (int k = 0; k < 16; ++k) {
+        best[k] = FLT_MAX;
+        bestIndex[k] = 0;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        float d[16] = {0};
+        for (uint32_t c = 0; c < channels; ++c) {
+            for (int k = 0; k < 16; ++k) {
+                float e = pixels[c][k] - palette[c][i];
+                d[k] += e * e;
+            }
+        }
+        for (int k = 0; k < 16; ++k) {
+            bestIndex[k] = d[k] < best[k] ? i : bestIndex[k];
+            best[k] = d[k] < best[k] ? d[k] : best[k];
+        }
+    }
+    for (int k = 0; k < 16; ++k) {
+        indices[k] = (uint8_t)bestIndex[k];
+        error += best[k];
+    }
+#endif
+    return error;
+}
+
+static float PixelError(const float (*pixels)[16], const float (*palette)[16],
+                        uint32_t channels, int k, uint32_t index) {
+    float d = 0;
+    for (uint32_t c = 0; c < channels; ++c) {
+        float e = pixels[c][k] - palette[c][index];
+        d += e * e;
+    }
+    return d;
+}
+
+// least squares endpoints for fixed indices: weights[i] is the share of the
+// second endpoint in palette entry i, negative for entries that are not
+// interpolated. False if the indices do not determine both endpoints.
+static bool RefineEndpoints(const float (*pixels)[16], uint32_t channels,
+                            const uint8_t indices[16], const float *weights,
+                            float e0[4], float e1[4]) {
+    float a = 0, b = 0, c = 0;
+    float x0[4] = {0}, x1[4] = {0};
+    for (int k = 0; k < 16; ++k) {
+        const float w = weights[indices[k]];
+        if (w < 0) continue;
+        const float v = 1 - w;
+        a += v * v;
+        b += v * w;
+        c += w * w;
+        for (uint32_t ch = 0; ch < channels; ++ch) {
+            x0[ch] += v * pixels[ch][k];
+            x1[ch] += w * pixels[ch][k];
+        }
+    }
+    const float det = a * c - b * b;
+    if (fabsf(det) < 1e-4f) return false;
+    for (uint32_t ch = 0; ch < channels; ++ch) {
+        e0[ch] = Clamp255((c * x0[ch] - b * x1[ch]) / det);
+        e1[ch] = Clamp255((a * x1[ch] - b * x0[ch]) / det);
+    }
+    return true;
+}
+
+// endpoints of a line through the pixels in `mask`: the principal axis, or
+// the bounding box diagonal that follows the correlation of the channels
+static void FindEndpoints(const float (*pixels)[16], uint32_t channels,
+                          uint32_t mask, bool principalAxis, float e0[4],
+                          float e1[4]) {
+    float mean[4] = {0}, lo[4], hi[4];
+    float n = 0;
+    for (uint32_t c = 0; c < channels; ++c) {
+        lo[c] = 255;
+        hi[c] = 0;
+    }
+    for (int k = 0; k < 16; ++k) {
+        if (!(mask >> k & 1)) continue;
+        n++;
+        for (uint32_t c = 0; c < channels; ++c) {
+            const float v = pixels[c][k];
+            mean[c] += v;
+            lo[c] = v < lo[c] ? v : lo[c];
+            hi[c] = v > hi[c] ? v : hi[c];
+        }
+    }
+    if (n == 0) {
+        memset(e0, 0, 4 * sizeof(float));
+        memset(e1, 0, 4 * sizeof(float));
+        return;
+    }
+    for (uint32_t c = 0; c < channels; ++c) mean[c] /= n;
+
+    float cov[4][4] = {{0}};
+    for (int k = 0; k < 16; ++k) {
+        if (!(mask >> k & 1)) continue;
+        for (uint32_t i = 0; i < channels; ++i) {
+            const float di = pixels[i][k] - mean[i];
+            for (uint32_t j = i; j < channels; ++j)
+                cov[i][j] += di * (pixels[j][k] - mean[j]);
+        }
+    }
+    for (uint32_t i = 0; i < channels; ++i)
+        for (uint32_t j = 0; j < i; ++j) cov[i][j] = cov[j][i];
+
+    // the diagonal of the box, flipped along the channels that fall while
+    // the widest one rises
+    uint32_t widest = 0;
+    for (uint32_t c = 1; c < channels; ++c)
+        if (hi[c] - lo[c] > hi[widest] - lo[widest]) widest = c;
+    float axis[4];
+    for (uint32_t c = 0; c < channels; ++c) {
+        axis[c] = hi[c] - lo[c];
+        if (cov[widest][c] < 0) axis[c] = -axis[c];
+    }
+
+    if (!principalAxis) {
+        // pulled in a little, the extremes are rarely worth a palette entry
+        for (uint32_t c = 0; c < channels; ++c) {
+            const float inset = (hi[c] - lo[c]) / 16;
+            float a = lo[c] + inset, b = hi[c] - inset;
+            if (axis[c] < 0) {
+                float t = a;
+                a = b;
+                b = t;
+            }
+            e0[c] = a;
+            e1[c] = b;
+        }
+        return;
+    }
+
+    // power iteration from the diagonal
+    for (int it = 0; it < 8; ++it) {
+        float next[4] = {0}, length = 0;
+        for (uint32_t i = 0; i < channels; ++i) {
+            for (uint32_t j = 0; j < channels; ++j)
+                next[i] += cov[i][j] * axis[j];
+            length = fabsf(next[i]) > length ? fabsf(next[i]) : length;
+        }
+        if (length < 1e-6f) break;
+        for (uint32_t i = 0; i < channels; ++i) axis[i] = next[i] / length;
+    }
+    float length = 0;
+    for (uint32_t c = 0; c < channels; ++c) length += axis[c] * axis[c];
+    if (length < 1e-12f) {
+        for (uint32_t c = 0; c < channels; ++c) e0[c] = e1[c] = mean[c];
+        return;
+    }
+    length = sqrtf(length);
+    for (uint32_t c = 0; c < channels; ++c) axis[c] /= length;
+
+    float tmin = FLT_MAX, tmax = -FLT_MAX;
+    for (int k = 0; k < 16; ++k) {
+        if (!(mask >> k & 1)) continue;
+        float t = 0;
+        for (uint32_t c = 0; c < channels; ++c)
+            t += (pixels[c][k] - mean[c]) * axis[c];
+        tmin = t < tmin ? t : tmin;
+        tmax = t > tmax ? t : tmax;
+    }
+    for (uint32_t c = 0; c < channels; ++c) {
+        e0[c] = Clamp255(mean[c] + tmin * axis[c]);
+        e1[c] = Clamp255(mean[c] + tmax * axis[c]);
+    }
+}
+
+// BC1: two RGB565 endpoints and 2 bit indices. c0 > c1 selects 4 colors,
+// otherwise 3 and transparent black.
+
+static uint16_t To565(const float c[4]) {
+    const uint32_t r = (uint32_t)(c[0] * 31 / 255 + 0.5f);
+    const uint32_t g = (uint32_t)(c[1] * 63 / 255 + 0.5f);
+    const uint32_t b = (uint32_t)(c[2] * 31 / 255 + 0.5f);
+    return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+static void From565(uint16_t v, float c[3]) {
+    const uint32_t r = v >> 11, g = v >> 5 & 63, b = v & 31;
+    c[0] = (float)(r << 3 | r >> 2);
+    c[1] = (float)(g << 2 | g >> 4);
+    c[2] = (float)(b << 3 | b >> 2);
+}
+
+static const float BC1Weights4[4] = {0, 1, 1.f / 3, 2.f / 3};
+static const float BC1Weights3[4] = {0, 1, 0.5f, -1};
+
+typedef struct {
+    uint16_t c0, c1;
+    uint8_t indices[16];
+    float error;
+} BC1Result;
+
+// indices for the quantized endpoints in the order the mode wants them
+static void BC1Fit(const Block *b, uint32_t transparent, const float e0[4],
+                   const float e1[4], BC1Result *r) {
+    uint16_t c0 = To565(e0), c1 = To565(e1);
+    const bool threeColor = transparent != 0;
+    if (threeColor ? c0 > c1 : c0 < c1) {
+        uint16_t t = c0;
+        c0 = c1;
+        c1 = t;
+    }
+    float a[3], z[3], palette[3][16];
+    From565(c0, a);
+    From565(c1, z);
+    for (int c = 0; c < 3; ++c) {
+        palette[c][0] = a[c];
+        palette[c][1] = z[c];
+        if (threeColor) {
+            palette[c][2] = (a[c] + z[c]) / 2;
+        } else {
+            palette[c][2] = (2 * a[c] + z[c]) / 3;
+            palette[c][3] = (a[c] + 2 * z[c]) / 3;
+        }
+    }
+    // with c0 == c1 every entry is the same color and the ties pick index 0,
+    // which also means the same in the 3 color mode that c0 == c1 selects
+    r->c0 = c0;
+    r->c1 = c1;
+    r->error = FitIndices(b->c, palette, 3, threeColor ? 3 : 4, r->indices);
+    for (int k = 0; k < 16; ++k) {
+        if (!(transparent >> k & 1)) continue;
+        r->error -= PixelError(b->c, palette, 3, k, r->indices[k]);
+        r->indices[k] = 3;
+    }
+}
+
+// `alpha` allows the transparent entry for pixels with alpha below 128
+static void EncodeBC1(const Block *b, TextureEncodeQuality quality,
+                      bool alpha, uint8_t *out) {
+    uint32_t transparent = 0;
+    if (alpha) {
+        for (int k = 0; k < 16; ++k)
+            transparent |= (uint32_t)(b->c[3][k] < 128) << k;
+    }
+    BC1Result best;
+    if (transparent == 0xffff) {
+        best.c0 = best.c1 = 0;
+        memset(best.indices, 3, 16);
+    } else {
+        const uint32_t mask = ~transparent & 0xffff;
+        float e0[4], e1[4];
+        FindEndpoints(b->c, 3, mask, false, e0, e1);
+        BC1Fit(b, transparent, e0, e1, &best);
+        if (quality != TextureEncodeQualityFast) {
+            // the box is better for some blocks, the axis for most
+            float a0[4], a1[4];
+            BC1Result r;
+            FindEndpoints(b->c, 3, mask, true, a0, a1);
+            BC1Fit(b, transparent, a0, a1, &r);
+            if (r.error < best.error) {
+                best = r;
+                memcpy(e0, a0, sizeof(e0));
+                memcpy(e1, a1, sizeof(e1));
+            }
+        }
+        const float *weights = transparent ? BC1Weights3 : BC1Weights4;
+        for (uint32_t it = Iterations(quality); it > 0; --it) {
+            BC1Result r;
+            if (!RefineEndpoints(b->c, 3, best.indices, weights, e0, e1))
+                break;
+            BC1Fit(b, transparent, e0, e1, &r);
+            if (r.error >= best.error) break;
+            best = r;
+        }
+    }
+    uint32_t bits = 0;
+    for (int k = 0; k < 16; ++k) bits |= (uint32_t)best.indices[k] << (2 * k);
+    out[0] = (uint8_t)best.c0;
+    out[1] = (uint8_t)(best.c0 >> 8);
+    out[2] = (uint8_t)best.c1;
+    out[3] = (uint8_t)(best.c1 >> 8);
+    memcpy(out + 4, &bits, 4);
+}
+
+// BC4: two 8 bit endpoints and 3 bit indices. e0 > e1 interpolates 6 values
+// between them, otherwise 4 and adds 0 and 255.
+
+static const float BC4Weights8[8] = {0,       1,       1.f / 7, 2.f / 7,
+                                     3.f / 7, 4.f / 7, 5.f / 7, 6.f / 7};
+static const float BC4Weights6[8] = {0,       1,       1.f / 5, 2.f / 5,
+                                     3.f / 5, 4.f / 5, -1,      -1};
+
+typedef struct {
+    uint8_t e0, e1;
+    uint8_t indices[16];
+    float error;
+} BC4Result;
+
+static void BC4Fit(const float (*values)[16], uint32_t e0, uint32_t e1,
+                   BC4Result *r) {
+    float palette[1][16];
+    const float *weights = e0 > e1 ? BC4Weights8 : BC4Weights6;
+    for (int i = 0; i < 8; ++i) {
+        if (weights[i] >= 0)
+            palette[0][i] = e0 + (float)((int)e1 - (int)e0) * weights[i];
+    }
+    if (e0 <= e1) {
+        palette[0][6] = 0;
+        palette[0][7] = 255;
+    }
+    r->e0 = (uint8_t)e0;
+    r->e1 = (uint8_t)e1;
+    r->error = FitIndices(values, palette, 1, 8, r->indices);
+}
+
+// least squares passes that keep the mode of `best`
+static void BC4Refine(const float (*values)[16], uint32_t iterations,
+                      BC4Result *best) {
+    const bool eight = best->e0 > best->e1;
+    for (; iterations > 0; --iterations) {
+        float e0[4], e1[4];
+        if (!RefineEndpoints(values, 1, best->indices,
+                             eight ? BC4Weights8 : BC4Weights6, e0, e1))
+            break;
+        uint32_t a = (uint32_t)(e0[0] + 0.5f), b = (uint32_t)(e1[0] + 0.5f);
+        if (eight ? a < b : a > b) {
+            uint32_t t = a;
+            a = b;
+            b = t;
+        }
+        if (eight && a == b) break;
+        BC4Result r;
+        BC4Fit(values, a, b, &r);
+        if (r.error >= best->error) break;
+        *best = r;
+    }
+}
+
+static void EncodeBC4(const float (*values)[16], TextureEncodeQuality quality,
+                      uint8_t *out) {
+    float lo = 255, hi = 0, lo6 = 255, hi6 = 0;
+    for (int k = 0; k < 16; ++k) {
+        const float v = values[0][k];
+        lo = v < lo ? v : lo;
+        hi = v > hi ? v : hi;
+        // 0 and 255 are free in the 6 value mode
+        if (v > 0 && v < 255) {
+            lo6 = v < lo6 ? v : lo6;
+            hi6 = v > hi6 ? v : hi6;
+        }
+    }
+    BC4Result best;
+    // hi == lo takes the 6 value mode with a single color
+    BC4Fit(values, (uint32_t)hi, (uint32_t)lo, &best);
+    if (quality != TextureEncodeQualityFast) {
+        const uint32_t iterations = Iterations(quality) - 1;
+        BC4Refine(values, iterations, &best);
+        if (lo6 <= hi6) {
+            BC4Result r;
+            BC4Fit(values, (uint32_t)lo6, (uint32_t)hi6, &r);
+            BC4Refine(values, iterations, &r);
+            if (r.error < best.error) best = r;
+        }
+    }
+    uint64_t bits = 0;
+    for (int k = 0; k < 16; ++k)
+        bits |= (uint64_t)best.indices[k] << (3 * k);
+    out[0] = best.e0;
+    out[1] = best.e1;
+    for (int i = 0; i < 6; ++i) out[2 + i] = (uint8_t)(bits >> (8 * i));
+}
+
+// BC7 mode 6: RGBA endpoints of 7 bits and a shared low bit (the p-bit) per
+// endpoint, 4 bit indices; the first index has an implicit high bit of 0
+
+static const uint32_t BC7Weights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                        34, 38, 43, 47, 51, 55, 60, 64};
+
+typedef struct {
+    uint8_t e0[4], e1[4];  // 7 bit
+    uint8_t p0, p1;
+    uint8_t indices[16];
+    float error;
+} BC7Result;
+
+static void BC7Quantize(const float e[4], uint32_t p, uint8_t q[4]) {
+    for (int c = 0; c < 4; ++c) {
+        int v = (int)((e[c] - (float)p) / 2 + 0.5f);
+        q[c] = (uint8_t)(v < 0 ? 0 : (v > 127 ? 127 : v));
+    }
+}
+
+// the p-bit that loses the least to quantization
+static uint32_t BC7BestPBit(const float e[4]) {
+    float error[2] = {0, 0};
+    for (uint32_t p = 0; p < 2; ++p) {
+        uint8_t q[4];
+        BC7Quantize(e, p, q);
+        for (int c = 0; c < 4; ++c) {
+            float d = e[c] - (float)(q[c] << 1 | p);
+            error[p] += d * d;
+        }
+    }
+    return error[1] < error[0];
+}
+
+static void BC7Fit(const Block *b, const float e0[4], const float e1[4],
+                   uint32_t p0, uint32_t p1, BC7Result *r) {
+    BC7Quantize(e0, p0, r->e0);
+    BC7Quantize(e1, p1, r->e1);
+    r->p0 = (uint8_t)p0;
+    r->p1 = (uint8_t)p1;
+    float palette[4][16];
+    for (int c = 0; c < 4; ++c) {
+        const uint32_t a = (uint32_t)r->e0[c] << 1 | p0;
+        const uint32_t z = (uint32_t)r->e1[c] << 1 | p1;
+        for (int i = 0; i < 16; ++i)
+            palette[c][i] = (float)(((64 - BC7Weights[i]) * a +
+                                     BC7Weights[i] * z + 32) >> 6);
+    }
+    r->error = FitIndices(b->c, palette, 4, 16, r->indices);
+}
+
+static void BC7FitBestPBits(const Block *b, const float e0[4],
+                            const float e1[4], TextureEncodeQuality quality,
+                            BC7Result *r) {
+    if (quality != TextureEncodeQualityHigh) {
+        BC7Fit(b, e0, e1, BC7BestPBit(e0), BC7BestPBit(e1), r);
+        return;
+    }
+    BC7Fit(b, e0, e1, 0, 0, r);
+    for (uint32_t p = 1; p < 4; ++p) {
+        BC7Result t;
+        BC7Fit(b, e0, e1, p & 1, p >> 1, &t);
+        if (t.error < r->error) *r = t;
+    }
+}
+
+static void PutBits(uint8_t *out, uint32_t *pos, uint32_t value,
+                    uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i, ++*pos) {
+        if (value >> i & 1) out[*pos >> 3] |= (uint8_t)(1 << (*pos & 7));
+    }
+}
+
+static void EncodeBC7(const Block *b, TextureEncodeQuality quality,
+                      uint8_t *out) {
+    float weights[16];
+    for (int i = 0; i < 16; ++i) weights[i] = BC7Weights[i] / 64.f;
+    float e0[4], e1[4];
+    // four channels are rarely correlated enough for the box
+    FindEndpoints(b->c, 4, 0xffff, true, e0, e1);
+    BC7Result best;
+    BC7FitBestPBits(b, e0, e1, quality, &best);
+    for (uint32_t it = Iterations(quality); it > 0; --it) {
+        BC7Result r;
+        if (!RefineEndpoints(b->c, 4, best.indices, weights, e0, e1)) break;
+        BC7FitBestPBits(b, e0, e1, quality, &r);
+        if (r.error >= best.error) break;
+        best = r;
+    }
+    // the first index must fit in 3 bits
+    if (best.indices[0] >= 8) {
+        for (int c = 0; c < 4; ++c) {
+            uint8_t t = best.e0[c];
+            best.e0[c] = best.e1[c];
+            best.e1[c] = t;
+        }
+        uint8_t t = best.p0;
+        best.p0 = best.p1;
+        best.p1 = t;
+        for (int k = 0; k < 16; ++k) best.indices[k] = 15 - best.indices[k];
+    }
+    memset(out, 0, 16);
+    uint32_t pos = 0;
+    PutBits(out, &pos, 1 << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        PutBits(out, &pos, best.e0[c], 7);
+        PutBits(out, &pos, best.e1[c], 7);
+    }
+    PutBits(out, &pos, best.p0, 1);
+    PutBits(out, &pos, best.p1, 1);
+    PutBits(out, &pos, best.indices[0], 3);
+    for (int k = 1; k < 16; ++k) PutBits(out, &pos, best.indices[k], 4);
+}
+
+static void EncodeBlock(const Block *b, TextureFormat format,
+                        TextureEncodeQuality quality, uint8_t *out) {
+    switch (format) {
+        case TextureFormatDXT1:
+        case TextureFormatDXT1_sRGB:
+            EncodeBC1(b, quality, true, out);
+            break;
+        case TextureFormatDXT5:
+        case TextureFormatDXT5_sRGB:
+            EncodeBC4(b->c + 3, quality, out);
+            EncodeBC1(b, quality, false, out + 8);
+            break;
+        case TextureFormatBC4:
+            EncodeBC4(b->c, quality, out);
+            break;
+        case TextureFormatBC5:
+            EncodeBC4(b->c, quality, out);
+            EncodeBC4(b->c + 1, quality, out + 8);
+            break;
+        case TextureFormatBC7:
+        case TextureFormatBC7_sRGB:
+            EncodeBC7(b, quality, out);
+            break;
+        default:
+            break;
+    }
+}
+
+struct EncodeContext {
+    const uint8_t *rgba;
+    uint32_t width, height;
+    TextureFormat format;
+    TextureEncodeQuality quality;
+    uint8_t *out;
+    uint32_t rowPitch;
+};
+typedef struct EncodeContext EncodeContext;
+
+static void EncodeBlockRows(void *_ctx, uint32_t begin, uint32_t end,
+                            uint32_t threadIndex) {
+    const EncodeContext *ctx = (const EncodeContext *)_ctx;
+    const uint32_t blockSize = TextureFormatBlockSize(ctx->format);
+    const uint32_t blocksX = (ctx->width + 3) / 4;
+    for (uint32_t by = begin; by < end; ++by) {
+        uint8_t *out = ctx->out + (size_t)by * ctx->rowPitch;
+        for (uint32_t bx = 0; bx < blocksX; ++bx) {
+            Block b;
+            for (uint32_t y = 0; y < 4; ++y) {
+                uint32_t sy = by * 4 + y;
+                if (sy >= ctx->height) sy = ctx->height - 1;
+                const uint8_t *row = ctx->rgba + (size_t)sy * ctx->width * 4;
+                for (uint32_t x = 0; x < 4; ++x) {
+                    uint32_t sx = bx * 4 + x;
+                    if (sx >= ctx->width) sx = ctx->width - 1;
+                    for (int c = 0; c < 4; ++c)
+                        b.c[c][y * 4 + x] = row[sx * 4 + c];
+                }
+            }
+            EncodeBlock(&b, ctx->format, ctx->quality, out + bx * blockSize);
+        }
+    }
+}
+
+void TextureEncodeImage(const uint8_t *rgba, uint32_t width, uint32_t height,
+                        TextureFormat format, TextureEncodeQuality quality,
+                        uint8_t *out) {
+    EncodeContext ctx = {rgba,    width, height, format, quality,
+                         out,     TextureFormatRowPitch(format, width)};
+    const uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    // about 64 blocks per job
+    const uint32_t grain = blocksX >= 64 ? 1 : 64 / blocksX;
+    JobParallelFor(blocksY, grain, EncodeBlockRows, &ctx);
+}
+
+// Mips are made from a float RGBA copy of the image, in linear space for the
+// sRGB formats, and turned back into RGBA8 one by one for the block encoder.
+
+typedef struct {
+    float toLinear[256];
+    uint8_t toSRGB[4096];  // by linear value * 4095
+} ColorTables;
+
+static void ColorTablesInit(ColorTables *t) {
+    for (int i = 0; i < 256; ++i) {
+        const float s = i / 255.f;
+        t->toLinear[i] = s <= 0.04045f ? s / 12.92f
+                                       : powf((s + 0.055f) / 1.055f, 2.4f);
+    }
+    for (int i = 0; i < 4096; ++i) {
+        const float l = i / 4095.f;
+        const float s = l <= 0.0031308f ? l * 12.92f
+                                        : 1.055f * powf(l, 1 / 2.4f) - 0.055f;
+        t->toSRGB[i] = (uint8_t)(s * 255 + 0.5f);
+    }
+}
+
+typedef struct {
+    uint32_t width, height;
+    float *pixels;  // RGBA
+} FloatImage;
+
+// a tent filter as wide as the scale, for each destination pixel `taps`
+// source indices (clamped at the edges) and normalized weights
+typedef struct {
+    uint32_t taps;
+    uint32_t *index;
+    float *weight;
+} Filter;
+
+struct RowContext {
+    const ColorTables *tables;
+    bool linear;
+    const uint8_t *rgba;
+    uint8_t *rgbaOut;
+    FloatImage src, dst;
+    const Filter *filter;
+};
+typedef struct RowContext RowContext;
+
+static void ToFloatRows(void *_ctx, uint32_t begin, uint32_t end,
+                        uint32_t threadIndex) {
+    const RowContext *ctx = (const RowContext *)_ctx;
+    const size_t n = (size_t)ctx->dst.width * 4;
+    for (uint32_t y = begin; y < end; ++y) {
+        const uint8_t *in = ctx->rgba + y * n;
+        float *out = ctx->dst.pixels + y * n;
+        for (size_t i = 0; i < n; ++i) {
+            const bool color = ctx->linear && (i & 3) != 3;
+            out[i] = color ? ctx->tables->toLinear[in[i]] : in[i] / 255.f;
+        }
+    }
+}
+
+static void ToRGBA8Rows(void *_ctx, uint32_t begin, uint32_t end,
+                        uint32_t threadIndex) {
+    const RowContext *ctx = (const RowContext *)_ctx;
+    const size_t n = (size_t)ctx->src.width * 4;
+    for (uint32_t y = begin; y < end; ++y) {
+        const float *in = ctx->src.pixels + y * n;
+        uint8_t *out = ctx->rgbaOut + y * n;
+        for (size_t i = 0; i < n; ++i) {
+            float v = in[i] < 0 ? 0 : (in[i] > 1 ? 1 : in[i]);
+            if (ctx->linear && (i & 3) != 3)
+                out[i] = ctx->tables->toSRGB[(uint32_t)(v * 4095 + 0.5f)];
+            else
+                out[i] = (uint8_t)(v * 255 + 0.5f);
+        }
+    }
+}
+
+// 2x2 box, sizes are powers of two so it only ever clamps at 1
+static void DownsampleRows(void *_ctx, uint32_t begin, uint32_t end,
+                           uint32_t threadIndex) {
+    const RowContext *ctx = (const RowContext *)_ctx;
+    const FloatImage *s = &ctx->src;
+    for (uint32_t y = begin; y < end; ++y) {
+        const uint32_t y0 = y * 2, y1 = y0 + 1 < s->height ? y0 + 1 : y0;
+        const float *r0 = s->pixels + (size_t)y0 * s->width * 4;
+        const float *r1 = s->pixels + (size_t)y1 * s->width * 4;
+        float *out = ctx->dst.pixels + (size_t)y * ctx->dst.width * 4;
+        for (uint32_t x = 0; x < ctx->dst.width; ++x) {
+            const uint32_t x0 = x * 2 * 4;
+            const uint32_t x1 = x * 2 + 1 < s->width ? x0 + 4 : x0;
+            for (int c = 0; c < 4; ++c)
+                out[x * 4 + c] = (r0[x0 + c] + r0[x1 + c] + r1[x0 + c] +
+                                  r1[x1 + c]) * 0.25f;
+        }
+    }
+}
+
+static void ResizeRowsX(void *_ctx, uint32_t begin, uint32_t end,
+                        uint32_t threadIndex) {
+    const RowContext *ctx = (const RowContext *)_ctx;
+    const Filter *f = ctx->filter;
+    for (uint32_t y = begin; y < end; ++y) {
+        const float *in = ctx->src.pixels + (size_t)y * ctx->src.width * 4;
+        float *out = ctx->dst.pixels + (size_t)y * ctx->dst.width * 4;
+        for (uint32_t x = 0; x < ctx->dst.width; ++x) {
+            float sum[4] = {0};
+            for (uint32_t t = 0; t < f->taps; ++t) {
+                const float *p = in + f->index[x * f->taps + t] * 4;
+                const float w = f->weight[x * f->taps + t];
+                for (int c = 0; c < 4; ++c) sum[c] += p[c] * w;
+            }
+            for (int c = 0; c < 4; ++c) out[x * 4 + c] = sum[c];
+        }
+    }
+}
+
+static void ResizeRowsY(void *_ctx, uint32_t begin, uint32_t end,
+                        uint32_t threadIndex) {
+    const RowContext *ctx = (const RowContext *)_ctx;
+    const Filter *f = ctx->filter;
+    const size_t n = (size_t)ctx->dst.width * 4;
+    for (uint32_t y = begin; y < end; ++y) {
+        float *out = ctx->dst.pixels + y * n;
+        memset(out, 0, n * sizeof(float));
+        for (uint32_t t = 0; t < f->taps; ++t) {
+            const float *in = ctx->src.pixels + f->index[y * f->taps + t] * n;
+            const float w = f->weight[y * f->taps + t];
+            for (size_t i = 0; i < n; ++i) out[i] += in[i] * w;
+        }
+    }
+}
+
+static bool FilterInit(Filter *f, uint32_t srcSize, uint32_t dstSize) {
+    const float scale = (float)srcSize / dstSize;
+    const float radius = scale > 1 ? scale : 1;
+    f->taps = (uint32_t)ceilf(radius * 2) + 1;
+    f->index = malloc((size_t)dstSize * f->taps * sizeof(uint32_t));
+    count_heap_allocation();
+    f->weight = malloc((size_t)dstSize * f->taps * sizeof(float));
+    count_heap_allocation();
+    if (f->index == NULL || f->weight == NULL) return false;
+    for (uint32_t i = 0; i < dstSize; ++i) {
+        const float center = (i + 0.5f) * scale - 0.5f;
+        const int first = (int)ceilf(center - radius);
+        float sum = 0;
+        for (uint32_t t = 0; t < f->taps; ++t) {
+            const int s = first + (int)t;
+            const float w = 1 - fabsf(s - center) / radius;
+            const int last = (int)srcSize - 1;
+            f->index[i * f->taps + t] =
+                (uint32_t)(s < 0 ? 0 : (s > last ? last : s));
+            f->weight[i * f->taps + t] = w > 0 ? w : 0;
+            sum += w > 0 ? w : 0;
+        }
+        for (uint32_t t = 0; t < f->taps; ++t)
+            f->weight[i * f->taps + t] /= sum;
+    }
+    return true;
+}
+
+static void FilterFree(Filter *f) {
+    free(f->index);
+    free(f->weight);
+}
+
+static bool FloatImageInit(FloatImage *image, uint32_t width,
+                           uint32_t height) {
+    image->width = width;
+    image->height = height;
+    image->pixels = malloc((size_t)width * height * 4 * sizeof(float));
+    count_heap_allocation();
+    return image->pixels != NULL;
+}
+
+// rows per job for images `width` wide
+static uint32_t RowGrain(uint32_t width) {
+    return width >= 4096 ? 1 : 4096 / width;
+}
+
+// replaces ctx->src with a copy of it scaled to width x height
+static bool Resize(RowContext *ctx, uint32_t width, uint32_t height) {
+    Filter fx = {0}, fy = {0};
+    FloatImage tmp = {0}, out = {0};
+    const bool ok = FilterInit(&fx, ctx->src.width, width) &&
+                    FilterInit(&fy, ctx->src.height, height) &&
+                    FloatImageInit(&tmp, width, ctx->src.height) &&
+                    FloatImageInit(&out, width, height);
+    if (ok) {
+        const FloatImage src = ctx->src;
+        ctx->dst = tmp;
+        ctx->filter = &fx;
+        JobParallelFor(tmp.height, RowGrain(width), ResizeRowsX, ctx);
+        ctx->src = tmp;
+        ctx->dst = out;
+        ctx->filter = &fy;
+        JobParallelFor(height, RowGrain(width), ResizeRowsY, ctx);
+        free(src.pixels);
+        ctx->src = out;
+    } else {
+        free(out.pixels);
+    }
+    FilterFree(&fx);
+    FilterFree(&fy);
+    free(tmp.pixels);
+    return ok;
+}
+
+static uint32_t NearestPowerOfTwo(uint32_t x) {
+    uint32_t p = 1;
+    while (p < x) p <<= 1;
+    // ties round up
+    if (p > x && p - x > x - p / 2) p >>= 1;
+    return p;
+}
+
+uint8_t *TextureEncodeDDS(const Image *image,
+                          const TextureEncodeSettings *settings,
+                          const uint32_t *tag, size_t *size) {
+    const TextureFormat format = settings->format;
+    if (!TextureEncodeFormatSupported(format)) return NULL;
+    TextureDesc desc;
+    desc.width = NearestPowerOfTwo(image->width);
+    desc.height = NearestPowerOfTwo(image->height);
+    desc.depth = 1;
+    desc.arraySize = 1;
+    desc.mipmaps = 1;
+    desc.format = format;
+    desc.dimension = TextureDimensionTex2D;
+    if (settings->mipmaps) {
+        const uint32_t longest =
+            desc.width > desc.height ? desc.width : desc.height;
+        while (longest >> desc.mipmaps) desc.mipmaps++;
+    }
+    TextureMip mips[TextureMaxMips];
+    DDSGetSubresources(&desc, DDSHeaderSize, mips);
+    *size = (size_t)mips[desc.mipmaps - 1].offset +
+            mips[desc.mipmaps - 1].byteLength;
+    uint8_t *dds = malloc(*size);
+    count_heap_allocation();
+    if (dds == NULL) return NULL;
+    DDSWriteHeader(&desc, tag, dds);
+
+    const bool resize =
+        desc.width != image->width || desc.height != image->height;
+    if (!resize && desc.mipmaps == 1) {
+        TextureEncodeImage(image->pixels, desc.width, desc.height, format,
+                           settings->quality, dds + mips[0].offset);
+        return dds;
+    }
+
+    ColorTables tables;
+    ColorTablesInit(&tables);
+    RowContext ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.tables = &tables;
+    ctx.linear = IsSRGB(format);
+    ctx.rgba = image->pixels;
+    // every mip goes through this one on the way to the encoder
+    uint8_t *rgba = malloc((size_t)desc.width * desc.height * 4);
+    count_heap_allocation();
+    bool ok = rgba != NULL &&
+              FloatImageInit(&ctx.dst, image->width, image->height);
+    if (ok) {
+        JobParallelFor(image->height, RowGrain(image->width), ToFloatRows,
+                       &ctx);
+        ctx.src = ctx.dst;
+        if (resize) ok = Resize(&ctx, desc.width, desc.height);
+    }
+    ctx.rgbaOut = rgba;
+    for (uint32_t i = 0; ok && i < desc.mipmaps; ++i) {
+        const uint32_t w = ctx.src.width, h = ctx.src.height;
+        JobParallelFor(h, RowGrain(w), ToRGBA8Rows, &ctx);
+        TextureEncodeImage(rgba, w, h, format, settings->quality,
+                           dds + mips[i].offset);
+        if (i + 1 == desc.mipmaps) break;
+        ok = FloatImageInit(&ctx.dst, mips[i + 1].width, mips[i + 1].height);
+        if (ok) {
+            JobParallelFor(ctx.dst.height, RowGrain(ctx.dst.width),
+                           DownsampleRows, &ctx);
+            free(ctx.src.pixels);
+            ctx.src = ctx.dst;
+        }
+    }
+    free(ctx.src.pixels);
+    free(rgba);
+    if (!ok) {
+        free(dds);
+        return NULL;
+    }
+    return dds;
+}
+
+// FNV-1a
+static uint64_t Hash(const uint8_t *data, size_t size) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= data[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+static uint8_t *ReadFile(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    const long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = length > 0 ? malloc((size_t)length) : NULL;
+    count_heap_allocation();
+    if (data != NULL && fread(data, (size_t)length, 1, f) != 1) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = (size_t)length;
+    return data;
+}
+
+// a complete DDS file with the same tag
+static bool IsUpToDate(const char *path, const uint32_t tag[DDSTagSize]) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    uint8_t header[DDSHeaderSize];
+    const size_t size = fread(header, 1, sizeof(header), f);
+    fseek(f, 0, SEEK_END);
+    const long fileSize = ftell(f);
+    fclose(f);
+    TextureDesc desc;
+    uint32_t dataOffset, fileTag[DDSTagSize];
+    return fileSize > 0 &&
+           DDSParseHeader(header, size, (uint64_t)fileSize, &desc,
+                          &dataOffset) == DDSOk &&
+           DDSReadTag(header, size, fileTag) &&
+           memcmp(tag, fileTag, sizeof(fileTag)) == 0;
+}
+
+TextureEncodeResult TextureEncodeFile(const char *source,
+                                      const char *destination,
+                                      const TextureEncodeSettings *settings,
+                                      const char **error) {
+    *error = NULL;
+    if (!TextureEncodeFormatSupported(settings->format)) {
+        *error = "the encoder can not write this format";
+        return TextureEncodeError;
+    }
+    size_t size;
+    uint8_t *data = ReadFile(source, &size);
+    if (data == NULL) {
+        *error = "can not read the source";
+        return TextureEncodeError;
+    }
+    const uint64_t hash = Hash(data, size);
+    const uint32_t tag[DDSTagSize] = {
+        (uint32_t)hash, (uint32_t)(hash >> 32),
+        (uint32_t)settings->format | (uint32_t)settings->quality << 8 |
+            (uint32_t)settings->mipmaps << 12,
+        TextureEncoderVersion};
+    if (IsUpToDate(destination, tag)) {
+        free(data);
+        return TextureEncodeUpToDate;
+    }
+
+    Image image;
+    const bool decoded = ImageDecode(data, size, &image, error);
+    free(data);
+    if (!decoded) return TextureEncodeError;
+    size_t ddsSize;
+    uint8_t *dds = TextureEncodeDDS(&image, settings, tag, &ddsSize);
+    ImageFree(&image);
+    if (dds == NULL) {
+        *error = "out of memory";
+        return TextureEncodeError;
+    }
+    FILE *f = fopen(destination, "wb");
+    bool written = f != NULL && fwrite(dds, ddsSize, 1, f) == 1;
+    if (f != NULL && fclose(f) != 0) written = false;
+    free(dds);
+    if (!written) {
+        *error = "can not write the destination";
+        return TextureEncodeError;
+    }
+    return TextureEncodeOk;
+}
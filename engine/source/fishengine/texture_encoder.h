@@ -0,0 +1,66 @@
+#ifndef TEXTURE_ENCODER_H
+#define TEXTURE_ENCODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image_decode.h"
+#include "texture_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Block compression of RGBA8 images into DXT1 (BC1), DXT5 (BC3), BC4, BC5
+// and BC7 (mode 6 only), with the blocks spread over the job system. BC4
+// takes the red channel, BC5 red and green.
+
+typedef enum {
+    TextureEncodeQualityFast,    // the first endpoints that are found
+    TextureEncodeQualityNormal,  // the better of two, refined once
+    TextureEncodeQualityHigh,    // refined until it stops improving
+    TextureEncodeQualityCount,
+} TextureEncodeQuality;
+
+typedef struct {
+    TextureFormat format;
+    TextureEncodeQuality quality;
+    bool mipmaps;  // the full chain, filtered in linear space for sRGB
+} TextureEncodeSettings;
+
+bool TextureEncodeFormatSupported(TextureFormat format);
+const char *TextureEncodeQualityName(TextureEncodeQuality quality);
+
+// encodes one mip into TextureFormatRowPitch * TextureFormatRowCount bytes
+// at `out`, blocks past the edges repeat the last row and column
+void TextureEncodeImage(const uint8_t *rgba, uint32_t width, uint32_t height,
+                        TextureFormat format, TextureEncodeQuality quality,
+                        uint8_t *out);
+
+// a whole DDS file, header included, resized to powers of two like texconv
+// -pow2 does; `tag` goes into the header (see DDSWriteHeader), NULL for none.
+// The result is freed with free().
+uint8_t *TextureEncodeDDS(const Image *image,
+                          const TextureEncodeSettings *settings,
+                          const uint32_t *tag, size_t *size);
+
+typedef enum {
+    TextureEncodeOk,
+    TextureEncodeUpToDate,  // destination was made from the same source
+    TextureEncodeError,
+} TextureEncodeResult;
+
+// decodes `source` (PNG or JPEG) and writes the DDS file `destination`,
+// unless that one is tagged with the hash of the same source bytes and the
+// same settings
+TextureEncodeResult TextureEncodeFile(const char *source,
+                                      const char *destination,
+                                      const TextureEncodeSettings *settings,
+                                      const char **error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEXTURE_ENCODER_H */
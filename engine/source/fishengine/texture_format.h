@@ -1,6 +1,9 @@
 #ifndef TEXTURE_FORMAT_H
 #define TEXTURE_FORMAT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 typedef enum {
     TextureFormatInvalid,
     TextureFormatAlpha8,
@@ -23,6 +26,106 @@ typedef enum {
     // is better.When targeting DX11 - class hardware(modern PC, PS4, XboxOne),
     // using BC7 might be useful, since compression quality is often better.
     TextureFormatDXT5,
+
+    TextureFormatR8Unorm,
+    TextureFormatRG8Unorm,
+    TextureFormatRGBA16Float,
+    TextureFormatRGBA32Float,
+    TextureFormatDXT1_sRGB,
+    // BC2, explicit 4 bit alpha; DXT5 is almost always the better choice
+    TextureFormatDXT3,
+    TextureFormatDXT3_sRGB,
+    TextureFormatDXT5_sRGB,
+    // single channel, 4 bits per pixel: masks, roughness, height
+    TextureFormatBC4,
+    // two channels, 8 bits per pixel: tangent space normals (z is
+    // reconstructed in the shader)
+    TextureFormatBC5,
+    // unsigned half float RGB, 8 bits per pixel: HDR environments
+    TextureFormatBC6H,
+    // RGBA, 8 bits per pixel, better quality than DXT1 and DXT5
+    TextureFormatBC7,
+    TextureFormatBC7_sRGB,
 } TextureFormat;
 
-#endif /* TEXTURE_FORMAT_H */
\ No newline at end of file
+typedef enum {
+    TextureDimensionUnknown = -1,
+    TextureDimensionNone,
+    TextureDimensionAny,
+    TextureDimensionTex2D,
+    TextureDimensionTex2DArray,
+    TextureDimensionTex3D,
+    TextureDimensionCube,
+    TextureDimensionCubeArray,
+} TextureDimension;
+
+static inline bool TextureFormatIsCompressed(TextureFormat format) {
+    switch (format) {
+        case TextureFormatDXT1:
+        case TextureFormatDXT1_sRGB:
+        case TextureFormatDXT3:
+        case TextureFormatDXT3_sRGB:
+        case TextureFormatDXT5:
+        case TextureFormatDXT5_sRGB:
+        case TextureFormatBC4:
+        case TextureFormatBC5:
+        case TextureFormatBC6H:
+        case TextureFormatBC7:
+        case TextureFormatBC7_sRGB:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// bytes of a 4x4 block for compressed formats, of a pixel otherwise; 0 for
+// TextureFormatInvalid
+static inline uint32_t TextureFormatBlockSize(TextureFormat format) {
+    switch (format) {
+        case TextureFormatAlpha8:
+        case TextureFormatR8Unorm:
+            return 1;
+        case TextureFormatRG8Unorm:
+            return 2;
+        case TextureFormatBGRA8Unorm:
+        case TextureFormatBGRA8Unorm_sRGB:
+        case TextureFormatRGBA8Unorm:
+        case TextureFormatRGBA8Unorm_sRGB:
+        case TextureFormatR32Float:
+            return 4;
+        case TextureFormatRGBA16Float:
+        case TextureFormatDXT1:
+        case TextureFormatDXT1_sRGB:
+        case TextureFormatBC4:
+            return 8;
+        case TextureFormatRGBA32Float:
+        case TextureFormatDXT3:
+        case TextureFormatDXT3_sRGB:
+        case TextureFormatDXT5:
+        case TextureFormatDXT5_sRGB:
+        case TextureFormatBC5:
+        case TextureFormatBC6H:
+        case TextureFormatBC7:
+        case TextureFormatBC7_sRGB:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// bytes of a row of pixels, or of 4x4 blocks
+static inline uint32_t TextureFormatRowPitch(TextureFormat format,
+                                             uint32_t width) {
+    if (TextureFormatIsCompressed(format))
+        width = width < 4 ? 1 : (width + 3) / 4;
+    return width * TextureFormatBlockSize(format);
+}
+
+static inline uint32_t TextureFormatRowCount(TextureFormat format,
+                                             uint32_t height) {
+    if (TextureFormatIsCompressed(format))
+        return height < 4 ? 1 : (height + 3) / 4;
+    return height;
+}
+
+#endif /* TEXTURE_FORMAT_H */
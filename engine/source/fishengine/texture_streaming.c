@@ -0,0 +1,243 @@
+#include "texture_streaming.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t key;
+    uint32_t index;
+    uint32_t previousMip;
+} SortItem;
+
+void TextureStreamerInit(TextureStreamer *s, uint64_t budget) {
+    memset(s, 0, sizeof(*s));
+    array_init(&s->textures, sizeof(StreamedTexture), 64);
+    array_init(&s->freeList, sizeof(uint32_t), 64);
+    array_init(&s->changes, sizeof(TextureStreamingChange), 64);
+    array_init(&s->scratch, sizeof(SortItem), 64);
+    s->budget = budget;
+}
+
+void TextureStreamerFree(TextureStreamer *s) {
+    array_free(&s->textures);
+    array_free(&s->freeList);
+    array_free(&s->changes);
+    array_free(&s->scratch);
+}
+
+// bytes of the mips from `mip` down to the smallest
+static uint64_t ChainSize(const StreamedTexture *t, uint32_t mip) {
+    uint64_t size = 0;
+    for (uint32_t i = mip; i < t->mipCount; ++i) size += t->mipSize[i];
+    return size;
+}
+
+StreamedTexture *TextureStreamerGet(TextureStreamer *s, uint32_t handle) {
+    assert(handle > 0 && handle <= s->textures.size);
+    StreamedTexture *t = (StreamedTexture *)array_at(&s->textures, handle - 1);
+    assert(t->mipCount > 0);
+    return t;
+}
+
+uint32_t TextureStreamerAdd(TextureStreamer *s, const uint64_t *mipSize,
+                            uint32_t mipCount, uint32_t tailMip, void *user) {
+    assert(mipCount > 0 && mipCount <= TextureStreamingMaxMips);
+    assert(tailMip < mipCount);
+    uint32_t index;
+    if (s->freeList.size > 0) {
+        index = ((uint32_t *)s->freeList.ptr)[--s->freeList.size];
+    } else {
+        index = s->textures.size;
+        array_push(&s->textures);
+    }
+    StreamedTexture *t = (StreamedTexture *)array_at(&s->textures, index);
+    memset(t, 0, sizeof(*t));
+    t->mipCount = mipCount;
+    t->tailMip = tailMip;
+    t->residentMip = tailMip;
+    t->wantedMip = tailMip;
+    memcpy(t->mipSize, mipSize, mipCount * sizeof(uint64_t));
+    t->user = user;
+    s->residentBytes += ChainSize(t, tailMip);
+    s->textureCount++;
+    return index + 1;
+}
+
+void TextureStreamerRemove(TextureStreamer *s, uint32_t handle) {
+    StreamedTexture *t = TextureStreamerGet(s, handle);
+    s->residentBytes -= ChainSize(t, t->residentMip);
+    t->mipCount = 0;
+    t->user = NULL;
+    *(uint32_t *)array_push(&s->freeList) = handle - 1;
+    s->textureCount--;
+}
+
+uint32_t TextureStreamingTailMip(uint32_t width, uint32_t height,
+                                 uint32_t mipCount) {
+    uint32_t size = width > height ? width : height;
+    uint32_t mip = 0;
+    while (mip + 1 < mipCount && (size >> mip) > TextureStreamingTailSize)
+        mip++;
+    return mip;
+}
+
+uint32_t TextureStreamingMipForScreenSize(uint32_t width, uint32_t height,
+                                          uint32_t mipCount, float screenSize) {
+    uint32_t size = width > height ? width : height;
+    // the smallest mip that still has a texel per pixel
+    uint32_t mip = 0;
+    while (mip + 1 < mipCount && (float)(size >> (mip + 1)) >= screenSize)
+        mip++;
+    return mip;
+}
+
+void TextureStreamerRequest(TextureStreamer *s, uint32_t handle,
+                            uint32_t mip, uint64_t frame) {
+    StreamedTexture *t = TextureStreamerGet(s, handle);
+    // the tail is always there
+    if (mip > t->tailMip) mip = t->tailMip;
+    if (t->lastUsedFrame != frame) {
+        t->lastUsedFrame = frame;
+        t->wantedMip = mip;
+    } else if (mip < t->wantedMip) {
+        t->wantedMip = mip;
+    }
+}
+
+void TextureStreamerSetResident(TextureStreamer *s, uint32_t handle,
+                                uint32_t mip) {
+    StreamedTexture *t = TextureStreamerGet(s, handle);
+    assert(mip <= t->tailMip);
+    s->residentBytes -= ChainSize(t, t->residentMip);
+    t->residentMip = mip;
+    s->residentBytes += ChainSize(t, t->residentMip);
+}
+
+static uint32_t Target(const StreamedTexture *t, uint64_t frame) {
+    return t->lastUsedFrame == frame ? t->wantedMip : t->tailMip;
+}
+
+static int CompareSortItems(const void *a, const void *b) {
+    const SortItem *x = (const SortItem *)a, *y = (const SortItem *)b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return x->index < y->index ? -1 : (x->index > y->index);
+}
+
+// the surplus mips of victims[*cursor..], `surplus` bytes in all
+typedef struct {
+    const SortItem *victims;
+    uint32_t victimCount;
+    uint32_t cursor;
+    uint64_t surplus;
+} Victims;
+
+// evicts surplus mips until `needed` more bytes fit in the budget, or there is
+// no surplus left
+static void Evict(TextureStreamer *s, Victims *v, uint64_t needed,
+                  uint64_t frame) {
+    StreamedTexture *textures = (StreamedTexture *)s->textures.ptr;
+    while (s->residentBytes + needed > s->budget &&
+           v->cursor < v->victimCount) {
+        StreamedTexture *t = textures + v->victims[v->cursor].index;
+        if (t->residentMip >= Target(t, frame)) {
+            v->cursor++;
+            continue;
+        }
+        s->residentBytes -= t->mipSize[t->residentMip];
+        v->surplus -= t->mipSize[t->residentMip];
+        t->residentMip++;
+        s->mipsEvicted++;
+    }
+}
+
+// evicts what it takes for `needed` more bytes, nothing when the surplus is
+// not enough, so that victims are not dropped for a mip that does not fit
+static bool MakeRoom(TextureStreamer *s, Victims *v, uint64_t needed,
+                     uint64_t frame) {
+    if (s->residentBytes + needed > s->budget + v->surplus) return false;
+    Evict(s, v, needed, frame);
+    return true;
+}
+
+static void AddChanges(TextureStreamer *s, const SortItem *items,
+                       uint32_t count) {
+    const StreamedTexture *textures = (const StreamedTexture *)s->textures.ptr;
+    for (uint32_t i = 0; i < count; ++i) {
+        const StreamedTexture *t = textures + items[i].index;
+        if (t->residentMip == items[i].previousMip) continue;
+        TextureStreamingChange *c =
+            (TextureStreamingChange *)array_push(&s->changes);
+        c->handle = items[i].index + 1;
+        c->residentMip = t->residentMip;
+        c->previousMip = items[i].previousMip;
+        c->user = t->user;
+    }
+}
+
+void TextureStreamerUpdate(TextureStreamer *s, uint64_t frame,
+                           uint64_t maxLoadBytes) {
+    s->changes.size = 0;
+    s->mipsLoaded = 0;
+    s->mipsEvicted = 0;
+    s->wantedBytes = 0;
+
+    // victims: textures with more mips than they need, least recently used
+    // first; candidates: textures with fewer, the furthest behind first
+    uint32_t victimCount = 0, candidateCount = 0;
+    const uint32_t n = s->textures.size;
+    for (uint32_t i = 0; i < n; ++i) {
+        const StreamedTexture *t = (const StreamedTexture *)s->textures.ptr + i;
+        if (t->mipCount == 0) continue;
+        uint32_t target = Target(t, frame);
+        s->wantedBytes += ChainSize(t, target);
+        if (target > t->residentMip)
+            victimCount++;
+        else if (target < t->residentMip)
+            candidateCount++;
+    }
+    array_resize(&s->scratch, victimCount + candidateCount);
+    SortItem *victims = (SortItem *)s->scratch.ptr;
+    SortItem *candidates = victims + victimCount;
+    uint32_t v = 0, c = 0;
+    uint64_t surplus = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const StreamedTexture *t = (const StreamedTexture *)s->textures.ptr + i;
+        if (t->mipCount == 0) continue;
+        uint32_t target = Target(t, frame);
+        if (target > t->residentMip) {
+            surplus += ChainSize(t, t->residentMip) - ChainSize(t, target);
+            victims[v].key = t->lastUsedFrame;
+            victims[v].index = i;
+            victims[v++].previousMip = t->residentMip;
+        } else if (target < t->residentMip) {
+            candidates[c].key =
+                TextureStreamingMaxMips - (t->residentMip - target);
+            candidates[c].index = i;
+            candidates[c++].previousMip = t->residentMip;
+        }
+    }
+    qsort(victims, victimCount, sizeof(SortItem), CompareSortItems);
+    qsort(candidates, candidateCount, sizeof(SortItem), CompareSortItems);
+
+    // a lowered budget is honoured even without new requests, as far as the
+    // surplus goes
+    Victims room = {victims, victimCount, 0, surplus};
+    Evict(s, &room, 0, frame);
+
+    uint64_t loaded = 0;
+    StreamedTexture *textures = (StreamedTexture *)s->textures.ptr;
+    for (uint32_t i = 0; i < candidateCount; ++i) {
+        StreamedTexture *t = textures + candidates[i].index;
+        const uint64_t cost = t->mipSize[t->residentMip - 1];
+        if (loaded + cost > maxLoadBytes) continue;
+        if (!MakeRoom(s, &room, cost, frame)) continue;
+        t->residentMip--;
+        s->residentBytes += cost;
+        loaded += cost;
+        s->mipsLoaded++;
+    }
+
+    AddChanges(s, victims, victimCount);
+    AddChanges(s, candidates, candidateCount);
+}
@@ -0,0 +1,96 @@
+#ifndef TEXTURE_STREAMING_H
+#define TEXTURE_STREAMING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "array.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mip residency policy of streamed textures. A texture starts with only its
+// mip tail (the levels of at most TextureStreamingTailSize texels) resident.
+// Every frame the renderer asks for the mip the screen-space texel density
+// of each visible use calls for (TextureStreamerRequest), and the update
+// turns the requests into residency changes: one more detailed level per
+// texture and update, as long as the budget allows. When it does not, the
+// levels nobody asked for are evicted, least recently used texture first.
+// Textures that were not seen keep their mips until the space is needed.
+//
+// This file only decides, texture.c reads the mips and recreates the gpu
+// textures (TextureStreamingUpdate).
+
+#define TextureStreamingMaxMips 16
+// mips up to this size are loaded with the texture and never evicted
+#define TextureStreamingTailSize 64
+
+struct StreamedTexture {
+    uint32_t mipCount;
+    uint32_t tailMip;      // first mip of the tail
+    uint32_t residentMip;  // most detailed resident mip
+    uint32_t wantedMip;    // most detailed requested in lastUsedFrame
+    uint64_t lastUsedFrame;
+    uint64_t mipSize[TextureStreamingMaxMips];  // bytes
+    void *user;
+};
+typedef struct StreamedTexture StreamedTexture;
+
+// a texture whose resident mip changed in the last update
+struct TextureStreamingChange {
+    uint32_t handle;
+    uint32_t residentMip;
+    uint32_t previousMip;
+    void *user;
+};
+typedef struct TextureStreamingChange TextureStreamingChange;
+
+struct TextureStreamer {
+    array textures;  // StreamedTexture, handle is the index + 1
+    array freeList;  // uint32_t, unused indices
+    array changes;   // TextureStreamingChange, of the last update
+    array scratch;   // victims and candidates of the update
+    uint64_t budget;         // bytes of resident mips, tails included
+    uint64_t residentBytes;
+    uint64_t wantedBytes;    // what the requests of the last update need
+    uint32_t textureCount;
+    uint32_t mipsLoaded;     // in the last update
+    uint32_t mipsEvicted;    // in the last update
+};
+typedef struct TextureStreamer TextureStreamer;
+
+void TextureStreamerInit(TextureStreamer *s, uint64_t budget);
+void TextureStreamerFree(TextureStreamer *s);
+
+// mipSize[mipCount], most detailed first; only the tail is resident.
+// Returns the handle, never 0.
+uint32_t TextureStreamerAdd(TextureStreamer *s, const uint64_t *mipSize,
+                            uint32_t mipCount, uint32_t tailMip, void *user);
+void TextureStreamerRemove(TextureStreamer *s, uint32_t handle);
+StreamedTexture *TextureStreamerGet(TextureStreamer *s, uint32_t handle);
+
+// first mip whose larger side is at most TextureStreamingTailSize texels
+uint32_t TextureStreamingTailMip(uint32_t width, uint32_t height,
+                                 uint32_t mipCount);
+// the mip whose texels are about the size of a pixel when the whole texture
+// covers screenSize pixels
+uint32_t TextureStreamingMipForScreenSize(uint32_t width, uint32_t height,
+                                          uint32_t mipCount, float screenSize);
+
+// a use of the texture in `frame`, the most detailed request of a frame wins
+void TextureStreamerRequest(TextureStreamer *s, uint32_t handle,
+                            uint32_t mip, uint64_t frame);
+// decides the residency after the requests of `frame`; newly resident mips
+// are limited to maxLoadBytes per update. The changes are in s->changes.
+void TextureStreamerUpdate(TextureStreamer *s, uint64_t frame,
+                           uint64_t maxLoadBytes);
+// undoes a change the caller could not carry out (the file is gone)
+void TextureStreamerSetResident(TextureStreamer *s, uint32_t handle,
+                                uint32_t mip);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEXTURE_STREAMING_H */
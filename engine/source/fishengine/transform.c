@@ -10,6 +10,19 @@ void TransformSetDirty(World *w, Transform *t) {
     tm->H[idx].localNotDirty = false;
 }
 
+void TransformSetDirtyRange(World *w, uint32_t begin, uint32_t count) {
+    SingletonTransformManager *tm =
+        WorldGetSingletonComponent(w, SingletonTransformManagerID);
+    const uint32_t size = w->componentArrays[TransformID].m.size;
+    if (begin >= size) return;
+    if (count > size - begin) count = size - begin;
+    tm->modified++;
+    for (uint32_t i = begin; i < begin + count; ++i) {
+        tm->H[i].modified = tm->modified;
+        tm->H[i].localNotDirty = false;
+    }
+}
+
 void TransformSetParent2(World *w, Transform *t, uint32_t newParent) {
     uint32_t child = WorldGetComponentIndex(w, t, TransformID);
     uint32_t parent = t->parent;
@@ -84,6 +84,9 @@ static inline Transform *TransformGetParent(World *w, Transform *t) {
 }
 
 void TransformSetDirty(World *w, Transform *t);
+// marks `count` transforms starting at index `begin`, for writes that went
+// straight to the component storage
+void TransformSetDirtyRange(World *w, uint32_t begin, uint32_t count);
 
 void TransformSetParent2(World *w, Transform *t, uint32_t newParent);
 
@@ -0,0 +1,65 @@
+#include "upload_ring.h"
+
+#include <assert.h>
+#include <string.h>
+
+void UploadRingInit(UploadRing *r, uint64_t capacity) {
+    memset(r, 0, sizeof(*r));
+    r->capacity = capacity;
+}
+
+uint64_t UploadRingAlloc(UploadRing *r, uint64_t size, uint64_t alignment) {
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    uint64_t offset = r->head % r->capacity;
+    uint64_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+    if (aligned + size > r->capacity) aligned = r->capacity;  // wrap around
+    uint64_t padding = aligned - offset;
+    if (aligned == r->capacity) aligned = 0;
+    if (size > r->capacity ||
+        r->head + padding + size - r->tail > r->capacity) {
+        r->failedCount++;
+        return UploadRingInvalidOffset;
+    }
+    r->head += padding + size;
+    r->allocatedBytes += size;
+    r->paddingBytes += padding;
+    if (r->head - r->tail > r->peakUsedBytes)
+        r->peakUsedBytes = r->head - r->tail;
+    return aligned;
+}
+
+void UploadRingEndFrame(UploadRing *r, uint64_t frame) {
+    if (r->frameCount > 0) {
+        struct UploadRingFrame *last = &r->frames[r->frameCount - 1];
+        assert(last->frame <= frame);
+        if (last->frame == frame) {  // same frame ended twice
+            last->head = r->head;
+            return;
+        }
+    }
+    // more frames than that in flight means UploadRingRetire is not called
+    // often enough; the last one is stretched to `frame`, its allocations
+    // are freed together with these, later than they could be
+    if (r->frameCount == UploadRingMaxFrames) {
+        struct UploadRingFrame *last = &r->frames[r->frameCount - 1];
+        last->frame = frame;
+        last->head = r->head;
+        return;
+    }
+    r->frames[r->frameCount].frame = frame;
+    r->frames[r->frameCount].head = r->head;
+    r->frameCount++;
+}
+
+void UploadRingRetire(UploadRing *r, uint64_t completedFrame) {
+    uint32_t n = 0;
+    while (n < r->frameCount && r->frames[n].frame <= completedFrame) {
+        r->tail = r->frames[n].head;
+        n++;
+    }
+    if (n > 0) {
+        memmove(r->frames, r->frames + n,
+                (r->frameCount - n) * sizeof(struct UploadRingFrame));
+        r->frameCount -= n;
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef UPLOAD_RING_H
+#define UPLOAD_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Allocator for a persistently mapped upload buffer that is written by the
+// cpu and read by the gpu a few frames later. Allocations are never freed one
+// by one: everything allocated before UploadRingEndFrame(frame) is retired
+// together by the first UploadRingRetire whose completedFrame reaches
+// `frame`. Only offsets are handed out, the backend owns the memory.
+
+#define UploadRingMaxFrames 8
+#define UploadRingInvalidOffset UINT64_MAX
+
+struct UploadRingFrame {
+    uint64_t frame;
+    uint64_t head;  // UploadRing.head at the end of the frame
+};
+
+struct UploadRing {
+    uint64_t capacity;
+    // both only grow, the offset in the buffer is head % capacity
+    uint64_t head;  // bytes handed out, padding included
+    uint64_t tail;  // bytes retired
+    struct UploadRingFrame frames[UploadRingMaxFrames];
+    uint32_t frameCount;
+
+    // accounting, since UploadRingInit
+    uint64_t allocatedBytes;  // requested by the callers
+    uint64_t paddingBytes;    // lost to alignment and wrapping around
+    uint64_t peakUsedBytes;   // max of head - tail
+    uint32_t failedCount;     // allocations that did not fit
+};
+typedef struct UploadRing UploadRing;
+
+void UploadRingInit(UploadRing *r, uint64_t capacity);
+
+// alignment must be a power of two. An allocation never wraps around the end
+// of the buffer. Returns UploadRingInvalidOffset if the gpu still holds too
+// much of the ring; the caller falls back to some other memory.
+uint64_t UploadRingAlloc(UploadRing *r, uint64_t size, uint64_t alignment);
+
+// tags every allocation since the last call with `frame`, frames must be
+// increasing. Past UploadRingMaxFrames frames in flight the last one also
+// takes the allocations of the next
+void UploadRingEndFrame(UploadRing *r, uint64_t frame);
+// frees the allocations of every frame <= completedFrame
+void UploadRingRetire(UploadRing *r, uint64_t completedFrame);
+
+// bytes still in flight
+static inline uint64_t UploadRingGetUsed(const UploadRing *r) {
+    return r->head - r->tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPLOAD_RING_H */
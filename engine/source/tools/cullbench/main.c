@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "culling.h"
+#include "jobs.h"
+
+// wall clock, clock() adds up the time of all threads
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float Random(float min, float max) {
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+// random boxes in a 2km cube around the origin, a camera at the origin
+// looking into `viewCount` directions
+static void MakeViews(Frustum *frustums, uint32_t viewCount) {
+    float4x4 p = float4x4_perspective(60, 16.f / 9.f, 0.3f, 1000.f);
+    for (uint32_t i = 0; i < viewCount; ++i) {
+        float angle = 6.2831853f * i / viewCount;
+        float3 forward = {sinf(angle), 0, -cosf(angle)};
+        float4x4 v = float4x4_look_to(float3_zero, forward, float3_up);
+        float4x4 vp = float4x4_mul(p, v);
+        FrustumFromMatrix(frustums + i, &vp);
+    }
+}
+
+static void Report(const char *name, double time, uint32_t culls,
+                   uint32_t count, uint32_t visible) {
+    double ms = time * 1000 / culls;
+    printf("%-24s time: %lfs  %.3fms per cull  %.0f objects/ms  visible: %u\n",
+           name, time, ms, count / ms, visible);
+}
+
+static void PrintHelp() {
+    puts(
+        "usage:\n"
+        "cullbench [renderable_count] [iterations]\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        PrintHelp();
+        return 0;
+    }
+    const uint32_t count = argc >= 2 ? (uint32_t)atoi(argv[1]) : 100000;
+    const uint32_t iterations = argc >= 3 ? (uint32_t)atoi(argv[2]) : 100;
+    if (count == 0 || iterations == 0) {
+        PrintHelp();
+        return 1;
+    }
+
+    srand(1234);
+    CullingGroup g;
+    CullingGroupInit(&g);
+    for (uint32_t i = 0; i < count; ++i) {
+        Bounds b;
+        b.center.x = Random(-1000, 1000);
+        b.center.y = Random(-1000, 1000);
+        b.center.z = Random(-1000, 1000);
+        b.extents.x = Random(0.5f, 5);
+        b.extents.y = Random(0.5f, 5);
+        b.extents.z = Random(0.5f, 5);
+        CullingGroupAdd(&g, b);
+    }
+    const uint32_t viewCount = 8;
+    Frustum frustums[8];
+    MakeViews(frustums, viewCount);
+    printf("%u renderables, %u culls\n", count, iterations);
+
+    // the reference every other method has to agree with
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (FrustumTestBounds(frustums, CullingGroupGet(&g, i)) !=
+            FrustumOutside)
+            expected++;
+    }
+
+    uint32_t visible = 0;
+    double start = Now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        visible = CullingGroupCull(&g, frustums + i % viewCount);
+    Report("simd, 1 thread", Now() - start, iterations, count, visible);
+
+    JobSystemInit(UINT32_MAX);
+    start = Now();
+    for (uint32_t i = 0; i < iterations; ++i)
+        visible = CullingGroupCull(&g, frustums + i % viewCount);
+    char name[64];
+    snprintf(name, sizeof(name), "simd, %u threads", JobSystemGetThreadCount());
+    Report(name, Now() - start, iterations, count, visible);
+    CullingGroupCull(&g, frustums);
+    if (g.visible.size != expected) {
+        printf("simd: %u visible, expected %u\n", g.visible.size, expected);
+        return 1;
+    }
+    JobSystemShutdown();
+
+    CullingBVH bvh;
+    start = Now();
+    CullingBVHBuild(&bvh, &g);
+    printf("bvh build time: %lfs, %u nodes\n", Now() - start, bvh.nodes.size);
+    array out;
+    array_init(&out, sizeof(uint32_t), count);
+    start = Now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        out.size = 0;
+        visible = CullingBVHCull(&bvh, &g, frustums + i % viewCount, &out);
+    }
+    Report("bvh, 1 thread", Now() - start, iterations, count, visible);
+    out.size = 0;
+    if (CullingBVHCull(&bvh, &g, frustums, &out) != expected) {
+        printf("bvh: %u visible, expected %u\n", out.size, expected);
+        return 1;
+    }
+
+    array_free(&out);
+    CullingBVHFree(&bvh);
+    CullingGroupFree(&g);
+    return 0;
+}
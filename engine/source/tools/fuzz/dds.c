@@ -0,0 +1,24 @@
+#include <stdlib.h>
+
+#include "ddsloader.h"
+#include "fuzz.h"
+
+// DDSParseHeader promises that every subresource is inside the file
+bool FuzzOne(const uint8_t *data, size_t size) {
+    TextureDesc desc;
+    uint32_t dataOffset;
+    if (DDSParseHeader(data, size, size, &desc, &dataOffset) != DDSOk)
+        return false;
+    const uint32_t count = TextureDescSubresourceCount(&desc);
+    TextureMip *subresources = malloc(count * sizeof(TextureMip));
+    DDSGetSubresources(&desc, dataOffset, subresources);
+    volatile uint8_t sum = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const TextureMip *m = subresources + i;
+        if (m->byteLength == 0 || (uint64_t)m->offset + m->byteLength > size)
+            abort();
+        sum += data[m->offset] + data[m->offset + m->byteLength - 1];
+    }
+    free(subresources);
+    return true;
+}
@@ -0,0 +1,17 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A fuzz target: parses one input the way the engine would and touches
+// everything the parser says is there. True when the input was accepted.
+//
+// Built with FISHENGINE_FUZZ the targets are libFuzzer binaries
+// (libfuzzer.c), otherwise they replay files and check that each one is
+// accepted or rejected as expected (replay.c), which is how the corpus runs
+// as a test.
+bool FuzzOne(const uint8_t *data, size_t size);
+
+#endif /* FUZZ_H */
@@ -0,0 +1,14 @@
+#include "fuzz.h"
+#include "image_decode.h"
+
+// an accepted image has all its pixels
+bool FuzzOne(const uint8_t *data, size_t size) {
+    Image image;
+    const char *error;
+    if (!ImageDecode(data, size, &image, &error)) return false;
+    const size_t bytes = (size_t)image.width * image.height * 4;
+    volatile uint8_t sum = image.pixels[0] + image.pixels[bytes - 1];
+    (void)sum;
+    ImageFree(&image);
+    return true;
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fuzz.h"
+
+static void PrintHelp(const char *name) {
+    printf(
+        "usage: %s [files] [--accept files] [--reject files]\n"
+        "  runs the files through the fuzz target; the ones after --accept\n"
+        "  must be accepted and the ones after --reject rejected\n",
+        name);
+}
+
+// the whole file in a buffer of its size, so that reading past the end of
+// the input is caught by the address sanitizer
+static uint8_t *ReadFile(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    const long length = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = NULL;
+    if (length >= 0) data = malloc(length > 0 ? (size_t)length : 1);
+    if (data != NULL && fread(data, 1, (size_t)length, f) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = (size_t)length;
+    return data;
+}
+
+int main(int argc, char *argv[]) {
+    enum { Run, Accept, Reject } expect = Run;
+    uint32_t count = 0, failed = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--help") == 0) {
+            PrintHelp(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--accept") == 0) {
+            expect = Accept;
+            continue;
+        } else if (strcmp(argv[i], "--reject") == 0) {
+            expect = Reject;
+            continue;
+        }
+        size_t size;
+        uint8_t *data = ReadFile(argv[i], &size);
+        if (data == NULL) {
+            printf("%s: can not be read\n", argv[i]);
+            failed++;
+            continue;
+        }
+        const bool accepted = FuzzOne(data, size);
+        free(data);
+        count++;
+        if ((expect == Accept && !accepted) || (expect == Reject && accepted)) {
+            printf("%s: %s, expected the opposite\n", argv[i],
+                   accepted ? "accepted" : "rejected");
+            failed++;
+        }
+    }
+    printf("%u inputs, %u failed\n", count, failed);
+    return failed == 0 ? 0 : 1;
+}
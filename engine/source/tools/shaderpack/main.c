@@ -0,0 +1,250 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <microtar.h>
+
+#include "shader_archive.h"
+
+typedef struct PackEntry {
+    char name[256];
+    uint64_t hash;
+    void *data;
+    uint64_t size;
+} PackEntry;
+
+static const char *Basename(const char *path) {
+    const char *p = path;
+    for (const char *c = path; *c; ++c) {
+        if (*c == '/' || *c == '\\') p = c + 1;
+    }
+    return p;
+}
+
+static uint64_t AlignUp(uint64_t x, uint64_t alignment) {
+    return (x + alignment - 1) / alignment * alignment;
+}
+
+static int PackEntryCompare(const void *a, const void *b) {
+    const PackEntry *e1 = (const PackEntry *)a;
+    const PackEntry *e2 = (const PackEntry *)b;
+    if (e1->hash != e2->hash) return e1->hash < e2->hash ? -1 : 1;
+    return strcmp(e1->name, e2->name);
+}
+
+static bool WritePadding(FILE *f, uint64_t count) {
+    static const char zeros[ShaderArchiveAlignment] = {0};
+    while (count > 0) {
+        size_t n = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+        if (fwrite(zeros, 1, n, f) != n) return false;
+        count -= n;
+    }
+    return true;
+}
+
+static bool WriteArchive(const char *path, PackEntry *entries, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        entries[i].hash = ShaderArchiveHash(entries[i].name);
+    }
+    qsort(entries, count, sizeof(PackEntry), PackEntryCompare);
+    for (uint32_t i = 1; i < count; ++i) {
+        if (strcmp(entries[i].name, entries[i - 1].name) == 0) {
+            printf("duplicated entry: %s\n", entries[i].name);
+            return false;
+        }
+    }
+
+    ShaderArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ShaderArchiveMagic;
+    header.version = ShaderArchiveVersion;
+    header.entryCount = count;
+    header.bucketBits = 1;
+    while ((1u << header.bucketBits) < count) header.bucketBits++;
+    const uint32_t bucketCount = 1u << header.bucketBits;
+
+    uint32_t *buckets = (uint32_t *)malloc((bucketCount + 1) * sizeof(uint32_t));
+    for (uint32_t b = 0, i = 0; b <= bucketCount; ++b) {
+        while (i < count &&
+               ShaderArchiveBucket(entries[i].hash, header.bucketBits) < b)
+            ++i;
+        buckets[b] = i;
+    }
+
+    ShaderArchiveEntry *table =
+        (ShaderArchiveEntry *)malloc(count * sizeof(ShaderArchiveEntry));
+    uint64_t namesSize = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        table[i].nameHash = entries[i].hash;
+        table[i].size = entries[i].size;
+        table[i].nameOffset = (uint32_t)namesSize;
+        table[i].nameLength = (uint32_t)strlen(entries[i].name);
+        namesSize += table[i].nameLength + 1;
+    }
+
+    header.entriesOffset = sizeof(ShaderArchiveHeader);
+    header.bucketsOffset =
+        header.entriesOffset + count * sizeof(ShaderArchiveEntry);
+    header.namesOffset =
+        header.bucketsOffset + (bucketCount + 1) * sizeof(uint32_t);
+    header.namesSize = namesSize;
+
+    uint64_t offset =
+        AlignUp(header.namesOffset + namesSize, ShaderArchiveAlignment);
+    for (uint32_t i = 0; i < count; ++i) {
+        table[i].offset = offset;
+        // +1: keep a zero byte after every entry
+        offset = AlignUp(offset + table[i].size + 1, ShaderArchiveAlignment);
+    }
+
+    bool ok = false;
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        printf("can not open %s\n", path);
+        goto END;
+    }
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(table, sizeof(ShaderArchiveEntry), count, f);
+    fwrite(buckets, sizeof(uint32_t), bucketCount + 1, f);
+    for (uint32_t i = 0; i < count; ++i) {
+        fwrite(entries[i].name, 1, table[i].nameLength + 1, f);
+    }
+    uint64_t pos = header.namesOffset + namesSize;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!WritePadding(f, table[i].offset - pos)) goto END;
+        if (fwrite(entries[i].data, 1, entries[i].size, f) != entries[i].size)
+            goto END;
+        pos = table[i].offset + table[i].size;
+    }
+    ok = WritePadding(f, offset - pos);
+END:
+    if (f) fclose(f);
+    free(table);
+    free(buckets);
+    return ok;
+}
+
+static bool ReadEntry(const char *path, PackEntry *e) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    e->size = size;
+    e->data = malloc(size > 0 ? size : 1);
+    bool ok = fread(e->data, 1, size, f) == (size_t)size;
+    fclose(f);
+    const char *name = Basename(path);
+    if (strlen(name) >= sizeof(e->name)) return false;
+    strcpy(e->name, name);
+    return ok;
+}
+
+// compares lookups in a tar (the old shaders.tar path: mtar_find + copy)
+// with lookups in a packed archive, on `count` synthetic entries
+static int Bench(uint32_t count) {
+    const char *tarPath = "shaderpack_bench.tar";
+    const char *pakPath = "shaderpack_bench.pak";
+
+    PackEntry *entries = (PackEntry *)malloc(count * sizeof(PackEntry));
+    srand(1234);
+    mtar_t tar;
+    mtar_open(&tar, tarPath, "w");
+    for (uint32_t i = 0; i < count; ++i) {
+        PackEntry *e = entries + i;
+        snprintf(e->name, sizeof(e->name), "shader%05u_%s.cso", i / 2,
+                 i % 2 ? "ps" : "vs");
+        e->size = 512 + rand() % (16 * 1024);
+        e->data = malloc(e->size);
+        for (uint64_t j = 0; j < e->size; ++j) ((uint8_t *)e->data)[j] = rand();
+        mtar_write_file_header(&tar, e->name, (unsigned)e->size);
+        mtar_write_data(&tar, e->data, (unsigned)e->size);
+    }
+    mtar_finalize(&tar);
+    mtar_close(&tar);
+    if (!WriteArchive(pakPath, entries, count)) return 1;
+
+    // look entries up in a different order than they were written
+    uint32_t *order = (uint32_t *)malloc(count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; ++i) order[i] = i;
+    for (uint32_t i = count - 1; i > 0; --i) {
+        uint32_t j = rand() % (i + 1);
+        uint32_t t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    clock_t start = clock();
+    mtar_open(&tar, tarPath, "r");
+    for (uint32_t i = 0; i < count; ++i) {
+        const PackEntry *e = entries + order[i];
+        mtar_header_t h;
+        int ret = mtar_find(&tar, e->name, &h);
+        assert(ret == MTAR_ESUCCESS);
+        void *p = malloc(h.size);
+        mtar_read_data(&tar, p, h.size);
+        assert(h.size == e->size && memcmp(p, e->data, h.size) == 0);
+        free(p);
+    }
+    mtar_close(&tar);
+    double tarTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    ShaderArchive *archive = ShaderArchiveOpen(pakPath);
+    if (archive == NULL) return 1;
+    for (uint32_t i = 0; i < count; ++i) {
+        const PackEntry *e = entries + order[i];
+        Memory m;
+        bool found = ShaderArchiveFind(archive, e->name, &m);
+        assert(found && m.byteLength == e->size);
+        assert(memcmp(m.buffer, e->data, m.byteLength) == 0);
+        (void)found;
+    }
+    ShaderArchiveClose(archive);
+    double pakTime = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%u entries\n", count);
+    printf("tar: %lfs %lfus per entry\n", tarTime, tarTime * 1e6 / count);
+    printf("pak: %lfs %lfus per entry\n", pakTime, pakTime * 1e6 / count);
+
+    for (uint32_t i = 0; i < count; ++i) free(entries[i].data);
+    free(entries);
+    free(order);
+    remove(tarPath);
+    remove(pakPath);
+    return 0;
+}
+
+static void PrintHelp() {
+    puts(
+        "usage:\n"
+        "shaderpack <output.pak> <files...>\n"
+        "shaderpack --bench [entry_count]\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        uint32_t count = argc >= 3 ? (uint32_t)atoi(argv[2]) : 4000;
+        return Bench(count > 0 ? count : 1);
+    }
+    if (argc < 3) {
+        PrintHelp();
+        return 1;
+    }
+
+    uint32_t count = argc - 2;
+    PackEntry *entries = (PackEntry *)calloc(count, sizeof(PackEntry));
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!ReadEntry(argv[i + 2], entries + i)) {
+            printf("can not read %s\n", argv[i + 2]);
+            return 1;
+        }
+    }
+    bool ok = WriteArchive(argv[1], entries, count);
+    if (ok) printf("%u entries -> %s\n", count, argv[1]);
+    for (uint32_t i = 0; i < count; ++i) free(entries[i].data);
+    free(entries);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,38 @@
+#include <string>
+
+#include "shader_internal.hpp"
+#include "test.h"
+
+// Which uint constants of a shader are bindless slots: only the
+// nameTextureIndex and nameSamplerIndex that FETexture2D(name) declares,
+// nothing else that happens to end in Index
+
+static void CheckKind(const char* name, ShaderConstantKind kind,
+                      const char* texture) {
+    std::string t = "unchanged";
+    const ShaderConstantKind k = ShaderGetConstantKind(name, &t);
+    if (k != kind) printf("%s: kind %d\n", name, (int)k);
+    CHECK(k == kind);
+    CHECK(t == texture);
+}
+
+int main() {
+    CheckKind("_MainTexTextureIndex", ShaderConstantTextureIndex, "_MainTex");
+    CheckKind("_MainTexSamplerIndex", ShaderConstantSamplerIndex, "_MainTex");
+    CheckKind("_BumpMapTextureIndex", ShaderConstantTextureIndex, "_BumpMap");
+    CheckKind("xTextureIndex", ShaderConstantTextureIndex, "x");
+
+    // plain values
+    CheckKind("_InstanceIndex", ShaderConstantValue, "unchanged");
+    CheckKind("_LODIndex", ShaderConstantValue, "unchanged");
+    CheckKind("_MainTexIndex", ShaderConstantValue, "unchanged");
+    CheckKind("_CascadeIndex", ShaderConstantValue, "unchanged");
+    CheckKind("_TextureIndexScale", ShaderConstantValue, "unchanged");
+    CheckKind("_MainTextureIndexOffset", ShaderConstantValue, "unchanged");
+    CheckKind("_MainTexTextureindex", ShaderConstantValue, "unchanged");
+    // the suffix alone names no texture
+    CheckKind("TextureIndex", ShaderConstantValue, "unchanged");
+    CheckKind("SamplerIndex", ShaderConstantValue, "unchanged");
+    CheckKind("", ShaderConstantValue, "unchanged");
+    return TestExit();
+}
@@ -0,0 +1,81 @@
+#include "frame_alloc.h"
+
+#include <string.h>
+
+#include "jobs.h"
+#include "statistics.h"
+#include "test.h"
+
+// FrameAlloc: aligned memory that is handed out again after FrameAllocReset,
+// requests that overflow a block move on to another one, and once the
+// blocks are there a frame no longer touches the heap
+
+static void TestAlignment() {
+    for (size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+        for (uint32_t i = 0; i < 8; ++i) {
+            char *p = FrameAlloc(0, 1 + i * 3, alignment);
+            CHECK((uintptr_t)p % alignment == 0);
+            memset(p, 0xcd, 1 + i * 3);
+        }
+    }
+    FrameAllocReset();
+}
+
+static void TestReset() {
+    void *first = FrameAlloc(0, 100, 16);
+    void *second = FrameAlloc(0, 100, 16);
+    CHECK(second != first);
+    FrameAllocReset();
+    CHECK(g_statistics.cpu.frameAllocSize >= 200);
+    CHECK(FrameAlloc(0, 100, 16) == first);
+    CHECK(FrameAlloc(0, 100, 16) == second);
+    FrameAllocReset();
+}
+
+// threads have arenas of their own
+static void TestThreads() {
+    char *a = FrameAlloc(0, 64, 16);
+    char *b = FrameAlloc(JobMaxWorkerCount, 64, 16);
+    CHECK(a + 64 <= b || b + 64 <= a);
+    memset(a, 1, 64);
+    memset(b, 2, 64);
+    CHECK(a[63] == 1 && b[0] == 2);
+    FrameAllocReset();
+}
+
+static void TestOverflow() {
+    // a frame of a few blocks, one request larger than a block
+    const size_t sizes[] = {FrameAllocBlockSize / 2, FrameAllocBlockSize / 2,
+                            FrameAllocBlockSize / 2, 3 * FrameAllocBlockSize,
+                            1000};
+    char *p[5];
+    for (uint32_t frame = 0; frame < 3; ++frame) {
+        for (uint32_t i = 0; i < 5; ++i) {
+            p[i] = FrameAlloc(1, sizes[i], 64);
+            CHECK((uintptr_t)p[i] % 64 == 0);
+            memset(p[i], (int)i, sizes[i]);
+        }
+        for (uint32_t i = 0; i < 5; ++i)
+            CHECK(p[i][0] == (char)i && p[i][sizes[i] - 1] == (char)i);
+        const uint32_t blocks = g_statistics.cpu.frameAllocBlockCount;
+        FrameAllocReset();
+        CHECK(g_statistics.cpu.frameAllocSize >= 4 * FrameAllocBlockSize);
+#ifndef NDEBUG
+        // the blocks of the first frame are enough for the next ones
+        if (frame > 0) CHECK(g_statistics.cpu.heapAllocations == 0);
+#endif
+        if (frame > 0)
+            CHECK(g_statistics.cpu.frameAllocBlockCount == blocks);
+    }
+    CHECK(g_statistics.cpu.frameAllocPeak >= 4 * FrameAllocBlockSize);
+}
+
+int main() {
+    init_global_statistics();
+    TestAlignment();
+    TestReset();
+    TestThreads();
+    TestOverflow();
+    FrameAllocShutdown();
+    return TestExit();
+}
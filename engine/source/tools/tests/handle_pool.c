@@ -0,0 +1,90 @@
+#include "handle_pool.h"
+
+#include "test.h"
+
+// HandlePool: a released handle is dead at once, its slot comes back with a
+// new generation once the frame is complete, and a full pool hands out 0
+
+static void CountDestroyed(void *ctx, uint32_t handle) { (*(uint32_t *)ctx)++; }
+
+static void TestGeneration() {
+    HandlePool p;
+    HandlePoolInit(&p, "test");
+    const uint32_t a = HandlePoolAlloc(&p);
+    const uint32_t b = HandlePoolAlloc(&p);
+    CHECK(a != 0 && b != 0 && a != b);
+    CHECK(HandleIndex(a) != 0 && HandleIndex(b) != 0);
+    CHECK(HandlePoolIsAlive(&p, a) && HandlePoolIsAlive(&p, b));
+    CHECK(!HandlePoolIsAlive(&p, 0));
+    CHECK(p.liveCount == 2);
+
+    // dead right away, the slot waits for frame 5
+    HandlePoolRelease(&p, a, 5);
+    CHECK(!HandlePoolIsAlive(&p, a));
+    CHECK(HandlePoolIsAlive(&p, b));
+    CHECK(p.liveCount == 1);
+    uint32_t destroyed = 0;
+    CHECK(HandlePoolCollect(&p, 4, CountDestroyed, &destroyed) == 0);
+    CHECK(destroyed == 0);
+    const uint32_t c = HandlePoolAlloc(&p);
+    CHECK(HandleIndex(c) != HandleIndex(a));
+
+    // recycled with the next generation, the old handle stays dead
+    CHECK(HandlePoolCollect(&p, 5, CountDestroyed, &destroyed) == 1);
+    CHECK(destroyed == 1);
+    const uint32_t d = HandlePoolAlloc(&p);
+    CHECK(HandleIndex(d) == HandleIndex(a));
+    CHECK(HandleGeneration(d) == HandleGeneration(a) + 1);
+    CHECK(HandlePoolIsAlive(&p, d));
+    CHECK(!HandlePoolIsAlive(&p, a));
+    CHECK(HandlePoolGetSlotCount(&p) == 4);
+
+    HandlePoolRelease(&p, b, 6);
+    HandlePoolRelease(&p, c, 6);
+    HandlePoolRelease(&p, d, 7);
+    CHECK(HandlePoolReportLeaks(&p) == 0);
+    HandlePoolFree(&p);
+}
+
+// the generation wraps around within its bits
+static void TestGenerationWraps() {
+    HandlePool p;
+    HandlePoolInit(&p, "test");
+    uint32_t h = HandlePoolAlloc(&p);
+    const uint32_t first = h;
+    for (uint64_t frame = 0; frame <= HandleGenerationMask; ++frame) {
+        HandlePoolRelease(&p, h, frame);
+        HandlePoolCollect(&p, frame, NULL, NULL);
+        h = HandlePoolAlloc(&p);
+        CHECK(HandleIndex(h) == HandleIndex(first));
+        CHECK(HandlePoolIsAlive(&p, h));
+    }
+    CHECK(h == first);
+    HandlePoolFree(&p);
+}
+
+static void TestExhausted() {
+    HandlePool p;
+    HandlePoolInit(&p, "test");
+    uint32_t last = 0;
+    for (uint32_t i = 1; i <= HandleIndexMask; ++i) last = HandlePoolAlloc(&p);
+    CHECK(HandleIndex(last) == HandleIndexMask);
+    CHECK(p.liveCount == HandleIndexMask);
+    CHECK(HandlePoolAlloc(&p) == 0);
+
+    // released but still in flight, the pool is still full
+    HandlePoolRelease(&p, last, 1);
+    CHECK(HandlePoolAlloc(&p) == 0);
+    HandlePoolCollect(&p, 1, NULL, NULL);
+    const uint32_t h = HandlePoolAlloc(&p);
+    CHECK(HandleIndex(h) == HandleIndexMask && h != last);
+    CHECK(HandlePoolAlloc(&p) == 0);
+    HandlePoolFree(&p);
+}
+
+int main() {
+    TestGeneration();
+    TestGenerationWraps();
+    TestExhausted();
+    return TestExit();
+}
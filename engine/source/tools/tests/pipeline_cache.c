@@ -0,0 +1,188 @@
+#include "pipeline_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+
+// pipeline_cache.bin: what is saved loads back the same, and a cut or
+// corrupted file loads nothing instead of reading past its end
+
+#define DeviceId 0x1234
+
+static PipelineDesc Desc(uint32_t i) {
+    PipelineDesc d;
+    memset(&d, 0, sizeof(d));
+    d.vsHash = 100 + i;
+    d.psHash = 200 + i;
+    d.vertexLayoutHash = 7;
+    d.state = PipelineRenderStateDefault();
+    d.colorFormat = 28;
+    d.depthFormat = 20;
+    d.sampleCount = 1;
+    return d;
+}
+
+// entry i has a blob of i bytes of value i
+static void Fill(PipelineCache *c, uint32_t count) {
+    uint8_t blob[64];
+    for (uint32_t i = 0; i < count; ++i) {
+        memset(blob, (int)i, sizeof(blob));
+        const PipelineDesc d = Desc(i);
+        PipelineCacheStore(c, &d, i > 0 ? blob : NULL, i);
+    }
+}
+
+static bool Load(PipelineCache *c, const void *data, size_t size) {
+    // a copy of its own size, reading past it is caught by the sanitizers
+    void *copy = malloc(size > 0 ? size : 1);
+    memcpy(copy, data, size);
+    const bool ok = PipelineCacheLoadFromMemory(c, MemoryMake(copy, size));
+    free(copy);
+    return ok;
+}
+
+static void TestRoundTrip() {
+    PipelineCache c;
+    PipelineCacheInit(&c, DeviceId);
+    Fill(&c, 20);
+    // replaced with a blob of another size, and one that was never used
+    uint8_t blob[32] = {0xab};
+    const PipelineDesc d5 = Desc(5);
+    PipelineCacheStore(&c, &d5, blob, sizeof(blob));
+    const PipelineDesc d19 = Desc(19);
+    PipelineCacheFind(&c, PipelineDescHash(&d19))->flags = 0;
+
+    array saved;
+    CHECK(PipelineCacheSaveToMemory(&c, &saved));
+    PipelineCache loaded;
+    PipelineCacheInit(&loaded, DeviceId);
+    CHECK(Load(&loaded, saved.ptr, saved.size));
+    CHECK(loaded.entries.size == 19);
+    for (uint32_t i = 0; i < 19; ++i) {
+        const PipelineDesc d = Desc(i);
+        PipelineCacheEntry *e =
+            PipelineCacheFind(&loaded, PipelineDescHash(&d));
+        CHECK(e != NULL);
+        if (e == NULL) continue;
+        CHECK(memcmp(&e->desc, &d, sizeof(d)) == 0);
+        // the warm-up list, nothing is used yet in this session
+        CHECK(e->flags == 0);
+        const uint8_t *b = PipelineCacheGetBlob(&loaded, e);
+        if (i == 5) {
+            CHECK(e->blobSize == sizeof(blob));
+            CHECK(b != NULL && memcmp(b, blob, sizeof(blob)) == 0);
+        } else if (i == 0) {
+            CHECK(b == NULL);
+        } else {
+            CHECK(e->blobSize == i && b != NULL);
+            if (b != NULL) CHECK(b[0] == i && b[i - 1] == i);
+        }
+    }
+    CHECK(PipelineCacheFind(&loaded, PipelineDescHash(&d19)) == NULL);
+
+    // only what was used again is saved the next time
+    for (uint32_t i = 0; i < 3; ++i) {
+        const PipelineDesc d = Desc(i);
+        PipelineCacheStore(&loaded, &d, NULL, 0);
+    }
+    array again;
+    CHECK(PipelineCacheSaveToMemory(&loaded, &again));
+    CHECK(again.size ==
+          sizeof(PipelineCacheHeader) + 3 * sizeof(PipelineCacheRecord) + 3);
+
+    // another device or driver throws the file away
+    PipelineCache other;
+    PipelineCacheInit(&other, DeviceId + 1);
+    CHECK(!Load(&other, saved.ptr, saved.size));
+    CHECK(other.entries.size == 0);
+
+    array_free(&saved);
+    array_free(&again);
+    PipelineCacheFree(&c);
+    PipelineCacheFree(&loaded);
+    PipelineCacheFree(&other);
+}
+
+static void CheckRefused(const void *data, size_t size) {
+    PipelineCache c;
+    PipelineCacheInit(&c, DeviceId);
+    Fill(&c, 3);
+    CHECK(!Load(&c, data, size));
+    CHECK(c.entries.size == 0 && c.blobs.size == 0);
+    PipelineCacheFree(&c);
+}
+
+static void TestCut() {
+    PipelineCache c;
+    PipelineCacheInit(&c, DeviceId);
+    Fill(&c, 10);
+    array saved;
+    PipelineCacheSaveToMemory(&c, &saved);
+    for (uint32_t size = 0; size < saved.size; ++size)
+        CheckRefused(saved.ptr, size);
+    CHECK(PipelineCacheLoadFromMemory(&c, MemoryMake(NULL, 0)) == false);
+    array_free(&saved);
+    PipelineCacheFree(&c);
+}
+
+static void TestCorrupt() {
+    PipelineCache c;
+    PipelineCacheInit(&c, DeviceId);
+    Fill(&c, 10);
+    array saved;
+    PipelineCacheSaveToMemory(&c, &saved);
+    uint8_t *bytes = saved.ptr;
+    PipelineCacheHeader *h = (PipelineCacheHeader *)bytes;
+    PipelineCacheRecord *r = (PipelineCacheRecord *)(h + 1);
+    const PipelineCacheHeader header = *h;
+    const PipelineCacheRecord record = r[3];
+
+    h->magic ^= 1;
+    CheckRefused(bytes, saved.size);
+    *h = header;
+    h->version++;
+    CheckRefused(bytes, saved.size);
+    *h = header;
+    h->recordCount++;
+    CheckRefused(bytes, saved.size);
+    *h = header;
+    h->recordCount = UINT32_MAX;
+    CheckRefused(bytes, saved.size);
+    *h = header;
+    h->blobSize++;
+    CheckRefused(bytes, saved.size);
+    *h = header;
+    h->blobSize = UINT64_MAX - sizeof(*h) - 10 * sizeof(*r) + 1;
+    CheckRefused(bytes, saved.size);
+    *h = header;
+
+    // records out of order, a key of another description, blobs past the
+    // end of the file
+    r[3] = r[4];
+    CheckRefused(bytes, saved.size);
+    r[3] = record;
+    r[3].desc.psHash++;
+    CheckRefused(bytes, saved.size);
+    r[3] = record;
+    r[3].blobOffset = header.blobSize;
+    CheckRefused(bytes, saved.size);
+    r[3].blobOffset = UINT64_MAX - 1;
+    CheckRefused(bytes, saved.size);
+    r[3] = record;
+    r[3].blobSize = UINT32_MAX;
+    CheckRefused(bytes, saved.size);
+    r[3] = record;
+
+    CHECK(Load(&c, bytes, saved.size));
+    CHECK(c.entries.size == 10);
+    array_free(&saved);
+    PipelineCacheFree(&c);
+}
+
+int main() {
+    TestRoundTrip();
+    TestCut();
+    TestCorrupt();
+    return TestExit();
+}
@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipeline_cache.h"
+#include "render_queue.h"
+#include "test.h"
+
+// The render queue's sort: keys order by pass, pipeline, material, mesh and
+// depth in that order, the radix sort agrees with qsort and keeps equal keys
+// in the order they were added, and the pipeline ids of the keys are reused
+// once their shaders are gone
+
+#define Max(bits) ((1u << (bits)) - 1)
+
+static void TestKeyOrder() {
+    const uint32_t pass = Max(RenderKeyPassBits);
+    const uint32_t pipeline = Max(RenderKeyPipelineBits);
+    const uint32_t material = Max(RenderKeyMaterialBits);
+    const uint32_t mesh = Max(RenderKeyMeshBits);
+    const uint32_t depth = Max(RenderKeyDepthBits);
+    // every field outweighs all the ones after it
+    CHECK(RenderKeyMake(1, 0, 0, 0, 0) >
+          RenderKeyMake(0, pipeline, material, depth, mesh));
+    CHECK(RenderKeyMake(0, 1, 0, 0, 0) >
+          RenderKeyMake(0, 0, material, depth, mesh));
+    CHECK(RenderKeyMake(0, 0, 1, 0, 0) > RenderKeyMake(0, 0, 0, depth, mesh));
+    CHECK(RenderKeyMake(0, 0, 0, 0, 1) > RenderKeyMake(0, 0, 0, depth, 0));
+    CHECK(RenderKeyMake(0, 0, 0, 1, 0) > RenderKeyMake(0, 0, 0, 0, 0));
+    CHECK(RenderKeyMake(pass, pipeline, material, depth, mesh) == UINT64_MAX);
+    // a value too large for its field does not spill into the next one
+    CHECK(RenderKeyMake(0, 0, 0, depth + 1, 0) == 0);
+    CHECK(RenderKeyMake(0, 0, 0, 0, mesh + 1) == 0);
+    CHECK(RenderKeyMake(0, 0, material + 1, 0, 0) == 0);
+    CHECK(RenderKeyMake(0, pipeline + 1, 0, 0, 0) == 0);
+    CHECK(RenderKeyMake(pass + 1, 0, 0, 0, 0) == 0);
+}
+
+static int CompareItems(const void *_a, const void *_b) {
+    const RenderSortItem *a = _a, *b = _b;
+    if (a->key != b->key) return a->key < b->key ? -1 : 1;
+    return a->index < b->index ? -1 : a->index > b->index;
+}
+
+static uint64_t g_Random = 0x9e3779b97f4a7c15ull;
+
+static uint64_t Random() {
+    g_Random ^= g_Random << 13;
+    g_Random ^= g_Random >> 7;
+    g_Random ^= g_Random << 17;
+    return g_Random;
+}
+
+// n random keys; with fewValues every field takes only a few values, so
+// that many keys are equal
+static void CheckSort(uint32_t n, bool fewValues) {
+    RenderQueue q;
+    memset(&q, 0, sizeof(q));
+    array_init(&q.items, sizeof(RenderSortItem), 16);
+    array_init(&q.scratch, sizeof(RenderSortItem), 16);
+    array_resize(&q.items, n);
+    RenderSortItem *items = q.items.ptr;
+    for (uint32_t i = 0; i < n; ++i) {
+        const uint64_t r = Random();
+        items[i].key = fewValues ? RenderKeyMake(r & 1, (r >> 8) & 3,
+                                                 (r >> 16) & 7, 0,
+                                                 (r >> 24) & 3)
+                                 : r;
+        items[i].index = i;
+    }
+    RenderSortItem *expected = malloc((n > 0 ? n : 1) * sizeof(*expected));
+    memcpy(expected, items, n * sizeof(*expected));
+    qsort(expected, n, sizeof(*expected), CompareItems);
+
+    RenderQueueSort(&q);
+    CHECK(q.items.size == n);
+    if (q.items.size == n)
+        CHECK(memcmp(q.items.ptr, expected, n * sizeof(*expected)) == 0);
+    free(expected);
+    array_free(&q.items);
+    array_free(&q.scratch);
+}
+
+static void TestSort() {
+    const uint32_t sizes[] = {0, 1, 2, 3, 100, 1000, 10000};
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        CheckSort(sizes[i], false);
+        CheckSort(sizes[i], true);
+    }
+}
+
+static void TestPipelineSortIDs() {
+    PipelineSortIDs s;
+    PipelineSortIDsInit(&s);
+    const uint32_t a = PipelineSortIDsGet(&s, 1, 2);
+    const uint32_t b = PipelineSortIDsGet(&s, 1, 3);
+    const uint32_t c = PipelineSortIDsGet(&s, 4, 2);
+    CHECK(a != b && b != c && a != c);
+    CHECK(PipelineSortIDsGet(&s, 1, 2) == a);
+
+    // shader 2 deleted: its pairs go, their ids come back for new pairs
+    PipelineSortIDsRelease(&s, 2);
+    CHECK(s.pairs.size == 1);
+    CHECK(PipelineSortIDsGet(&s, 1, 3) == b);
+    const uint32_t d = PipelineSortIDsGet(&s, 5, 6);
+    const uint32_t e = PipelineSortIDsGet(&s, 5, 7);
+    CHECK((d == a && e == c) || (d == c && e == a));
+    // no id is handed out twice, and they stay small
+    const uint32_t f = PipelineSortIDsGet(&s, 8, 9);
+    CHECK(f == 3);
+    CHECK(f != a && f != b && f != d && f != e);
+
+    for (uint32_t i = 0; i < 1000; ++i) {
+        PipelineSortIDsGet(&s, 100 + i, 100 + i);
+        PipelineSortIDsRelease(&s, 100 + i);
+    }
+    CHECK(PipelineSortIDsGet(&s, 2000, 2000) == 4);
+    PipelineSortIDsFree(&s);
+}
+
+int main() {
+    TestKeyOrder();
+    TestSort();
+    TestPipelineSortIDs();
+    return TestExit();
+}
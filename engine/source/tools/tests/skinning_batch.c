@@ -0,0 +1,100 @@
+#include "skinning_batch.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "test.h"
+
+// SkinningBatch: the job table matches SkinningJob of
+// Internal-Skinning.comp, meshes get consecutive outputs and palettes, and
+// the search finds the job of every thread group of the dispatch
+
+static void TestJobLayout() {
+    CHECK(sizeof(SkinningJob) == 32);
+    CHECK(offsetof(SkinningJob, firstGroup) == 0);
+    CHECK(offsetof(SkinningJob, vertexCount) == 4);
+    CHECK(offsetof(SkinningJob, sourceVertices) == 8);
+    CHECK(offsetof(SkinningJob, sourceSkin) == 12);
+    CHECK(offsetof(SkinningJob, paletteOffset) == 16);
+    CHECK(offsetof(SkinningJob, outputOffset) == 20);
+}
+
+// bone j of a mesh is filled with the byte `first + j`
+static void MakeBones(float4x4 *bones, uint32_t count, uint32_t first) {
+    for (uint32_t j = 0; j < count; ++j)
+        memset(bones + j, (int)(first + j), sizeof(float4x4));
+}
+
+static void TestBatch() {
+    // vertex and bone counts, an empty mesh and exact multiples of a group
+    // among them
+    const uint32_t vertices[] = {100, SkinningGroupSize, 0, 1,
+                                 3 * SkinningGroupSize + 1, 5000};
+    const uint32_t boneCounts[] = {3, 64, 2, 1, 0, 40};
+    const uint32_t meshCount = sizeof(vertices) / sizeof(vertices[0]);
+    float4x4 bones[64];
+
+    SkinningBatch b;
+    SkinningBatchInit(&b);
+    for (uint32_t frame = 0; frame < 2; ++frame) {
+        SkinningBatchClear(&b);
+        uint32_t firstBone = 0, vertexCount = 0, groupCount = 0;
+        for (uint32_t i = 0; i < meshCount; ++i) {
+            MakeBones(bones, boneCounts[i], firstBone);
+            const uint32_t output = SkinningBatchAdd(
+                &b, vertices[i], bones, boneCounts[i], 10 + i, 20 + i);
+            CHECK(output == vertexCount);
+            vertexCount += vertices[i];
+            groupCount += (vertices[i] + SkinningGroupSize - 1) /
+                          SkinningGroupSize;
+            firstBone += boneCounts[i];
+        }
+        CHECK(b.vertexCount == vertexCount);
+        CHECK(b.groupCount == groupCount);
+        CHECK(b.palette.size == firstBone);
+        // no job for the empty mesh
+        CHECK(b.jobs.size == meshCount - 1);
+
+        const SkinningJob *jobs = b.jobs.ptr;
+        uint32_t paletteOffset = 0;
+        for (uint32_t i = 0, j = 0; i < meshCount; ++i) {
+            if (vertices[i] > 0) {
+                CHECK(jobs[j].vertexCount == vertices[i]);
+                CHECK(jobs[j].sourceVertices == 10 + i);
+                CHECK(jobs[j].sourceSkin == 20 + i);
+                CHECK(jobs[j].paletteOffset == paletteOffset);
+                CHECK(jobs[j].reserved[0] == 0 && jobs[j].reserved[1] == 0);
+                MakeBones(bones, boneCounts[i], paletteOffset);
+                CHECK(memcmp((float4x4 *)b.palette.ptr + paletteOffset, bones,
+                             boneCounts[i] * sizeof(float4x4)) == 0);
+                j++;
+            }
+            paletteOffset += boneCounts[i];
+        }
+
+        // every group lands in the job that covers it, and every vertex is
+        // skinned by exactly one group
+        uint32_t skinned = 0;
+        for (uint32_t group = 0; group < b.groupCount; ++group) {
+            const uint32_t i =
+                SkinningBatchFindJob(jobs, b.jobs.size, group);
+            CHECK(i < b.jobs.size);
+            const SkinningJob *job = jobs + i;
+            CHECK(job->firstGroup <= group);
+            const uint32_t first = (group - job->firstGroup) *
+                                   SkinningGroupSize;
+            CHECK(first < job->vertexCount);
+            uint32_t n = job->vertexCount - first;
+            if (n > SkinningGroupSize) n = SkinningGroupSize;
+            skinned += n;
+        }
+        CHECK(skinned == b.vertexCount);
+    }
+    SkinningBatchFree(&b);
+}
+
+int main() {
+    TestJobLayout();
+    TestBatch();
+    return TestExit();
+}
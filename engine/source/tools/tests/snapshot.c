@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "animation.h"
+#include "asset.h"
+#include "camera.h"
+#include "ecs.h"
+#include "free_camera.h"
+#include "input.h"
+#include "light.h"
+#include "material.h"
+#include "mesh.h"
+#include "renderable.h"
+#include "singleton_selection.h"
+#include "singleton_time.h"
+#include "test.h"
+#include "transform.h"
+
+// WorldSerialize and WorldDeserialize: a restored world saves to the same
+// bytes, and a cut or corrupted snapshot is refused with the world left as
+// it was
+
+#define COMP(T)                                                        \
+    {                                                                  \
+        .type = T##ID, .name = #T, .size = sizeof(T), .ctor = T##Init, \
+        .dtor = NULL,                                                  \
+    }
+#define COMP2(T)                                                    \
+    {                                                               \
+        .type = T##ID, .name = #T, .size = sizeof(T), .ctor = NULL, \
+        .dtor = NULL,                                               \
+    }
+#define COMP3(T, free)                                                 \
+    {                                                                  \
+        .type = T##ID, .name = #T, .size = sizeof(T), .ctor = T##Init, \
+        .dtor = free, .save = T##Save, .load = T##Load,                \
+        .check = T##Check,                                             \
+    }
+
+static ComponentDef g_componentDef[] = {
+    COMP(Transform), COMP3(Renderable, NULL),
+    COMP(Camera),    COMP(Light),
+    COMP3(Animation, AnimationFree), COMP(FreeCamera)};
+
+static ComponentDef g_singleComponentDef[] = {
+    COMP(SingletonTransformManager), COMP(SingletonInput),
+    COMP2(SingletonTime), COMP(SingletonSelection)};
+
+// assets the renderables point to, only their ids matter here
+static Mesh *g_mesh, *g_otherMesh;
+static Material *g_material;
+
+static array Save(World *w) {
+    array a = {.stride = 1};
+    WorldSerialize(w, &a);
+    return a;
+}
+
+static bool SameBytes(const array *a, const array *b) {
+    return a->size == b->size && memcmp(a->ptr, b->ptr, a->size) == 0;
+}
+
+// root <- a <- b, c under root; a and b drawn, b animated with two clips
+static World *BuildWorld(AnimationClip **clips) {
+    WorldDef def = {g_componentDef, countof(g_componentDef),
+                    g_singleComponentDef, countof(g_singleComponentDef)};
+    World *w = WorldCreate(&def);
+    Entity root = WorldCreateEntity(w);
+    Entity a = WorldCreateEntity(w);
+    Entity b = WorldCreateEntity(w);
+    Entity c = WorldCreateEntity(w);
+    TransformSetParent2(w, TransformGet(w, a), root);
+    TransformSetParent2(w, TransformGet(w, b), a);
+    TransformSetParent2(w, TransformGet(w, c), root);
+    TransformGet(w, b)->localPosition = (float3){1, 2, 3};
+
+    Renderable *r = EntityAddComponent(a, w, RenderableID);
+    r->mesh = g_mesh;
+    r->material = g_material;
+    r = EntityAddComponent(b, w, RenderableID);
+    r->mesh = g_otherMesh;
+    r->material = g_material;
+
+    Animation *anim = EntityAddComponent(b, w, AnimationID);
+    for (uint32_t i = 0; i < 2; ++i) {
+        clips[i] = AnimationClipNew();
+        clips[i]->length = 1.f + i;
+        AnimationAddClip(anim, clips[i]);
+    }
+    return w;
+}
+
+static void TestRoundTrip(World *w, AnimationClip *extraClip) {
+    array saved = Save(w);
+
+    // everything a play session could change
+    TransformGet(w, 2)->localPosition = (float3){7, 7, 7};
+    TransformSetParent2(w, TransformGet(w, 3), 4);
+    Entity e = WorldCreateEntity(w);
+    TransformSetParent2(w, TransformGet(w, e), 1);
+    Renderable *r = EntityAddComponent(e, w, RenderableID);
+    r->mesh = g_mesh;
+    r = EntityGetComponent(2, w, RenderableID);
+    r->mesh = g_otherMesh;
+    r->material = NULL;
+    AnimationAddClip(EntityGetComponent(3, w, AnimationID), extraClip);
+
+    CHECK(WorldDeserialize(w, saved.ptr, saved.size));
+    array restored = Save(w);
+    CHECK(SameBytes(&saved, &restored));
+    CHECK(w->entityCount == 5);
+    CHECK(TransformGet(w, 3)->parent == 2);
+    CHECK(TransformGet(w, 2)->firstChild == 3);
+    r = EntityGetComponent(2, w, RenderableID);
+    CHECK(r->mesh == g_mesh && r->material == g_material);
+    CHECK(((Animation *)EntityGetComponent(3, w, AnimationID))->clips.size ==
+          2);
+    array_free(&saved);
+    array_free(&restored);
+}
+
+// the blob must be refused and leave the world as it was
+static void CheckRefused(World *w, const void *data, uint32_t size,
+                         const char *what) {
+    array before = Save(w);
+    // a copy of its own size, reading past it is caught by the sanitizers
+    void *copy = malloc(size > 0 ? size : 1);
+    memcpy(copy, data, size);
+    const bool accepted = WorldDeserialize(w, copy, size);
+    free(copy);
+    array after = Save(w);
+    if (accepted) printf("accepted: %s\n", what);
+    CHECK(!accepted);
+    CHECK(SameBytes(&before, &after));
+    array_free(&before);
+    array_free(&after);
+}
+
+static void TestCut(World *w) {
+    array saved = Save(w);
+    for (uint32_t size = 0; size < saved.size;
+         size = size < 512 ? size + 8 : size + size / 4)
+        CheckRefused(w, saved.ptr, size, "cut snapshot");
+    for (uint32_t cut = 8; cut <= 32; cut += 8)
+        CheckRefused(w, saved.ptr, saved.size - cut, "cut snapshot");
+    array_free(&saved);
+}
+
+static void TestCorruptHeader(World *w) {
+    array saved = Save(w);
+    uint32_t *header = (uint32_t *)saved.ptr;
+    // magic, version, entity count, component and singleton def counts,
+    // extra size
+    const uint32_t bad[][2] = {{0, 0},          {1, 2},     {2, 0},
+                               {2, MaxEntity + 1}, {3, 1},     {4, 0},
+                               {5, UINT32_MAX}, {5, 1 << 20}};
+    for (uint32_t i = 0; i < countof(bad); ++i) {
+        const uint32_t old = header[bad[i][0]];
+        header[bad[i][0]] = bad[i][1];
+        CheckRefused(w, saved.ptr, saved.size, "corrupt header");
+        header[bad[i][0]] = old;
+    }
+    array_free(&saved);
+}
+
+// what the corrupting save hooks do to the snapshot
+enum Corruption {
+    ClipOffsetPastExtra,
+    ClipOffsetMisaligned,
+    ClipCountPastExtra,
+    ClipOfWrongType,
+    ClipMissing,
+    MeshOfWrongType,
+    MeshMissing,
+};
+static enum Corruption g_corruption;
+
+static void CorruptAnimationSave(void *_a, array *extra) {
+    Animation *a = _a;
+    const uint32_t clipCount = a->clips.size;
+    AnimationSave(a, extra);
+    const uintptr_t offset = (uintptr_t)a->clips.ptr;
+    AssetID *ids = (AssetID *)((char *)extra->ptr + offset);
+    if (g_corruption == ClipOffsetPastExtra)
+        a->clips.ptr = (void *)(uintptr_t)(UINT32_MAX - 3);
+    else if (g_corruption == ClipOffsetMisaligned)
+        a->clips.ptr = (void *)(offset + 2);
+    else if (g_corruption == ClipCountPastExtra)
+        a->clips.size = 1u << 28;
+    else if (g_corruption == ClipOfWrongType && clipCount > 0)
+        ids[0] = g_mesh->assetID;
+    else if (g_corruption == ClipMissing && clipCount > 0)
+        ids[0] = 0xffff;
+}
+
+static void CorruptRenderableSave(void *_r, array *extra) {
+    Renderable *r = _r;
+    RenderableSave(r, extra);
+    if (g_corruption == MeshOfWrongType)
+        r->mesh = (Mesh *)(uintptr_t)g_material->assetID;
+    else if (g_corruption == MeshMissing)
+        r->mesh = (Mesh *)(uintptr_t)0xffff;
+}
+
+static void TestCorruptHooks(World *w) {
+    static const char *names[] = {
+        "clip offset past the extra section", "misaligned clip offset",
+        "clip count past the extra section",  "clip id of a mesh",
+        "clip id of no asset",                "mesh id of a material",
+        "mesh id of no asset"};
+    ComponentDef *defs = w->def.componentDefs;
+    for (uint32_t i = ClipOffsetPastExtra; i <= MeshMissing; ++i) {
+        g_corruption = i;
+        defs[AnimationID].save = CorruptAnimationSave;
+        defs[RenderableID].save = CorruptRenderableSave;
+        array corrupt = Save(w);
+        defs[AnimationID].save = AnimationSave;
+        defs[RenderableID].save = RenderableSave;
+        CheckRefused(w, corrupt.ptr, corrupt.size, names[i]);
+        array_free(&corrupt);
+    }
+}
+
+// a clip deleted after the snapshot was taken, its id may be handed out
+// again to another type of asset
+static void TestDeletedClip(World *w) {
+    Animation *anim = EntityGetComponent(3, w, AnimationID);
+    AnimationClip *clip = AnimationClipNew();
+    AnimationAddClip(anim, clip);
+    array saved = Save(w);
+    anim->clips.size--;
+    AssetDelete(clip->assetID);
+    CheckRefused(w, saved.ptr, saved.size, "deleted clip");
+    array_free(&saved);
+}
+
+static void TestCorruptEntities(World *w) {
+    _Entity *e = w->entities + 2;
+    const _Component old = e->components[1];
+    e->components[1].index = MaxComponent - 1;
+    array corrupt = Save(w);
+    e->components[1] = old;
+    CheckRefused(w, corrupt.ptr, corrupt.size, "component past its array");
+    array_free(&corrupt);
+
+    const Entity oldEntity = w->componentEntityMap[RenderableID][0];
+    w->componentEntityMap[RenderableID][0] = w->entityCount;
+    corrupt = Save(w);
+    w->componentEntityMap[RenderableID][0] = oldEntity;
+    CheckRefused(w, corrupt.ptr, corrupt.size, "component of no entity");
+    array_free(&corrupt);
+}
+
+int main() {
+    g_mesh = MeshNew();
+    g_otherMesh = MeshNew();
+    g_material = MaterialNew();
+    AnimationClip *clips[2];
+    World *w = BuildWorld(clips);
+    AnimationClip *extraClip = AnimationClipNew();
+
+    TestRoundTrip(w, extraClip);
+    TestCut(w);
+    TestCorruptHeader(w);
+    TestCorruptHooks(w);
+    TestDeletedClip(w);
+    TestCorruptEntities(w);
+
+    // the world is still the one built, it restores from itself
+    array saved = Save(w);
+    CHECK(WorldDeserialize(w, saved.ptr, saved.size));
+    array_free(&saved);
+    ComponentArray *anims = w->componentArrays + AnimationID;
+    for (uint32_t i = 0; i < anims->m.size; ++i)
+        AnimationFree(array_at(&anims->m, i));
+    WorldFree(w);
+    return TestExit();
+}
@@ -0,0 +1,24 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+// A test is an executable that runs its checks and returns non-zero if one
+// of them failed; every failed check prints where it is. TestExit is what
+// main returns.
+static int g_TestFailures = 0;
+
+#define CHECK(x)                                                          \
+    do {                                                                  \
+        if (!(x)) {                                                       \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            g_TestFailures++;                                             \
+        }                                                                 \
+    } while (0)
+
+static inline int TestExit() {
+    if (g_TestFailures > 0) printf("%d checks failed\n", g_TestFailures);
+    return g_TestFailures > 0 ? 1 : 0;
+}
+
+#endif /* TEST_H */
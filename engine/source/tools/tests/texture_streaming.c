@@ -0,0 +1,173 @@
+#include "texture_streaming.h"
+
+#include "test.h"
+
+// TextureStreamer: one more detailed mip per texture and update within the
+// load limit, the mips nobody asks for go first when the budget is short,
+// least recently used texture first, and residentBytes always adds up
+
+#define Size 1024
+#define MipCount 11  // 1024 to 1
+#define TailMip 4    // 64
+
+static uint64_t g_MipSize[MipCount];
+
+static void InitMipSizes() {
+    for (uint32_t i = 0; i < MipCount; ++i)
+        g_MipSize[i] = (uint64_t)(Size >> i) * (Size >> i);
+}
+
+static uint64_t ChainSize(uint32_t mip) {
+    uint64_t size = 0;
+    for (uint32_t i = mip; i < MipCount; ++i) size += g_MipSize[i];
+    return size;
+}
+
+// residentBytes is the sum of the resident chains
+static bool Consistent(TextureStreamer *s) {
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < s->textures.size; ++i) {
+        const StreamedTexture *t = array_at(&s->textures, i);
+        if (t->mipCount > 0) bytes += ChainSize(t->residentMip);
+    }
+    return bytes == s->residentBytes;
+}
+
+static uint32_t Add(TextureStreamer *s) {
+    const uint32_t tail = TextureStreamingTailMip(Size, Size, MipCount);
+    return TextureStreamerAdd(s, g_MipSize, MipCount, tail, NULL);
+}
+
+static uint32_t Resident(TextureStreamer *s, uint32_t handle) {
+    return TextureStreamerGet(s, handle)->residentMip;
+}
+
+static void TestMipMath() {
+    CHECK(TextureStreamingTailMip(Size, Size, MipCount) == TailMip);
+    CHECK(TextureStreamingTailMip(64, 64, 7) == 0);
+    CHECK(TextureStreamingTailMip(2048, 16, 12) == 5);
+    CHECK(TextureStreamingTailMip(Size, Size, 3) == 2);
+
+    CHECK(TextureStreamingMipForScreenSize(Size, Size, MipCount, 2000) == 0);
+    CHECK(TextureStreamingMipForScreenSize(Size, Size, MipCount, 1024) == 0);
+    CHECK(TextureStreamingMipForScreenSize(Size, Size, MipCount, 600) == 0);
+    CHECK(TextureStreamingMipForScreenSize(Size, Size, MipCount, 512) == 1);
+    CHECK(TextureStreamingMipForScreenSize(Size, Size, MipCount, 1) == 10);
+    CHECK(TextureStreamingMipForScreenSize(Size, Size, MipCount, 0.1f) == 10);
+}
+
+static void TestHandles() {
+    TextureStreamer s;
+    TextureStreamerInit(&s, UINT64_MAX);
+    const uint32_t a = Add(&s);
+    const uint32_t b = Add(&s);
+    CHECK(a != 0 && b != 0 && a != b);
+    CHECK(s.textureCount == 2);
+    CHECK(s.residentBytes == 2 * ChainSize(TailMip));
+    TextureStreamerRemove(&s, a);
+    CHECK(s.residentBytes == ChainSize(TailMip));
+    CHECK(Add(&s) == a);
+    CHECK(s.textureCount == 2);
+    CHECK(Consistent(&s));
+    TextureStreamerFree(&s);
+}
+
+// one more level per update, the most detailed request of a frame wins, and
+// a texture that is not seen keeps its mips while there is room
+static void TestLoad() {
+    TextureStreamer s;
+    TextureStreamerInit(&s, UINT64_MAX);
+    const uint32_t t = Add(&s);
+    uint64_t frame = 1;
+    for (uint32_t mip = TailMip; mip > 1; --mip, ++frame) {
+        TextureStreamerRequest(&s, t, 3, frame);
+        TextureStreamerRequest(&s, t, 1, frame);
+        TextureStreamerRequest(&s, t, 8, frame);
+        TextureStreamerUpdate(&s, frame, UINT64_MAX);
+        CHECK(Resident(&s, t) == mip - 1);
+        CHECK(s.mipsLoaded == 1 && s.mipsEvicted == 0);
+        CHECK(s.changes.size == 1);
+        const TextureStreamingChange *c = array_at(&s.changes, 0);
+        CHECK(c->handle == t && c->previousMip == mip &&
+              c->residentMip == mip - 1);
+        CHECK(s.wantedBytes == ChainSize(1));
+        CHECK(Consistent(&s));
+    }
+    TextureStreamerUpdate(&s, frame, UINT64_MAX);
+    CHECK(Resident(&s, t) == 1);
+    CHECK(s.changes.size == 0);
+    CHECK(s.wantedBytes == ChainSize(TailMip));
+
+    // the file is gone, the caller puts the tail back
+    TextureStreamerSetResident(&s, t, TailMip);
+    CHECK(s.residentBytes == ChainSize(TailMip));
+    TextureStreamerFree(&s);
+}
+
+static void TestLoadLimit() {
+    TextureStreamer s;
+    TextureStreamerInit(&s, UINT64_MAX);
+    const uint32_t a = Add(&s);
+    const uint32_t b = Add(&s);
+    TextureStreamerRequest(&s, a, 0, 1);
+    TextureStreamerRequest(&s, b, 2, 1);
+    // room for one mip 3, the texture furthest behind goes first
+    TextureStreamerUpdate(&s, 1, g_MipSize[3] + g_MipSize[3] / 2);
+    CHECK(Resident(&s, a) == 3 && Resident(&s, b) == TailMip);
+    CHECK(s.mipsLoaded == 1);
+    TextureStreamerUpdate(&s, 1, 0);
+    CHECK(s.mipsLoaded == 0 && s.changes.size == 0);
+    CHECK(Consistent(&s));
+    TextureStreamerFree(&s);
+}
+
+// the budget fits two textures at mip 3 next to the tail of the third
+static void TestBudget() {
+    TextureStreamer s;
+    TextureStreamerInit(&s, 2 * ChainSize(3) + ChainSize(TailMip));
+    const uint32_t a = Add(&s);
+    const uint32_t b = Add(&s);
+    const uint32_t c = Add(&s);
+    TextureStreamerRequest(&s, a, 3, 1);
+    TextureStreamerUpdate(&s, 1, UINT64_MAX);
+    TextureStreamerRequest(&s, b, 3, 2);
+    TextureStreamerUpdate(&s, 2, UINT64_MAX);
+    CHECK(Resident(&s, a) == 3 && Resident(&s, b) == 3);
+    CHECK(s.residentBytes == s.budget);
+    CHECK(s.mipsEvicted == 0);
+
+    // a was seen before b, it makes room for c
+    TextureStreamerRequest(&s, c, 3, 3);
+    TextureStreamerUpdate(&s, 3, UINT64_MAX);
+    CHECK(Resident(&s, c) == 3);
+    CHECK(Resident(&s, a) == TailMip && Resident(&s, b) == 3);
+    CHECK(s.mipsLoaded == 1 && s.mipsEvicted == 1);
+    CHECK(s.changes.size == 2);
+    CHECK(s.residentBytes <= s.budget);
+    CHECK(Consistent(&s));
+
+    // the tails stay whatever the budget
+    s.budget = 0;
+    TextureStreamerUpdate(&s, 4, UINT64_MAX);
+    CHECK(Resident(&s, a) == TailMip && Resident(&s, b) == TailMip &&
+          Resident(&s, c) == TailMip);
+    CHECK(s.residentBytes == 3 * ChainSize(TailMip));
+    CHECK(s.changes.size == 2);
+    CHECK(Consistent(&s));
+
+    // no request fits, nothing is loaded nor evicted for it
+    TextureStreamerRequest(&s, a, 0, 5);
+    TextureStreamerUpdate(&s, 5, UINT64_MAX);
+    CHECK(s.mipsLoaded == 0 && s.mipsEvicted == 0);
+    TextureStreamerFree(&s);
+}
+
+int main() {
+    InitMipSizes();
+    TestMipMath();
+    TestHandles();
+    TestLoad();
+    TestLoadLimit();
+    TestBudget();
+    return TestExit();
+}
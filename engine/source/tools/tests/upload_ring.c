@@ -0,0 +1,128 @@
+#include "upload_ring.h"
+
+#include "test.h"
+
+// UploadRing: aligned offsets that never straddle the end of the buffer,
+// memory that comes back once the gpu finished the frame, and a ring that
+// refuses what does not fit instead of overwriting frames in flight
+
+static void TestAlignment() {
+    UploadRing r;
+    UploadRingInit(&r, 4096);
+    CHECK(UploadRingAlloc(&r, 1, 1) == 0);
+    CHECK(UploadRingAlloc(&r, 10, 256) == 256);
+    CHECK(UploadRingAlloc(&r, 4, 4) == 268);
+    CHECK(UploadRingAlloc(&r, 16, 16) == 272);
+    CHECK(r.allocatedBytes == 31);
+    CHECK(r.paddingBytes == 255 + 2);
+    CHECK(UploadRingGetUsed(&r) == 288);
+}
+
+static void TestRetire() {
+    UploadRing r;
+    UploadRingInit(&r, 1024);
+    UploadRingAlloc(&r, 100, 4);
+    UploadRingEndFrame(&r, 1);
+    UploadRingAlloc(&r, 200, 4);
+    UploadRingEndFrame(&r, 2);
+    // ending a frame twice keeps one entry
+    UploadRingAlloc(&r, 50, 4);
+    UploadRingEndFrame(&r, 2);
+    CHECK(r.frameCount == 2);
+
+    UploadRingRetire(&r, 0);
+    CHECK(UploadRingGetUsed(&r) == 350);
+    UploadRingRetire(&r, 1);
+    CHECK(UploadRingGetUsed(&r) == 250);
+    CHECK(r.frameCount == 1);
+    UploadRingRetire(&r, 2);
+    CHECK(UploadRingGetUsed(&r) == 0);
+    CHECK(r.frameCount == 0);
+    CHECK(r.peakUsedBytes == 350);
+}
+
+static void TestFull() {
+    UploadRing r;
+    UploadRingInit(&r, 1024);
+    CHECK(UploadRingAlloc(&r, 2048, 4) == UploadRingInvalidOffset);
+    CHECK(UploadRingAlloc(&r, 1000, 4) == 0);
+    UploadRingEndFrame(&r, 1);
+    // the gpu still reads frame 1
+    CHECK(UploadRingAlloc(&r, 100, 4) == UploadRingInvalidOffset);
+    CHECK(UploadRingAlloc(&r, 24, 4) == 1000);
+    CHECK(UploadRingAlloc(&r, 1, 1) == UploadRingInvalidOffset);
+    CHECK(r.failedCount == 3);
+    UploadRingEndFrame(&r, 2);
+    UploadRingRetire(&r, 1);
+    CHECK(UploadRingGetUsed(&r) == 24);
+    CHECK(UploadRingAlloc(&r, 1000, 4) == 0);
+}
+
+// an allocation that does not fit before the end starts over at 0, but not
+// over memory still in flight
+static void TestWrapAround() {
+    UploadRing r;
+    UploadRingInit(&r, 1024);
+    UploadRingAlloc(&r, 600, 4);
+    UploadRingEndFrame(&r, 1);
+    UploadRingAlloc(&r, 300, 4);
+    UploadRingEndFrame(&r, 2);
+    CHECK(UploadRingAlloc(&r, 200, 16) == UploadRingInvalidOffset);
+    UploadRingRetire(&r, 1);
+    const uint64_t padding = r.paddingBytes;
+    CHECK(UploadRingAlloc(&r, 200, 16) == 0);
+    CHECK(r.paddingBytes == padding + 1024 - 900);
+    // up to where frame 2 starts
+    CHECK(UploadRingAlloc(&r, 400, 16) == UploadRingInvalidOffset);
+    CHECK(UploadRingAlloc(&r, 392, 16) == 208);
+    CHECK(UploadRingAlloc(&r, 1, 1) == UploadRingInvalidOffset);
+    UploadRingEndFrame(&r, 3);
+    UploadRingRetire(&r, 3);
+    CHECK(UploadRingGetUsed(&r) == 0);
+
+    // many times around, the offsets stay in the buffer
+    for (uint64_t frame = 4; frame < 100; ++frame) {
+        const uint64_t offset = UploadRingAlloc(&r, 300, 64);
+        CHECK(offset != UploadRingInvalidOffset);
+        CHECK(offset % 64 == 0 && offset + 300 <= r.capacity);
+        UploadRingEndFrame(&r, frame);
+        UploadRingRetire(&r, frame - 1);
+    }
+    CHECK(r.frameCount == 1);
+}
+
+// more frames in flight than the ring keeps: the last frame takes the
+// allocations of the next ones and nothing is freed before the gpu is done
+// with all of them
+static void TestFramesInFlight() {
+    UploadRing r;
+    UploadRingInit(&r, 1 << 20);
+    for (uint64_t frame = 1; frame <= 3 * UploadRingMaxFrames; ++frame) {
+        UploadRingAlloc(&r, 1000, 4);
+        UploadRingEndFrame(&r, frame);
+    }
+    CHECK(r.frameCount == UploadRingMaxFrames);
+    UploadRingRetire(&r, UploadRingMaxFrames - 1);
+    CHECK(UploadRingGetUsed(&r) ==
+          1000 * (3 * UploadRingMaxFrames - (UploadRingMaxFrames - 1)));
+    UploadRingRetire(&r, 3 * UploadRingMaxFrames - 1);
+    CHECK(UploadRingGetUsed(&r) ==
+          1000 * (3 * UploadRingMaxFrames - (UploadRingMaxFrames - 1)));
+    UploadRingRetire(&r, 3 * UploadRingMaxFrames);
+    CHECK(UploadRingGetUsed(&r) == 0);
+    CHECK(r.frameCount == 0);
+
+    // and it goes on as usual
+    UploadRingAlloc(&r, 10, 4);
+    UploadRingEndFrame(&r, 3 * UploadRingMaxFrames + 1);
+    CHECK(r.frameCount == 1);
+}
+
+int main() {
+    TestAlignment();
+    TestRetire();
+    TestFull();
+    TestWrapAround();
+    TestFramesInFlight();
+    return TestExit();
+}
@@ -0,0 +1,222 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jobs.h"
+#include "texture_encoder.h"
+
+// wall clock, clock() adds up the time of all threads
+static double Now() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// decoders to measure the error with, independent of the encoder
+
+static void Decode565(uint32_t v, int c[4]) {
+    const int r = v >> 11, g = v >> 5 & 63, b = v & 31;
+    c[0] = r << 3 | r >> 2;
+    c[1] = g << 2 | g >> 4;
+    c[2] = b << 3 | b >> 2;
+    c[3] = 255;
+}
+
+static void DecodeBC1(const uint8_t *b, bool fourColors, uint8_t out[16][4]) {
+    const uint32_t c0 = b[0] | b[1] << 8, c1 = b[2] | b[3] << 8;
+    int p[4][4];
+    Decode565(c0, p[0]);
+    Decode565(c1, p[1]);
+    fourColors = fourColors || c0 > c1;
+    for (int c = 0; c < 4; ++c) {
+        if (fourColors) {
+            p[2][c] = (2 * p[0][c] + p[1][c]) / 3;
+            p[3][c] = (p[0][c] + 2 * p[1][c]) / 3;
+        } else {
+            p[2][c] = (p[0][c] + p[1][c]) / 2;
+            p[3][c] = 0;
+        }
+    }
+    for (int k = 0; k < 16; ++k) {
+        const int index = b[4 + k / 4] >> (k % 4 * 2) & 3;
+        for (int c = 0; c < 4; ++c) out[k][c] = (uint8_t)p[index][c];
+    }
+}
+
+static void DecodeBC4(const uint8_t *b, uint8_t out[16][4], int channel) {
+    const int e0 = b[0], e1 = b[1];
+    int p[8] = {e0, e1, 0, 0, 0, 0, 0, 255};
+    for (int i = 1; i < 7; ++i) {
+        if (e0 > e1)
+            p[i + 1] = ((7 - i) * e0 + i * e1) / 7;
+        else if (i < 5)
+            p[i + 1] = ((5 - i) * e0 + i * e1) / 5;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) bits |= (uint64_t)b[2 + i] << (8 * i);
+    for (int k = 0; k < 16; ++k) out[k][channel] = p[bits >> (3 * k) & 7];
+}
+
+static uint32_t ReadBits(const uint8_t *b, uint32_t *pos, uint32_t count) {
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < count; ++i, ++*pos)
+        v |= (uint32_t)(b[*pos >> 3] >> (*pos & 7) & 1) << i;
+    return v;
+}
+
+// mode 6 only, other modes come out black
+static void DecodeBC7(const uint8_t *b, uint8_t out[16][4]) {
+    static const int weights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                    34, 38, 43, 47, 51, 55, 60, 64};
+    memset(out, 0, 64);
+    uint32_t pos = 0;
+    if (ReadBits(b, &pos, 7) != 1 << 6) return;
+    int e[2][4];
+    for (int c = 0; c < 4; ++c) {
+        e[0][c] = ReadBits(b, &pos, 7);
+        e[1][c] = ReadBits(b, &pos, 7);
+    }
+    const uint32_t p0 = ReadBits(b, &pos, 1), p1 = ReadBits(b, &pos, 1);
+    for (int c = 0; c < 4; ++c) {
+        e[0][c] = e[0][c] << 1 | p0;
+        e[1][c] = e[1][c] << 1 | p1;
+    }
+    for (int k = 0; k < 16; ++k) {
+        const int w = weights[ReadBits(b, &pos, k == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c)
+            out[k][c] = ((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6;
+    }
+}
+
+static void Decode(const uint8_t *data, uint32_t width, uint32_t height,
+                   TextureFormat format, uint8_t *rgba) {
+    const uint32_t blockSize = TextureFormatBlockSize(format);
+    const uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    for (uint32_t by = 0; by < blocksY; ++by) {
+        for (uint32_t bx = 0; bx < blocksX; ++bx) {
+            const uint8_t *b = data + (by * blocksX + bx) * blockSize;
+            uint8_t px[16][4];
+            memset(px, 0, sizeof(px));
+            if (format == TextureFormatDXT1) {
+                DecodeBC1(b, false, px);
+            } else if (format == TextureFormatDXT5) {
+                DecodeBC1(b + 8, true, px);
+                DecodeBC4(b, px, 3);
+            } else if (format == TextureFormatBC4) {
+                DecodeBC4(b, px, 0);
+            } else if (format == TextureFormatBC5) {
+                DecodeBC4(b, px, 0);
+                DecodeBC4(b + 8, px, 1);
+            } else {
+                DecodeBC7(b, px);
+            }
+            for (uint32_t k = 0; k < 16; ++k) {
+                const uint32_t x = bx * 4 + k % 4, y = by * 4 + k / 4;
+                if (x < width && y < height)
+                    memcpy(rgba + ((size_t)y * width + x) * 4, px[k], 4);
+            }
+        }
+    }
+}
+
+// over the channels the format keeps
+static double PSNR(const uint8_t *a, const uint8_t *b, size_t pixelCount,
+                   uint32_t channels) {
+    double sum = 0;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        for (uint32_t c = 0; c < channels; ++c) {
+            const double d = (double)a[i * 4 + c] - b[i * 4 + c];
+            sum += d * d;
+        }
+    }
+    if (sum == 0) return INFINITY;
+    return 10 * log10(255.0 * 255.0 * pixelCount * channels / sum);
+}
+
+// smooth gradients, hard edges and noise, the alpha channel fully opaque
+// so that DXT1 errors are comparable
+static void MakeImage(Image *image, uint32_t size) {
+    image->width = image->height = size;
+    image->pixels = malloc((size_t)size * size * 4);
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            uint8_t *p = image->pixels + ((size_t)y * size + x) * 4;
+            const float u = (float)x / size, v = (float)y / size;
+            p[0] = (uint8_t)(127 + 120 * sinf(u * 20 + v * 3));
+            p[1] = (uint8_t)(255 * v);
+            p[2] = (uint8_t)(((x / 32 + y / 32) & 1 ? 200 : 40) + rand() % 16);
+            p[3] = 255;
+        }
+    }
+}
+
+static void PrintHelp() {
+    puts(
+        "usage:\n"
+        "texbench [image.png|image.jpg] [iterations]\n"
+        "without an image a 1024x1024 synthetic one is used\n");
+}
+
+static void Run(const Image *image, uint32_t iterations) {
+    static const TextureFormat formats[] = {
+        TextureFormatDXT1, TextureFormatDXT5, TextureFormatBC4,
+        TextureFormatBC5, TextureFormatBC7};
+    static const char *names[] = {"DXT1", "DXT5", "BC4", "BC5", "BC7"};
+    static const uint32_t channels[] = {3, 4, 1, 2, 4};
+    const size_t pixelCount = (size_t)image->width * image->height;
+    uint8_t *out = malloc(pixelCount * 4 + 64);
+    uint8_t *decoded = malloc(pixelCount * 4);
+    for (int f = 0; f < 5; ++f) {
+        for (int q = 0; q < TextureEncodeQualityCount; ++q) {
+            const double start = Now();
+            for (uint32_t i = 0; i < iterations; ++i)
+                TextureEncodeImage(image->pixels, image->width,
+                                   image->height, formats[f],
+                                   (TextureEncodeQuality)q, out);
+            const double time = (Now() - start) / iterations;
+            Decode(out, image->width, image->height, formats[f], decoded);
+            printf("%-5s %-7s %8.2f MP/s  %6.2f dB\n", names[f],
+                   TextureEncodeQualityName((TextureEncodeQuality)q),
+                   pixelCount / time * 1e-6,
+                   PSNR(image->pixels, decoded, pixelCount, channels[f]));
+        }
+    }
+    free(out);
+    free(decoded);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--help") == 0) {
+        PrintHelp();
+        return 0;
+    }
+    Image image;
+    if (argc >= 2) {
+        const char *error;
+        if (!ImageDecodeFile(argv[1], &image, &error)) {
+            printf("%s: %s\n", argv[1], error);
+            return 1;
+        }
+    } else {
+        srand(1234);
+        MakeImage(&image, 1024);
+    }
+    const uint32_t iterations = argc >= 3 ? (uint32_t)atoi(argv[2]) : 3;
+    if (iterations == 0) {
+        PrintHelp();
+        return 1;
+    }
+    printf("%ux%u, %u iterations\n", image.width, image.height, iterations);
+
+    puts("1 thread");
+    Run(&image, iterations);
+    JobSystemInit(UINT32_MAX);
+    printf("%u threads\n", JobSystemGetThreadCount());
+    Run(&image, iterations);
+    JobSystemShutdown();
+
+    ImageFree(&image);
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Draws a list of 10000 items with a Selectable call per item and with the
+// clipped SelectableList, then a slider and 100 of the items as ops of a
+// command buffer that imgui.Submit runs in one call, and prints the time each
+// took every 100 frames.
+// Needs the editor, renderUI is not called by FishHeadless.
+import * as imgui from 'imgui';
+
+const itemCount = 10000;
+const labels = [];
+for (let i = 0; i < itemCount; ++i) {
+    labels.push(`item ${i}`);
+}
+
+// imgui.Submit(words, count, strings): an op, then a word for every
+// parameter, then one for the result of the ops that return a bool
+class CommandBuffer {
+    constructor(capacity) {
+        this.words = new Uint32Array(capacity);
+        this.floats = new Float32Array(this.words.buffer);
+        this.strings = [];
+        this.count = 0;
+    }
+    clear() {
+        this.count = 0;
+        this.strings.length = 0;
+    }
+    op(op) { this.words[this.count++] = op; }
+    string(s) {
+        this.words[this.count++] = this.strings.length;
+        this.strings.push(s);
+    }
+    bool(b) { this.words[this.count++] = b ? 1 : 0; }
+    float(f) { this.floats[this.count++] = f; }
+    // where the result of the last op goes
+    result() { return this.count++; }
+    submit() { imgui.Submit(this.words, this.count, this.strings); }
+}
+
+const commands = new CommandBuffer(1024);
+let selected = -1, volume = 0.5;
+let perItemTime = 0, clippedTime = 0, commandTime = 0, frame = 0;
+
+globalThis.renderUI = () => {
+    let start = Date.now();
+    imgui.Begin('per item');
+    for (let i = 0; i < itemCount; ++i) {
+        if (imgui.Selectable(labels[i], i == selected)) selected = i;
+    }
+    imgui.End();
+    perItemTime += Date.now() - start;
+
+    start = Date.now();
+    imgui.Begin('clipped');
+    selected = imgui.SelectableList(labels, selected);
+    imgui.End();
+    clippedTime += Date.now() - start;
+
+    start = Date.now();
+    commands.clear();
+    commands.op(imgui.Op.Begin);
+    commands.string('commands');
+    commands.result();
+    commands.op(imgui.Op.SliderFloat);
+    commands.string('volume');
+    const volumeWord = commands.count;
+    commands.float(volume);
+    commands.float(0);
+    commands.float(1);
+    commands.result();
+    const pressed = [];
+    for (let i = 0; i < 100; ++i) {
+        commands.op(imgui.Op.Selectable);
+        commands.string(labels[i]);
+        commands.bool(i == selected);
+        pressed.push(commands.result());
+    }
+    commands.op(imgui.Op.End);
+    commands.submit();
+    volume = commands.floats[volumeWord];
+    pressed.forEach((word, i) => {
+        if (commands.words[word]) selected = i;
+    });
+    commandTime += Date.now() - start;
+
+    if (++frame % 100 == 0) {
+        print(`per item: ${perItemTime} ms, clipped: ${clippedTime} ms, ` +
+              `command buffer: ${commandTime} ms`);
+        perItemTime = clippedTime = commandTime = 0;
+    }
+};
@@ -0,0 +1,49 @@
+// Moves 1000 transforms every frame from a system that visits the entities
+// one by one and from a query system that gets them in chunks, and prints
+// the time each took after the last frame.
+// FishHeadless samples/benchmarks/query_systems.js 100
+import * as fe from 'FishEngine';
+
+const entityCount = 1000;
+const frames = 100;
+
+const world = fe.GetDefaultWorld();
+const entities = [];
+for (let i = 0; i < entityCount; ++i) {
+    entities.push(world.CreateEntity());
+}
+
+let perEntityTime = 0, chunkedTime = 0, chunks = 0, frame = 0;
+
+world.AddSystem((w) => {
+    const start = Date.now();
+    for (const e of entities) {
+        const t = e.transform;
+        const p = t.localPosition;
+        p[0] += 0.01;
+        t.localPosition = p;
+    }
+    perEntityTime += Date.now() - start;
+});
+
+world.AddSystem({
+    query: [fe.TransformID],
+    write: [[fe.TransformID, 'localPosition']],
+}, (chunk, w) => {
+    const start = Date.now();
+    const p = chunk.localPosition;
+    for (let i = 0; i < chunk.count; ++i) {
+        p[i * 3 + 2] += 0.01;
+    }
+    chunkedTime += Date.now() - start;
+    chunks++;
+});
+
+world.AddSystem((w) => {
+    if (++frame != frames) return;
+    // the query also visits the entities that were there before
+    print(`per entity: ${perEntityTime} ms, chunked: ${chunkedTime} ms in ` +
+          `${chunks / frames} chunks a frame`);
+    const p = entities[0].transform.localPosition;
+    print(`first entity moved to ${p[0].toFixed(2)}, ${p[2].toFixed(2)}`);
+});
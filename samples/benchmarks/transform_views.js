@@ -0,0 +1,77 @@
+// Moves 100k transforms through the Transform properties, through
+// GetLocalPosition into a reused Float32Array and through typed array views
+// over the component storage, and prints how long each took.
+// FishHeadless samples/benchmarks/transform_views.js 1
+import * as fe from 'FishEngine';
+
+// the world has room for 1024 entities, 100k updates are made of passes
+const entityCount = 1000;
+const passes = 100;
+
+const world = fe.GetDefaultWorld();
+const entities = [];
+for (let i = 0; i < entityCount; ++i) {
+    entities.push(world.CreateEntity());
+}
+// a transform has the index of its entity
+const first = entities[0].GetID();
+
+function MoveWithProperties(dy) {
+    for (let pass = 0; pass < passes; ++pass) {
+        for (const e of entities) {
+            const t = e.transform;
+            const p = t.localPosition;
+            p[1] += dy;
+            t.localPosition = p;
+        }
+    }
+}
+
+// no array is made per call, the setter reads the Float32Array directly
+function MoveWithTarget(dy) {
+    const p = new Float32Array(3);
+    for (let pass = 0; pass < passes; ++pass) {
+        for (const e of entities) {
+            const t = e.transform;
+            t.GetLocalPosition(p);
+            p[1] += dy;
+            t.localPosition = p;
+        }
+    }
+}
+
+function MoveWithViews(dy) {
+    const position = world.View(fe.TransformID, 'localPosition');
+    const stride = position.stride;
+    for (let pass = 0; pass < passes; ++pass) {
+        for (let i = first; i < first + entityCount; ++i) {
+            position[i * stride + 1] += dy;
+        }
+        world.Commit(fe.TransformID, first, entityCount);
+    }
+}
+
+function Measure(name, f) {
+    const start = Date.now();
+    f(0.01);
+    const ms = Date.now() - start;
+    const updates = entityCount * passes;
+    print(`${name}: ${ms} ms, ${(updates / Math.max(ms, 1) / 1000).toFixed(2)}` +
+          ` M updates/s`);
+    return ms;
+}
+
+const properties = Measure('properties', MoveWithProperties);
+Measure('target', MoveWithTarget);
+const views = Measure('views', MoveWithViews);
+print(`views are ${(properties / Math.max(views, 1)).toFixed(1)}x faster`);
+
+// every path moved every transform by the same amount
+const position = world.View(fe.TransformID, 'localPosition');
+for (const e of entities) {
+    const y = e.transform.localPosition[1];
+    const z = position[e.GetID() * position.stride + 1];
+    if (Math.abs(y - 3) > 1e-3 || y !== z) {
+        throw new Error(`entity ${e.GetID()}: ${y} ${z}`);
+    }
+}
@@ -209,6 +209,83 @@ export function LoadglTFFromFile(path) {
             b._buffer = buf;
         }
     }
+    return BuildglTF(path, duck);
+}
+
+// The .bin files are read, and the 8 bit indices widened, by glTFWorker.js
+// on its own thread; the rest of the load runs on the main thread when the
+// buffers are back, in the frame after.
+let loaderWorker = null;
+let nextLoadID = 0;
+const pendingLoads = new Map();
+
+function GetLoaderWorker() {
+    if (loaderWorker)
+        return loaderWorker;
+    loaderWorker = new fe.Worker("E:\\workspace\\cengine\\samples\\gltfviewer\\assets\\glTFWorker.js");
+    loaderWorker.onmessage = ({id, bufferCount, indices, error}, buffers) => {
+        const load = pendingLoads.get(id);
+        pendingLoads.delete(id);
+        if (error) {
+            load.reject(Error(error));
+            return;
+        }
+        // the promise is rejected with what BuildglTF throws
+        try {
+            const duck = load.duck;
+            let next = 0;
+            for (const b of duck.buffers) {
+                if (!('uri' in b))
+                    continue;
+                const buffer = buffers[next++];
+                assert(b.byteLength <= buffer.byteLength);
+                b._buffer = new Uint8Array(buffer);
+            }
+            indices.forEach((accessorID, i) => {
+                duck.accessors[accessorID]._widened = new Uint16Array(buffers[bufferCount + i]);
+            });
+            load.resolve(BuildglTF(load.path, duck));
+        } catch (e) {
+            load.reject(e);
+        }
+    };
+    return loaderWorker;
+}
+
+// a promise of the glTF
+export function LoadglTFFromFileAsync(path) {
+    print('LoadglTFAsync', path);
+    const duck = LoadFileAsJSON(path);
+
+    const dir = path.substring(0, path.lastIndexOf(PATH_SEP));
+    // null for a buffer without a uri, as in LoadglTFFromFile
+    const paths = duck.buffers.map(b => 'uri' in b ? `${dir}\\${b.uri}` : null);
+    let indices = [];
+    for (const m of duck.meshes) {
+        for (const primitive of m.primitives) {
+            if (!('indices' in primitive))
+                continue;
+            const accessorID = primitive.indices;
+            const accessor = duck.accessors[accessorID];
+            if (accessor.componentType !== 5121 || indices.some(x => x.accessorID === accessorID))
+                continue;
+            const bufferView = duck.bufferViews[accessor.bufferView];
+            const {byteOffset=0} = bufferView;
+            indices.push({accessorID, buffer: bufferView.buffer,
+                          byteOffset: byteOffset + (accessor.byteOffset || 0),
+                          count: accessor.count});
+        }
+    }
+
+    const id = nextLoadID++;
+    GetLoaderWorker().postMessage({id, paths, indices});
+    return new Promise((resolve, reject) => {
+        pendingLoads.set(id, {resolve, reject, path, duck});
+    });
+}
+
+function BuildglTF(path, duck) {
+    const dir = path.substring(0, path.lastIndexOf(PATH_SEP));
     const {samplers, textures, images} = duck;
     if (samplers) {
         for (let sampler of samplers) {
@@ -335,10 +412,8 @@ export function LoadglTFFromFile(path) {
         } else if (accessor.componentType === 5121) {
             const _indices = new Uint8Array(buffer._buffer.buffer, byteOffset, accessor.count  * componentCount);
             if (convertU8ToU16) {
-                ret = new Uint16Array(accessor.count);
-                _indices.forEach((v, idx)=>{
-                    ret[idx] = v;
-                });
+                // widened by the worker, or here in one native copy
+                ret = accessor._widened || new Uint16Array(_indices);
             } else {
                 ret = _indices;
             }
@@ -465,6 +540,10 @@ export function LoadglTFFromFile(path) {
     {
         b._buffer = null;
     }
+    for (let a of duck.accessors)
+    {
+        delete a._widened;
+    }
 
     const gltf = new glTF();
     gltf.duck = duck;
@@ -0,0 +1,39 @@
+// Runs on a worker thread for LoadglTFFromFileAsync in glTFLoader.js: reads
+// the .bin buffers of a glTF file and widens its 8 bit index accessors to 16
+// bits, then hands them all back to the main thread.
+// Only 'std' and the constants of 'FishEngine' are there in a worker.
+import * as std from 'std';
+
+function readBinFile(path) {
+    const fd = std.open(path, "rb");
+    if (!fd)
+        throw Error(`can not open ${path}`);
+    fd.seek(0, std.SEEK_END);
+    const size = fd.tell();
+    fd.seek(0, std.SEEK_SET);
+    const buf = new Uint8Array(size);
+    const ret = fd.read(buf.buffer, 0, size);
+    fd.close();
+    if (ret !== size)
+        throw Error(`read ${ret} of ${size} bytes from ${path}`);
+    return buf;
+}
+
+// {id, paths, indices: [{accessorID, buffer, byteOffset, count}]} gets back
+// {id, bufferCount, indices: [accessorID]} with the buffers of the paths that
+// are not null and then the widened indices
+globalThis.onmessage = ({id, paths, indices}) => {
+    try {
+        const bins = paths.map(path => path === null ? null : readBinFile(path));
+        const widened = indices.map(({buffer, byteOffset, count}) => {
+            if (bins[buffer] === null)
+                throw Error(`buffer ${buffer} has no uri`);
+            return new Uint16Array(new Uint8Array(bins[buffer].buffer, byteOffset, count));
+        });
+        const read = bins.filter(b => b !== null);
+        postMessage({id, bufferCount: read.length, indices: indices.map(x => x.accessorID)},
+                    [...read.map(b => b.buffer), ...widened.map(w => w.buffer)]);
+    } catch (e) {
+        postMessage({id, error: `${e}`});
+    }
+};
@@ -1,5 +1,5 @@
 import * as fe from 'FishEngine';
-import {glTF, LoadglTFFromFile} from './glTFLoader.js'
+import {glTF, LoadglTFFromFile, LoadglTFFromFileAsync} from './glTFLoader.js'
 import * as imgui from 'imgui';
 import {assert, print2, LoadFileAsJSON} from './utils.js'
 
@@ -14,18 +14,13 @@ for (const m of models) {
         list.push({name: m.name, glTF: m.variants.glTF});
     }
 }
+const names = list.map(l => l.name);
 
 globalThis.renderUI = ()=>{
     const oldSelected = selectedModel;
     imgui.Begin("glTF-Sample-Models");
-    list.forEach((l, index)=>{
-        if (imgui.Selectable(l.name, index==selectedModel)) {
-            selectedModel = index;
-        }
-        if (imgui.IsItemFocused()) {
-            selectedModel = index;
-        }
-    });
+    // only the rows in view are drawn
+    selectedModel = imgui.SelectableList(names, selectedModel);
     imgui.End();
 
     if (oldSelected != selectedModel)
@@ -34,14 +29,20 @@ globalThis.renderUI = ()=>{
         fe.reload();
         if (selectedModel >=0 && selectedModel < list.length)
         {
-            let duck = loaded.get(selectedModel);
-            if (!duck) {
-                const {name, glTF} = list[selectedModel];
+            const selected = selectedModel;
+            let duck = loaded.get(selected);
+            if (duck) {
+                duck.Instantiate(fe.GetDefaultWorld());
+            } else {
+                const {name, glTF} = list[selected];
                 const path = `D:\\workspace\\glTF-Sample-Models\\2.0\\${name}\\glTF\\${glTF}`;
-                duck = LoadglTFFromFile(path);
-                loaded.set(selectedModel, duck);
+                // the buffers are read on a worker, the UI keeps going
+                LoadglTFFromFileAsync(path).then(duck => {
+                    loaded.set(selected, duck);
+                    if (selectedModel == selected)
+                        duck.Instantiate(fe.GetDefaultWorld());
+                }).catch(e => print(e));
             }
-            duck.Instantiate(fe.GetDefaultWorld());
         }
     }
 }
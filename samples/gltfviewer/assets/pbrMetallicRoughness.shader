@@ -12,6 +12,7 @@ Shader "pbr"
 			#pragma vertex VS
 			#pragma fragment PS
 			#pragma target 5.1
+			#pragma multi_compile _ INSTANCING_ON
 			#pragma multi_compile _ HAS_BASECOLORMAP
 			#pragma multi_compile _ HAS_METALROUGHNESSMAP
 			